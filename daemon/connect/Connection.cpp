@@ -385,6 +385,80 @@ bool Connection::Send(const char* buffer, int size)
 	return true;
 }
 
+/* Sends multiple buffers in one system call (gather write), which avoids an
+ * extra packet for the small header sent before the body. */
+bool Connection::Send(const char* const* buffers, const int* sizes, int count)
+{
+#ifndef WIN32
+#ifndef DISABLE_TLS
+	if (!m_tlsSocket)
+#endif
+	{
+		debug("Sending data");
+
+		if (m_status != csConnected)
+		{
+			return false;
+		}
+
+		int index = 0;
+		int offset = 0;
+		while (true)
+		{
+			struct iovec iov[8];
+			int vecCount = 0;
+			for (int i = index; i < count && vecCount < 8; i++)
+			{
+				int skip = i == index ? offset : 0;
+				if (sizes[i] > skip)
+				{
+					iov[vecCount].iov_base = (void*)(buffers[i] + skip);
+					iov[vecCount].iov_len = sizes[i] - skip;
+					vecCount++;
+				}
+			}
+
+			if (vecCount == 0)
+			{
+				return true;
+			}
+
+			ssize_t res = writev(m_socket, iov, vecCount);
+			if (res <= 0)
+			{
+				m_status = csBroken;
+				return false;
+			}
+
+			while (res > 0)
+			{
+				int avail = sizes[index] - offset;
+				if (res >= avail)
+				{
+					res -= avail;
+					index++;
+					offset = 0;
+				}
+				else
+				{
+					offset += (int)res;
+					res = 0;
+				}
+			}
+		}
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+	{
+		if (!Send(buffers[i], sizes[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 char* Connection::ReadLine(char* buffer, int size, int* bytesReadOut)
 {
 	if (m_status != csConnected)
@@ -61,6 +61,7 @@ public:
 	virtual bool Disconnect();
 	bool Bind();
 	bool Send(const char* buffer, int size);
+	bool Send(const char* const* buffers, const int* sizes, int count);
 	bool Recv(char* buffer, int size);
 	int TryRecv(char* buffer, int size);
 	char* ReadLine(char* buffer, int size, int* bytesRead);
@@ -70,6 +71,7 @@ public:
 	void Cancel();
 	const char* GetHost() { return m_host; }
 	int GetPort() { return m_port; }
+	SOCKET GetSocket() { return m_socket; }
 	bool GetTls() { return m_tls; }
 	const char* GetCipher() { return m_cipher; }
 	void SetCipher(const char* cipher) { m_cipher = cipher; }
@@ -91,7 +91,8 @@ void WebDownloader::Run()
 			break;
 		}
 
-		if (Status == adFinished || Status == adFatalError || Status == adNotFound)
+		if (Status == adFinished || Status == adFatalError || Status == adNotFound ||
+			Status == adNotModified)
 		{
 			break;
 		}
@@ -106,7 +107,7 @@ void WebDownloader::Run()
 		}
 	}
 
-	if (Status != adFinished && Status != adRetry)
+	if (Status != adFinished && Status != adRetry && Status != adNotModified)
 	{
 		Status = adFailed;
 	}
@@ -128,6 +129,11 @@ void WebDownloader::Run()
 		detail("Download %s completed", *m_infoName);
 	}
 
+	if (Status == adNotModified)
+	{
+		detail("Download %s skipped: not modified", *m_infoName);
+	}
+
 	SetStatus(Status);
 
 	debug("Exiting WebDownloader-loop");
@@ -262,6 +268,14 @@ void WebDownloader::SendHeaders(URL *url)
 #ifndef DISABLE_GZIP
 	m_connection->WriteLine("Accept-Encoding: gzip\r\n");
 #endif
+	if (!m_ifNoneMatch.Empty())
+	{
+		m_connection->WriteLine(BString<1024>("If-None-Match: %s\r\n", *m_ifNoneMatch));
+	}
+	if (!m_ifModifiedSince.Empty())
+	{
+		m_connection->WriteLine(BString<1024>("If-Modified-Since: %s\r\n", *m_ifModifiedSince));
+	}
 	m_connection->WriteLine("Connection: close\r\n");
 	m_connection->WriteLine("\r\n");
 }
@@ -277,6 +291,8 @@ WebDownloader::EStatus WebDownloader::DownloadHeaders()
 	m_gzip = false;
 	m_redirecting = false;
 	m_redirected = false;
+	m_etag = nullptr;
+	m_lastModified = nullptr;
 
 	// Headers
 	while (!IsStopped())
@@ -449,6 +465,11 @@ WebDownloader::EStatus WebDownloader::CheckResponse(const char* response)
 		m_redirecting = true;
 		return adRunning;
 	}
+	else if (!strncmp(hTTPResponse, "304", 3))
+	{
+		// answer to conditional request: the content was not changed since last download
+		return adNotModified;
+	}
 	else if (!strncmp(hTTPResponse, "200", 3))
 	{
 		// OK
@@ -477,6 +498,14 @@ void WebDownloader::ProcessHeader(const char* line)
 	{
 		ParseFilename(line);
 	}
+	else if (!strncasecmp(line, "ETag: ", 6))
+	{
+		m_etag = line + 6;
+	}
+	else if (!strncasecmp(line, "Last-Modified: ", 15))
+	{
+		m_lastModified = line + 15;
+	}
 	else if (m_redirecting && !strncasecmp(line, "Location: ", 10))
 	{
 		ParseRedirect(line + 10);
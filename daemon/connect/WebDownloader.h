@@ -41,7 +41,8 @@ public:
 		adNotFound,
 		adRedirect,
 		adConnectError,
-		adFatalError
+		adFatalError,
+		adNotModified
 	};
 
 	WebDownloader();
@@ -61,6 +62,10 @@ public:
 	const char* GetOriginalFilename() { return m_originalFilename; }
 	void SetForce(bool force) { m_force = force; }
 	void SetRetry(bool retry) { m_retry = retry; }
+	void SetIfNoneMatch(const char* etag) { m_ifNoneMatch = etag; }
+	void SetIfModifiedSince(const char* lastModified) { m_ifModifiedSince = lastModified; }
+	const char* GetETag() { return m_etag; }
+	const char* GetLastModified() { return m_lastModified; }
 
 	void LogDebugInfo();
 
@@ -84,6 +89,10 @@ private:
 	bool m_redirected;
 	bool m_gzip;
 	bool m_retry = true;
+	CString m_ifNoneMatch;
+	CString m_ifModifiedSince;
+	CString m_etag;
+	CString m_lastModified;
 #ifndef DISABLE_GZIP
 	std::unique_ptr<GUnzipStream> m_gUnzipStream;
 #endif
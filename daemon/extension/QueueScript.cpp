@@ -108,7 +108,7 @@ void QueueScriptController::Run()
 	if (m_markBad)
 	{
 		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
-		NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_id);
+		NzbInfo* nzbInfo = downloadQueue->FindNzb(m_id);
 		if (nzbInfo)
 		{
 			nzbInfo->PrintMessage(Message::mkWarning, "Cancelling download and deleting %s", *m_nzbName);
@@ -387,13 +387,13 @@ bool QueueScriptCoordinator::UsableScript(ScriptConfig::Script& script, NzbInfo*
 
 NzbInfo* QueueScriptCoordinator::FindNzbInfo(DownloadQueue* downloadQueue, int nzbId)
 {
-	NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(nzbId);
+	NzbInfo* nzbInfo = downloadQueue->FindNzb(nzbId);
 	if (nzbInfo)
 	{
 		return nzbInfo;
 	}
 
-	HistoryInfo* historyInfo = downloadQueue->GetHistory()->Find(nzbId);
+	HistoryInfo* historyInfo = downloadQueue->FindHistory(nzbId);
 	if (historyInfo)
 	{
 		return historyInfo->GetNzbInfo();
@@ -247,6 +247,8 @@ void FeedCoordinator::StartFeedDownload(FeedInfo* feedInfo, bool force)
 	feedDownloader->SetUrl(feedInfo->GetUrl());
 	feedDownloader->SetInfoName(feedInfo->GetName());
 	feedDownloader->SetForce(force || g_Options->GetUrlForce());
+	feedDownloader->SetIfNoneMatch(feedInfo->GetETag());
+	feedDownloader->SetIfModifiedSince(feedInfo->GetLastModified());
 
 	BString<1024> outFilename;
 	if (feedInfo->GetId() > 0)
@@ -274,7 +276,8 @@ void FeedCoordinator::Update(Subject* caller, void* aspect)
 	FeedDownloader* feedDownloader = (FeedDownloader*) caller;
 	if ((feedDownloader->GetStatus() == WebDownloader::adFinished) ||
 		(feedDownloader->GetStatus() == WebDownloader::adFailed) ||
-		(feedDownloader->GetStatus() == WebDownloader::adRetry))
+		(feedDownloader->GetStatus() == WebDownloader::adRetry) ||
+		(feedDownloader->GetStatus() == WebDownloader::adNotModified))
 	{
 		FeedCompleted(feedDownloader);
 	}
@@ -285,11 +288,14 @@ void FeedCoordinator::FeedCompleted(FeedDownloader* feedDownloader)
 	debug("Feed downloaded");
 
 	FeedInfo* feedInfo = feedDownloader->GetFeedInfo();
-	bool statusOK = feedDownloader->GetStatus() == WebDownloader::adFinished;
-	if (statusOK)
+	bool notModified = feedDownloader->GetStatus() == WebDownloader::adNotModified;
+	bool statusOK = feedDownloader->GetStatus() == WebDownloader::adFinished || notModified;
+	if (statusOK && !notModified)
 	{
 		feedInfo->SetOutputFilename(feedDownloader->GetOutputFilename());
 	}
+	CString etag = feedDownloader->GetETag();
+	CString lastModified = feedDownloader->GetLastModified();
 
 	// remove downloader from downloader list
 	{
@@ -303,31 +309,48 @@ void FeedCoordinator::FeedCompleted(FeedDownloader* feedDownloader)
 	{
 		if (!feedInfo->GetPreview())
 		{
-			bool scriptSuccess = true;
-			FeedScriptController::ExecuteScripts(
-				!Util::EmptyStr(feedInfo->GetExtensions()) ? feedInfo->GetExtensions(): g_Options->GetExtensions(),
-				feedInfo->GetOutputFilename(), feedInfo->GetId(), &scriptSuccess);
-			if (!scriptSuccess)
+			std::shared_ptr<FeedItemList> feedItems;
+			if (notModified)
 			{
-				feedInfo->SetStatus(FeedInfo::fsFailed);
-				return;
+				detail("%s is not modified since last update", feedInfo->GetName());
+				Guard guard(m_downloadsMutex);
+				feedItems = feedInfo->GetFeedItems();
 			}
+			else
+			{
+				bool scriptSuccess = true;
+				FeedScriptController::ExecuteScripts(
+					!Util::EmptyStr(feedInfo->GetExtensions()) ? feedInfo->GetExtensions(): g_Options->GetExtensions(),
+					feedInfo->GetOutputFilename(), feedInfo->GetId(), &scriptSuccess);
+				if (!scriptSuccess)
+				{
+					feedInfo->SetStatus(FeedInfo::fsFailed);
+					return;
+				}
 
-			std::unique_ptr<FeedFile> feedFile = parseFeed(feedInfo);
+				std::unique_ptr<FeedFile> feedFile = parseFeed(feedInfo);
+				if (feedFile)
+				{
+					feedItems = feedFile->DetachFeedItems();
+				}
+			}
 
-			std::vector<std::unique_ptr<NzbInfo>> addedNzbs;
+			std::vector<std::unique_ptr<NzbInfo>> addedNzbs = UpdateFeed(feedInfo, feedItems);
 
+			// validators are remembered only for successfully processed content,
+			// otherwise the next update must download the feed again
+			if (!notModified || !feedItems)
+			{
+				feedInfo->SetETag(feedItems ? *etag : nullptr);
+				feedInfo->SetLastModified(feedItems ? *lastModified : nullptr);
+			}
+
+			// without validators the server never reports "not modified",
+			// the items would only waste memory until the next update
+			if (Util::EmptyStr(feedInfo->GetETag()) && Util::EmptyStr(feedInfo->GetLastModified()))
 			{
 				Guard guard(m_downloadsMutex);
-				if (feedFile)
-				{
-					std::unique_ptr<FeedItemList> feedItems = feedFile->DetachFeedItems();
-					addedNzbs = ProcessFeed(feedInfo, feedItems.get());
-					feedFile.reset();
-				}
-				feedInfo->SetLastUpdate(Util::CurrentTime());
-				feedInfo->SetForce(false);
-				m_save = true;
+				feedInfo->SetFeedItems(nullptr);
 			}
 
 			for (std::unique_ptr<NzbInfo>& nzbInfo : addedNzbs)
@@ -343,6 +366,33 @@ void FeedCoordinator::FeedCompleted(FeedDownloader* feedDownloader)
 	}
 }
 
+std::vector<std::unique_ptr<NzbInfo>> FeedCoordinator::UpdateFeed(FeedInfo* feedInfo,
+	std::shared_ptr<FeedItemList> feedItems)
+{
+	if (feedItems)
+	{
+		// Filtering checks each item against download queue and history and
+		// is done without locking to not hold up other feeds and the coordinator.
+		FilterFeed(feedInfo, feedItems.get());
+	}
+
+	std::vector<std::unique_ptr<NzbInfo>> addedNzbs;
+
+	Guard guard(m_downloadsMutex);
+	if (feedItems)
+	{
+		addedNzbs = ProcessFeed(feedInfo, feedItems.get());
+	}
+	feedInfo->SetLastUpdate(Util::CurrentTime());
+	feedInfo->SetForce(false);
+	// The items are filtered again if the feed isn't modified on next update: rules with
+	// "age" or "dupestatus" terms may then accept items rejected now.
+	feedInfo->SetFeedItems(feedItems);
+	m_save = true;
+
+	return addedNzbs;
+}
+
 void FeedCoordinator::SchedulerNextUpdate(FeedInfo* feedInfo, bool success)
 {
 	time_t current = Util::CurrentTime();
@@ -389,11 +439,19 @@ void FeedCoordinator::FilterFeed(FeedInfo* feedInfo, FeedItemList* feedItems)
 		feedItemInfo.SetDupeScore(0);
 		feedItemInfo.SetDupeMode(dmScore);
 		feedItemInfo.SetFeedFilterHelper(&filterHelper);
+		feedItemInfo.ResetDupeStatus();
 		feedItemInfo.BuildDupeKey(nullptr, nullptr, nullptr, nullptr);
-		if (feedFilter)
-		{
-			feedFilter->Match(feedItemInfo);
-		}
+	}
+
+	if (feedFilter)
+	{
+		feedFilter->Match(*feedItems);
+	}
+
+	// the items outlive the helper (feed cache, items kept for "not modified" updates)
+	for (FeedItemInfo& feedItemInfo : feedItems)
+	{
+		feedItemInfo.SetFeedFilterHelper(nullptr);
 	}
 }
 
@@ -401,8 +459,6 @@ std::vector<std::unique_ptr<NzbInfo>> FeedCoordinator::ProcessFeed(FeedInfo* fee
 {
 	debug("Process feed %s", feedInfo->GetName());
 
-	FilterFeed(feedInfo, feedItems);
-
 	std::vector<std::unique_ptr<NzbInfo>> addedNzbs;
 	bool firstFetch = feedInfo->GetLastUpdate() == 0;
 	int added = 0;
@@ -574,6 +630,7 @@ std::shared_ptr<FeedItemList> FeedCoordinator::PreviewFeed(int id,
 		feedItems = feedFile->DetachFeedItems();
 		feedFile.reset();
 
+		Guard guard(m_downloadsMutex);
 		for (FeedItemInfo& feedItemInfo : feedItems.get())
 		{
 			feedItemInfo.SetStatus(firstFetch && feedInfo->GetBacklog() ? FeedItemInfo::isBacklog : FeedItemInfo::isNew);
@@ -52,6 +52,10 @@ public:
 	/* may return empty pointer on error */
 	std::shared_ptr<FeedItemList> ViewFeed(int id);
 
+	/* filters parsed feed items, or the items of the last update if the feed wasn't modified,
+	   and records them in feed history; returns new items to be added to download queue */
+	std::vector<std::unique_ptr<NzbInfo>> UpdateFeed(FeedInfo* feedInfo, std::shared_ptr<FeedItemList> feedItems);
+
 	void FetchFeed(int id);
 	bool HasActiveDownloads();
 	Feeds* GetFeeds() { return &m_feeds; }
@@ -24,50 +24,215 @@
 #include "Util.h"
 #include "FeedFilter.h"
 
-bool FeedFilter::Term::Match(FeedItemInfo& feedItemInfo)
+static const char* WORD_SEPARATORS = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+static void LowerStr(char* str)
 {
-	const char* strValue = nullptr;
-	int64 intValue = 0;
+	for (char* p = str; *p; p++)
+	{
+		*p = tolower(*p);
+	}
+}
 
-	if (!GetFieldData(m_field, &feedItemInfo, &strValue, &intValue))
+const char* FeedFilter::FieldValue::GetLowerText()
+{
+	if (!m_hasLowerText)
 	{
-		return false;
+		m_lowerText = GetText();
+		LowerStr(m_lowerText);
+		m_hasLowerText = true;
 	}
+	return m_lowerText;
+}
 
-	bool match = MatchValue(strValue, intValue);
+std::vector<const char*>* FeedFilter::FieldValue::GetWords()
+{
+	if (!m_hasWords)
+	{
+		m_wordBuf = GetText();
+		Tokenizer tok(m_wordBuf, WORD_SEPARATORS, true);
+		while (const char* word = tok.Next())
+		{
+			m_words.push_back(word);
+		}
+		m_hasWords = true;
+	}
+	return &m_words;
+}
 
-	if (m_positive != match)
+void FeedFilter::FieldValue::Clear()
+{
+	m_extracted = false;
+	m_strValue = nullptr;
+	m_intValue = 0;
+	m_hasLowerText = false;
+	m_hasWords = false;
+	m_words.clear();
+}
+
+FeedFilter::FieldValue* FeedFilter::ItemContext::GetField(EField field, const char* attrName)
+{
+	FieldValue* value = nullptr;
+
+	if (field == ffAttr)
 	{
-		return false;
+		for (AttrValue& attrValue : m_attrs)
+		{
+			if (!strcmp(attrValue.m_name, attrName))
+			{
+				value = &attrValue.m_value;
+				break;
+			}
+		}
+		if (!value)
+		{
+			m_attrs.emplace_back(attrName);
+			value = &m_attrs.back().m_value;
+		}
+	}
+	else
+	{
+		value = &m_fields[field];
 	}
 
-	return true;
+	if (!value->m_extracted)
+	{
+		Extract(field, attrName, value);
+		value->m_floatValue = value->m_strValue ? atof(value->m_strValue) : (double)value->m_intValue;
+		if (!value->m_strValue)
+		{
+			value->m_intText.Format("%" PRId64, value->m_intValue);
+		}
+		value->m_extracted = true;
+	}
+
+	return value;
 }
 
-bool FeedFilter::Term::MatchValue(const char* strValue, int64 intValue)
+void FeedFilter::ItemContext::Extract(EField field, const char* attrName, FieldValue* value)
 {
-	double fFloatValue = (double)intValue;
-	BString<100> intBuf;
+	switch (field)
+	{
+		case ffTitle:
+			value->m_strValue = m_feedItemInfo.GetTitle();
+			break;
+
+		case ffFilename:
+			value->m_strValue = m_feedItemInfo.GetFilename();
+			break;
+
+		case ffCategory:
+			value->m_strValue = m_feedItemInfo.GetCategory();
+			break;
+
+		case ffUrl:
+			value->m_strValue = m_feedItemInfo.GetUrl();
+			break;
+
+		case ffSize:
+			value->m_intValue = m_feedItemInfo.GetSize();
+			break;
+
+		case ffAge:
+			value->m_intValue = m_curTime - m_feedItemInfo.GetTime();
+			break;
+
+		case ffImdbId:
+			value->m_intValue = m_feedItemInfo.GetImdbId();
+			break;
+
+		case ffRageId:
+			value->m_intValue = m_feedItemInfo.GetRageId();
+			break;
+
+		case ffTvdbId:
+			value->m_intValue = m_feedItemInfo.GetTvdbId();
+			break;
+
+		case ffTvmazeId:
+			value->m_intValue = m_feedItemInfo.GetTvmazeId();
+			break;
+
+		case ffDescription:
+			value->m_strValue = m_feedItemInfo.GetDescription();
+			break;
+
+		case ffSeason:
+			value->m_intValue = m_feedItemInfo.GetSeasonNum();
+			break;
+
+		case ffEpisode:
+			value->m_intValue = m_feedItemInfo.GetEpisodeNum();
+			break;
 
-	if (m_command < fcEqual && !strValue)
+		case ffPriority:
+			value->m_intValue = m_feedItemInfo.GetPriority();
+			break;
+
+		case ffDupeKey:
+			value->m_strValue = m_feedItemInfo.GetDupeKey();
+			break;
+
+		case ffDupeScore:
+			value->m_intValue = m_feedItemInfo.GetDupeScore();
+			break;
+
+		case ffDupeStatus:
+			value->m_strValue = m_feedItemInfo.GetDupeStatus();
+			break;
+
+		case ffAttr:
+		{
+			FeedItemInfo::Attr* attr = m_feedItemInfo.GetAttributes()->Find(attrName);
+			value->m_strValue = attr ? attr->GetValue() : nullptr;
+			break;
+		}
+	}
+}
+
+/*
+ * Must be called after the feed item was modified by a rule (options "priority", "dupekey", etc.)
+ */
+void FeedFilter::ItemContext::Reset()
+{
+	for (FieldValue& value : m_fields)
 	{
-		intBuf.Format("%" PRId64, intValue);
-		strValue = intBuf;
+		value.Clear();
 	}
+	m_attrs.clear();
+}
+
+bool FeedFilter::Term::Match(ItemContext& context)
+{
+	FieldValue* value = context.GetField(m_fieldId, m_fieldId == ffAttr ? m_field + 5 : nullptr);
+
+	bool match = MatchValue(value);
 
-	else if (m_command >= fcEqual && strValue)
+	if (m_positive != match)
 	{
-		fFloatValue = atof(strValue);
-		intValue = (int64)fFloatValue;
+		return false;
 	}
 
+	return true;
+}
+
+bool FeedFilter::Term::MatchValue(FieldValue* value)
+{
+	double fFloatValue = value->m_floatValue;
+	int64 intValue = value->m_strValue ? (int64)fFloatValue : value->m_intValue;
+
 	switch (m_command)
 	{
 		case fcText:
-			return MatchText(strValue);
+			return MatchText(value);
 
 		case fcRegex:
-			return MatchRegex(strValue);
+			// quick check for a literal which must be present in any matching string
+			if (!m_literal.Empty() && !strstr(value->GetLowerText(), m_literal))
+			{
+				return false;
+			}
+			return MatchRegex(value->GetText());
 
 		case fcEqual:
 			return m_float ? fFloatValue == m_floatParam : intValue == m_intParam;
@@ -89,85 +254,92 @@ bool FeedFilter::Term::MatchValue(const char* strValue, int64 intValue)
 	}
 }
 
-bool FeedFilter::Term::MatchText(const char* strValue)
+/*
+ * Decides between word-search and substring-search and prepares the mask;
+ * done once when the term is compiled.
+ */
+void FeedFilter::Term::PrepareText()
 {
-	const char* WORD_SEPARATORS = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
-
 	// first check if we should make word-search or substring-search
 	int paramLen = strlen(m_param);
-	bool substr = paramLen >= 2 && m_param[0] == '*' && m_param[paramLen-1] == '*';
-	if (!substr)
+	m_substr = paramLen >= 2 && m_param[0] == '*' && m_param[paramLen-1] == '*';
+	if (!m_substr)
 	{
 		for (const char* p = m_param; *p; p++)
 		{
 			char ch = *p;
 			if (strchr(WORD_SEPARATORS, ch) && ch != '*' && ch != '?' && ch != '#')
 			{
-				substr = true;
+				m_substr = true;
 				break;
 			}
 		}
 	}
 
-	bool match = false;
-
-	if (!substr)
+	if (!m_substr)
 	{
-		// Word-search
-
-		// split szStrValue into tokens
-		Tokenizer tok(strValue, WORD_SEPARATORS);
-		while (const char* word = tok.Next())
-		{
-			WildMask mask(m_param, m_refValues != nullptr);
-			match = mask.Match(word);
-			if (match)
-			{
-				FillWildMaskRefValues(word, &mask, 0);
-				break;
-			}
-		}
+		m_mask = std::make_unique<WildMask>(m_param, m_refValues != nullptr);
 	}
 	else
 	{
-		// Substring-search
-
-		int refOffset = 1;
+		m_refOffset = 1;
 		const char* format = "*%s*";
 		if (paramLen >= 2 && m_param[0] == '*' && m_param[paramLen-1] == '*')
 		{
 			format = "%s";
-			refOffset = 0;
+			m_refOffset = 0;
 		}
 		else if (paramLen >= 1 && m_param[0] == '*')
 		{
 			format = "%s*";
-			refOffset = 0;
+			m_refOffset = 0;
 		}
 		else if (paramLen >= 1 && m_param[paramLen-1] == '*')
 		{
 			format = "*%s";
 		}
 
-		WildMask mask(CString::FormatStr(format, *m_param), m_refValues != nullptr);
-		match = mask.Match(strValue);
+		m_mask = std::make_unique<WildMask>(CString::FormatStr(format, *m_param), m_refValues != nullptr);
+	}
+
+	m_literal = ExtractMaskLiteral(m_param);
+}
+
+bool FeedFilter::Term::MatchText(FieldValue* value)
+{
+	// quick check for a literal which must be present in any matching string
+	if (!m_literal.Empty() && !strstr(value->GetLowerText(), m_literal))
+	{
+		return false;
+	}
 
-		if (match)
+	if (!m_substr)
+	{
+		// Word-search
+		for (const char* word : *value->GetWords())
 		{
-			FillWildMaskRefValues(strValue, &mask, refOffset);
+			if (m_mask->Match(word))
+			{
+				FillWildMaskRefValues(word, m_mask.get(), 0);
+				return true;
+			}
 		}
+		return false;
 	}
 
-	return match;
+	// Substring-search
+	const char* strValue = value->GetText();
+	if (m_mask->Match(strValue))
+	{
+		FillWildMaskRefValues(strValue, m_mask.get(), m_refOffset);
+		return true;
+	}
+
+	return false;
 }
 
 bool FeedFilter::Term::MatchRegex(const char* strValue)
 {
-	if (!m_regEx)
-	{
-		m_regEx = std::make_unique<RegEx>(m_param, m_refValues == nullptr ? 0 : 100);
-	}
-
 	bool found = m_regEx->Match(strValue);
 	if (found)
 	{
@@ -176,6 +348,143 @@ bool FeedFilter::Term::MatchRegex(const char* strValue)
 	return found;
 }
 
+/*
+ * Returns the longest (lower case) part of the wildcard pattern without wildcard characters.
+ * Any string matching the pattern must contain that literal.
+ */
+CString FeedFilter::Term::ExtractMaskLiteral(const char* pattern)
+{
+	CString best = "";
+	const char* runStart = pattern;
+	for (const char* p = pattern; ; p++)
+	{
+		if (!*p || *p == '*' || *p == '?' || *p == '#')
+		{
+			if (p - runStart > best.Length())
+			{
+				best.Set(runStart, (int)(p - runStart));
+			}
+			if (!*p)
+			{
+				break;
+			}
+			runStart = p + 1;
+		}
+	}
+
+	LowerStr(best);
+	return best;
+}
+
+/*
+ * Returns the longest (lower case) literal, which must be present in any string
+ * matching the extended regular expression, or an empty string if no such literal
+ * could be determined. The analysis is conservative: patterns with alternatives
+ * have no literals, groups and bracket expressions split literals and characters
+ * followed by optional quantifiers are excluded.
+ */
+CString FeedFilter::Term::ExtractRegexLiteral(const char* pattern)
+{
+	CString best = "";
+	const char* runStart = nullptr;
+	int runLen = 0;
+	int depth = 0;
+
+	auto endRun = [&best, &runStart, &runLen]()
+		{
+			if (runLen > best.Length())
+			{
+				best.Set(runStart, runLen);
+			}
+			runLen = 0;
+		};
+
+	for (const char* p = pattern; *p; p++)
+	{
+		char ch = *p;
+		if (ch == '|')
+		{
+			return "";
+		}
+		else if (ch == '(')
+		{
+			endRun();
+			depth++;
+		}
+		else if (ch == ')')
+		{
+			endRun();
+			depth--;
+		}
+		else if (ch == '[')
+		{
+			endRun();
+			p++;
+			if (*p == '^') p++;
+			if (*p == ']') p++;
+			while (*p && *p != ']')
+			{
+				if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+				{
+					char term = p[1];
+					for (p += 2; *p && !(*p == term && p[1] == ']'); p++) ;
+					if (!*p)
+					{
+						return "";
+					}
+					p++;
+				}
+				p++;
+			}
+			if (!*p)
+			{
+				return "";
+			}
+		}
+		else if (ch == '\\')
+		{
+			endRun();
+			if (!*++p)
+			{
+				break;
+			}
+		}
+		else if (ch == '?' || ch == '*' || ch == '{')
+		{
+			// the preceding character is optional
+			if (runLen > 0)
+			{
+				runLen--;
+			}
+			endRun();
+			if (ch == '{')
+			{
+				for (; *p && *p != '}'; p++) ;
+				if (!*p)
+				{
+					return "";
+				}
+			}
+		}
+		else if (depth == 0 && ch > 0 && (isalnum(ch) || ch == ' ' || ch == '_' || ch == '-'))
+		{
+			if (runLen == 0)
+			{
+				runStart = p;
+			}
+			runLen++;
+		}
+		else
+		{
+			endRun();
+		}
+	}
+
+	endRun();
+	LowerStr(best);
+	return best;
+}
+
 bool FeedFilter::Term::Compile(char* token)
 {
 	debug("Token: %s", token);
@@ -267,9 +576,7 @@ bool FeedFilter::Term::Compile(char* token)
 
 	debug("%s, Field: %s, Command: %i, Param: %s", (m_positive ? "Positive" : "Negative"), field, m_command, token);
 
-	const char* strValue;
-	int64 intValue;
-	if (!GetFieldData(field, nullptr, &strValue, &intValue))
+	if (!ParseField(field))
 	{
 		return false;
 	}
@@ -282,110 +589,66 @@ bool FeedFilter::Term::Compile(char* token)
 	m_field = field;
 	m_param = token;
 
-	return true;
-}
-
-/*
- * If pFeedItemInfo is nullptr, only field name is validated
- */
-bool FeedFilter::Term::GetFieldData(const char* field, FeedItemInfo* feedItemInfo,
-	const char** StrValue, int64* IntValue)
-{
-	*StrValue = nullptr;
-	*IntValue = 0;
-
-	if (!field || !strcasecmp(field, "title"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetTitle() : nullptr;
-		return true;
-	}
-	else if (!strcasecmp(field, "filename"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetFilename() : nullptr;
-		return true;
-	}
-	else if (!strcasecmp(field, "category"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetCategory() : nullptr;
-		return true;
-	}
-	else if (!strcasecmp(field, "link") || !strcasecmp(field, "url"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetUrl() : nullptr;
-		return true;
-	}
-	else if (!strcasecmp(field, "size"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetSize() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "age"))
+	if (m_command == fcText)
 	{
-		*IntValue = feedItemInfo ? Util::CurrentTime() - feedItemInfo->GetTime() : 0;
-		return true;
+		PrepareText();
 	}
-	else if (!strcasecmp(field, "imdbid"))
+	else if (m_command == fcRegex)
 	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetImdbId() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "rageid"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetRageId() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "tvdbid"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetTvdbId() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "tvmazeid"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetTvmazeId() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "description"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetDescription() : nullptr;
-		return true;
-	}
-	else if (!strcasecmp(field, "season"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetSeasonNum() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "episode"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetEpisodeNum() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "priority"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetPriority() : 0;
-		return true;
-	}
-	else if (!strcasecmp(field, "dupekey"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetDupeKey() : nullptr;
-		return true;
-	}
-	else if (!strcasecmp(field, "dupescore"))
-	{
-		*IntValue = feedItemInfo ? feedItemInfo->GetDupeScore() : 0;
-		return true;
+		m_regEx = std::make_unique<RegEx>(m_param, m_refValues == nullptr ? 0 : 100);
+		m_literal = ExtractRegexLiteral(m_param);
 	}
-	else if (!strcasecmp(field, "dupestatus"))
-	{
-		*StrValue = feedItemInfo ? feedItemInfo->GetDupeStatus() : nullptr;
+
+	return true;
+}
+
+bool FeedFilter::Term::ParseField(const char* field)
+{
+	struct FieldName
+	{
+		const char* name;
+		EField field;
+	};
+
+	static const FieldName FIELD_NAMES[] = {
+		{"title", ffTitle},
+		{"filename", ffFilename},
+		{"category", ffCategory},
+		{"link", ffUrl},
+		{"url", ffUrl},
+		{"size", ffSize},
+		{"age", ffAge},
+		{"imdbid", ffImdbId},
+		{"rageid", ffRageId},
+		{"tvdbid", ffTvdbId},
+		{"tvmazeid", ffTvmazeId},
+		{"description", ffDescription},
+		{"season", ffSeason},
+		{"episode", ffEpisode},
+		{"priority", ffPriority},
+		{"dupekey", ffDupeKey},
+		{"dupescore", ffDupeScore},
+		{"dupestatus", ffDupeStatus}
+	};
+
+	if (!field)
+	{
+		m_fieldId = ffTitle;
 		return true;
 	}
-	else if (!strncasecmp(field, "attr-", 5))
+
+	for (const FieldName& fieldName : FIELD_NAMES)
 	{
-		if (feedItemInfo)
+		if (!strcasecmp(field, fieldName.name))
 		{
-			FeedItemInfo::Attr* attr = feedItemInfo->GetAttributes()->Find(field + 5);
-			*StrValue = attr ? attr->GetValue() : nullptr;
+			m_fieldId = fieldName.field;
+			return true;
 		}
+	}
+
+	if (!strncasecmp(field, "attr-", 5))
+	{
+		m_fieldId = ffAttr;
 		return true;
 	}
 
@@ -559,6 +822,15 @@ void FeedFilter::Rule::Compile(char* rule)
 
 	m_isValid = m_isValid && CompileTerm(term);
 
+	for (Term& term : m_terms)
+	{
+		if (term.GetCommand() == fcOpeningBrace || term.GetCommand() == fcClosingBrace ||
+			term.GetCommand() == fcOrOperator)
+		{
+			m_plainExpression = false;
+		}
+	}
+
 	if (m_isValid && m_hasPatCategory)
 	{
 		m_patCategory.Bind(m_category.Unbind());
@@ -789,15 +1061,17 @@ bool FeedFilter::Rule::CompileTerm(char* termstr)
 	return ok;
 }
 
-bool FeedFilter::Rule::Match(FeedItemInfo& feedItemInfo)
+bool FeedFilter::Rule::Match(ItemContext& context)
 {
 	m_refValues.clear();
 
-	if (!MatchExpression(feedItemInfo))
+	if (!MatchExpression(context))
 	{
 		return false;
 	}
 
+	FeedItemInfo& feedItemInfo = context.GetFeedItemInfo();
+
 	if (m_hasPatCategory)
 	{
 		ExpandRefValues(feedItemInfo, &m_category, m_patCategory);
@@ -814,8 +1088,21 @@ bool FeedFilter::Rule::Match(FeedItemInfo& feedItemInfo)
 	return true;
 }
 
-bool FeedFilter::Rule::MatchExpression(FeedItemInfo& feedItemInfo)
+bool FeedFilter::Rule::MatchExpression(ItemContext& context)
 {
+	if (m_plainExpression)
+	{
+		// no braces and no "OR"-operators: all terms must match
+		for (Term& term : m_terms)
+		{
+			if (!term.Match(context))
+			{
+				return false;
+			}
+		}
+		return !m_terms.empty();
+	}
+
 	CString expr;
 	expr.Reserve(m_terms.size());
 
@@ -837,7 +1124,7 @@ bool FeedFilter::Rule::MatchExpression(FeedItemInfo& feedItemInfo)
 				break;
 
 			default:
-				expr[index] = term.Match(feedItemInfo) ? 'T' : 'F';
+				expr[index] = term.Match(context) ? 'T' : 'F';
 				break;
 		}
 		index++;
@@ -959,13 +1246,35 @@ void FeedFilter::CompileRule(char* rulestr)
 
 void FeedFilter::Match(FeedItemInfo& feedItemInfo)
 {
+	ItemContext context(feedItemInfo, Util::CurrentTime());
+	Match(context);
+}
+
+/*
+ * Filters a batch of items. Field values of each item are extracted only once
+ * and shared by all rules; the current time (for field "age") is taken once per batch.
+ */
+void FeedFilter::Match(FeedItemList& feedItems)
+{
+	time_t curTime = Util::CurrentTime();
+	for (FeedItemInfo& feedItemInfo : feedItems)
+	{
+		ItemContext context(feedItemInfo, curTime);
+		Match(context);
+	}
+}
+
+void FeedFilter::Match(ItemContext& context)
+{
+	FeedItemInfo& feedItemInfo = context.GetFeedItemInfo();
+
 	int index = 0;
 	for (Rule& rule : m_rules)
 	{
 		index++;
 		if (rule.IsValid())
 		{
-			bool match = rule.Match(feedItemInfo);
+			bool match = rule.Match(context);
 			switch (rule.GetCommand())
 			{
 				case frAccept:
@@ -975,6 +1284,7 @@ void FeedFilter::Match(FeedItemInfo& feedItemInfo)
 						feedItemInfo.SetMatchStatus(FeedItemInfo::msAccepted);
 						feedItemInfo.SetMatchRule(index);
 						ApplyOptions(rule, feedItemInfo);
+						context.Reset();
 						if (rule.GetCommand() == frAccept)
 						{
 							return;
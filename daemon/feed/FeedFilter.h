@@ -31,10 +31,85 @@ class FeedFilter
 public:
 	FeedFilter(const char* filter);
 	void Match(FeedItemInfo& feedItemInfo);
+	void Match(FeedItemList& feedItems);
 
 private:
 	typedef std::vector<CString> RefValues;
 
+	enum EField
+	{
+		ffTitle,
+		ffFilename,
+		ffCategory,
+		ffUrl,
+		ffSize,
+		ffAge,
+		ffImdbId,
+		ffRageId,
+		ffTvdbId,
+		ffTvmazeId,
+		ffDescription,
+		ffSeason,
+		ffEpisode,
+		ffPriority,
+		ffDupeKey,
+		ffDupeScore,
+		ffDupeStatus,
+		ffAttr
+	};
+
+	/*
+	 * Value of a field of a feed item, extracted once per item and shared by all terms.
+	 * Text representation, its lower case version and the list of words
+	 * are prepared on first use.
+	 */
+	struct FieldValue
+	{
+		bool m_extracted = false;
+		const char* m_strValue = nullptr;
+		int64 m_intValue = 0;
+		double m_floatValue = 0.0;
+		BString<100> m_intText;
+		CString m_lowerText;
+		CString m_wordBuf;
+		std::vector<const char*> m_words;
+		bool m_hasLowerText = false;
+		bool m_hasWords = false;
+
+		const char* GetText() { return m_strValue ? m_strValue : *m_intText; }
+		void Clear();
+		const char* GetLowerText();
+		std::vector<const char*>* GetWords();
+	};
+
+	class ItemContext
+	{
+	public:
+		ItemContext(FeedItemInfo& feedItemInfo, time_t curTime) :
+			m_feedItemInfo(feedItemInfo), m_curTime(curTime) {}
+		FeedItemInfo& GetFeedItemInfo() { return m_feedItemInfo; }
+		FieldValue* GetField(EField field, const char* attrName);
+		void Reset();
+
+	private:
+		struct AttrValue
+		{
+			CString m_name;
+			FieldValue m_value;
+
+			AttrValue(const char* name) : m_name(name) {}
+		};
+
+		typedef std::deque<AttrValue> AttrValues;
+
+		FeedItemInfo& m_feedItemInfo;
+		time_t m_curTime;
+		FieldValue m_fields[ffAttr];
+		AttrValues m_attrs;
+
+		void Extract(EField field, const char* attrName, FieldValue* value);
+	};
+
 	enum ETermCommand
 	{
 		fcText,
@@ -56,28 +131,35 @@ private:
 		Term(Term&&) = delete; // catch performance issues
 		void SetRefValues(RefValues* refValues) { m_refValues = refValues; }
 		bool Compile(char* token);
-		bool Match(FeedItemInfo& feedItemInfo);
+		bool Match(ItemContext& context);
 		ETermCommand GetCommand() { return m_command; }
+		static CString ExtractMaskLiteral(const char* pattern);
+		static CString ExtractRegexLiteral(const char* pattern);
 
 	private:
 		bool m_positive;
 		CString m_field;
+		EField m_fieldId = ffTitle;
 		ETermCommand m_command;
 		CString m_param;
 		int64 m_intParam = 0;
 		double m_floatParam = 0.0;
 		bool m_float = false;
+		bool m_substr = false;
+		int m_refOffset = 0;
+		CString m_literal;
+		std::unique_ptr<WildMask> m_mask;
 		std::unique_ptr<RegEx> m_regEx;
 		RefValues* m_refValues = nullptr;
 
-		bool GetFieldData(const char* field, FeedItemInfo* feedItemInfo,
-			const char** StrValue, int64* IntValue);
+		bool ParseField(const char* field);
 		bool ParseParam(const char* field, const char* param);
 		bool ParseSizeParam(const char* param);
 		bool ParseAgeParam(const char* param);
 		bool ParseNumericParam(const char* param);
-		bool MatchValue(const char* strValue, int64 intValue);
-		bool MatchText(const char* strValue);
+		void PrepareText();
+		bool MatchValue(FieldValue* value);
+		bool MatchText(FieldValue* value);
 		bool MatchRegex(const char* strValue);
 		void FillWildMaskRefValues(const char* strValue, WildMask* mask, int refOffset);
 		void FillRegExRefValues(const char* strValue, RegEx* regEx);
@@ -128,7 +210,7 @@ private:
 		bool HasTvdbId() { return m_hasTvdbId; }
 		bool HasTvmazeId() { return m_hasTvmazeId; }
 		bool HasSeries() { return m_hasSeries; }
-		bool Match(FeedItemInfo& feedItemInfo);
+		bool Match(ItemContext& context);
 		void ExpandRefValues(FeedItemInfo& feedItemInfo, CString* destStr, const char* patStr);
 		const char* GetRefValue(FeedItemInfo& feedItemInfo, const char* varName);
 
@@ -164,6 +246,7 @@ private:
 		bool m_hasRageId = false;
 		bool m_hasTvdbId = false;
 		bool m_hasTvmazeId = false;
+		bool m_plainExpression = true;
 		CString m_patCategory;
 		CString m_patDupeKey;
 		CString m_patAddDupeKey;
@@ -173,7 +256,7 @@ private:
 		char* CompileCommand(char* rule);
 		char* CompileOptions(char* rule);
 		bool CompileTerm(char* term);
-		bool MatchExpression(FeedItemInfo& feedItemInfo);
+		bool MatchExpression(ItemContext& context);
 	};
 
 	typedef std::deque<Rule> RuleList;
@@ -182,6 +265,7 @@ private:
 
 	void Compile(const char* filter);
 	void CompileRule(char* rule);
+	void Match(ItemContext& context);
 	void ApplyOptions(Rule& rule, FeedItemInfo& feedItemInfo);
 };
 
@@ -25,6 +25,9 @@
 #include "Util.h"
 #include "DownloadInfo.h"
 
+class FeedItemInfo;
+typedef std::deque<FeedItemInfo> FeedItemList;
+
 class FeedInfo
 {
 public:
@@ -67,6 +70,12 @@ public:
 	void SetForce(bool force) { m_force = force; }
 	bool GetBacklog() { return m_backlog; }
 	void SetBacklog(bool backlog) { m_backlog = backlog; }
+	const char* GetETag() { return m_etag; }
+	void SetETag(const char* etag) { m_etag = etag; }
+	const char* GetLastModified() { return m_lastModified; }
+	void SetLastModified(const char* lastModified) { m_lastModified = lastModified; }
+	std::shared_ptr<FeedItemList> GetFeedItems() { return m_feedItems; }
+	void SetFeedItems(std::shared_ptr<FeedItemList> feedItems) { m_feedItems = feedItems; }
 
 private:
 	int m_id;
@@ -88,6 +97,9 @@ private:
 	CString m_outputFilename;
 	bool m_fetch = false;
 	bool m_force = false;
+	CString m_etag;
+	CString m_lastModified;
+	std::shared_ptr<FeedItemList> m_feedItems;
 };
 
 typedef std::deque<std::unique_ptr<FeedInfo>> Feeds;
@@ -189,6 +201,7 @@ public:
 	EDupeMode GetDupeMode() { return m_dupeMode; }
 	void SetDupeMode(EDupeMode dupeMode) { m_dupeMode = dupeMode; }
 	const char* GetDupeStatus();
+	void ResetDupeStatus() { m_dupeStatus = nullptr; }
 	Attributes* GetAttributes() { return &m_attributes; }
 
 private:
@@ -225,8 +238,6 @@ private:
 	void ParseSeasonEpisode();
 };
 
-typedef std::deque<FeedItemInfo> FeedItemList;
-
 class FeedHistoryInfo
 {
 public:
@@ -90,7 +90,11 @@ static const char* OPTION_PARCHECK				= "ParCheck";
 static const char* OPTION_PARREPAIR				= "ParRepair";
 static const char* OPTION_PARSCAN				= "ParScan";
 static const char* OPTION_PARQUICK				= "ParQuick";
+static const char* OPTION_DIRECTPARCHECK		= "DirectParCheck";
 static const char* OPTION_POSTSTRATEGY			= "PostStrategy";
+static const char* OPTION_POSTCPUJOBS			= "PostCpuJobs";
+static const char* OPTION_POSTDISKJOBS			= "PostDiskJobs";
+static const char* OPTION_POSTSCRIPTJOBS		= "PostScriptJobs";
 static const char* OPTION_FILENAMING			= "FileNaming";
 static const char* OPTION_PARRENAME				= "ParRename";
 static const char* OPTION_PARBUFFER				= "ParBuffer";
@@ -111,6 +115,7 @@ static const char* OPTION_NZBDIRFILEAGE			= "NzbDirFileAge";
 static const char* OPTION_DISKSPACE				= "DiskSpace";
 static const char* OPTION_CRASHTRACE			= "CrashTrace";
 static const char* OPTION_CRASHDUMP				= "CrashDump";
+static const char* OPTION_LOCKPROFILING			= "LockProfiling";
 static const char* OPTION_PARPAUSEQUEUE			= "ParPauseQueue";
 static const char* OPTION_SCRIPTPAUSEQUEUE		= "ScriptPauseQueue";
 static const char* OPTION_NZBCLEANUPDISK		= "NzbCleanupDisk";
@@ -123,6 +128,7 @@ static const char* OPTION_UNRARCMD				= "UnrarCmd";
 static const char* OPTION_SEVENZIPCMD			= "SevenZipCmd";
 static const char* OPTION_UNPACKPASSFILE		= "UnpackPassFile";
 static const char* OPTION_UNPACKPAUSEQUEUE		= "UnpackPauseQueue";
+static const char* OPTION_UNPACKTHREADS			= "UnpackThreads";
 static const char* OPTION_SCRIPTORDER			= "ScriptOrder";
 static const char* OPTION_EXTENSIONS			= "Extensions";
 static const char* OPTION_EXTCLEANUPDISK		= "ExtCleanupDisk";
@@ -469,7 +475,11 @@ void Options::InitDefaults()
 	SetOption(OPTION_PARREPAIR, "yes");
 	SetOption(OPTION_PARSCAN, "extended");
 	SetOption(OPTION_PARQUICK, "yes");
+	SetOption(OPTION_DIRECTPARCHECK, "no");
 	SetOption(OPTION_POSTSTRATEGY, "sequential");
+	SetOption(OPTION_POSTCPUJOBS, "1");
+	SetOption(OPTION_POSTDISKJOBS, "1");
+	SetOption(OPTION_POSTSCRIPTJOBS, "2");
 	SetOption(OPTION_FILENAMING, "article");
 	SetOption(OPTION_PARRENAME, "yes");
 	SetOption(OPTION_PARBUFFER, "16");
@@ -493,6 +503,7 @@ void Options::InitDefaults()
 	SetOption(OPTION_DISKSPACE, "250");
 	SetOption(OPTION_CRASHTRACE, "no");
 	SetOption(OPTION_CRASHDUMP, "no");
+	SetOption(OPTION_LOCKPROFILING, "no");
 	SetOption(OPTION_PARPAUSEQUEUE, "no");
 	SetOption(OPTION_SCRIPTPAUSEQUEUE, "no");
 	SetOption(OPTION_NZBCLEANUPDISK, "no");
@@ -510,6 +521,7 @@ void Options::InitDefaults()
 #endif
 	SetOption(OPTION_UNPACKPASSFILE, "");
 	SetOption(OPTION_UNPACKPAUSEQUEUE, "no");
+	SetOption(OPTION_UNPACKTHREADS, "1");
 	SetOption(OPTION_EXTCLEANUPDISK, "");
 	SetOption(OPTION_PARIGNOREEXT, "");
 	SetOption(OPTION_UNPACKIGNOREEXT, "");
@@ -725,6 +737,10 @@ void Options::InitOptions()
 	m_eventInterval			= ParseIntValue(OPTION_EVENTINTERVAL, 10);
 	m_parBuffer				= ParseIntValue(OPTION_PARBUFFER, 10);
 	m_parThreads			= ParseIntValue(OPTION_PARTHREADS, 10);
+	m_unpackThreads			= ParseIntValue(OPTION_UNPACKTHREADS, 10);
+	m_postCpuJobs			= ParseIntValue(OPTION_POSTCPUJOBS, 10);
+	m_postDiskJobs			= ParseIntValue(OPTION_POSTDISKJOBS, 10);
+	m_postScriptJobs		= ParseIntValue(OPTION_POSTSCRIPTJOBS, 10);
 	m_monthlyQuota			= ParseIntValue(OPTION_MONTHLYQUOTA, 10);
 	m_quotaStartDay			= ParseIntValue(OPTION_QUOTASTARTDAY, 10);
 	m_dailyQuota			= ParseIntValue(OPTION_DAILYQUOTA, 10);
@@ -736,6 +752,7 @@ void Options::InitOptions()
 	m_dupeCheck				= (bool)ParseEnumValue(OPTION_DUPECHECK, BoolCount, BoolNames, BoolValues);
 	m_parRepair				= (bool)ParseEnumValue(OPTION_PARREPAIR, BoolCount, BoolNames, BoolValues);
 	m_parQuick				= (bool)ParseEnumValue(OPTION_PARQUICK, BoolCount, BoolNames, BoolValues);
+	m_directParCheck		= (bool)ParseEnumValue(OPTION_DIRECTPARCHECK, BoolCount, BoolNames, BoolValues);
 	m_parRename				= (bool)ParseEnumValue(OPTION_PARRENAME, BoolCount, BoolNames, BoolValues);
 	m_rarRename				= (bool)ParseEnumValue(OPTION_RARRENAME, BoolCount, BoolNames, BoolValues);
 	m_directRename			= (bool)ParseEnumValue(OPTION_DIRECTRENAME, BoolCount, BoolNames, BoolValues);
@@ -748,6 +765,7 @@ void Options::InitOptions()
 	m_skipWrite				= (bool)ParseEnumValue(OPTION_SKIPWRITE, BoolCount, BoolNames, BoolValues);
 	m_crashTrace			= (bool)ParseEnumValue(OPTION_CRASHTRACE, BoolCount, BoolNames, BoolValues);
 	m_crashDump				= (bool)ParseEnumValue(OPTION_CRASHDUMP, BoolCount, BoolNames, BoolValues);
+	m_lockProfiling			= (bool)ParseEnumValue(OPTION_LOCKPROFILING, BoolCount, BoolNames, BoolValues);
 	m_parPauseQueue			= (bool)ParseEnumValue(OPTION_PARPAUSEQUEUE, BoolCount, BoolNames, BoolValues);
 	m_scriptPauseQueue		= (bool)ParseEnumValue(OPTION_SCRIPTPAUSEQUEUE, BoolCount, BoolNames, BoolValues);
 	m_nzbCleanupDisk		= (bool)ParseEnumValue(OPTION_NZBCLEANUPDISK, BoolCount, BoolNames, BoolValues);
@@ -776,9 +794,9 @@ void Options::InitOptions()
 	const int ParScanCount = 4;
 	m_parScan = (EParScan)ParseEnumValue(OPTION_PARSCAN, ParScanCount, ParScanNames, ParScanValues);
 
-	const char* PostStrategyNames[] = { "sequential", "balanced", "aggressive", "rocket" };
-	const int PostStrategyValues[] = { ppSequential, ppBalanced, ppAggressive, ppRocket };
-	const int PostStrategyCount = 4;
+	const char* PostStrategyNames[] = { "sequential", "balanced", "aggressive", "rocket", "staged" };
+	const int PostStrategyValues[] = { ppSequential, ppBalanced, ppAggressive, ppRocket, ppStaged };
+	const int PostStrategyCount = 5;
 	m_postStrategy = (EPostStrategy)ParseEnumValue(OPTION_POSTSTRATEGY, PostStrategyCount, PostStrategyNames, PostStrategyValues);
 
 	const char* FileNamingNames[] = { "auto", "article", "nzb" };
@@ -1760,6 +1778,11 @@ void Options::CheckOptions()
 		LocateOptionSrcPos(OPTION_DIRECTRENAME);
 		ConfigError("Invalid value for option \"%s\": program was compiled without parcheck-support", OPTION_DIRECTRENAME);
 	}
+	if (m_directParCheck)
+	{
+		LocateOptionSrcPos(OPTION_DIRECTPARCHECK);
+		ConfigError("Invalid value for option \"%s\": program was compiled without parcheck-support", OPTION_DIRECTPARCHECK);
+	}
 #endif
 
 #ifdef DISABLE_CURSES
@@ -1821,6 +1844,7 @@ void Options::CheckOptions()
 	if (m_skipWrite)
 	{
 		m_directRename = false;
+		m_directParCheck = false;
 	}
 
 	// if option "ConfigTemplate" is not set, use "WebDir" as default location for template
@@ -90,7 +90,8 @@ public:
 		ppSequential,
 		ppBalanced,
 		ppAggressive,
-		ppRocket
+		ppRocket,
+		ppStaged
 	};
 	enum EFileNaming
 	{
@@ -250,7 +251,11 @@ public:
 	bool GetParRepair() { return m_parRepair; }
 	EParScan GetParScan() { return m_parScan; }
 	bool GetParQuick() { return m_parQuick; }
+	bool GetDirectParCheck() { return m_directParCheck; }
 	EPostStrategy GetPostStrategy() { return m_postStrategy; }
+	int GetPostCpuJobs() { return m_postCpuJobs; }
+	int GetPostDiskJobs() { return m_postDiskJobs; }
+	int GetPostScriptJobs() { return m_postScriptJobs; }
 	bool GetParRename() { return m_parRename; }
 	int GetParBuffer() { return m_parBuffer; }
 	int GetParThreads() { return m_parThreads; }
@@ -272,6 +277,7 @@ public:
 	bool GetTls() { return m_tls; }
 	bool GetCrashTrace() { return m_crashTrace; }
 	bool GetCrashDump() { return m_crashDump; }
+	bool GetLockProfiling() { return m_lockProfiling; }
 	bool GetParPauseQueue() { return m_parPauseQueue; }
 	bool GetScriptPauseQueue() { return m_scriptPauseQueue; }
 	bool GetNzbCleanupDisk() { return m_nzbCleanupDisk; }
@@ -284,6 +290,7 @@ public:
 	const char* GetSevenZipCmd() { return m_sevenZipCmd; }
 	const char* GetUnpackPassFile() { return m_unpackPassFile; }
 	bool GetUnpackPauseQueue() { return m_unpackPauseQueue; }
+	int GetUnpackThreads() { return m_unpackThreads; }
 	const char* GetExtCleanupDisk() { return m_extCleanupDisk; }
 	const char* GetParIgnoreExt() { return m_parIgnoreExt; }
 	const char* GetUnpackIgnoreExt() { return m_unpackIgnoreExt; }
@@ -383,7 +390,11 @@ private:
 	bool m_parRepair = false;
 	EParScan m_parScan = psLimited;
 	bool m_parQuick = true;
+	bool m_directParCheck = false;
 	EPostStrategy m_postStrategy = ppSequential;
+	int m_postCpuJobs = 1;
+	int m_postDiskJobs = 1;
+	int m_postScriptJobs = 2;
 	bool m_parRename = false;
 	int m_parBuffer = 0;
 	int m_parThreads = 0;
@@ -406,6 +417,7 @@ private:
 	bool m_tls = false;
 	bool m_crashTrace = false;
 	bool m_crashDump = false;
+	bool m_lockProfiling = false;
 	bool m_parPauseQueue = false;
 	bool m_scriptPauseQueue = false;
 	bool m_nzbCleanupDisk = false;
@@ -418,6 +430,7 @@ private:
 	CString m_sevenZipCmd;
 	CString m_unpackPassFile;
 	bool m_unpackPauseQueue;
+	int m_unpackThreads = 1;
 	CString m_extCleanupDisk;
 	CString m_parIgnoreExt;
 	CString m_unpackIgnoreExt;
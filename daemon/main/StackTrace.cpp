@@ -204,7 +204,8 @@ void PrintBacktrace()
 		printf("%s\n", strings[i]);
 	}
 
-	// then trace to log
+	// then trace to log; errors are written synchronously, bypassing the
+	// queue of the log writer, and are on disk before the program terminates
 	error("Segmentation fault, tracing...");
 	error("Obtained %zd stack frames", size);
 	for (i = 0; i < size; i++)
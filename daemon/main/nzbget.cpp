@@ -322,6 +322,9 @@ void NZBGet::Init()
 	{
 		m_serverPool->InitConnections();
 		m_statMeter->Init();
+
+		// the writer thread must be started after forking into background
+		m_log->StartWriter();
 	}
 
 	InstallErrorHandler();
@@ -170,6 +170,11 @@ using namespace MSXML;
 #include <sys/wait.h>
 #include <sys/un.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#ifdef HAVE_POSIX_SPAWN_SETSID
+#include <spawn.h>
+#endif
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <stdint.h>
@@ -195,6 +200,11 @@ using namespace MSXML;
 #include <execinfo.h>
 #endif
 
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#endif
+
 #endif /* POSIX INCLUDES */
 
 // COMMON INCLUDES
@@ -227,6 +237,7 @@ using namespace MSXML;
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <atomic>
 
 // NOTE: do not include <iostream> in "nzbget.h". <iostream> contains objects requiring
 // intialization, causing every unit in nzbget to have initialization routine. This in particular
@@ -357,7 +368,11 @@ extern "C" FILE * __cdecl __iob_func(void) { return _iob; }
 #define FOPEN_RBP "rb+"
 #define FOPEN_WB "wb"
 #define FOPEN_AB "ab"
+#if defined(HAVE_POSIX_SPAWN_ADDCHDIR) && defined(HAVE_POSIX_SPAWN_SETSID)
+#define USE_POSIX_SPAWN 1
+#else
 #define CHILD_WATCHDOG 1
+#endif
 
 #endif /* POSIX */
 
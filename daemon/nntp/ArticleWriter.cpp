@@ -25,6 +25,8 @@
 #include "Log.h"
 #include "Util.h"
 #include "FileSystem.h"
+#include "RarReader.h"
+#include "PerfStats.h"
 
 CachedSegmentData::~CachedSegmentData()
 {
@@ -147,6 +149,8 @@ bool ArticleWriter::Start(Decoder::EFormat format, const char* filename, int64 f
 
 bool ArticleWriter::Write(char* buffer, int len)
 {
+	PerfTimer timer(PerfStats::pmArticleWrite);
+
 	if (!g_Options->GetRawArticle())
 	{
 		m_articlePtr += len;
@@ -438,12 +442,7 @@ void ArticleWriter::CompleteFileParts()
 				DiskFile infile;
 				if (pa->GetResultFilename() && infile.Open(pa->GetResultFilename(), DiskFile::omRead))
 				{
-					int cnt = buffer.Size();
-					while (cnt == buffer.Size())
-					{
-						cnt = (int)infile.Read(buffer, buffer.Size());
-						outfile.Write(buffer, cnt);
-					}
+					outfile.CopyFrom(infile);
 					infile.Close();
 				}
 				else
@@ -541,11 +540,29 @@ void ArticleWriter::CompleteFileParts()
 		m_fileInfo->GetNzbInfo()->PrintMessage(Message::mkInfo, "Partially downloaded %s", *infoFilename);
 	}
 
+	// index rar-headers while the file is still in the system cache,
+	// rar-renamer, direct unpack and unpack then don't need to read the volume again
+	CString rarInfo;
+	if (!g_Options->GetRawArticle() && !g_Options->GetSkipWrite() &&
+		m_fileInfo->GetTotalArticles() == m_fileInfo->GetSuccessArticles())
+	{
+		RarVolume volume(ofn);
+		if (volume.Read())
+		{
+			rarInfo = volume.Serialize();
+			if (rarInfo.Length() > CompletedFile::MAX_RARINFO_SIZE)
+			{
+				rarInfo.Clear();
+			}
+		}
+	}
+
 	{
 		GuardedDownloadQueue guard = DownloadQueue::Guard();
 
 		m_fileInfo->SetCrc(crc);
 		m_fileInfo->SetOutputFilename(ofn);
+		m_fileInfo->SetRarInfo(rarInfo);
 
 		if (strcmp(m_fileInfo->GetFilename(), filename))
 		{
@@ -570,6 +587,8 @@ void ArticleWriter::CompleteFileParts()
 
 void ArticleWriter::FlushCache()
 {
+	PerfTimer timer(PerfStats::pmCacheFlush);
+
 	detail("Flushing cache for %s", *m_infoName);
 
 	bool directWrite = g_Options->GetDirectWrite() && m_fileInfo->GetOutputInitialized();
@@ -23,6 +23,7 @@
 #include "Log.h"
 #include "Util.h"
 #include "YEncode.h"
+#include "PerfStats.h"
 
 Decoder::Decoder()
 {
@@ -62,6 +63,8 @@ void Decoder::Clear()
  */
 int Decoder::DecodeBuffer(char* buffer, int len)
 {
+	PerfTimer timer(PerfStats::pmDecode);
+
 	if (m_rawMode)
 	{
 		ProcessRaw(buffer, len);
@@ -0,0 +1,314 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "nzbget.h"
+#include "FaultInjector.h"
+#include "Util.h"
+#include "FileSystem.h"
+#include "Log.h"
+
+static const char* FAULT_NAMES[] = { "none", "missing", "truncate", "corrupt", "stall", "reset", "tlsdelay" };
+static const int FAULT_DEFAULTS[] = { 0, 0, 50, 0, 60, 50, 5000 };
+static const int REPORT_INTERVAL = 10;
+static const int MAX_TRACKED_ATTEMPTS = 100000;
+
+/*
+ Scenario file format, one directive per line, "#" starts a comment:
+   seed <number>
+       initial value for the random generator (default is 0);
+   at <seconds>
+       the following rules become active at the given time after start,
+       replacing the rules of the previous section;
+   <server> <fault> <percent> [<param>]
+       server - server instance id (1..n) or "*" for all instances;
+       fault  - one of:
+           missing  - reply with "430 No Such Article Found"; the article
+                      stays missing on this server in all attempts;
+           truncate - send only <param> percent of the article body
+                      (default 50) and terminate the response;
+           corrupt  - change one byte in the middle of the yEnc-data,
+                      the article fails CRC check;
+           stall    - send half of the article, then stop responding for
+                      <param> seconds (default 60) and close the connection;
+           reset    - send <param> percent of the article (default 50)
+                      and reset the connection;
+           tlsdelay - delay TLS handshake by <param> milliseconds
+                      (default 5000), the rate applies per connection;
+       percent - probability of the fault, 0..100 (fractions allowed).
+ Example:
+   seed 42
+   * missing 2
+   2 corrupt 5
+   at 60
+   1 reset 100
+*/
+bool FaultInjector::Load(const char* filename)
+{
+	DiskFile infile;
+	if (!infile.Open(filename, DiskFile::omRead))
+	{
+		error("Could not open file %s: %s", filename, *FileSystem::GetLastErrorMessage());
+		return false;
+	}
+
+	int64 startTime = 0;
+	int lineNo = 0;
+	char buf[1024];
+	while (infile.ReadLine(buf, sizeof(buf)))
+	{
+		lineNo++;
+		if (!ParseLine(buf, startTime))
+		{
+			error("Invalid line %i in scenario file %s", lineNo, filename);
+			return false;
+		}
+	}
+
+	m_startTime = Util::CurrentTicks();
+	m_lastReport = m_startTime;
+
+	info("Loaded %i fault rules from %s", (int)m_rules.size(), filename);
+	return true;
+}
+
+bool FaultInjector::ParseLine(char* line, int64& startTime)
+{
+	char* comment = strchr(line, '#');
+	if (comment)
+	{
+		*comment = '\0';
+	}
+
+	Tokenizer tok(line, " \t\r\n", true);
+	const char* first = tok.Next();
+	if (!first)
+	{
+		return true;
+	}
+
+	if (!strcmp(first, "seed"))
+	{
+		const char* value = tok.Next();
+		m_seed = value ? (uint32)strtoul(value, nullptr, 10) : 0;
+		return value && !tok.Next();
+	}
+
+	if (!strcmp(first, "at"))
+	{
+		const char* value = tok.Next();
+		startTime = value ? (int64)(atof(value) * 1000000) : -1;
+		if (!value || startTime < 0 || tok.Next())
+		{
+			return false;
+		}
+		m_sections.push_back(startTime);
+		return true;
+	}
+
+	const char* kindName = tok.Next();
+	const char* rate = tok.Next();
+	const char* param = tok.Next();
+	if (!kindName || !rate || tok.Next())
+	{
+		return false;
+	}
+
+	Rule rule;
+	rule.startTime = startTime;
+	rule.serverId = strcmp(first, "*") ? atoi(first) : 0;
+	rule.kind = fkNone;
+	for (int i = fkMissing; i <= fkTlsDelay; i++)
+	{
+		if (!strcmp(kindName, FAULT_NAMES[i]))
+		{
+			rule.kind = (EKind)i;
+		}
+	}
+	rule.rate = (int)(atof(rate) * 100);
+	rule.param = param ? atoi(param) : FAULT_DEFAULTS[rule.kind];
+
+	if (rule.kind == fkNone || (rule.serverId <= 0 && strcmp(first, "*")) ||
+		rule.rate < 0 || rule.rate > 10000 || rule.param < 0 ||
+		((rule.kind == fkTruncate || rule.kind == fkReset) && rule.param > 100))
+	{
+		return false;
+	}
+
+	m_rules.push_back(rule);
+	return true;
+}
+
+FaultInjector::Fault FaultInjector::GetArticleFault(int serverId, const char* messageid)
+{
+	Guard guard(m_mutex);
+
+	BString<1024> key("%i%s", serverId, messageid);
+	int attempt = NextAttempt(key);
+
+	Fault fault = Evaluate(serverId, key, attempt, false);
+
+	Statistics& statistics = m_statistics[serverId];
+	statistics.requests++;
+	statistics.faults[fault.kind]++;
+	m_changed = true;
+	Report(Util::CurrentTicks());
+
+	if (fault.kind != fkNone)
+	{
+		detail("[server %i] Injecting fault \"%s\" into %s", serverId, FAULT_NAMES[fault.kind], messageid);
+	}
+
+	return fault;
+}
+
+int FaultInjector::GetTlsDelay(int serverId)
+{
+	Guard guard(m_mutex);
+
+	BString<100> key("%i", serverId);
+	int attempt = NextAttempt(key);
+
+	Fault fault = Evaluate(serverId, key, attempt, true);
+	if (fault.kind != fkTlsDelay)
+	{
+		return 0;
+	}
+
+	m_statistics[serverId].faults[fkTlsDelay]++;
+	m_changed = true;
+	return fault.param;
+}
+
+/*
+ Attempt counters are kept for a limited number of keys. When the limit is
+ reached all counters start over, which happens at the same request in every
+ run, so the faults remain reproducible.
+*/
+int FaultInjector::NextAttempt(const char* key)
+{
+	if ((int)m_attempts.size() >= MAX_TRACKED_ATTEMPTS && m_attempts.find(key) == m_attempts.end())
+	{
+		m_attempts.clear();
+	}
+	return ++m_attempts[key];
+}
+
+void FaultInjector::CountBytes(int serverId, int64 bytes)
+{
+	Guard guard(m_mutex);
+	m_statistics[serverId].bytes += bytes;
+}
+
+FaultInjector::Fault FaultInjector::Evaluate(int serverId, const char* key, int attempt, bool connection)
+{
+	int64 elapsed = Util::CurrentTicks() - m_startTime;
+
+	// rules of the last section which has already started
+	int64 sectionTime = 0;
+	for (int64 startTime : m_sections)
+	{
+		if (startTime <= elapsed)
+		{
+			sectionTime = std::max(sectionTime, startTime);
+		}
+	}
+
+	Fault fault;
+	for (Rule& rule : m_rules)
+	{
+		if (rule.startTime != sectionTime || (rule.serverId && rule.serverId != serverId) ||
+			(rule.kind == fkTlsDelay) != connection)
+		{
+			continue;
+		}
+
+		// missing articles remain missing on retries
+		BString<1024> seedKey("%u:%s:%i:%i", m_seed, key, (int)rule.kind,
+			rule.kind == fkMissing ? 0 : attempt);
+		Crc32 crc;
+		crc.Append((uchar*)(const char*)seedKey, seedKey.Length());
+		if ((int)(crc.Finish() % 10000) < rule.rate)
+		{
+			fault.kind = rule.kind;
+			fault.param = rule.param;
+			break;
+		}
+	}
+
+	return fault;
+}
+
+void FaultInjector::Report(int64 now)
+{
+	if (!m_changed || now - m_lastReport < (int64)REPORT_INTERVAL * 1000000)
+	{
+		return;
+	}
+
+	for (StatisticsMap::value_type& item : m_statistics)
+	{
+		Statistics& st = item.second;
+		info("[server %i] Requests: %i, missing: %i, truncated: %i, corrupted: %i, stalled: %i, reset: %i, "
+			"tls delayed: %i, sent: %" PRIi64 " KB",
+			item.first, st.requests, st.faults[fkMissing], st.faults[fkTruncate], st.faults[fkCorrupt],
+			st.faults[fkStall], st.faults[fkReset], st.faults[fkTlsDelay], st.bytes / 1024);
+	}
+
+	m_lastReport = now;
+	m_changed = false;
+}
+
+// Position of the first line beginning at or after "pos"
+int FaultInjector::FindLineStart(const char* data, int size, int pos)
+{
+	for (; pos > 0 && pos < size; pos++)
+	{
+		if (data[pos - 1] == '\n')
+		{
+			return pos;
+		}
+	}
+	return std::min(std::max(pos, 0), size);
+}
+
+// Position of an unescaped yEnc-data character at or after "pos", which can be
+// replaced without breaking the line structure; -1 if none
+int FaultInjector::FindDataChar(const char* data, int size, int pos)
+{
+	for (pos = FindLineStart(data, size, pos); pos < size; pos = FindLineStart(data, size, pos + 1))
+	{
+		// skip yEnc header and trailer lines
+		if (data[pos] == '=' && pos + 1 < size && data[pos + 1] == 'y')
+		{
+			continue;
+		}
+
+		for (int i = pos + 1; i < size && data[i] != '\r' && data[i] != '\n'; i++)
+		{
+			char ch = data[i];
+			if (ch != '=' && ch != '.' && data[i - 1] != '=')
+			{
+				return i;
+			}
+		}
+	}
+	return -1;
+}
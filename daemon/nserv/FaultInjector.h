@@ -0,0 +1,97 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef FAULTINJECTOR_H
+#define FAULTINJECTOR_H
+
+#include "NString.h"
+#include "Thread.h"
+
+/*
+ Simulates faulty news servers according to a scenario file. Decisions are
+ derived from a hash of seed, server id, message-id and attempt number, so
+ the same sequence of requests produces the same faults in every run.
+*/
+class FaultInjector
+{
+public:
+	enum EKind
+	{
+		fkNone,
+		fkMissing,
+		fkTruncate,
+		fkCorrupt,
+		fkStall,
+		fkReset,
+		fkTlsDelay
+	};
+
+	struct Fault
+	{
+		EKind kind = fkNone;
+		int param = 0;
+	};
+
+	bool Load(const char* filename);
+	Fault GetArticleFault(int serverId, const char* messageid);
+	int GetTlsDelay(int serverId);
+	void CountBytes(int serverId, int64 bytes);
+	static int FindLineStart(const char* data, int size, int pos);
+	static int FindDataChar(const char* data, int size, int pos);
+
+private:
+	struct Rule
+	{
+		int64 startTime;
+		int serverId;
+		EKind kind;
+		int rate;
+		int param;
+	};
+
+	struct Statistics
+	{
+		int requests = 0;
+		int faults[fkTlsDelay + 1] = {0};
+		int64 bytes = 0;
+	};
+
+	typedef std::vector<Rule> RuleList;
+	typedef std::unordered_map<std::string, int> AttemptMap;
+	typedef std::map<int, Statistics> StatisticsMap;
+
+	RuleList m_rules;
+	std::vector<int64> m_sections;
+	uint32 m_seed = 0;
+	int64 m_startTime = 0;
+	AttemptMap m_attempts;
+	StatisticsMap m_statistics;
+	int64 m_lastReport = 0;
+	bool m_changed = false;
+	Mutex m_mutex;
+
+	bool ParseLine(char* line, int64& startTime);
+	int NextAttempt(const char* key);
+	Fault Evaluate(int serverId, const char* key, int attempt, bool connection);
+	void Report(int64 now);
+};
+
+#endif
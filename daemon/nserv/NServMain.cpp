@@ -28,12 +28,16 @@
 #include "NServFrontend.h"
 #include "NntpServer.h"
 #include "NzbGenerator.h"
+#include "SegmentStore.h"
+#include "FaultInjector.h"
 #include "Options.h"
 
 struct NServOpts
 {
 	CString dataDir;
 	CString cacheDir;
+	CString storeFile;
+	CString scenarioFile;
 	CString bindAddress;
 	int firstPort;
 	int instances;
@@ -47,6 +51,7 @@ struct NServOpts
 	int latency;
 	int speed;
 	bool memCache;
+	bool eventLoop;
 	bool paramError;
 
 	NServOpts(int argc, char* argv[], Options::CmdOptList& cmdOpts);
@@ -112,6 +117,40 @@ int NServMain(int argc, char* argv[])
 		error("Could not create directory %s: %s", *opts.cacheDir, *errmsg);
 	}
 
+	std::unique_ptr<SegmentStore> store;
+	if (opts.storeFile)
+	{
+		store = std::make_unique<SegmentStore>(opts.dataDir, opts.storeFile, opts.segmentSize);
+		if (!store->Load())
+		{
+			return 1;
+		}
+	}
+
+	std::unique_ptr<FaultInjector> faults;
+	if (opts.scenarioFile)
+	{
+		faults = std::make_unique<FaultInjector>();
+		if (!faults->Load(opts.scenarioFile))
+		{
+			return 1;
+		}
+	}
+
+	bool eventLoop = opts.eventLoop;
+#ifndef HAVE_EPOLL
+	if (eventLoop)
+	{
+		warn("Event loop mode is not supported on this platform, serving connections in threads");
+		eventLoop = false;
+	}
+#endif
+	if (eventLoop && opts.secureCert)
+	{
+		warn("Event loop mode doesn't support TLS, serving connections in threads");
+		eventLoop = false;
+	}
+
 	std::vector<std::unique_ptr<NntpServer>> instances;
 	NntpCache cache;
 
@@ -119,7 +158,7 @@ int NServMain(int argc, char* argv[])
 	{
 		instances.emplace_back(std::make_unique<NntpServer>(i + 1, opts.bindAddress,
 			opts.firstPort + i, opts.secureCert, opts.secureKey, opts.dataDir, opts.cacheDir,
-			opts.latency, opts.speed, opts.memCache ? &cache : nullptr));
+			opts.latency, opts.speed, opts.memCache ? &cache : nullptr, store.get(), faults.get(), eventLoop));
 		instances.back()->Start();
 	}
 
@@ -154,6 +193,10 @@ void NServPrintUsage(const char* com)
 		"  Optional switches:\n"
 		"    -c <cache-dir>  - directory to store encoded articles\n"
 		"    -m              - in-memory cache (unlimited, use with care)\n"
+		"    -a <store-file> - pre-encode all segments into store-file and serve them\n"
+		"                      from there (segment size is set with -z)\n"
+		"    -e              - serve all connections of an instance in one thread\n"
+		"                      using epoll (Linux only, no TLS)\n"
 		"    -l <log-file>   - write into log-file (disabled by default)\n"
 		"    -i <instances>  - number of server instances (default is 1)\n"
 		"    -b <address>    - ip address to bind to (default is 0.0.0.0)\n"
@@ -162,6 +205,7 @@ void NServPrintUsage(const char* com)
 		"    -v <verbose>    - verbosity level 0..3 (default is 2)\n"
 		"    -w <msec>       - response latency (in milliseconds)\n"
 		"    -r <KB/s>       - speed throttling (in kilobytes per second)\n"
+		"    -f <scenario>   - inject faults as described in scenario file\n"
 		"    -z <seg-size>   - generate nzbs for all files in data-dir (size in bytes)\n"
 		"    -q              - quit after generating nzbs (in combination with -z)\n"
 		, FileSystem::BaseFileName(com));
@@ -177,11 +221,12 @@ NServOpts::NServOpts(int argc, char* argv[], Options::CmdOptList& cmdOpts)
 	quit = false;
 	latency = 0;
 	memCache = false;
+	eventLoop = false;
 	speed = 0;
 	paramError = false;
 	int verbosity = 2;
 
-	char short_options[] = "b:c:d:l:p:i:ms:v:w:r:z:q";
+	char short_options[] = "a:b:c:d:ef:l:p:i:ms:v:w:r:z:q";
 
 	optind = 2;
 	while (true)
@@ -202,6 +247,18 @@ NServOpts::NServOpts(int argc, char* argv[], Options::CmdOptList& cmdOpts)
 				memCache = true;
 				break;
 
+			case 'a':
+				storeFile = optind > argc ? nullptr : argv[optind - 1];
+				break;
+
+			case 'e':
+				eventLoop = true;
+				break;
+
+			case 'f':
+				scenarioFile = optind > argc ? nullptr : argv[optind - 1];
+				break;
+
 			case 'l':
 				logFile = optind > argc ? nullptr : argv[optind - 1];
 				break;
@@ -23,15 +23,17 @@
 #include "Log.h"
 #include "Util.h"
 #include "YEncoder.h"
+#include "FaultInjector.h"
 
 class NntpProcessor : public Thread
 {
 public:
 	NntpProcessor(int id, int serverId, const char* dataDir, const char* cacheDir,
-		const char* secureCert, const char* secureKey, int latency, int speed, NntpCache* cache) :
+		const char* secureCert, const char* secureKey, int latency, int speed, NntpCache* cache,
+		SegmentStore* store, FaultInjector* faults) :
 		m_id(id), m_serverId(serverId), m_dataDir(dataDir), m_cacheDir(cacheDir),
 		m_secureCert(secureCert), m_secureKey(secureKey), m_latency(latency),
-		m_speed(speed), m_cache(cache) {}
+		m_speed(speed), m_cache(cache), m_store(store), m_faults(faults) {}
 	~NntpProcessor() { m_connection->Disconnect(); }
 	virtual void Run();
 	void SetConnection(std::unique_ptr<Connection>&& connection) { m_connection = std::move(connection); }
@@ -54,13 +56,138 @@ private:
 	bool m_sendHeaders;
 	int64 m_start;
 	NntpCache* m_cache;
+	SegmentStore* m_store;
+	FaultInjector* m_faults;
+	FaultInjector::Fault m_fault;
+	int64 m_faultPos;
+	int64 m_bodySent;
 
 	void ServArticle();
 	void SendSegment();
-	bool ServerInList(const char* servList);
+	void SendBody(const char* buffer, int size);
 	void SendData(const char* buffer, int size);
+	void AbortConnection(bool reset);
 };
 
+#ifdef HAVE_EPOLL
+/*
+ Serves all connections of a server instance in one thread. Articles from
+ segment store are sent directly from the store-file (sendfile) or from its
+ memory mapping (writev), without copying them into a send buffer.
+ Latency and speed throttling are applied per connection using timers of the
+ loop instead of sleeping.
+*/
+class NntpEventLoop
+{
+public:
+	NntpEventLoop(Thread* owner, int serverId, const char* dataDir, int latency, int speed,
+		SegmentStore* store, FaultInjector* faults) :
+		m_owner(owner), m_serverId(serverId), m_dataDir(dataDir), m_latency(latency),
+		m_speed(speed), m_store(store), m_faults(faults) {}
+	~NntpEventLoop();
+	void Run(SOCKET listenSocket);
+
+private:
+	struct Response
+	{
+		CString head;
+		const char* body = nullptr;
+		int bodySize = 0;
+		int64 storeOffset = -1;
+		StringBuilder encoded;
+		int sent = 0;
+		int64 readyTime = 0;
+		int abortAt = -1;
+		FaultInjector::EKind abortKind = FaultInjector::fkNone;
+		int stallTime = 0;
+	};
+
+	struct Client
+	{
+		int id;
+		SOCKET socket;
+		std::string input;
+		std::deque<Response> output;
+		int64 sendTime = 0;
+		bool quit = false;
+		bool broken = false;
+	};
+
+	typedef std::unordered_map<SOCKET, std::unique_ptr<Client>> ClientMap;
+
+	Thread* m_owner;
+	int m_serverId;
+	const char* m_dataDir;
+	int m_latency;
+	int m_speed;
+	SegmentStore* m_store;
+	FaultInjector* m_faults;
+	int m_epoll = -1;
+	int m_storeFd = -1;
+	ClientMap m_clients;
+	int m_num = 1;
+	int64 m_now = 0;
+
+	void Accept(SOCKET listenSocket);
+	void Receive(Client& client);
+	void ProcessLine(Client& client, char* line);
+	void ServArticle(Client& client, const char* messageid, bool sendHeaders);
+	void InjectFault(Response& response, FaultInjector::Fault& fault, int size);
+	void Transmit(Client& client, int64& wakeTime);
+	Response& AddResponse(Client& client, const char* head);
+};
+#endif
+
+/*
+ Message-id format:
+   <file-path-relative-to-dataDir?xxx=yyy:zzz!1,2,3>
+where:
+   xxx   - part number (integer)
+   xxx   - offset from which to read the files (integer)
+   yyy   - size of file block to return (integer)
+   1,2,3 - list of server ids, which have the article (optional),
+           if the list is given and current server is not in the list
+           the "article not found"-error is returned.
+ Examples:
+	<parchecker/testfile.dat?1=0:50000>	       - return first 50000 bytes starting from beginning
+	<parchecker/testfile.dat?2=50000:50000>      - return 50000 bytes starting from offset 50000
+	<parchecker/testfile.dat?2=50000:50000!2>    - article is missing on server 1
+*/
+static bool ParseMessageId(const char* messageid, CString& filename, int& part, int64& offset,
+	int& size, const char*& servList)
+{
+	const char* from = strchr(messageid, '?');
+	const char* off = strchr(messageid, '=');
+	const char* to = strchr(messageid, ':');
+	const char* end = strchr(messageid, '>');
+	const char* serv = strchr(messageid, '!');
+
+	if (!(from && off && to && end))
+	{
+		return false;
+	}
+
+	filename.Set(messageid + 1, (int)(from - messageid - 1));
+	part = atoi(from + 1);
+	offset = atoll(off + 1);
+	size = atoi(to + 1);
+	servList = serv ? serv + 1 : nullptr;
+	return true;
+}
+
+static bool ServerInList(const char* servList, int serverId)
+{
+	Tokenizer tok(servList, ",");
+	while (const char* servid = tok.Next())
+	{
+		if (atoi(servid) == serverId)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 
 void NntpServer::Run()
 {
@@ -89,6 +216,15 @@ void NntpServer::Run()
 			bind = m_connection->Bind();
 		}
 
+#ifdef HAVE_EPOLL
+		if (bind && m_eventLoop)
+		{
+			NntpEventLoop eventLoop(this, m_id, m_dataDir, m_latency, m_speed, m_store, m_faults);
+			eventLoop.Run(m_connection->GetSocket());
+			break;
+		}
+#endif
+
 		// Accept connections and store the new Connection
 		std::unique_ptr<Connection> acceptedConnection;
 		if (bind)
@@ -108,7 +244,7 @@ void NntpServer::Run()
 		}
 		
 		NntpProcessor* commandThread = new NntpProcessor(num++, m_id, m_dataDir,
-			m_cacheDir, m_secureCert, m_secureKey, m_latency, m_speed, m_cache);
+			m_cacheDir, m_secureCert, m_secureKey, m_latency, m_speed, m_cache, m_store, m_faults);
 		commandThread->SetAutoDestroy(true);
 		commandThread->SetConnection(std::move(acceptedConnection));
 		commandThread->Start();
@@ -141,6 +277,15 @@ void NntpProcessor::Run()
 	m_connection->SetSuppressErrors(false);
 
 #ifndef DISABLE_TLS
+	if (m_secureCert && m_faults)
+	{
+		if (int delay = m_faults->GetTlsDelay(m_serverId))
+		{
+			detail("[%i] Delaying TLS handshake by %i ms", m_id, delay);
+			Util::Sleep(delay);
+		}
+	}
+
 	if (m_secureCert && !m_connection->StartTls(false, m_secureCert, m_secureKey))
 	{
 		error("Could not establish secure connection to nntp-client: Start TLS failed");
@@ -195,21 +340,6 @@ void NntpProcessor::Run()
 	m_connection->Disconnect();
 }
 
-/* 
- Message-id format:
-   <file-path-relative-to-dataDir?xxx=yyy:zzz!1,2,3>
-where:
-   xxx   - part number (integer)
-   xxx   - offset from which to read the files (integer)
-   yyy   - size of file block to return (integer)
-   1,2,3 - list of server ids, which have the article (optional),
-           if the list is given and current server is not in the list
-           the "article not found"-error is returned.
- Examples:
-	<parchecker/testfile.dat?1=0:50000>	       - return first 50000 bytes starting from beginning
-	<parchecker/testfile.dat?2=50000:50000>      - return 50000 bytes starting from offset 50000
-	<parchecker/testfile.dat?2=50000:50000!2>    - article is missing on server 1
-*/
 void NntpProcessor::ServArticle()
 {
 	detail("[%i] Serving: %s", m_id, m_messageid);
@@ -219,51 +349,27 @@ void NntpProcessor::ServArticle()
 		Util::Sleep(m_latency);
 	}
 
-	bool ok = false;
-
-	const char* from = strchr(m_messageid, '?');
-	const char* off = strchr(m_messageid, '=');
-	const char* to = strchr(m_messageid, ':');
-	const char* end = strchr(m_messageid, '>');
-	const char* serv = strchr(m_messageid, '!');
-
-	if (from && off && to && end)
+	const char* servList;
+	if (!ParseMessageId(m_messageid, m_filename, m_part, m_offset, m_size, servList))
 	{
-		m_filename.Set(m_messageid + 1, (int)(from - m_messageid - 1));
-		m_part = atoi(from + 1);
-		m_offset = atoll(off + 1);
-		m_size = atoi(to + 1);
-
-		ok = !serv || ServerInList(serv + 1);
-
-		if (ok)
-		{
-			SendSegment();
-			return;
-		}
-
-		if (!ok)
-		{
-			m_connection->WriteLine("430 No Such Article Found\r\n");
-		}
+		m_connection->WriteLine("430 No Such Article Found (invalid message id format)\r\n");
+		return;
 	}
-	else
+
+	if (servList && !ServerInList(servList, m_serverId))
 	{
-		m_connection->WriteLine("430 No Such Article Found (invalid message id format)\r\n");
+		m_connection->WriteLine("430 No Such Article Found\r\n");
+		return;
 	}
-}
 
-bool NntpProcessor::ServerInList(const char* servList)
-{
-	Tokenizer tok(servList, ",");
-	while (const char* servid = tok.Next())
+	m_fault = m_faults ? m_faults->GetArticleFault(m_serverId, m_messageid) : FaultInjector::Fault();
+	if (m_fault.kind == FaultInjector::fkMissing)
 	{
-		if (atoi(servid) == m_serverId)
-		{
-			return true;
-		}
+		m_connection->WriteLine("430 No Such Article Found\r\n");
+		return;
 	}
-	return false;
+
+	SendSegment();
 }
 
 void NntpProcessor::SendSegment()
@@ -275,6 +381,29 @@ void NntpProcessor::SendSegment()
 		m_start = Util::CurrentTicks();
 	}
 
+	m_bodySent = 0;
+	m_faultPos = m_fault.kind == FaultInjector::fkTruncate || m_fault.kind == FaultInjector::fkReset ?
+		(int64)m_size * m_fault.param / 100 : m_size / 2;
+
+	if (m_store)
+	{
+		BString<1024> key;
+		SegmentStore::MakeKey(key, m_filename, m_part, m_offset, m_size);
+		if (const SegmentStore::Segment* segment = m_store->Find(key))
+		{
+			m_connection->WriteLine(CString::FormatStr("%i, 0 %s\r\n", m_sendHeaders ? 222 : 220, m_messageid));
+			if (m_sendHeaders)
+			{
+				m_connection->WriteLine(CString::FormatStr("Message-ID: %s\r\n", m_messageid));
+				m_connection->WriteLine(CString::FormatStr("Subject: \"%s\"\r\n", FileSystem::BaseFileName(m_filename)));
+				m_connection->WriteLine("\r\n");
+			}
+			// stored article includes the terminating line
+			SendBody(m_store->GetData(segment), segment->size);
+			return;
+		}
+	}
+
 	BString<1024> fullFilename("%s/%s", m_dataDir, *m_filename);
 	BString<1024> cacheFileDir("%s/%s", m_cacheDir, *m_filename);
 	BString<1024> cacheFileName("%i=%" PRIi64 "-%i", m_part, m_offset, m_size);
@@ -325,7 +454,7 @@ void NntpProcessor::SendSegment()
 			{
 				cacheFile.Write(buf, size);
 			}
-			proc->SendData(buf, size);
+			proc->SendBody(buf, size);
 		});
 
 	if (!cachedData && !readCache && !encoder.OpenFile(errmsg))
@@ -344,7 +473,7 @@ void NntpProcessor::SendSegment()
 
 	if (cachedData)
 	{
-		SendData(cachedData, cachedSize);
+		SendBody(cachedData, cachedSize);
 	}
 	else if (readCache)
 	{
@@ -360,7 +489,7 @@ void NntpProcessor::SendSegment()
 		{
 			cacheMem.Append(buf, size);
 		}
-		SendData(buf, size);
+		SendBody(buf, size);
 	}
 	else
 	{
@@ -372,11 +501,107 @@ void NntpProcessor::SendSegment()
 		m_cache->Append(cacheKey, cacheMem, cacheMem.Length());
 	}
 
-	m_connection->WriteLine(".\r\n");
+	SendBody(".\r\n", 3);
+}
+
+// Sends article body, applying the injected fault
+void NntpProcessor::SendBody(const char* buffer, int size)
+{
+	if (m_fault.kind == FaultInjector::fkNone || m_bodySent + size <= m_faultPos)
+	{
+		SendData(buffer, size);
+		m_bodySent += size;
+		return;
+	}
+
+	if (m_bodySent > m_faultPos)
+	{
+		// the rest of a truncated or aborted article
+		return;
+	}
+
+	int pos = (int)(m_faultPos - m_bodySent);
+	switch (m_fault.kind)
+	{
+		case FaultInjector::fkTruncate:
+		{
+			int cut = FaultInjector::FindLineStart(buffer, size, pos);
+			SendData(buffer, cut);
+			if (cut > 0 && buffer[cut - 1] != '\n')
+			{
+				SendData("\r\n", 2);
+			}
+			SendData(".\r\n", 3);
+			m_bodySent = m_faultPos + 1;
+			break;
+		}
+
+		case FaultInjector::fkCorrupt:
+		{
+			int corruptPos = FaultInjector::FindDataChar(buffer, size, pos);
+			if (corruptPos == -1)
+			{
+				// no data chars left in this block
+				SendData(buffer, size);
+				m_bodySent += size;
+				m_faultPos = m_bodySent;
+				return;
+			}
+			char ch = buffer[corruptPos] == 'x' ? 'y' : 'x';
+			SendData(buffer, corruptPos);
+			SendData(&ch, 1);
+			SendData(buffer + corruptPos + 1, size - corruptPos - 1);
+			m_fault.kind = FaultInjector::fkNone;
+			m_bodySent += size;
+			break;
+		}
+
+		case FaultInjector::fkStall:
+		{
+			SendData(buffer, pos);
+			detail("[%i] Stalling for %i seconds", m_id, m_fault.param);
+			for (int64 until = Util::CurrentTicks() + (int64)m_fault.param * 1000000;
+				!IsStopped() && Util::CurrentTicks() < until; )
+			{
+				Util::Sleep(100);
+			}
+			AbortConnection(false);
+			m_bodySent = m_faultPos + 1;
+			break;
+		}
+
+		case FaultInjector::fkReset:
+			SendData(buffer, pos);
+			AbortConnection(true);
+			m_bodySent = m_faultPos + 1;
+			break;
+
+		default:
+			break;
+	}
+}
+
+void NntpProcessor::AbortConnection(bool reset)
+{
+	detail("[%i] %s connection", m_id, reset ? "Resetting" : "Closing");
+	if (reset)
+	{
+		// close without FIN-handshake, the client gets "connection reset by peer"
+		struct linger lingerOpt;
+		lingerOpt.l_onoff = 1;
+		lingerOpt.l_linger = 0;
+		setsockopt(m_connection->GetSocket(), SOL_SOCKET, SO_LINGER, (char*)&lingerOpt, sizeof(lingerOpt));
+	}
+	m_connection->Disconnect();
 }
 
 void NntpProcessor::SendData(const char* buffer, int size)
 {
+	if (m_faults)
+	{
+		m_faults->CountBytes(m_serverId, size);
+	}
+
 	if (m_speed == 0)
 	{
 		m_connection->Send(buffer, size);
@@ -417,6 +642,462 @@ void NntpProcessor::SendData(const char* buffer, int size)
 }
 
 
+#ifdef HAVE_EPOLL
+NntpEventLoop::~NntpEventLoop()
+{
+	for (ClientMap::value_type& item : m_clients)
+	{
+		closesocket(item.first);
+	}
+	if (m_epoll != -1)
+	{
+		close(m_epoll);
+	}
+	if (m_storeFd != -1)
+	{
+		close(m_storeFd);
+	}
+}
+
+void NntpEventLoop::Run(SOCKET listenSocket)
+{
+	m_epoll = epoll_create1(0);
+	if (m_epoll == -1)
+	{
+		error("Could not create epoll instance: %s", *FileSystem::GetLastErrorMessage());
+		return;
+	}
+
+	if (m_store)
+	{
+		m_storeFd = open(m_store->GetFilename(), O_RDONLY);
+		if (m_storeFd == -1)
+		{
+			error("Could not open file %s: %s", m_store->GetFilename(), *FileSystem::GetLastErrorMessage());
+			return;
+		}
+	}
+
+	fcntl(listenSocket, F_SETFL, fcntl(listenSocket, F_GETFL) | O_NONBLOCK);
+	epoll_event listenEvent{};
+	listenEvent.events = EPOLLIN;
+	listenEvent.data.ptr = nullptr;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, listenSocket, &listenEvent);
+
+	const int maxEvents = 64;
+	epoll_event events[maxEvents];
+	std::vector<SOCKET> closed;
+
+	while (!m_owner->IsStopped())
+	{
+		m_now = Util::CurrentTicks();
+
+		// wake up at least every 100 ms to check for stop request
+		int64 wakeTime = m_now + 100000;
+
+		for (ClientMap::value_type& item : m_clients)
+		{
+			Client& client = *item.second;
+			Transmit(client, wakeTime);
+			if (client.broken || (client.quit && client.output.empty()))
+			{
+				closed.push_back(client.socket);
+			}
+		}
+
+		for (SOCKET socket : closed)
+		{
+			detail("[%i] Closing connection", m_clients[socket]->id);
+			closesocket(socket);
+			m_clients.erase(socket);
+		}
+		closed.clear();
+
+		int timeout = (int)((wakeTime - m_now + 999) / 1000);
+		int eventCount = epoll_wait(m_epoll, events, maxEvents, timeout);
+		if (eventCount == -1 && errno != EINTR)
+		{
+			error("Could not wait for connection events: %s", *FileSystem::GetLastErrorMessage());
+			break;
+		}
+
+		m_now = Util::CurrentTicks();
+		for (int i = 0; i < eventCount; i++)
+		{
+			Client* client = (Client*)events[i].data.ptr;
+			if (!client)
+			{
+				Accept(listenSocket);
+			}
+			else if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+			{
+				Receive(*client);
+			}
+		}
+	}
+}
+
+void NntpEventLoop::Accept(SOCKET listenSocket)
+{
+	while (true)
+	{
+		SOCKET socket = accept4(listenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (socket == INVALID_SOCKET)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR)
+			{
+				error("Could not accept connection: %s", *FileSystem::GetLastErrorMessage());
+			}
+			return;
+		}
+
+		std::unique_ptr<Client> client = std::make_unique<Client>();
+		client->id = m_num++;
+		client->socket = socket;
+
+		epoll_event event{};
+		event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		event.data.ptr = client.get();
+		if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &event) == -1)
+		{
+			error("Could not add connection to epoll instance: %s", *FileSystem::GetLastErrorMessage());
+			closesocket(socket);
+			continue;
+		}
+
+		info("[%i] Incoming connection", client->id);
+		AddResponse(*client, "200 Welcome (NServ)\r\n");
+		m_clients[socket] = std::move(client);
+	}
+}
+
+void NntpEventLoop::Receive(Client& client)
+{
+	char buf[4096];
+	while (!client.broken)
+	{
+		int received = (int)recv(client.socket, buf, sizeof(buf), 0);
+		if (received > 0)
+		{
+			client.input.append(buf, received);
+			continue;
+		}
+		if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+		if (received == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		// connection closed by client or failed
+		client.broken = true;
+	}
+
+	size_t start = 0;
+	size_t end;
+	while (!client.quit && (end = client.input.find('\n', start)) != std::string::npos)
+	{
+		client.input[end] = '\0';
+		ProcessLine(client, &client.input[start]);
+		start = end + 1;
+	}
+	client.input.erase(0, start);
+
+	if (client.input.length() > 10000)
+	{
+		warn("[%i] Command line too long", client.id);
+		client.broken = true;
+	}
+}
+
+void NntpEventLoop::ProcessLine(Client& client, char* line)
+{
+	Util::TrimRight(line);
+	detail("[%i] Received: %s", client.id, line);
+
+	if (!strncasecmp(line, "ARTICLE ", 8))
+	{
+		ServArticle(client, line + 8, true);
+	}
+	else if (!strncasecmp(line, "BODY ", 5))
+	{
+		ServArticle(client, line + 5, false);
+	}
+	else if (!strncasecmp(line, "GROUP ", 6))
+	{
+		AddResponse(client, CString::FormatStr("211 0 0 0 %s\r\n", line + 7));
+	}
+	else if (!strncasecmp(line, "AUTHINFO ", 9))
+	{
+		AddResponse(client, "281 Authentication accepted\r\n");
+	}
+	else if (!strcasecmp(line, "QUIT"))
+	{
+		AddResponse(client, "205 Connection closing\r\n");
+		client.quit = true;
+	}
+	else
+	{
+		warn("[%i] Unknown command: %s", client.id, line);
+		AddResponse(client, "500 Unknown command\r\n");
+	}
+}
+
+void NntpEventLoop::ServArticle(Client& client, const char* messageid, bool sendHeaders)
+{
+	detail("[%i] Serving: %s", client.id, messageid);
+
+	Response& response = AddResponse(client, nullptr);
+	response.readyTime = m_now + (int64)m_latency * 1000;
+
+	CString filename;
+	int part;
+	int64 offset;
+	int size;
+	const char* servList;
+	if (!ParseMessageId(messageid, filename, part, offset, size, servList))
+	{
+		response.head = "430 No Such Article Found (invalid message id format)\r\n";
+		return;
+	}
+
+	if (servList && !ServerInList(servList, m_serverId))
+	{
+		response.head = "430 No Such Article Found\r\n";
+		return;
+	}
+
+	FaultInjector::Fault fault = m_faults ? m_faults->GetArticleFault(m_serverId, messageid) : FaultInjector::Fault();
+	if (fault.kind == FaultInjector::fkMissing)
+	{
+		response.head = "430 No Such Article Found\r\n";
+		return;
+	}
+
+	BString<1024> key;
+	SegmentStore::MakeKey(key, filename, part, offset, size);
+	const SegmentStore::Segment* segment = m_store ? m_store->Find(key) : nullptr;
+
+	if (segment)
+	{
+		response.body = m_store->GetData(segment);
+		response.bodySize = segment->size;
+		response.storeOffset = segment->offset;
+	}
+	else
+	{
+		// article isn't in the store, encoding it now
+		BString<1024> fullFilename("%s/%s", m_dataDir, *filename);
+		if (!FileSystem::FileExists(fullFilename))
+		{
+			response.head = "430 Article not found\r\n";
+			return;
+		}
+
+		YEncoder encoder(fullFilename, part, offset, size,
+			[&response](const char* buf, int size)
+			{
+				response.encoded.Append(buf, size);
+			});
+
+		CString errmsg;
+		if (!encoder.OpenFile(errmsg))
+		{
+			response.head = CString::FormatStr("403 %s\r\n", *errmsg);
+			return;
+		}
+
+		encoder.WriteSegment();
+		response.encoded.Append(".\r\n");
+		response.body = response.encoded;
+		response.bodySize = response.encoded.Length();
+	}
+
+	if (sendHeaders)
+	{
+		response.head = CString::FormatStr("222, 0 %s\r\nMessage-ID: %s\r\nSubject: \"%s\"\r\n\r\n",
+			messageid, messageid, FileSystem::BaseFileName(filename));
+	}
+	else
+	{
+		response.head = CString::FormatStr("220, 0 %s\r\n", messageid);
+	}
+
+	if (fault.kind != FaultInjector::fkNone)
+	{
+		InjectFault(response, fault, size);
+	}
+}
+
+void NntpEventLoop::InjectFault(Response& response, FaultInjector::Fault& fault, int size)
+{
+	int pos = fault.kind == FaultInjector::fkTruncate || fault.kind == FaultInjector::fkReset ?
+		(int)((int64)size * fault.param / 100) : size / 2;
+
+	switch (fault.kind)
+	{
+		case FaultInjector::fkTruncate:
+		{
+			int cut = FaultInjector::FindLineStart(response.body, response.bodySize, pos);
+			if (response.body == response.encoded)
+			{
+				response.encoded.SetLength(cut);
+			}
+			else
+			{
+				response.encoded.Append(response.body, cut);
+			}
+			response.encoded.Append(".\r\n");
+			response.body = response.encoded;
+			response.bodySize = response.encoded.Length();
+			response.storeOffset = -1;
+			break;
+		}
+
+		case FaultInjector::fkCorrupt:
+		{
+			int corruptPos = FaultInjector::FindDataChar(response.body, response.bodySize, pos);
+			if (corruptPos == -1)
+			{
+				break;
+			}
+			if (response.body != response.encoded)
+			{
+				response.encoded.Append(response.body, response.bodySize);
+				response.body = response.encoded;
+				response.storeOffset = -1;
+			}
+			char* data = (char*)response.encoded;
+			data[corruptPos] = data[corruptPos] == 'x' ? 'y' : 'x';
+			break;
+		}
+
+		case FaultInjector::fkStall:
+		case FaultInjector::fkReset:
+			response.abortAt = response.head.Length() + std::min(pos, response.bodySize);
+			response.abortKind = fault.kind;
+			response.stallTime = fault.param;
+			break;
+
+		default:
+			break;
+	}
+}
+
+NntpEventLoop::Response& NntpEventLoop::AddResponse(Client& client, const char* head)
+{
+	client.output.emplace_back();
+	Response& response = client.output.back();
+	response.head = head;
+	return response;
+}
+
+void NntpEventLoop::Transmit(Client& client, int64& wakeTime)
+{
+	while (!client.output.empty() && !client.broken)
+	{
+		Response& response = client.output.front();
+		if (response.abortAt >= 0 && response.sent >= response.abortAt && response.readyTime <= m_now)
+		{
+			if (response.abortKind == FaultInjector::fkStall)
+			{
+				// closing the connection after the stall time
+				detail("[%i] Stalling for %i seconds", client.id, response.stallTime);
+				response.abortKind = FaultInjector::fkNone;
+				response.readyTime = m_now + (int64)response.stallTime * 1000000;
+				continue;
+			}
+			if (response.abortKind == FaultInjector::fkReset)
+			{
+				struct linger lingerOpt;
+				lingerOpt.l_onoff = 1;
+				lingerOpt.l_linger = 0;
+				setsockopt(client.socket, SOL_SOCKET, SO_LINGER, &lingerOpt, sizeof(lingerOpt));
+			}
+			detail("[%i] %s connection", client.id, response.abortKind == FaultInjector::fkReset ? "Resetting" : "Closing");
+			client.broken = true;
+			return;
+		}
+
+		int64 readyTime = std::max(response.readyTime, client.sendTime);
+		if (readyTime > m_now)
+		{
+			wakeTime = std::min(wakeTime, readyTime);
+			return;
+		}
+
+		int headSize = response.head.Length();
+		int total = headSize + response.bodySize;
+		int len = total - response.sent;
+		if (m_speed > 0)
+		{
+			// sending in portions of 50 ms to keep the rate smooth
+			len = std::min(len, std::max(m_speed * 1024 / 20, 1024));
+		}
+		if (response.abortAt >= 0)
+		{
+			len = std::min(len, response.abortAt - response.sent);
+		}
+
+		ssize_t written;
+		if (response.sent >= headSize && response.storeOffset >= 0)
+		{
+			off_t offset = (off_t)(response.storeOffset + response.sent - headSize);
+			written = sendfile(client.socket, m_storeFd, &offset, len);
+		}
+		else
+		{
+			iovec iov[2];
+			int count = 0;
+			int headLen = std::min(len, std::max(headSize - response.sent, 0));
+			if (headLen > 0)
+			{
+				iov[count].iov_base = (void*)(response.head + response.sent);
+				iov[count++].iov_len = headLen;
+			}
+			if (len > headLen)
+			{
+				iov[count].iov_base = (void*)(response.body + response.sent + headLen - headSize);
+				iov[count++].iov_len = len - headLen;
+			}
+			written = writev(client.socket, iov, count);
+		}
+
+		if (written == -1)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			{
+				client.broken = true;
+			}
+			// waiting for EPOLLOUT
+			return;
+		}
+
+		response.sent += (int)written;
+		if (m_faults)
+		{
+			m_faults->CountBytes(m_serverId, written);
+		}
+		if (m_speed > 0)
+		{
+			client.sendTime = std::max(client.sendTime, m_now) + written * 1000000 / (m_speed * 1024);
+		}
+
+		if (response.sent == total)
+		{
+			client.output.pop_front();
+		}
+		else if (written < len)
+		{
+			// socket buffer is full
+			return;
+		}
+	}
+}
+#endif
+
+
 void NntpCache::Append(const char* key, const char* data, int len)
 {
 	Guard guard(m_lock);
@@ -24,6 +24,8 @@
 #include "Thread.h"
 #include "Connection.h"
 #include "Util.h"
+#include "SegmentStore.h"
+#include "FaultInjector.h"
 
 class NntpCache
 {
@@ -54,10 +56,12 @@ class NntpServer : public Thread
 public:
 	NntpServer(int id, const char* host, int port, const char* secureCert,
 		const char* secureKey, const char* dataDir, const char* cacheDir,
-		int latency, int speed, NntpCache* cache) :
+		int latency, int speed, NntpCache* cache, SegmentStore* store, FaultInjector* faults,
+		bool eventLoop) :
 		m_id(id), m_host(host), m_port(port), m_secureCert(secureCert),
 		m_secureKey(secureKey), m_dataDir(dataDir), m_cacheDir(cacheDir),
-		m_latency(latency), m_speed(speed), m_cache(cache) {}
+		m_latency(latency), m_speed(speed), m_cache(cache), m_store(store),
+		m_faults(faults), m_eventLoop(eventLoop) {}
 	virtual void Run();
 	virtual void Stop();
 
@@ -73,6 +77,9 @@ private:
 	int m_latency;
 	int m_speed;
 	NntpCache* m_cache;
+	SegmentStore* m_store;
+	FaultInjector* m_faults;
+	bool m_eventLoop;
 };
 
 #endif
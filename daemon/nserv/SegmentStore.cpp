@@ -0,0 +1,282 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "nzbget.h"
+#include "SegmentStore.h"
+#include "YEncoder.h"
+#include "Log.h"
+
+static const char* STORE_SIGNATURE = "nzbget nserv store";
+static const int STORE_FORMAT = 1;
+
+bool SegmentStore::Load()
+{
+	SourceList sources;
+	CollectSources(sources);
+
+	if (!ReadIndex(sources))
+	{
+		info("Pre-encoding segments into %s", *m_filename);
+		if (!Build(sources))
+		{
+			return false;
+		}
+	}
+
+	if (!m_data.Open(m_filename))
+	{
+		error("Could not open file %s: %s", *m_filename, *FileSystem::GetLastErrorMessage());
+		return false;
+	}
+
+	info("Segment store %s: %i segments, %" PRIi64 " bytes", *m_filename, (int)m_segments.size(), m_data.GetSize());
+	return true;
+}
+
+void SegmentStore::MakeKey(BString<1024>& key, const char* filename, int part, int64 offset, int size)
+{
+	key.Format("%s?%i=%" PRIi64 ":%i", filename, part, offset, size);
+}
+
+const SegmentStore::Segment* SegmentStore::Find(const char* key)
+{
+	SegmentMap::iterator pos = m_segments.find(key);
+	return pos != m_segments.end() ? &pos->second : nullptr;
+}
+
+// Same files as NzbGenerator creates nzbs for: files in data-dir and in its direct subdirectories
+void SegmentStore::CollectSources(SourceList& sources)
+{
+	DirBrowser dir(m_dataDir);
+	while (const char* filename = dir.Next())
+	{
+		BString<1024> fullFilename("%s%c%s", *m_dataDir, PATH_SEPARATOR, filename);
+
+		if (FileSystem::DirectoryExists(fullFilename))
+		{
+			DirBrowser subdir(fullFilename);
+			while (const char* subfilename = subdir.Next())
+			{
+				BString<1024> relativeFilename("%s/%s", filename, subfilename);
+				AddSource(sources, relativeFilename);
+			}
+		}
+		else
+		{
+			int len = strlen(filename);
+			if (len > 4 && !strcasecmp(filename + len - 4, ".nzb"))
+			{
+				continue;
+			}
+			AddSource(sources, filename);
+		}
+	}
+
+	std::sort(sources.begin(), sources.end(),
+		[](const Source& source1, const Source& source2)
+		{
+			return strcmp(source1.filename, source2.filename) < 0;
+		});
+}
+
+void SegmentStore::AddSource(SourceList& sources, const char* filename)
+{
+	BString<1024> fullFilename("%s/%s", *m_dataDir, filename);
+	if (FileSystem::DirectoryExists(fullFilename) || FileSystem::SameFilename(fullFilename, m_filename) ||
+		FileSystem::SameFilename(fullFilename, BString<1024>("%s.idx", *m_filename)))
+	{
+		return;
+	}
+
+	int64 size = -1;
+	int64 time = FileSystem::FileTime(fullFilename, &size);
+	sources.push_back({filename, size, time});
+}
+
+/*
+ Index format:
+   nzbget nserv store <format> <segment-size>
+   F <file-size> <file-time> <filename>
+   S <offset> <size> <message-id>
+   S ...
+   F ...
+*/
+bool SegmentStore::ReadIndex(SourceList& sources)
+{
+	BString<1024> indexFilename("%s.idx", *m_filename);
+	DiskFile infile;
+	if (!FileSystem::FileExists(m_filename) || !infile.Open(indexFilename, DiskFile::omRead))
+	{
+		return false;
+	}
+
+	int64 storeSize = FileSystem::FileSize(m_filename);
+	uint32 fileNum = 0;
+	char buf[2048];
+
+	if (!infile.ReadLine(buf, sizeof(buf)) ||
+		strcmp(buf, BString<100>("%s %i %i\n", STORE_SIGNATURE, STORE_FORMAT, m_segmentSize)))
+	{
+		return false;
+	}
+
+	while (infile.ReadLine(buf, sizeof(buf)))
+	{
+		char* end = buf + strlen(buf);
+		if (end > buf && *(end - 1) == '\n')
+		{
+			*(end - 1) = '\0';
+		}
+
+		char* name = nullptr;
+		if (buf[0] == 'F' && buf[1] == ' ')
+		{
+			int64 size = strtoll(buf + 2, &name, 10);
+			int64 time = strtoll(name, &name, 10);
+			if (fileNum >= sources.size() || *name != ' ' ||
+				strcmp(sources[fileNum].filename, name + 1) ||
+				sources[fileNum].size != size || sources[fileNum].time != time)
+			{
+				// files in data-dir have changed
+				m_segments.clear();
+				return false;
+			}
+			fileNum++;
+		}
+		else if (buf[0] == 'S' && buf[1] == ' ')
+		{
+			int64 offset = strtoll(buf + 2, &name, 10);
+			int size = (int)strtol(name, &name, 10);
+			if (*name != ' ' || offset < 0 || size <= 0 || offset + size > storeSize)
+			{
+				m_segments.clear();
+				return false;
+			}
+			m_segments.emplace(name + 1, Segment{offset, size});
+		}
+	}
+
+	if (fileNum != sources.size())
+	{
+		m_segments.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool SegmentStore::Build(SourceList& sources)
+{
+	BString<1024> indexFilename("%s.idx", *m_filename);
+
+	// the index is written last, an interrupted build is restarted on next load
+	FileSystem::DeleteFile(indexFilename);
+
+	DiskFile storeFile;
+	if (!storeFile.Open(m_filename, DiskFile::omWrite))
+	{
+		error("Could not create file %s: %s", *m_filename, *FileSystem::GetLastErrorMessage());
+		return false;
+	}
+	storeFile.SetWriteBuffer(1024 * 1024);
+
+	DiskFile indexFile;
+	BString<1024> tmpIndexFilename("%s.tmp", *indexFilename);
+	if (!indexFile.Open(tmpIndexFilename, DiskFile::omWrite))
+	{
+		error("Could not create file %s: %s", *tmpIndexFilename, *FileSystem::GetLastErrorMessage());
+		return false;
+	}
+
+	indexFile.Print("%s %i %i\n", STORE_SIGNATURE, STORE_FORMAT, m_segmentSize);
+
+	for (Source& source : sources)
+	{
+		if (!EncodeSource(source, storeFile, indexFile))
+		{
+			return false;
+		}
+	}
+
+	if (!storeFile.Flush())
+	{
+		error("Could not write file %s: %s", *m_filename, *FileSystem::GetLastErrorMessage());
+		return false;
+	}
+	storeFile.Close();
+
+	indexFile.Close();
+	if (!FileSystem::MoveFile(tmpIndexFilename, indexFilename))
+	{
+		error("Could not rename file %s: %s", *tmpIndexFilename, *FileSystem::GetLastErrorMessage());
+		return false;
+	}
+
+	return true;
+}
+
+bool SegmentStore::EncodeSource(Source& source, DiskFile& storeFile, DiskFile& indexFile)
+{
+	detail("Encoding %s", *source.filename);
+
+	indexFile.Print("F %" PRIi64 " %" PRIi64 " %s\n", source.size, source.time, *source.filename);
+
+	BString<1024> fullFilename("%s/%s", *m_dataDir, *source.filename);
+	int segmentCount = (int)((source.size + m_segmentSize - 1) / m_segmentSize);
+	int64 segOffset = 0;
+	bool ok = true;
+
+	for (int segno = 1; segno <= segmentCount && ok; segno++)
+	{
+		int segSize = (int)(segOffset + m_segmentSize < source.size ? m_segmentSize : source.size - segOffset);
+		int64 storeOffset = storeFile.Position();
+
+		YEncoder encoder(fullFilename, segno, segOffset, segSize,
+			[&storeFile, &ok](const char* buf, int size)
+			{
+				ok &= storeFile.Write(buf, size) == size;
+			});
+
+		CString errmsg;
+		if (!encoder.OpenFile(errmsg))
+		{
+			error("Could not encode file %s: %s", *fullFilename, *errmsg);
+			return false;
+		}
+
+		encoder.WriteSegment();
+		ok &= storeFile.Write(".\r\n", 3) == 3;
+
+		BString<1024> key;
+		MakeKey(key, source.filename, segno, segOffset, segSize);
+		indexFile.Print("S %" PRIi64 " %i %s\n", storeOffset, (int)(storeFile.Position() - storeOffset), *key);
+		m_segments.emplace(*key, Segment{storeOffset, (int)(storeFile.Position() - storeOffset)});
+
+		segOffset += segSize;
+	}
+
+	if (!ok)
+	{
+		error("Could not write file %s: %s", *m_filename, *FileSystem::GetLastErrorMessage());
+	}
+
+	return ok;
+}
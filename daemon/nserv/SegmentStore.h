@@ -0,0 +1,76 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include "NString.h"
+#include "FileSystem.h"
+
+/*
+ Pre-encoded articles for all files in data-dir, split into segments the same
+ way as NzbGenerator does. Article bodies (yEnc-data including the terminating
+ ".\r\n") are stored one after another in store-file, which is mapped into
+ memory when serving. The index is kept in "<store-file>.idx"; the store is
+ rebuilt when files in data-dir or the segment size change.
+*/
+class SegmentStore
+{
+public:
+	struct Segment
+	{
+		int64 offset;
+		int size;
+	};
+
+	SegmentStore(const char* dataDir, const char* filename, int segmentSize) :
+		m_dataDir(dataDir), m_filename(filename), m_segmentSize(segmentSize) {}
+	bool Load();
+	const char* GetFilename() { return m_filename; }
+	const Segment* Find(const char* key);
+	const char* GetData(const Segment* segment) { return m_data.GetData() + segment->offset; }
+	static void MakeKey(BString<1024>& key, const char* filename, int part, int64 offset, int size);
+
+private:
+	struct Source
+	{
+		CString filename;
+		int64 size;
+		int64 time;
+	};
+
+	typedef std::vector<Source> SourceList;
+	typedef std::unordered_map<std::string, Segment> SegmentMap;
+
+	CString m_dataDir;
+	CString m_filename;
+	int m_segmentSize;
+	SegmentMap m_segments;
+	MappedFile m_data;
+
+	void CollectSources(SourceList& sources);
+	void AddSource(SourceList& sources, const char* filename);
+	bool ReadIndex(SourceList& sources);
+	bool Build(SourceList& sources);
+	bool EncodeSource(Source& source, DiskFile& storeFile, DiskFile& indexFile);
+};
+
+#endif
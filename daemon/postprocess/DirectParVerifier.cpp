@@ -0,0 +1,600 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#ifndef DISABLE_PARCHECK
+
+#include "DirectParVerifier.h"
+#include "Options.h"
+#include "Util.h"
+#include "FileSystem.h"
+#include "ParParser.h"
+#include "par2cmdline.h"
+#include "par2repairer.h"
+
+class DirectParSetRepairer : public Par2::Par2Repairer
+{
+public:
+	DirectParSetRepairer() : Par2::Par2Repairer(m_nout, m_nout) {};
+	friend class DirectParSetLoader;
+
+private:
+	class NullStreamBuf : public std::streambuf {};
+	NullStreamBuf m_nullbuf;
+	std::ostream m_nout{&m_nullbuf};
+};
+
+class DirectParSetLoader : public Thread
+{
+public:
+	static void StartLoader(DirectParVerifier* owner, NzbInfo* nzbInfo, const char* parFilename);
+	virtual void Run();
+
+private:
+	DirectParVerifier* m_owner;
+	int m_nzbId;
+	CString m_parFilename;
+	CString m_fullFilename;
+
+	std::unique_ptr<DirectParVerifier::ParSet> LoadParSet();
+
+	friend class DirectParVerifier;
+};
+
+void DirectParSetLoader::StartLoader(DirectParVerifier* owner, NzbInfo* nzbInfo, const char* parFilename)
+{
+	DirectParSetLoader* loader = new DirectParSetLoader();
+	loader->m_owner = owner;
+	loader->m_nzbId = nzbInfo->GetId();
+	loader->m_parFilename = parFilename;
+	loader->m_fullFilename.Format("%s%c%s", nzbInfo->GetDestDir(), PATH_SEPARATOR, parFilename);
+
+	owner->m_loaders.push_back(loader);
+
+	loader->SetAutoDestroy(true);
+	loader->Start();
+}
+
+void DirectParSetLoader::Run()
+{
+	debug("Started DirectParSetLoader for %s", *m_fullFilename);
+
+	std::unique_ptr<DirectParVerifier::ParSet> parSet = LoadParSet();
+
+	GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
+
+	// the owner disconnects the loaders it doesn't want to wait for (see DirectParVerifier::Stop)
+	if (m_owner)
+	{
+		m_owner->m_loaders.erase(std::find(m_owner->m_loaders.begin(), m_owner->m_loaders.end(), this));
+		m_owner->ParLoaded(downloadQueue, m_nzbId, m_parFilename, std::move(parSet));
+	}
+}
+
+std::unique_ptr<DirectParVerifier::ParSet> DirectParSetLoader::LoadParSet()
+{
+	DirectParSetRepairer repairer;
+
+	if (!repairer.LoadPacketsFromFile(*m_fullFilename) || !repairer.mainpacket)
+	{
+		return nullptr;
+	}
+
+	std::unique_ptr<DirectParVerifier::ParSet> parSet = std::make_unique<DirectParVerifier::ParSet>();
+	parSet->m_parFilename = *m_parFilename;
+	parSet->m_setId = repairer.mainpacket->SetId().print().c_str();
+	parSet->m_blockSize = repairer.mainpacket->BlockSize();
+
+	for (std::pair<const Par2::MD5Hash, Par2::Par2RepairerSourceFile*>& entry : repairer.sourcefilemap)
+	{
+		Par2::Par2RepairerSourceFile* sourceFile = entry.second;
+		if (!sourceFile || !sourceFile->GetDescriptionPacket() || !sourceFile->GetVerificationPacket())
+		{
+			// critical packets are missing, the par2-file is damaged
+			return nullptr;
+		}
+
+		std::string filename = Par2::DiskFile::TranslateFilename(sourceFile->GetDescriptionPacket()->FileName());
+		std::string hash = sourceFile->GetDescriptionPacket()->Hash16k().print();
+
+		parSet->m_sourceFiles.emplace_back(filename.c_str(), hash.c_str(),
+			sourceFile->GetDescriptionPacket()->FileSize());
+		DirectParVerifier::SourceFile& parSourceFile = parSet->m_sourceFiles.back();
+
+		Par2::VerificationPacket* packet = sourceFile->GetVerificationPacket();
+		parSourceFile.m_blockCrcs.reserve(packet->BlockCount());
+		for (uint32 i = 0; i < packet->BlockCount(); i++)
+		{
+			parSourceFile.m_blockCrcs.push_back(packet->VerificationEntry(i)->crc);
+		}
+	}
+
+	return parSet;
+}
+
+
+void DirectParVerifier::FileDownloaded(DownloadQueue* downloadQueue, FileInfo* fileInfo)
+{
+	NzbInfo* nzbInfo = fileInfo->GetNzbInfo();
+
+	NzbState* state = FindState(nzbInfo->GetId());
+	if (!state)
+	{
+		m_nzbStates.emplace_back(nzbInfo->GetId());
+		state = &m_nzbStates.back();
+	}
+
+	const char* filename = fileInfo->GetOutputFilename() ?
+		FileSystem::BaseFileName(fileInfo->GetOutputFilename()) : fileInfo->GetFilename();
+
+	if (fileInfo->GetParFile())
+	{
+		if (!HasLoadedCollection(state, filename, nullptr))
+		{
+			nzbInfo->PrintMessage(Message::mkInfo, "Loading par2-file %s for direct par-check", filename);
+			state->m_loadingPars.emplace_back(filename);
+			DirectParSetLoader::StartLoader(this, nzbInfo, filename);
+		}
+		return;
+	}
+
+	CompletedFile::EStatus status =
+		fileInfo->GetTotalArticles() == fileInfo->GetSuccessArticles() ? CompletedFile::cfSuccess :
+		fileInfo->GetTotalArticles() == fileInfo->GetMissedArticles() + fileInfo->GetFailedArticles() ? CompletedFile::cfFailure :
+		fileInfo->GetSuccessArticles() > 0 || fileInfo->GetFailedArticles() > 0 ? CompletedFile::cfPartial :
+		CompletedFile::cfNone;
+
+	state->m_files.emplace_back(filename, fileInfo->GetHash16k(), status,
+		status == CompletedFile::cfSuccess ? fileInfo->GetCrc() : 0);
+	DownloadedFile& file = state->m_files.back();
+
+	for (ArticleInfo* article : fileInfo->GetArticles())
+	{
+		bool success = article->GetStatus() == ArticleInfo::aiFinished;
+		if (success)
+		{
+			file.m_size += article->GetSegmentSize();
+		}
+		if (status == CompletedFile::cfPartial)
+		{
+			file.m_segments.emplace_back(success, article->GetSegmentOffset(), article->GetSegmentSize(),
+				article->GetCrc());
+		}
+	}
+
+	VerifyFiles(nzbInfo, state);
+}
+
+/*
+ * Hands the files verified during download over to post-processing,
+ * the par-checker doesn't need to verify them again.
+ */
+void DirectParVerifier::NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo,
+	PostInfo::DirectParFiles* directParFiles)
+{
+	NzbState* state = FindState(nzbInfo->GetId());
+	if (!state)
+	{
+		return;
+	}
+
+	if (!state->m_parSets.empty())
+	{
+		int damagedBlocks = 0;
+		int missingFiles = 0;
+
+		for (ParSet& parSet : state->m_parSets)
+		{
+			for (SourceFile& sourceFile : parSet.m_sourceFiles)
+			{
+				damagedBlocks += sourceFile.m_damagedBlocks;
+				missingFiles += sourceFile.m_matched ? 0 : 1;
+			}
+		}
+
+		nzbInfo->PrintMessage(Message::mkInfo,
+			"Direct par-check for %s: %i damaged block(s), %i missing file(s)",
+			nzbInfo->GetName(), damagedBlocks, missingFiles);
+	}
+
+	TakeVerifiedFiles(&state->m_files, directParFiles);
+
+	DeleteState(nzbInfo->GetId());
+}
+
+/*
+ * Good files and partially downloaded files with known damaged blocks are taken.
+ * Files of wrong size and files with a wrong checksum are left for the
+ * full verification, the checksum of the whole file can't tell which blocks are damaged.
+ */
+void DirectParVerifier::TakeVerifiedFiles(DownloadedFileList* files, PostInfo::DirectParFiles* directParFiles)
+{
+	for (DownloadedFile& file : *files)
+	{
+		if (!file.m_matched ||
+			(file.m_status == CompletedFile::cfSuccess && file.m_damagedBlocks != 0) ||
+			(file.m_status == CompletedFile::cfPartial && file.m_damagedBlocks <= 0))
+		{
+			continue;
+		}
+
+		directParFiles->emplace_back(file.m_sourceFilename, file.m_sourceSize, file.m_status);
+		if (file.m_status == CompletedFile::cfPartial)
+		{
+			*directParFiles->back().GetSegments() = std::move(file.m_segments);
+		}
+	}
+}
+
+void DirectParVerifier::NzbDeleted(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
+{
+	DeleteState(nzbInfo->GetId());
+}
+
+void DirectParVerifier::Stop()
+{
+	debug("DirectParVerifier: waiting for loaders to complete");
+
+	// wait 5 seconds until all loaders gracefully finish
+	time_t waitStart = Util::CurrentTime();
+	while (Util::CurrentTime() < waitStart + 5)
+	{
+		{
+			GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
+			if (m_loaders.empty())
+			{
+				return;
+			}
+		}
+		Util::Sleep(100);
+	}
+
+	// disconnect remaining loaders, they destroy themselves once loading is finished
+	GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
+	for (DirectParSetLoader* loader : m_loaders)
+	{
+		loader->m_owner = nullptr;
+	}
+	m_loaders.clear();
+}
+
+DirectParVerifier::NzbState* DirectParVerifier::FindState(int nzbId)
+{
+	NzbStateList::iterator pos = std::find_if(m_nzbStates.begin(), m_nzbStates.end(),
+		[nzbId](NzbState& state)
+		{
+			return state.m_nzbId == nzbId;
+		});
+
+	return pos != m_nzbStates.end() ? &*pos : nullptr;
+}
+
+void DirectParVerifier::DeleteState(int nzbId)
+{
+	m_nzbStates.erase(std::remove_if(m_nzbStates.begin(), m_nzbStates.end(),
+		[nzbId](NzbState& state)
+		{
+			return state.m_nzbId == nzbId;
+		}),
+		m_nzbStates.end());
+}
+
+bool DirectParVerifier::HasLoadedCollection(NzbState* state, const char* parFilename, const char* setId)
+{
+	auto sameCollection = [parFilename](const char* filename2)
+	{
+		return !strcasecmp(parFilename, filename2) ||
+			ParParser::SameParCollection(parFilename, filename2, false);
+	};
+
+	for (CString& loadingPar : state->m_loadingPars)
+	{
+		if (sameCollection(loadingPar))
+		{
+			return true;
+		}
+	}
+
+	for (ParSet& parSet : state->m_parSets)
+	{
+		if (sameCollection(parSet.m_parFilename) ||
+			(!Util::EmptyStr(setId) && !strcmp(setId, parSet.m_setId)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void DirectParVerifier::ParLoaded(DownloadQueue* downloadQueue, int nzbId, const char* parFilename,
+	std::unique_ptr<ParSet> parSet)
+{
+	NzbState* state = FindState(nzbId);
+	NzbInfo* nzbInfo = downloadQueue->FindNzb(nzbId);
+	if (!state || !nzbInfo)
+	{
+		// nzb has been completed or deleted in the meantime
+		return;
+	}
+
+	state->m_loadingPars.erase(std::remove_if(state->m_loadingPars.begin(), state->m_loadingPars.end(),
+		[parFilename](CString& loadingPar)
+		{
+			return !strcmp(loadingPar, parFilename);
+		}),
+		state->m_loadingPars.end());
+
+	if (!parSet)
+	{
+		nzbInfo->PrintMessage(Message::mkWarning, "Could not load par2-file %s for direct par-check", parFilename);
+		state->m_failed = true;
+		return;
+	}
+
+	for (ParSet& parSet2 : state->m_parSets)
+	{
+		if (!strcmp(parSet2.m_setId, parSet->m_setId))
+		{
+			// same par-set was already loaded from a file with different name
+			return;
+		}
+	}
+
+	nzbInfo->PrintMessage(Message::mkInfo, "Loaded par2-file %s for direct par-check", parFilename);
+
+	state->m_parSets.push_back(std::move(*parSet));
+	VerifyFiles(nzbInfo, state);
+}
+
+void DirectParVerifier::VerifyFiles(NzbInfo* nzbInfo, NzbState* state)
+{
+	for (ParSet& parSet : state->m_parSets)
+	{
+		bool damaged = false;
+
+		for (DownloadedFile& file : state->m_files)
+		{
+			if (file.m_matched)
+			{
+				continue;
+			}
+
+			SourceFileList::iterator pos = std::find_if(parSet.m_sourceFiles.begin(), parSet.m_sourceFiles.end(),
+				[&file](SourceFile& sourceFile)
+				{
+					return !sourceFile.m_matched &&
+						(!strcasecmp(file.m_filename, sourceFile.m_filename) ||
+						 (!Util::EmptyStr(file.m_hash16k) && !strcmp(file.m_hash16k, sourceFile.m_hash16k)));
+				});
+
+			if (pos == parSet.m_sourceFiles.end())
+			{
+				continue;
+			}
+
+			SourceFile& sourceFile = *pos;
+			int damagedBlocks = CalcDamagedBlocks(&parSet, &sourceFile, &file);
+
+			file.m_matched = true;
+			file.m_sourceFilename = *sourceFile.m_filename;
+			file.m_sourceSize = sourceFile.m_size;
+			file.m_damagedBlocks = damagedBlocks;
+			if (file.m_status != CompletedFile::cfPartial || damagedBlocks <= 0)
+			{
+				// segments are needed only to tell the valid blocks of damaged files
+				file.m_segments.clear();
+				file.m_segments.shrink_to_fit();
+			}
+			sourceFile.m_matched = true;
+			sourceFile.m_damagedBlocks = std::max(damagedBlocks, 0);
+
+			if (damagedBlocks == 0)
+			{
+				nzbInfo->PrintMessage(Message::mkDetail, "Directly verified good file %s", *file.m_filename);
+			}
+			else if (damagedBlocks > 0 && file.m_status == CompletedFile::cfSuccess)
+			{
+				nzbInfo->PrintMessage(Message::mkInfo,
+					"Directly verified damaged file %s: checksums do not match, considering all %i block(s) damaged",
+					*file.m_filename, damagedBlocks);
+				damaged = true;
+			}
+			else if (damagedBlocks > 0)
+			{
+				nzbInfo->PrintMessage(Message::mkInfo, "Directly verified damaged file %s: %i of %i block(s) damaged",
+					*file.m_filename, damagedBlocks, (int)sourceFile.m_blockCrcs.size());
+				damaged = true;
+			}
+			else
+			{
+				nzbInfo->PrintMessage(Message::mkInfo, "Could not directly verify file %s, file size does not match",
+					*file.m_filename);
+			}
+		}
+
+		if (damaged)
+		{
+			RequestPars(nzbInfo, &parSet);
+		}
+	}
+}
+
+/*
+ * Computes the number of damaged blocks of a downloaded file using the CRCs
+ * of articles and the block CRCs from par2-file, without reading the file.
+ * For partially downloaded files every block not completely covered by
+ * successfully downloaded articles is considered damaged.
+ * If the checksum of a completely downloaded file doesn't match, the checksums
+ * of articles can't tell which blocks are affected and all blocks are
+ * considered damaged.
+ * Returns vrNotMatching if the size of the file doesn't match the source file
+ * from the par-set.
+ */
+int DirectParVerifier::CalcDamagedBlocks(ParSet* parSet, SourceFile* sourceFile, DownloadedFile* file)
+{
+	int blockCount = (int)sourceFile->m_blockCrcs.size();
+	int64 blockSize = parSet->m_blockSize;
+
+	if (file->m_status == CompletedFile::cfSuccess)
+	{
+		if (file->m_size != sourceFile->m_size || blockCount == 0)
+		{
+			return blockCount == 0 && file->m_size == 0 ? 0 : vrNotMatching;
+		}
+
+		// extend download CRC to block size
+		uint32 downloadCrc = Par2::CRCUpdateBlock(file->m_crc ^ 0xFFFFFFFF,
+			(size_t)(blockSize * blockCount - sourceFile->m_size)) ^ 0xFFFFFFFF;
+
+		// compute file CRC using CRCs of blocks
+		uint32 parCrc = 0;
+		for (int i = 0; i < blockCount; i++)
+		{
+			uint32 blockCrc = sourceFile->m_blockCrcs[i];
+			parCrc = i == 0 ? blockCrc : Crc32::Combine(parCrc, blockCrc, (uint32)blockSize);
+		}
+
+		return parCrc == downloadCrc ? 0 : blockCount;
+	}
+
+	if (file->m_status != CompletedFile::cfPartial)
+	{
+		return blockCount;
+	}
+
+	// merge successfully downloaded adjacent articles into continuous ranges
+	std::vector<std::pair<int64, int64>> ranges;
+	for (Segment& segment : file->m_segments)
+	{
+		if (!segment.m_success)
+		{
+			continue;
+		}
+		if (!ranges.empty() && ranges.back().second == segment.m_offset)
+		{
+			ranges.back().second += segment.m_size;
+		}
+		else
+		{
+			ranges.emplace_back(segment.m_offset, segment.m_offset + segment.m_size);
+		}
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+
+	int validBlocks = 0;
+	std::vector<std::pair<int64, int64>>::iterator range = ranges.begin();
+	for (int i = 0; i < blockCount && range != ranges.end(); i++)
+	{
+		int64 blockStart = i * blockSize;
+		int64 blockEnd = std::min(blockStart + blockSize, sourceFile->m_size);
+
+		while (range != ranges.end() && range->second < blockEnd)
+		{
+			range++;
+		}
+
+		if (range != ranges.end() && range->first <= blockStart)
+		{
+			validBlocks++;
+		}
+	}
+
+	return blockCount - validBlocks;
+}
+
+void DirectParVerifier::RequestPars(NzbInfo* nzbInfo, ParSet* parSet)
+{
+	if (g_Options->GetParCheck() != Options::pcAuto && g_Options->GetParCheck() != Options::pcAlways)
+	{
+		// in mode "Force" all par2-files are downloaded anyway,
+		// in mode "Manual" they are unpaused only if the download is damaged
+		return;
+	}
+
+	int damagedBlocks = 0;
+	for (SourceFile& sourceFile : parSet->m_sourceFiles)
+	{
+		damagedBlocks += sourceFile.m_damagedBlocks;
+	}
+
+	int availableBlocks = 0;
+	for (CompletedFile& completedFile : nzbInfo->GetCompletedFiles())
+	{
+		int blocks = 0;
+		if (completedFile.GetParFile() &&
+			ParParser::SameParCollection(completedFile.GetFilename(), parSet->m_parFilename, false) &&
+			ParParser::ParseParFilename(completedFile.GetFilename(), false, nullptr, &blocks))
+		{
+			availableBlocks += blocks;
+		}
+	}
+
+	RawFileList pausedPars;
+	for (FileInfo* fileInfo : nzbInfo->GetFileList())
+	{
+		int blocks = 0;
+		if (fileInfo->GetParFile() &&
+			ParParser::SameParCollection(fileInfo->GetFilename(), parSet->m_parFilename, false) &&
+			ParParser::ParseParFilename(fileInfo->GetFilename(), fileInfo->GetFilenameConfirmed(), nullptr, &blocks) &&
+			blocks > 0)
+		{
+			if (fileInfo->GetPaused())
+			{
+				pausedPars.push_back(fileInfo);
+			}
+			else
+			{
+				availableBlocks += blocks;
+			}
+		}
+	}
+
+	std::sort(pausedPars.begin(), pausedPars.end(),
+		[](FileInfo* fileInfo1, FileInfo* fileInfo2)
+		{
+			int blocks1 = 0, blocks2 = 0;
+			ParParser::ParseParFilename(fileInfo1->GetFilename(), fileInfo1->GetFilenameConfirmed(), nullptr, &blocks1);
+			ParParser::ParseParFilename(fileInfo2->GetFilename(), fileInfo2->GetFilenameConfirmed(), nullptr, &blocks2);
+			return blocks1 < blocks2;
+		});
+
+	for (FileInfo* fileInfo : pausedPars)
+	{
+		if (availableBlocks >= damagedBlocks)
+		{
+			break;
+		}
+
+		int blocks = 0;
+		ParParser::ParseParFilename(fileInfo->GetFilename(), fileInfo->GetFilenameConfirmed(), nullptr, &blocks);
+		availableBlocks += blocks;
+
+		nzbInfo->PrintMessage(Message::mkInfo, "Unpausing %s%c%s for par-recovery",
+			nzbInfo->GetName(), PATH_SEPARATOR, fileInfo->GetFilename());
+		fileInfo->SetPaused(false);
+		fileInfo->SetExtraPriority(true);
+		nzbInfo->SetChanged(true);
+	}
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DIRECTPARVERIFIER_H
+#define DIRECTPARVERIFIER_H
+
+#ifndef DISABLE_PARCHECK
+
+#include "DownloadInfo.h"
+
+class DirectParSetLoader;
+
+/*
+ * Verifies files against par2-checksums while the nzb is still downloading.
+ * The critical packets are loaded as soon as the first par2-file of a
+ * collection is completed; every completed file is then checked using CRCs
+ * computed during download, without reading the file from disk.
+ * All methods must be called with locked DownloadQueue.
+ */
+class DirectParVerifier
+{
+public:
+	// result of CalcDamagedBlocks if the size of the file doesn't match
+	enum EVerifyResult
+	{
+		vrNotMatching = -1
+	};
+
+	struct SourceFile
+	{
+		CString m_filename;
+		CString m_hash16k;
+		int64 m_size;
+		std::vector<uint32> m_blockCrcs;
+		bool m_matched = false;
+		int m_damagedBlocks = 0;
+
+		SourceFile(const char* filename, const char* hash16k, int64 size) :
+			m_filename(filename), m_hash16k(hash16k), m_size(size) {}
+	};
+
+	typedef std::deque<SourceFile> SourceFileList;
+
+	struct ParSet
+	{
+		CString m_parFilename;
+		CString m_setId;
+		int64 m_blockSize = 0;
+		SourceFileList m_sourceFiles;
+	};
+
+	typedef PostInfo::DirectParFile::Segment Segment;
+	typedef PostInfo::DirectParFile::SegmentList SegmentList;
+
+	struct DownloadedFile
+	{
+		CString m_filename;
+		CString m_hash16k;
+		CompletedFile::EStatus m_status;
+		uint32 m_crc;
+		int64 m_size = 0;
+		SegmentList m_segments;
+		bool m_matched = false;
+		CString m_sourceFilename;
+		int64 m_sourceSize = 0;
+		int m_damagedBlocks = 0;
+
+		DownloadedFile(const char* filename, const char* hash16k, CompletedFile::EStatus status, uint32 crc) :
+			m_filename(filename), m_hash16k(hash16k), m_status(status), m_crc(crc) {}
+	};
+
+	typedef std::deque<DownloadedFile> DownloadedFileList;
+
+	void FileDownloaded(DownloadQueue* downloadQueue, FileInfo* fileInfo);
+	void NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo, PostInfo::DirectParFiles* directParFiles);
+	void NzbDeleted(DownloadQueue* downloadQueue, NzbInfo* nzbInfo);
+	// must be called without locked DownloadQueue
+	void Stop();
+	static int CalcDamagedBlocks(ParSet* parSet, SourceFile* sourceFile, DownloadedFile* file);
+	static void TakeVerifiedFiles(DownloadedFileList* files, PostInfo::DirectParFiles* directParFiles);
+
+private:
+	struct NzbState
+	{
+		int m_nzbId;
+		std::deque<ParSet> m_parSets;
+		DownloadedFileList m_files;
+		std::vector<CString> m_loadingPars;
+		bool m_failed = false;
+
+		NzbState(int nzbId) : m_nzbId(nzbId) {}
+	};
+
+	typedef std::deque<NzbState> NzbStateList;
+
+	NzbStateList m_nzbStates;
+	std::vector<DirectParSetLoader*> m_loaders;
+
+	NzbState* FindState(int nzbId);
+	void DeleteState(int nzbId);
+	void ParLoaded(DownloadQueue* downloadQueue, int nzbId, const char* parFilename, std::unique_ptr<ParSet> parSet);
+	void VerifyFiles(NzbInfo* nzbInfo, NzbState* state);
+	void RequestPars(NzbInfo* nzbInfo, ParSet* parSet);
+	bool HasLoadedCollection(NzbState* state, const char* parFilename, const char* setId);
+
+	friend class DirectParSetLoader;
+};
+
+#endif
+
+#endif
@@ -21,6 +21,7 @@
 #include "nzbget.h"
 #include "DirectUnpack.h"
 #include "Log.h"
+#include "RarReader.h"
 #include "Util.h"
 #include "FileSystem.h"
 #include "Options.h"
@@ -44,7 +45,7 @@ void DirectUnpack::Run()
 	{
 		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
 
-		NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
+		NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
 		if (!nzbInfo)
 		{
 			debug("Could not find NzbInfo for %i", m_nzbId);
@@ -60,6 +61,14 @@ void DirectUnpack::Run()
 		{
 			m_password = parameter->GetValue();
 		}
+
+		for (CompletedFile& completedFile : nzbInfo->GetCompletedFiles())
+		{
+			if (!IsFirstVolume(completedFile.GetRarInfo()))
+			{
+				m_nonFirstVolumes.emplace_back(completedFile.GetFilename());
+			}
+		}
 	}
 
 	m_infoName.Format("direct unpack for %s", *m_name);
@@ -74,7 +83,9 @@ void DirectUnpack::Run()
 	{
 		CString archive;
 		{
+			// sleep until a new archive arrives, the nzb is completed or we are stopped
 			Guard guard(m_volumeMutex);
+			m_volumeCond.Wait(m_volumeMutex, [&]{ return !m_archives.empty() || m_nzbCompleted || IsStopped(); });
 			if (!m_archives.empty())
 			{
 				archive = std::move(m_archives.front());
@@ -99,13 +110,9 @@ void DirectUnpack::Run()
 				break;
 			}
 		}
-		else
+		else if (m_nzbCompleted)
 		{
-			if (m_nzbCompleted)
-			{
-				break;
-			}
-			Util::Sleep(100);
+			break;
 		}
 	}
 
@@ -117,7 +124,7 @@ void DirectUnpack::Run()
 	{
 		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
 
-		NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
+		NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
 		if (!nzbInfo || nzbInfo->GetUnpackThread() != this)
 		{
 			debug("Could not find NzbInfo for %s", *m_infoName);
@@ -259,7 +266,8 @@ void DirectUnpack::FindArchiveFiles()
 	DirBrowser dir(m_destDir);
 	while (const char* filename = dir.Next())
 	{
-		if (IsMainArchive(filename))
+		if (IsMainArchive(filename) &&
+			std::find(m_nonFirstVolumes.begin(), m_nonFirstVolumes.end(), filename) == m_nonFirstVolumes.end())
 		{
 			BString<1024> fullFilename("%s%c%s", *m_destDir, PATH_SEPARATOR, filename);
 			if (!FileSystem::DirectoryExists(fullFilename))
@@ -278,6 +286,16 @@ bool DirectUnpack::IsMainArchive(const char* filename)
 	return mainPart;
 }
 
+/**
+ * Check the volume number in rar-headers indexed during download. Filenames don't always
+ * tell the truth; a volume which isn't the first one must not be passed to unrar.
+ */
+bool DirectUnpack::IsFirstVolume(const char* rarInfo)
+{
+	RarVolume volume("");
+	return Util::EmptyStr(rarInfo) || !volume.Deserialize(rarInfo) || volume.GetVolumeNo() == 0;
+}
+
 /**
  * Unrar prints "Insert disk"-message without new line terminator.
  * In order to become the message we analyze the output after every char.
@@ -352,7 +370,7 @@ void DirectUnpack::AddMessage(Message::EKind kind, const char* text)
 	}
 
 	GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
-	NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
+	NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
 	if (nzbInfo)
 	{
 		nzbInfo->AddMessage(kind, msgText);
@@ -416,44 +434,93 @@ void DirectUnpack::Stop(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 	{
 		Terminate();
 	}
+	WakeUp();
+}
+
+void DirectUnpack::WakeUp()
+{
+	Guard guard(m_volumeMutex);
+	m_volumeCond.NotifyAll();
 }
 
 void DirectUnpack::WaitNextVolume(const char* filename)
 {
 	debug("WaitNextVolume for %s", filename);
 
-	// Stop direct unpack if destination directory was changed during unpack
+	bool volumeExists;
+	bool nzbCompleted = false;
+
 	{
 		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
-		NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
+		NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
+
+		// Stop direct unpack if destination directory was changed during unpack
 		if (nzbInfo && (strcmp(m_destDir, nzbInfo->GetDestDir()) ||
 			strcmp(m_finalDir, nzbInfo->BuildFinalDirName())))
 		{
 			nzbInfo->AddMessage(Message::mkWarning, BString<1024>("Destination directory changed for %s", nzbInfo->GetName()));
 			Stop(downloadQueue, nzbInfo);
 		}
+
+		// The check and the assignment of "m_waitingFile" are made under the queue lock,
+		// which is also held when "FileDownloaded" is called, so no volume can slip through
+		BString<1024> fullFilename("%s%c%s", *m_destDir, PATH_SEPARATOR, filename);
+		volumeExists = FileSystem::FileExists(fullFilename);
+		if (!volumeExists)
+		{
+			{
+				Guard guard(m_volumeMutex);
+				m_waitingFile = filename;
+				nzbCompleted = m_nzbCompleted;
+			}
+
+			if (!nzbCompleted && nzbInfo)
+			{
+				BoostVolume(downloadQueue, nzbInfo, filename);
+			}
+		}
 	}
 
-	BString<1024> fullFilename("%s%c%s", *m_destDir, PATH_SEPARATOR, filename);
-	if (FileSystem::FileExists(fullFilename))
+	// the queue must not be locked here: printing messages locks it again
+	// and writing to unrar may block
+	if (volumeExists)
 	{
 		Write("\n"); // emulating click on Enter-key for "continue"
 	}
-	else
+	else if (nzbCompleted)
 	{
-		Guard guard(m_volumeMutex);
-		m_waitingFile = filename;
-		if (m_nzbCompleted)
+		// nzb completed but unrar waits for another volume
+		PrintMessage(Message::mkWarning, "Could not find volume %s", filename);
+		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
+		NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
+		if (nzbInfo)
 		{
-			// nzb completed but unrar waits for another volume
-			PrintMessage(Message::mkWarning, "Could not find volume %s", filename);
-			GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
-			NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
 			Stop(downloadQueue, nzbInfo);
 		}
 	}
 }
 
+// Unrar is blocked until this volume is available, download it before other files
+void DirectUnpack::BoostVolume(DownloadQueue* downloadQueue, NzbInfo* nzbInfo, const char* filename)
+{
+	for (FileInfo* fileInfo : nzbInfo->GetFileList())
+	{
+		if (!strcasecmp(fileInfo->GetFilename(), filename))
+		{
+			if (!fileInfo->GetExtraPriority() || fileInfo->GetPaused())
+			{
+				nzbInfo->PrintMessage(Message::mkInfo, "Increasing priority for volume %s%c%s",
+					nzbInfo->GetName(), PATH_SEPARATOR, fileInfo->GetFilename());
+				fileInfo->SetPaused(false);
+				fileInfo->SetExtraPriority(true);
+				nzbInfo->SetChanged(true);
+				downloadQueue->Save();
+			}
+			return;
+		}
+	}
+}
+
 void DirectUnpack::FileDownloaded(DownloadQueue* downloadQueue, FileInfo* fileInfo)
 {
 	debug("FileDownloaded for %s/%s", fileInfo->GetNzbInfo()->GetName(), fileInfo->GetFilename());
@@ -471,9 +538,10 @@ void DirectUnpack::FileDownloaded(DownloadQueue* downloadQueue, FileInfo* fileIn
 		Write("\n"); // emulating click on Enter-key for "continue"
 	}
 
-	if (IsMainArchive(fileInfo->GetFilename()))
+	if (IsMainArchive(fileInfo->GetFilename()) && IsFirstVolume(fileInfo->GetRarInfo()))
 	{
 		m_archives.emplace_back(fileInfo->GetFilename());
+		m_volumeCond.NotifyAll();
 	}
 }
 
@@ -481,12 +549,18 @@ void DirectUnpack::NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 {
 	debug("NzbDownloaded for %s", nzbInfo->GetName());
 
-	Guard guard(m_volumeMutex);
-	m_nzbCompleted = true;
-	if (m_waitingFile)
+	CString waitingFile;
+	{
+		Guard guard(m_volumeMutex);
+		m_nzbCompleted = true;
+		waitingFile = *m_waitingFile;
+		m_volumeCond.NotifyAll();
+	}
+
+	if (waitingFile)
 	{
 		// nzb completed but unrar waits for another volume
-		nzbInfo->AddMessage(Message::mkWarning, BString<1024>("Unrar: Could not find volume %s", *m_waitingFile));
+		nzbInfo->AddMessage(Message::mkWarning, BString<1024>("Unrar: Could not find volume %s", *waitingFile));
 		Stop(downloadQueue, nzbInfo);
 		return;
 	}
@@ -66,19 +66,24 @@ private:
 	bool m_finalDirCreated = false;
 	bool m_nzbCompleted = false;
 	Mutex m_volumeMutex;
+	ConditionVar m_volumeCond;
 	ArchiveList m_archives;
 	bool m_processed = false;
 	bool m_unpacking = false;
 	time_t m_extraStartTime = 0;
 	ArchiveList m_extractedArchives;
+	ArchiveList m_nonFirstVolumes;
 
 	void CreateUnpackDir();
 	void FindArchiveFiles();
 	void ExecuteUnrar(const char* archiveName);
 	bool PrepareCmdParams(const char* command, ParamList* params, const char* infoName);
 	void WaitNextVolume(const char* filename);
+	void BoostVolume(DownloadQueue* downloadQueue, NzbInfo* nzbInfo, const char* filename);
+	void WakeUp();
 	void Cleanup();
 	bool IsMainArchive(const char* filename);
+	bool IsFirstVolume(const char* rarInfo);
 	void SetProgressLabel(NzbInfo* nzbInfo, const char* progressLabel);
 	void AddExtraTime(NzbInfo* nzbInfo);
 };
@@ -74,7 +74,7 @@ private:
 
 	virtual void BeginRepair();
 	virtual void EndRepair();
-	void RepairBlock(Par2::u32 inputindex, Par2::u32 outputindex, size_t blocklength);
+	void RepairBlocks(Par2::u32 inputindex, Par2::u32 firstoutput, Par2::u32 lastoutput, size_t blocklength);
 	static void SyncSleep();
 
 	friend class ParChecker;
@@ -85,7 +85,7 @@ class RepairThread : public Thread
 {
 public:
 	RepairThread(Repairer* owner) : m_owner(owner) {}
-	void RepairBlock(Par2::u32 inputindex, Par2::u32 outputindex, size_t blocklength);
+	void RepairBlocks(Par2::u32 inputindex, Par2::u32 firstoutput, Par2::u32 lastoutput, size_t blocklength);
 	bool IsWorking() { return m_working; }
 
 protected:
@@ -94,7 +94,8 @@ protected:
 private:
 	Repairer* m_owner;
 	Par2::u32 m_inputindex;
-	Par2::u32 m_outputindex;
+	Par2::u32 m_firstoutput;
+	Par2::u32 m_lastoutput;
 	size_t m_blocklength;
 	volatile bool m_working = false;
 };
@@ -147,7 +148,7 @@ Par2::Result Repairer::Process(bool dorepair)
 bool Repairer::ScanDataFile(Par2::DiskFile *diskfile, Par2::Par2RepairerSourceFile* &sourcefile,
 	Par2::MatchType &matchtype, Par2::MD5Hash &hashfull, Par2::MD5Hash &hash16k, Par2::u32 &count)
 {
-	if (m_owner->GetParQuick() && sourcefile)
+	if (sourcefile)
 	{
 		string path;
 		string name;
@@ -171,7 +172,12 @@ bool Repairer::ScanDataFile(Par2::DiskFile *diskfile, Par2::Par2RepairerSourceFi
 		}
 	}
 
-	return Par2Repairer::ScanDataFile(diskfile, sourcefile, matchtype, hashfull, hash16k, count);
+	int64 startTicks = Util::CurrentTicks();
+	bool ok = Par2Repairer::ScanDataFile(diskfile, sourcefile, matchtype, hashfull, hash16k, count);
+	m_owner->m_verifyTicks += Util::CurrentTicks() - startTicks;
+	m_owner->m_verifiedSize += diskfile->FileSize();
+
+	return ok;
 }
 
 void Repairer::BeginRepair()
@@ -186,6 +192,26 @@ void Repairer::BeginRepair()
 
 	m_parallel = threads > 1;
 
+	m_owner->PrintMessage(Message::mkInfo, "Repair of %s needs %i pass(es), reading %s and writing %s",
+		*m_owner->m_nzbName, (int)repairpasses, *Util::FormatSize(plannedreadsize),
+		*Util::FormatSize(plannedwritesize));
+
+	// Estimate the repair time from the throughput of the full verification
+	// of source files, which reads and hashes a comparable amount of data.
+	// Only the time spent scanning the files counts (not waiting for extra
+	// par-files), files verified using CRCs from download are not included.
+	// The Reed-Solomon computation isn't included either, so the estimate is
+	// rather low: if even this estimate exceeds the time limit, the repair
+	// can't finish in time.
+	// The estimate is only made if enough data was read to measure the throughput.
+	int64 verifyTicks = m_owner->m_verifyTicks;
+	if (verifyTicks >= 10000000 && m_owner->m_verifiedSize > 0)
+	{
+		m_owner->m_estimatedRepairSec = (int)((double)(plannedreadsize + plannedwritesize) *
+			verifyTicks / m_owner->m_verifiedSize / 1000000);
+		debug("Estimated repair time for %s: %i seconds", *m_owner->m_nzbName, m_owner->m_estimatedRepairSec);
+	}
+
 	if (m_parallel)
 	{
 		for (int i = 0; i < threads; i++)
@@ -217,6 +243,11 @@ void Repairer::EndRepair()
 	}
 }
 
+/*
+ * The output blocks are split into one range per thread. Every thread processes
+ * the input block tile by tile through all of its output blocks, so that each
+ * tile stays in the cache while it is multiplied into the output blocks.
+ */
 bool Repairer::RepairData(Par2::u32 inputindex, size_t blocklength)
 {
 	if (!m_parallel)
@@ -224,30 +255,13 @@ bool Repairer::RepairData(Par2::u32 inputindex, size_t blocklength)
 		return false;
 	}
 
-	for (Par2::u32 outputindex = 0; outputindex < missingblockcount; )
+	Par2::u32 threadcount = (Par2::u32)m_threads.size();
+	for (Par2::u32 i = 0; i < threadcount; i++)
 	{
-		bool jobAdded = false;
-		for (Thread* thread : m_threads)
-		{
-			RepairThread* repairThread = (RepairThread*)thread;
-			if (!repairThread->IsWorking())
-			{
-				repairThread->RepairBlock(inputindex, outputindex, blocklength);
-				outputindex++;
-				jobAdded = true;
-				break;
-			}
-		}
-
-		if (cancelled)
-		{
-			break;
-		}
-
-		if (!jobAdded)
-		{
-			SyncSleep();
-		}
+		RepairThread* repairThread = (RepairThread*)m_threads[i];
+		Par2::u32 firstoutput = (Par2::u32)((Par2::u64)missingblockcount * i / threadcount);
+		Par2::u32 lastoutput = (Par2::u32)((Par2::u64)missingblockcount * (i + 1) / threadcount);
+		repairThread->RepairBlocks(inputindex, firstoutput, lastoutput, blocklength);
 	}
 
 	// Wait until all m_Threads complete their jobs
@@ -270,30 +284,39 @@ bool Repairer::RepairData(Par2::u32 inputindex, size_t blocklength)
 	return true;
 }
 
-void Repairer::RepairBlock(Par2::u32 inputindex, Par2::u32 outputindex, size_t blocklength)
+void Repairer::RepairBlocks(Par2::u32 inputindex, Par2::u32 firstoutput, Par2::u32 lastoutput, size_t blocklength)
 {
-	// Select the appropriate part of the output buffer
-	void *outbuf = &((Par2::u8*)outputbuffer)[chunksize * outputindex];
-
-	// Process the data
-	rs.Process(blocklength, inputindex, inputbuffer, outputindex, outbuf);
-
-	if (noiselevel > Par2::CommandLine::nlQuiet)
+	for (size_t tileoffset = 0; tileoffset < blocklength && !cancelled; tileoffset += Par2::repairtilesize)
 	{
-		// Update a progress indicator
+		size_t tilelength = std::min(Par2::repairtilesize, blocklength - tileoffset);
+		const void* tile = &((const Par2::u8*)inputbuffer)[tileoffset];
 
-		Par2::u32 oldfraction;
-		Par2::u32 newfraction;
+		for (Par2::u32 outputindex = firstoutput; outputindex < lastoutput; outputindex++)
 		{
-			Guard guard(progresslock);
-			oldfraction = (Par2::u32)(1000 * progress / totaldata);
-			progress += blocklength;
-			newfraction = (Par2::u32)(1000 * progress / totaldata);
+			// Select the appropriate part of the output buffer
+			void *outbuf = &((Par2::u8*)outputbuffer)[chunksize * outputindex + tileoffset];
+
+			// Process the data
+			rs.Process(tilelength, inputindex, tile, outputindex, outbuf);
 		}
 
-		if (oldfraction != newfraction)
+		if (noiselevel > Par2::CommandLine::nlQuiet)
 		{
-			sig_progress(newfraction);
+			// Update a progress indicator
+
+			Par2::u32 oldfraction;
+			Par2::u32 newfraction;
+			{
+				Guard guard(progresslock);
+				oldfraction = (Par2::u32)(1000 * progress / totaldata);
+				progress += tilelength * (lastoutput - firstoutput);
+				newfraction = (Par2::u32)(1000 * progress / totaldata);
+			}
+
+			if (oldfraction != newfraction)
+			{
+				sig_progress(newfraction);
+			}
 		}
 	}
 }
@@ -315,7 +338,7 @@ void RepairThread::Run()
 	{
 		if (m_working)
 		{
-			m_owner->RepairBlock(m_inputindex, m_outputindex, m_blocklength);
+			m_owner->RepairBlocks(m_inputindex, m_firstoutput, m_lastoutput, m_blocklength);
 			m_working = false;
 		}
 		else
@@ -325,10 +348,12 @@ void RepairThread::Run()
 	}
 }
 
-void RepairThread::RepairBlock(Par2::u32 inputindex, Par2::u32 outputindex, size_t blocklength)
+void RepairThread::RepairBlocks(Par2::u32 inputindex, Par2::u32 firstoutput, Par2::u32 lastoutput,
+	size_t blocklength)
 {
 	m_inputindex = inputindex;
-	m_outputindex = outputindex;
+	m_firstoutput = firstoutput;
+	m_lastoutput = lastoutput;
 	m_blocklength = blocklength;
 	m_working = true;
 }
@@ -390,10 +415,11 @@ void ParChecker::Execute()
 {
 	m_status = RunParCheckAll();
 
-	if (m_status == psRepairNotNeeded && m_parQuick && m_forceRepair && !IsStopped())
+	if (m_status == psRepairNotNeeded && (m_parQuick || m_directVerified) && m_forceRepair && !IsStopped())
 	{
 		PrintMessage(Message::mkInfo, "Performing full par-check for %s", *m_nzbName);
 		m_parQuick = false;
+		m_parDirect = false;
 		m_status = RunParCheckAll();
 	}
 
@@ -451,6 +477,9 @@ ParChecker::EStatus ParChecker::RunParCheck(const char* parFilename)
 	m_quickFiles = 0;
 	m_verifyingExtraFiles = false;
 	m_hasDamagedFiles = false;
+	m_verifiedSize = 0;
+	m_verifyTicks = 0;
+	m_estimatedRepairSec = 0;
 	EStatus status = psFailed;
 
 	PrintMessage(Message::mkInfo, "Verifying %s", *m_infoName);
@@ -1294,6 +1323,10 @@ void ParChecker::DeleteLeftovers()
  *   in PAR2-file;
  * - for completely failed files (not a single successful article) no verification is needed at all.
  *
+ * Files verified during download (option DirectParCheck) are also handled here, even if
+ * quick verification is disabled: good files are taken as they are, for damaged files the
+ * CRCs of articles passed from the download are used and the file state isn't loaded.
+ *
  * Limitation of the function:
  * This function requires every block in the file to have an unique CRC (across all blocks
  * of the par-set). Otherwise the full verification is performed.
@@ -1307,7 +1340,7 @@ ParChecker::EFileStatus ParChecker::VerifyDataFile(void* diskfile, void* sourcef
 		// skipping verification for repaired files, assuming the files were correctly repaired,
 		// the only reason for incorrect files after repair are hardware errors (memory, disk),
 		// but this isn't something NZBGet should care about.
-		return fsSuccess;
+		return m_parQuick ? fsSuccess : fsUnknown;
 	}
 
 	Par2::DiskFile* diskFile = (Par2::DiskFile*)diskfile;
@@ -1333,20 +1366,37 @@ ParChecker::EFileStatus ParChecker::VerifyDataFile(void* diskfile, void* sourcef
 	}
 
 	// find file status and CRC computed during download
-	uint32 downloadCrc;
+	uint32 downloadCrc = 0;
+	int64 directSize = 0;
 	SegmentList segments;
-	EFileStatus	fileStatus = FindFileCrc(FileSystem::BaseFileName(filename), &downloadCrc, &segments);
+	EFileStatus	fileStatus = m_parDirect ?
+		FindDirectFile(FileSystem::BaseFileName(filename), &directSize, &segments) : fsUnknown;
+	bool direct = fileStatus != fsUnknown;
 	ValidBlocks validBlocks;
 
+	if (direct && directSize != FileSystem::FileSize(filename))
+	{
+		// the file was changed after download
+		return fsUnknown;
+	}
+	else if (!direct && !m_parQuick)
+	{
+		return fsUnknown;
+	}
+	else if (!direct)
+	{
+		fileStatus = FindFileCrc(FileSystem::BaseFileName(filename), &downloadCrc, &segments);
+	}
+
 	if (fileStatus == fsFailure || fileStatus == fsUnknown)
 	{
 		return fileStatus;
 	}
-	else if ((fileStatus == fsSuccess && !VerifySuccessDataFile(diskfile, sourcefile, downloadCrc)) ||
+	else if ((fileStatus == fsSuccess && !direct && !VerifySuccessDataFile(diskfile, sourcefile, downloadCrc)) ||
 		(fileStatus == fsPartial && !VerifyPartialDataFile(diskfile, sourcefile, &segments, &validBlocks)))
 	{
-		PrintMessage(Message::mkWarning, "Quick verification failed for %s file %s, performing full verification instead",
-			fileStatus == fsSuccess ? "good" : "damaged", FileSystem::BaseFileName(filename));
+		PrintMessage(Message::mkWarning, "%s verification failed for %s file %s, performing full verification instead",
+			direct ? "Direct" : "Quick", fileStatus == fsSuccess ? "good" : "damaged", FileSystem::BaseFileName(filename));
 		return fsUnknown; // let libpar2 do the full verification of the file
 	}
 
@@ -1380,7 +1430,8 @@ ParChecker::EFileStatus ParChecker::VerifyDataFile(void* diskfile, void* sourcef
 	}
 
 	m_quickFiles++;
-	PrintMessage(Message::mkDetail, "Quickly verified %s file %s",
+	m_directVerified |= direct;
+	PrintMessage(Message::mkDetail, "%s %s file %s", direct ? "Verified during download" : "Quickly verified",
 		fileStatus == fsSuccess ? "good" : "damaged", FileSystem::BaseFileName(filename));
 
 	return fileStatus;
@@ -132,6 +132,7 @@ protected:
 	virtual void RegisterParredFile(const char* filename) {}
 	virtual bool IsParredFile(const char* filename) { return false; }
 	virtual EFileStatus FindFileCrc(const char* filename, uint32* crc, SegmentList* segments) { return fsUnknown; }
+	virtual EFileStatus FindDirectFile(const char* filename, int64* size, SegmentList* segments) { return fsUnknown; }
 	virtual const char* FindFileOrigname(const char* filename) { return nullptr; }
 	virtual void RequestDupeSources(DupeSourceList* dupeSourceList) {}
 	virtual void StatDupeSources(DupeSourceList* dupeSourceList) {}
@@ -139,6 +140,7 @@ protected:
 	const char* GetProgressLabel() { return m_progressLabel; }
 	int GetFileProgress() { return m_fileProgress; }
 	int GetStageProgress() { return m_stageProgress; }
+	int GetEstimatedRepairSec() { return m_estimatedRepairSec; }
 
 private:
 	class StreamBuf : public std::streambuf
@@ -179,9 +181,14 @@ private:
 	SourceList m_sourceFiles;
 	std::string m_lastFilename;
 	bool m_hasDamagedFiles;
+	int64 m_verifyTicks = 0;
+	int64 m_verifiedSize = 0;
+	int m_estimatedRepairSec = 0;
 	bool m_parQuick = false;
 	bool m_forceRepair = false;
 	bool m_parFull = false;
+	bool m_parDirect = true;
+	bool m_directVerified = false;
 	DupeSourceList m_dupeSources;
 	StreamBuf m_parOutStream{this, Message::mkDetail};
 	StreamBuf m_parErrStream{this, Message::mkError};
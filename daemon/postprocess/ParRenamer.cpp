@@ -197,28 +197,71 @@ void ParRenamer::LoadParFile(const char* parFilename)
 
 void ParRenamer::CheckFiles(const char* destDir, bool checkPars)
 {
+	ScanList files;
+
 	DirBrowser dir(destDir);
 	while (const char* filename = dir.Next())
 	{
-		if (!IsStopped())
+		BString<1024> fullFilename("%s%c%s", destDir, PATH_SEPARATOR, filename);
+		if (!FileSystem::DirectoryExists(fullFilename))
 		{
-			BString<1024> fullFilename("%s%c%s", destDir, PATH_SEPARATOR, filename);
+			files.emplace_back(fullFilename);
+		}
+	}
 
-			if (!FileSystem::DirectoryExists(fullFilename))
+	// only the beginning of files is read; request it for all files before reading any of them
+	for (ScanFile& file : files)
+	{
+		FileSystem::WillNeed(file.m_filename, READ_AHEAD_SIZE, 0);
+	}
+
+	// read files in parallel and process the results in directory order
+	WorkerPool pool(WorkerPool::IO_THREADS);
+	pool.Execute((int)files.size(),
+		[&](int index)
+		{
+			if (checkPars)
+			{
+				ReadParSetId(&files[index]);
+			}
+			else
+			{
+				ReadHash16k(&files[index]);
+			}
+		},
+		[&](int completed, int lastIndex)
+		{
+			m_progressLabel.Format("Checking file %s", FileSystem::BaseFileName(files[lastIndex].m_filename));
+			m_stageProgress = m_fileCount > 0 ? (m_curFile + completed) * 1000 / m_fileCount / 2 : 1000;
+			UpdateProgress();
+			if (IsStopped())
 			{
-				m_progressLabel.Format("Checking file %s", filename);
-				m_stageProgress = m_fileCount > 0 ? m_curFile * 1000 / m_fileCount / 2 : 1000;
-				UpdateProgress();
-				m_curFile++;
+				pool.Stop();
+			}
+		});
 
-				if (checkPars)
-				{
-					CheckParFile(destDir, fullFilename);
-				}
-				else
-				{
-					CheckRegularFile(destDir, fullFilename);
-				}
+	m_curFile += (int)files.size();
+
+	for (ScanFile& file : files)
+	{
+		if (IsStopped())
+		{
+			break;
+		}
+
+		if (!file.m_error.Empty())
+		{
+			PrintMessage(Message::mkError, "%s", *file.m_error);
+		}
+		else if (!file.m_result.Empty())
+		{
+			if (checkPars)
+			{
+				CheckParFile(file.m_filename, file.m_result);
+			}
+			else
+			{
+				CheckRegularFile(destDir, file.m_filename, file.m_result);
 			}
 		}
 	}
@@ -263,14 +306,14 @@ bool ParRenamer::IsSplittedFragment(const char* filename, const char* correctNam
 	return splittedFragement;
 }
 
-void ParRenamer::CheckRegularFile(const char* destDir, const char* filename)
+void ParRenamer::ReadHash16k(ScanFile* file)
 {
-	debug("Computing hash for %s", filename);
+	debug("Computing hash for %s", *file->m_filename);
 
-	DiskFile file;
-	if (!file.Open(filename, DiskFile::omRead))
+	DiskFile diskFile;
+	if (!diskFile.Open(file->m_filename, DiskFile::omRead))
 	{
-		PrintMessage(Message::mkError, "Could not open file %s", filename);
+		file->m_error.Format("Could not open file %s", *file->m_filename);
 		return;
 	}
 
@@ -278,25 +321,30 @@ void ParRenamer::CheckRegularFile(const char* destDir, const char* filename)
 	static const int blockSize = 16*1024;
 	CharBuffer buffer(blockSize);
 
-	int readBytes = (int)file.Read(buffer, buffer.Size());
-	if (readBytes != buffer.Size() && file.Error())
+	int readBytes = (int)diskFile.Read(buffer, buffer.Size());
+	if (readBytes != buffer.Size() && diskFile.Error())
 	{
-		PrintMessage(Message::mkError, "Could not read file %s", filename);
+		file->m_error.Format("Could not read file %s", *file->m_filename);
 		return;
 	}
 
-	file.Close();
+	diskFile.Close();
 
 	Par2::MD5Hash hash16k;
 	Par2::MD5Context context;
 	context.Update(buffer, readBytes);
 	context.Final(hash16k);
 
-	debug("file: %s; hash16k: %s", FileSystem::BaseFileName(filename), hash16k.print().c_str());
+	file->m_result = hash16k.print().c_str();
+}
+
+void ParRenamer::CheckRegularFile(const char* destDir, const char* filename, const char* hash16k)
+{
+	debug("file: %s; hash16k: %s", FileSystem::BaseFileName(filename), hash16k);
 
 	for (FileHash& fileHash : m_fileHashList)
 	{
-		if (!strcmp(fileHash.GetHash(), hash16k.print().c_str()))
+		if (!strcmp(fileHash.GetHash(), hash16k))
 		{
 			debug("Found correct filename: %s", fileHash.GetFilename());
 			fileHash.SetFileExists(true);
@@ -313,34 +361,34 @@ void ParRenamer::CheckRegularFile(const char* destDir, const char* filename)
 	}
 }
 
-void ParRenamer::CheckParFile(const char* destDir, const char* filename)
+void ParRenamer::ReadParSetId(ScanFile* file)
 {
-	debug("Checking par2-header for %s", filename);
+	debug("Checking par2-header for %s", *file->m_filename);
 
-	DiskFile file;
-	if (!file.Open(filename, DiskFile::omRead))
+	DiskFile diskFile;
+	if (!diskFile.Open(file->m_filename, DiskFile::omRead))
 	{
-		PrintMessage(Message::mkError, "Could not open file %s", filename);
+		file->m_error.Format("Could not open file %s", *file->m_filename);
 		return;
 	}
 
 	// load par2-header
 	Par2::PACKET_HEADER header;
 
-	int readBytes = (int)file.Read(&header, sizeof(header));
-	if (readBytes != sizeof(header) && file.Error())
+	int readBytes = (int)diskFile.Read(&header, sizeof(header));
+	if (readBytes != sizeof(header) && diskFile.Error())
 	{
-		PrintMessage(Message::mkError, "Could not read file %s", filename);
+		file->m_error.Format("Could not read file %s", *file->m_filename);
 		return;
 	}
 
-	file.Close();
+	diskFile.Close();
 
 	// Check the packet header
 	if (Par2::packet_magic != header.magic ||          // not par2-file
 		sizeof(Par2::PACKET_HEADER) > header.length || // packet length is too small
 		0 != (header.length & 3) ||              // packet length is not a multiple of 4
-		FileSystem::FileSize(filename) < (int)header.length)       // packet would extend beyond the end of the file
+		FileSystem::FileSize(file->m_filename) < (int)header.length)       // packet would extend beyond the end of the file
 	{
 		// not par2-file or damaged header, ignoring the file
 		return;
@@ -349,7 +397,12 @@ void ParRenamer::CheckParFile(const char* destDir, const char* filename)
 	BString<100> setId = header.setid.print().c_str();
 	for (char* p = setId; *p; p++) *p = tolower(*p); // convert string to lowercase
 
-	debug("Storing: %s; setid: %s", FileSystem::BaseFileName(filename), *setId);
+	file->m_result = *setId;
+}
+
+void ParRenamer::CheckParFile(const char* filename, const char* setId)
+{
+	debug("Storing: %s; setid: %s", FileSystem::BaseFileName(filename), setId);
 
 	m_parInfoList.emplace_back(filename, setId);
 }
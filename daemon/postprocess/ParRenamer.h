@@ -75,9 +75,22 @@ private:
 		CString m_setId;
 	};
 
+	struct ScanFile
+	{
+		CString m_filename;
+		CString m_result;
+		CString m_error;
+
+		ScanFile(const char* filename) : m_filename(filename) {}
+	};
+
+	// enough for the 16K hash and for the header packet of par2-files
+	static const int64 READ_AHEAD_SIZE = 16 * 1024;
+
 	typedef std::deque<FileHash> FileHashList;
 	typedef std::deque<ParInfo> ParInfoList;
 	typedef std::deque<CString> NameList;
+	typedef std::vector<ScanFile> ScanList;
 
 	CString m_infoName;
 	CString m_destDir;
@@ -100,8 +113,10 @@ private:
 	void LoadExtraParFiles(const char* destDir);
 	void LoadParFile(const char* parFilename);
 	void CheckFiles(const char* destDir, bool checkPars);
-	void CheckRegularFile(const char* destDir, const char* filename);
-	void CheckParFile(const char* destDir, const char* filename);
+	void ReadHash16k(ScanFile* file);
+	void ReadParSetId(ScanFile* file);
+	void CheckRegularFile(const char* destDir, const char* filename, const char* hash16k);
+	void CheckParFile(const char* filename, const char* setId);
 	bool IsSplittedFragment(const char* filename, const char* correctName);
 	void CheckMissing();
 	void RenameParFiles(const char* destDir);
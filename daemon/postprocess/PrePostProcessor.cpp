@@ -149,6 +149,10 @@ void PrePostProcessor::WaitJobs()
 		}
 	}
 
+#ifndef DISABLE_PARCHECK
+	m_directParVerifier.Stop();
+#endif
+
 	debug("PrePostProcessor: Jobs are completed");
 }
 
@@ -333,6 +337,11 @@ void PrePostProcessor::NzbAdded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 
 void PrePostProcessor::NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 {
+#ifndef DISABLE_PARCHECK
+	PostInfo::DirectParFiles directParFiles;
+	m_directParVerifier.NzbDownloaded(downloadQueue, nzbInfo, &directParFiles);
+#endif
+
 	if (nzbInfo->GetDeleteStatus() == NzbInfo::dsHealth ||
 		nzbInfo->GetDeleteStatus() == NzbInfo::dsBad)
 	{
@@ -345,6 +354,10 @@ void PrePostProcessor::NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbI
 
 		nzbInfo->EnterPostProcess();
 
+#ifndef DISABLE_PARCHECK
+		*nzbInfo->GetPostInfo()->GetDirectParFiles() = std::move(directParFiles);
+#endif
+
 		if (nzbInfo->GetParStatus() == NzbInfo::psNone &&
 			g_Options->GetParCheck() != Options::pcAlways &&
 			g_Options->GetParCheck() != Options::pcForce)
@@ -380,6 +393,10 @@ void PrePostProcessor::NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbI
 
 void PrePostProcessor::NzbDeleted(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 {
+#ifndef DISABLE_PARCHECK
+	m_directParVerifier.NzbDeleted(downloadQueue, nzbInfo);
+#endif
+
 	if (nzbInfo->GetUnpackThread())
 	{
 		((DirectUnpack*)nzbInfo->GetUnpackThread())->NzbDeleted(downloadQueue, nzbInfo);
@@ -406,6 +423,10 @@ void PrePostProcessor::NzbDeleted(DownloadQueue* downloadQueue, NzbInfo* nzbInfo
 
 void PrePostProcessor::NzbCompleted(DownloadQueue* downloadQueue, NzbInfo* nzbInfo, bool saveQueue)
 {
+#ifndef DISABLE_PARCHECK
+	m_directParVerifier.NzbDeleted(downloadQueue, nzbInfo);
+#endif
+
 	bool downloadDupe = nzbInfo->GetDupeHint() == NzbInfo::dhRedownloadAuto;
 	bool addToHistory = g_Options->GetKeepHistory() > 0 && !nzbInfo->GetAvoidHistory();
 	if (addToHistory)
@@ -439,6 +460,7 @@ void PrePostProcessor::NzbCompleted(DownloadQueue* downloadQueue, NzbInfo* nzbIn
 	{
 		g_HistoryCoordinator->DeleteDiskFiles(nzbInfo);
 		downloadQueue->GetQueue()->Remove(nzbInfo);
+		downloadQueue->Changed();
 	}
 
 	if (saveQueue && needSave)
@@ -596,11 +618,77 @@ bool PrePostProcessor::CanRunMoreJobs(bool* allowPar)
 		case Options::ppRocket:
 			*allowPar = parJobs < 2;
 			return totalJobs < 6;
+
+		case Options::ppStaged:
+			*allowPar = HasClassCapacity(rcCpu);
+			return *allowPar || HasClassCapacity(rcDisk) || HasClassCapacity(rcScript);
 	}
 
 	return false;
 }
 
+PrePostProcessor::EResourceClass PrePostProcessor::GetStageClass(PostInfo::EStage stage)
+{
+	switch (stage)
+	{
+		case PostInfo::ptLoadingPars:
+		case PostInfo::ptVerifyingSources:
+		case PostInfo::ptRepairing:
+		case PostInfo::ptVerifyingRepaired:
+			return rcCpu;
+
+		case PostInfo::ptParRenaming:
+		case PostInfo::ptRarRenaming:
+		case PostInfo::ptUnpacking:
+		case PostInfo::ptCleaningUp:
+		case PostInfo::ptMoving:
+			return rcDisk;
+
+		case PostInfo::ptExecutingScript:
+			return rcScript;
+
+		case PostInfo::ptQueued:
+		case PostInfo::ptFinished:
+			break;
+	}
+
+	return rcNone;
+}
+
+int PrePostProcessor::GetClassLimit(EResourceClass resClass)
+{
+	switch (resClass)
+	{
+		case rcCpu:
+			return std::max(g_Options->GetPostCpuJobs(), 1);
+
+		case rcDisk:
+			return std::max(g_Options->GetPostDiskJobs(), 1);
+
+		case rcScript:
+			return std::max(g_Options->GetPostScriptJobs(), 1);
+
+		case rcNone:
+			break;
+	}
+
+	return 0;
+}
+
+int PrePostProcessor::CountClassJobs(EResourceClass resClass)
+{
+	return (int)std::count_if(m_activeJobs.begin(), m_activeJobs.end(),
+		[resClass](NzbInfo* postJob)
+		{
+			return GetStageClass(postJob->GetPostInfo()->GetStage()) == resClass;
+		});
+}
+
+bool PrePostProcessor::HasClassCapacity(EResourceClass resClass)
+{
+	return CountClassJobs(resClass) < GetClassLimit(resClass);
+}
+
 NzbInfo* PrePostProcessor::PickNextJob(DownloadQueue* downloadQueue, bool allowPar)
 {
 	NzbInfo* nzbInfo = nullptr;
@@ -613,6 +701,8 @@ NzbInfo* PrePostProcessor::PickNextJob(DownloadQueue* downloadQueue, bool allowP
 			(!nzbInfo || nzbInfo1->GetPriority() > nzbInfo->GetPriority()) &&
 			(!g_WorkState->GetPausePostProcess() || nzbInfo1->GetForcePriority()) &&
 			(allowPar || !nzbInfo1->GetPostInfo()->GetNeedParCheck()) &&
+			(nzbInfo1->GetPostInfo()->GetWaitStage() == PostInfo::ptQueued ||
+			 HasClassCapacity(GetStageClass(nzbInfo1->GetPostInfo()->GetWaitStage()))) &&
 			(std::find(m_activeJobs.begin(), m_activeJobs.end(), nzbInfo1) == m_activeJobs.end()) &&
 			nzbInfo1->IsDownloadCompleted(true))
 		{
@@ -680,8 +770,10 @@ void PrePostProcessor::StartJob(DownloadQueue* downloadQueue, PostInfo* postInfo
 		nzbInfo->GetDeleteStatus() == NzbInfo::dsNone &&
 		g_Options->GetParRename())
 	{
-		EnterStage(downloadQueue, postInfo, PostInfo::ptParRenaming);
-		RenameController::StartJob(postInfo, RenameController::jkPar);
+		if (EnterStage(downloadQueue, postInfo, PostInfo::ptParRenaming))
+		{
+			RenameController::StartJob(postInfo, RenameController::jkPar);
+		}
 		return;
 	}
 
@@ -697,9 +789,11 @@ void PrePostProcessor::StartJob(DownloadQueue* downloadQueue, PostInfo* postInfo
 				return;
 			}
 
-			EnterStage(downloadQueue, postInfo, PostInfo::ptLoadingPars);
-			postInfo->SetNeedParCheck(false);
-			RepairController::StartJob(postInfo);
+			if (EnterStage(downloadQueue, postInfo, PostInfo::ptLoadingPars))
+			{
+				postInfo->SetNeedParCheck(false);
+				RepairController::StartJob(postInfo);
+			}
 		}
 		else
 		{
@@ -753,8 +847,10 @@ void PrePostProcessor::StartJob(DownloadQueue* downloadQueue, PostInfo* postInfo
 	if (nzbInfo->GetRarRenameStatus() == NzbInfo::rsNone &&
 		unpack && g_Options->GetRarRename())
 	{
-		EnterStage(downloadQueue, postInfo, PostInfo::ptRarRenaming);
-		RenameController::StartJob(postInfo, RenameController::jkRar);
+		if (EnterStage(downloadQueue, postInfo, PostInfo::ptRarRenaming))
+		{
+			RenameController::StartJob(postInfo, RenameController::jkRar);
+		}
 		return;
 	}
 
@@ -820,30 +916,50 @@ void PrePostProcessor::StartJob(DownloadQueue* downloadQueue, PostInfo* postInfo
 
 	if (unpack)
 	{
-		EnterStage(downloadQueue, postInfo, PostInfo::ptUnpacking);
-		UnpackController::StartJob(postInfo);
+		if (EnterStage(downloadQueue, postInfo, PostInfo::ptUnpacking))
+		{
+			UnpackController::StartJob(postInfo);
+		}
 	}
 	else if (cleanup)
 	{
-		EnterStage(downloadQueue, postInfo, PostInfo::ptCleaningUp);
-		CleanupController::StartJob(postInfo);
+		if (EnterStage(downloadQueue, postInfo, PostInfo::ptCleaningUp))
+		{
+			CleanupController::StartJob(postInfo);
+		}
 	}
 	else if (moveInter)
 	{
-		EnterStage(downloadQueue, postInfo, PostInfo::ptMoving);
-		MoveController::StartJob(postInfo);
+		if (EnterStage(downloadQueue, postInfo, PostInfo::ptMoving))
+		{
+			MoveController::StartJob(postInfo);
+		}
 	}
 	else
 	{
-		EnterStage(downloadQueue, postInfo, PostInfo::ptExecutingScript);
-		PostScriptController::StartJob(postInfo);
+		if (EnterStage(downloadQueue, postInfo, PostInfo::ptExecutingScript))
+		{
+			PostScriptController::StartJob(postInfo);
+		}
 	}
 }
 
-void PrePostProcessor::EnterStage(DownloadQueue* downloadQueue, PostInfo* postInfo, PostInfo::EStage stage)
+/**
+ * With strategy "staged" the job waits (remains queued) if the resource class
+ * of the stage has no free slots; it is picked again once a slot becomes free.
+ */
+bool PrePostProcessor::EnterStage(DownloadQueue* downloadQueue, PostInfo* postInfo, PostInfo::EStage stage)
 {
+	if (g_Options->GetPostStrategy() == Options::ppStaged && !HasClassCapacity(GetStageClass(stage)))
+	{
+		postInfo->SetWaitStage(stage);
+		return false;
+	}
+
+	postInfo->SetWaitStage(PostInfo::ptQueued);
 	postInfo->SetWorking(true);
 	postInfo->SetStage(stage);
+	return true;
 }
 
 void PrePostProcessor::JobCompleted(DownloadQueue* downloadQueue, PostInfo* postInfo)
@@ -925,50 +1041,49 @@ bool PrePostProcessor::PostQueueDelete(DownloadQueue* downloadQueue, IdList* idL
 
 	for (int id : *idList)
 	{
-		for (NzbInfo* nzbInfo: downloadQueue->GetQueue())
+		NzbInfo* nzbInfo = downloadQueue->FindNzb(id);
+		PostInfo* postInfo = nzbInfo ? nzbInfo->GetPostInfo() : nullptr;
+		if (!postInfo)
 		{
-			PostInfo* postInfo = nzbInfo->GetPostInfo();
-			if (postInfo && nzbInfo->GetId() == id)
+			continue;
+		}
+
+		if (postInfo->GetWorking())
+		{
+			postInfo->GetNzbInfo()->PrintMessage(Message::mkInfo,
+				"Deleting active post-job %s", postInfo->GetNzbInfo()->GetName());
+			postInfo->SetDeleted(true);
+			if (postInfo->GetPostThread())
 			{
-				if (postInfo->GetWorking())
-				{
-					postInfo->GetNzbInfo()->PrintMessage(Message::mkInfo,
-						"Deleting active post-job %s", postInfo->GetNzbInfo()->GetName());
-					postInfo->SetDeleted(true);
-					if (postInfo->GetPostThread())
-					{
-						debug("Terminating post-process thread for %s", postInfo->GetNzbInfo()->GetName());
-						postInfo->GetPostThread()->Stop();
-						ok = true;
-					}
-					else if (postInfo->GetNzbInfo()->GetUnpackThread())
-					{
-						((DirectUnpack*)postInfo->GetNzbInfo()->GetUnpackThread())->NzbDeleted(downloadQueue, postInfo->GetNzbInfo());
-						ok = true;
-					}
-					else
-					{
-						error("Internal error in PrePostProcessor::QueueDelete");
-					}
-				}
-				else
-				{
-					postInfo->GetNzbInfo()->PrintMessage(Message::mkInfo,
-						"Deleting queued post-job %s", postInfo->GetNzbInfo()->GetName());
+				debug("Terminating post-process thread for %s", postInfo->GetNzbInfo()->GetName());
+				postInfo->GetPostThread()->Stop();
+				ok = true;
+			}
+			else if (postInfo->GetNzbInfo()->GetUnpackThread())
+			{
+				((DirectUnpack*)postInfo->GetNzbInfo()->GetUnpackThread())->NzbDeleted(downloadQueue, postInfo->GetNzbInfo());
+				ok = true;
+			}
+			else
+			{
+				error("Internal error in PrePostProcessor::QueueDelete");
+			}
+		}
+		else
+		{
+			postInfo->GetNzbInfo()->PrintMessage(Message::mkInfo,
+				"Deleting queued post-job %s", postInfo->GetNzbInfo()->GetName());
 
-					JobCompleted(downloadQueue, postInfo);
+			JobCompleted(downloadQueue, postInfo);
 
-					m_activeJobs.erase(std::remove_if(m_activeJobs.begin(), m_activeJobs.end(),
-						[postInfo](NzbInfo* postJob)
-						{
-							return postInfo == postJob->GetPostInfo();
-						}),
-						m_activeJobs.end());
+			m_activeJobs.erase(std::remove_if(m_activeJobs.begin(), m_activeJobs.end(),
+				[postInfo](NzbInfo* postJob)
+				{
+					return postInfo == postJob->GetPostInfo();
+				}),
+				m_activeJobs.end());
 
-					ok = true;
-				}
-				break;
-			}
+			ok = true;
 		}
 	}
 
@@ -987,6 +1102,15 @@ void PrePostProcessor::FileDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzb
 		g_QueueScriptCoordinator->EnqueueScript(nzbInfo, QueueScriptCoordinator::qeFileDownloaded);
 	}
 
+#ifndef DISABLE_PARCHECK
+	// article CRCs are needed to verify files without reading them
+	if (g_Options->GetDirectParCheck() && g_Options->GetCrcCheck() && !g_Options->GetRawArticle() &&
+		!nzbInfo->GetPostInfo() && nzbInfo->GetDeleteStatus() == NzbInfo::dsNone)
+	{
+		m_directParVerifier.FileDownloaded(downloadQueue, fileInfo);
+	}
+#endif
+
 	if (g_Options->GetDirectUnpack() && !g_Options->GetRawArticle() && !g_Options->GetSkipWrite())
 	{
 		bool allowPar;
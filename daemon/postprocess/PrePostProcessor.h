@@ -24,10 +24,19 @@
 #include "Thread.h"
 #include "Observer.h"
 #include "DownloadInfo.h"
+#include "DirectParVerifier.h"
 
 class PrePostProcessor : public Thread, public Observer
 {
 public:
+	enum EResourceClass
+	{
+		rcNone,
+		rcCpu,
+		rcDisk,
+		rcScript
+	};
+
 	PrePostProcessor();
 	virtual void Run();
 	virtual void Stop();
@@ -37,23 +46,31 @@ public:
 		const char* args);
 	void NzbAdded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo);
 	void NzbDownloaded(DownloadQueue* downloadQueue, NzbInfo* nzbInfo);
+	static EResourceClass GetStageClass(PostInfo::EStage stage);
+	static int GetClassLimit(EResourceClass resClass);
 
 protected:
+	RawNzbList m_activeJobs;
+
 	virtual void Update(Subject* caller, void* aspect) { DownloadQueueUpdate(aspect); }
+	bool CanRunMoreJobs(bool* allowPar);
+	NzbInfo* PickNextJob(DownloadQueue* downloadQueue, bool allowPar);
+	bool HasClassCapacity(EResourceClass resClass);
 
 private:
 	int m_queuedJobs = 0;
-	RawNzbList m_activeJobs;
 	Mutex m_waitMutex;
 	ConditionVar m_waitCond;
+#ifndef DISABLE_PARCHECK
+	DirectParVerifier m_directParVerifier;
+#endif
 
 	void CheckPostQueue();
 	void CheckRequestPar(DownloadQueue* downloadQueue);
 	void CleanupJobs(DownloadQueue* downloadQueue);
-	bool CanRunMoreJobs(bool* allowPar);
-	NzbInfo* PickNextJob(DownloadQueue* downloadQueue, bool allowPar);
 	void StartJob(DownloadQueue* downloadQueue, PostInfo* postInfo, bool allowPar);
-	void EnterStage(DownloadQueue* downloadQueue, PostInfo* postInfo, PostInfo::EStage stage);
+	bool EnterStage(DownloadQueue* downloadQueue, PostInfo* postInfo, PostInfo::EStage stage);
+	int CountClassJobs(EResourceClass resClass);
 	void SanitisePostQueue();
 	void UpdatePauseState();
 	void NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo);
@@ -536,6 +536,122 @@ bool RarVolume::ReadRar5File(DiskFile& file, RarBlock& block, RarFile& innerFile
 	return true;
 }
 
+/*
+ * Filenames may contain any characters, but the serialized headers are stored
+ * as a single line with tab-separated entries; control characters and "%" are
+ * therefore written as "%XX".
+ */
+static void AppendEscaped(StringBuilder& result, const char* str)
+{
+	for (const char* p = str; *p; p++)
+	{
+		uchar ch = *p;
+		if (ch < 0x20 || ch == '%')
+		{
+			result.AppendFmt("%%%02X", ch);
+		}
+		else
+		{
+			result.Append(p, 1);
+		}
+	}
+}
+
+static bool Unescape(const char* str, CString& result)
+{
+	StringBuilder output;
+	output.Reserve(strlen(str));
+	for (const char* p = str; *p; p++)
+	{
+		if (*p == '%')
+		{
+			if (!isxdigit((uchar)p[1]) || !isxdigit((uchar)p[2]))
+			{
+				return false;
+			}
+			char hex[3] = {p[1], p[2], '\0'};
+			uchar ch = (uchar)strtoul(hex, nullptr, 16);
+			if (ch == 0)
+			{
+				return false;
+			}
+			output.Append((const char*)&ch, 1);
+			p += 2;
+		}
+		else
+		{
+			output.Append(p, 1);
+		}
+	}
+	result = *output;
+	return true;
+}
+
+CString RarVolume::Serialize()
+{
+	StringBuilder result;
+	result.AppendFmt("%i,%u,%i,%i,%i,%i", m_version, m_volumeNo, (int)m_newNaming,
+		(int)m_hasNextVolume, (int)m_multiVolume, (int)m_encrypted);
+
+	for (RarFile& file : m_files)
+	{
+		result.AppendFmt("\t%" PRIi64 ",%u,%u,%i,%i,", file.m_size, file.m_time, file.m_attr,
+			(int)file.m_splitBefore, (int)file.m_splitAfter);
+		AppendEscaped(result, file.m_filename);
+	}
+
+	return *result;
+}
+
+bool RarVolume::Deserialize(const char* data)
+{
+	m_files.clear();
+
+	Tokenizer tok(data, "\t");
+	const char* header = tok.Next();
+	int newNaming, hasNextVolume, multiVolume, encrypted;
+	if (!header || sscanf(header, "%i,%u,%i,%i,%i,%i", &m_version, &m_volumeNo, &newNaming,
+		&hasNextVolume, &multiVolume, &encrypted) != 6)
+	{
+		return false;
+	}
+
+	m_newNaming = newNaming;
+	m_hasNextVolume = hasNextVolume;
+	m_multiVolume = multiVolume;
+	m_encrypted = encrypted;
+
+	while (const char* entry = tok.Next())
+	{
+		RarFile file;
+		int splitBefore, splitAfter;
+		if (sscanf(entry, "%" PRIi64 ",%u,%u,%i,%i", &file.m_size, &file.m_time, &file.m_attr,
+			&splitBefore, &splitAfter) != 5)
+		{
+			return false;
+		}
+
+		const char* filename = entry;
+		for (int i = 0; i < 5 && filename; i++)
+		{
+			filename = strchr(filename, ',');
+			if (filename) filename++;
+		}
+		if (!filename || !Unescape(filename, file.m_filename))
+		{
+			return false;
+		}
+
+		file.m_splitBefore = splitBefore;
+		file.m_splitAfter = splitAfter;
+		m_files.push_back(std::move(file));
+	}
+
+	LogDebugInfo();
+
+	return true;
+}
+
 void RarVolume::LogDebugInfo()
 {
 #ifdef DEBUG
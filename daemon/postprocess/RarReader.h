@@ -52,6 +52,13 @@ public:
 	RarVolume(const char* filename) : m_filename(filename) {}
 	bool Read();
 
+	/**
+	* Serialized headers are stored in the rar-index of nzb (see CompletedFile::GetRarInfo)
+	* and allow to restore the volume without reading the file again.
+	*/
+	CString Serialize();
+	bool Deserialize(const char* data);
+
 	const char* GetFilename() { return m_filename; }
 	int GetVersion() { return m_version; }
 	uint32 GetVolumeNo() { return m_volumeNo; }
@@ -65,22 +65,57 @@ void RarRenamer::BuildDirList(const char* destDir)
 
 void RarRenamer::CheckFiles(const char* destDir)
 {
+	FileList files;
+
 	DirBrowser dir(destDir);
 	while (const char* filename = dir.Next())
 	{
-		if (!IsStopped())
+		BString<1024> fullFilename("%s%c%s", destDir, PATH_SEPARATOR, filename);
+		if (!FileSystem::DirectoryExists(fullFilename))
 		{
-			BString<1024> fullFilename("%s%c%s", destDir, PATH_SEPARATOR, filename);
+			files.emplace_back(fullFilename);
+		}
+	}
 
-			if (!FileSystem::DirectoryExists(fullFilename))
-			{
-				m_progressLabel.Format("Checking file %s", filename);
-				m_stageProgress = m_fileCount > 0 ? m_curFile * 1000 / m_fileCount : 1000;
-				UpdateProgress();
-				m_curFile++;
+	std::vector<std::unique_ptr<RarVolume>> volumes(files.size());
+	bool useIndex = !strcmp(destDir, m_destDir);
 
-				CheckOneFile(fullFilename);
+	// the headers are at the beginning of a volume and the end-of-archive block
+	// is at its end; request both ranges of all volumes before reading any of them
+	for (CString& filename : files)
+	{
+		if (!(m_ignoreExt && Util::MatchFileExt(FileSystem::BaseFileName(filename), m_ignoreExt, ",;")) &&
+			!(useIndex && FindIndexedVolume(filename)))
+		{
+			FileSystem::WillNeed(filename, READ_AHEAD_SIZE, READ_AHEAD_SIZE);
+		}
+	}
+
+	// scan files in parallel and collect the results in directory order
+	WorkerPool pool(WorkerPool::IO_THREADS);
+	pool.Execute((int)files.size(),
+		[&](int index)
+		{
+			volumes[index] = CheckOneFile(files[index], useIndex);
+		},
+		[&](int completed, int lastIndex)
+		{
+			m_progressLabel.Format("Checking file %s", FileSystem::BaseFileName(files[lastIndex]));
+			m_stageProgress = m_fileCount > 0 ? (m_curFile + completed) * 1000 / m_fileCount : 1000;
+			UpdateProgress();
+			if (IsStopped())
+			{
+				pool.Stop();
 			}
+		});
+
+	m_curFile += (int)files.size();
+
+	for (std::unique_ptr<RarVolume>& volume : volumes)
+	{
+		if (volume)
+		{
+			m_volumes.push_back(std::move(*volume));
 		}
 	}
 
@@ -90,19 +125,43 @@ void RarRenamer::CheckFiles(const char* destDir)
 	}
 }
 
-void RarRenamer::CheckOneFile(const char* filename)
+std::unique_ptr<RarVolume> RarRenamer::CheckOneFile(const char* filename, bool useIndex)
 {
 	if (m_ignoreExt && Util::MatchFileExt(FileSystem::BaseFileName(filename), m_ignoreExt, ",;"))
 	{
-		return;
+		return nullptr;
 	}
-	
-	RarVolume volume(filename);
-	volume.SetPassword(m_password);
-	if (volume.Read())
+
+	std::unique_ptr<RarVolume> volume = std::make_unique<RarVolume>(filename);
+
+	if (useIndex)
 	{
-		m_volumes.push_back(std::move(volume));
+		IndexedVolume* indexedVolume = FindIndexedVolume(filename);
+		if (indexedVolume && volume->Deserialize(indexedVolume->m_rarInfo))
+		{
+			debug("Using indexed rar-headers for %s", FileSystem::BaseFileName(filename));
+			return volume;
+		}
 	}
+
+	volume->SetPassword(m_password);
+	if (!volume->Read())
+	{
+		return nullptr;
+	}
+
+	return volume;
+}
+
+RarRenamer::IndexedVolume* RarRenamer::FindIndexedVolume(const char* filename)
+{
+	IndexedVolumeList::iterator it = std::find_if(m_indexedVolumes.begin(), m_indexedVolumes.end(),
+		[filename = FileSystem::BaseFileName(filename)](IndexedVolume& indexedVolume)
+		{
+			return !strcasecmp(indexedVolume.m_filename, filename);
+		});
+
+	return it != m_indexedVolumes.end() ? &*it : nullptr;
 }
 
 void RarRenamer::RenameFile(const char* srcFilename, const char* destFileName)
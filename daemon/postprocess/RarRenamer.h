@@ -36,6 +36,8 @@ public:
 	void SetPassword(const char* password) { m_password = password; }
 	void SetIgnoreExt(const char* ignoreExt) { m_ignoreExt = ignoreExt; }
 	int GetRenamedCount() { return m_renamedCount; }
+	// rar-headers indexed during download (see RarVolume::Serialize) for files in dest dir
+	void AddIndexedVolume(const char* filename, const char* rarInfo) { m_indexedVolumes.emplace_back(filename, rarInfo); }
 
 protected:
 	virtual void UpdateProgress() {}
@@ -46,7 +48,20 @@ protected:
 	int GetStageProgress() { return m_stageProgress; }
 
 private:
+	static const int64 READ_AHEAD_SIZE = 64 * 1024;
+
+	struct IndexedVolume
+	{
+		CString m_filename;
+		CString m_rarInfo;
+
+		IndexedVolume(const char* filename, const char* rarInfo) :
+			m_filename(filename), m_rarInfo(rarInfo) {}
+	};
+
 	typedef std::deque<CString> DirList;
+	typedef std::vector<CString> FileList;
+	typedef std::deque<IndexedVolume> IndexedVolumeList;
 	typedef std::deque<RarVolume> RarVolumeList;
 	typedef std::deque<RarVolume*> RarVolumeSet;
 	typedef std::deque<RarVolumeSet> RarSets;
@@ -64,10 +79,12 @@ private:
 	RarSets m_sets;
 	CString m_password;
 	CString m_ignoreExt;
+	IndexedVolumeList m_indexedVolumes;
 
 	void BuildDirList(const char* destDir);
 	void CheckFiles(const char* destDir);
-	void CheckOneFile(const char* filename);
+	std::unique_ptr<RarVolume> CheckOneFile(const char* filename, bool useIndex);
+	IndexedVolume* FindIndexedVolume(const char* filename);
 	void RenameFile(const char* srcFilename, const char* destFileName);
 	void RenameFiles(const char* destDir);
 	CString GenNewVolumeFilename(const char* destDir, const char* newBasename, RarVolume* volume);
@@ -143,6 +143,17 @@ void RenameController::ExecRename(const char* destDir, const char* finalDir, con
 			m_rarRenamer.SetPassword(parameter->GetValue());
 		}
 
+		{
+			GuardedDownloadQueue guard = DownloadQueue::Guard();
+			for (CompletedFile& completedFile : m_postInfo->GetNzbInfo()->GetCompletedFiles())
+			{
+				if (!Util::EmptyStr(completedFile.GetRarInfo()))
+				{
+					m_rarRenamer.AddIndexedVolume(completedFile.GetFilename(), completedFile.GetRarInfo());
+				}
+			}
+		}
+
 		m_rarRenamer.Execute();
 	}
 }
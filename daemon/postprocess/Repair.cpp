@@ -115,6 +115,27 @@ ParChecker::EFileStatus RepairController::PostParChecker::FindFileCrc(const char
 		ParChecker::fsUnknown;
 }
 
+ParChecker::EFileStatus RepairController::PostParChecker::FindDirectFile(const char* filename,
+	int64* size, SegmentList* segments)
+{
+	for (PostInfo::DirectParFile& directFile : m_directParFiles)
+	{
+		if (!strcasecmp(directFile.GetFilename(), filename))
+		{
+			*size = directFile.GetSize();
+			for (PostInfo::DirectParFile::Segment& segment : directFile.GetSegments())
+			{
+				segments->emplace_back(segment.m_success, segment.m_offset, segment.m_size, segment.m_crc);
+			}
+
+			return directFile.GetStatus() == CompletedFile::cfSuccess ? ParChecker::fsSuccess :
+				ParChecker::fsPartial;
+		}
+	}
+
+	return ParChecker::fsUnknown;
+}
+
 const char* RepairController::PostParChecker::FindFileOrigname(const char* filename)
 {
 	for (CompletedFile& completedFile : m_postInfo->GetNzbInfo()->GetCompletedFiles())
@@ -233,10 +254,15 @@ void RepairController::Run()
 {
 	BString<1024> nzbName;
 	CString destDir;
+	PostInfo::DirectParFiles directParFiles;
 	{
 		GuardedDownloadQueue guard = DownloadQueue::Guard();
 		nzbName = m_postInfo->GetNzbInfo()->GetName();
 		destDir = m_postInfo->GetNzbInfo()->GetDestDir();
+		// results of direct par-check are used only once and not if the unpack has failed,
+		// a repeated par-check verifies all files
+		directParFiles = std::move(*m_postInfo->GetDirectParFiles());
+		m_postInfo->GetDirectParFiles()->clear();
 	}
 
 	m_parChecker.SetPostInfo(m_postInfo);
@@ -246,6 +272,10 @@ void RepairController::Run()
 	m_parChecker.SetDownloadSec(m_postInfo->GetNzbInfo()->GetDownloadSec());
 	m_parChecker.SetParQuick(g_Options->GetParQuick() && !m_postInfo->GetForceParFull());
 	m_parChecker.SetForceRepair(m_postInfo->GetForceRepair());
+	if (!m_postInfo->GetForceParFull() && !m_postInfo->GetUnpackTried())
+	{
+		m_parChecker.m_directParFiles = std::move(directParFiles);
+	}
 
 	m_parChecker.PrintMessage(Message::mkInfo, "Checking pars for %s", *nzbName);
 
@@ -505,7 +535,16 @@ void RepairController::UpdateParCheckProgress()
 		bool parCancel = false;
 		if (!IsStopped())
 		{
-			if ((g_Options->GetParTimeLimit() > 0) &&
+			if (g_Options->GetParTimeLimit() > 0 &&
+				m_parChecker.GetStage() == PostParChecker::ptRepairing &&
+				m_parChecker.GetEstimatedRepairSec() > g_Options->GetParTimeLimit() * 60)
+			{
+				// the planned I/O volume alone takes longer than allowed, no need to wait
+				// until the elapsed time allows to extrapolate the progress
+				m_parChecker.PrintMessage(Message::mkWarning, "Cancelling par-repair for %s, estimated repair time (%i minutes) exceeds allowed repair time", m_parChecker.GetInfoName(), m_parChecker.GetEstimatedRepairSec() / 60);
+				parCancel = true;
+			}
+			else if ((g_Options->GetParTimeLimit() > 0) &&
 				m_parChecker.GetStage() == PostParChecker::ptRepairing &&
 				((g_Options->GetParTimeLimit() > 5 && current - postInfo->GetStageTime() > 5 * 60) ||
 					(g_Options->GetParTimeLimit() <= 5 && current - postInfo->GetStageTime() > 1 * 60)))
@@ -68,6 +68,7 @@ private:
 		virtual void RegisterParredFile(const char* filename);
 		virtual bool IsParredFile(const char* filename);
 		virtual EFileStatus FindFileCrc(const char* filename, uint32* crc, SegmentList* segments);
+		virtual EFileStatus FindDirectFile(const char* filename, int64* size, SegmentList* segments);
 		virtual const char* FindFileOrigname(const char* filename);
 		virtual void RequestDupeSources(DupeSourceList* dupeSourceList);
 		virtual void StatDupeSources(DupeSourceList* dupeSourceList);
@@ -77,6 +78,7 @@ private:
 		time_t m_parTime;
 		time_t m_repairTime;
 		int m_downloadSec;
+		PostInfo::DirectParFiles m_directParFiles;
 
 		friend class RepairController;
 	};
@@ -25,6 +25,7 @@
 #include "FileSystem.h"
 #include "ParParser.h"
 #include "Options.h"
+#include "RarReader.h"
 
 bool UnpackController::FileList::Exists(const char* filename)
 {
@@ -68,6 +69,20 @@ void UnpackController::Run()
 		{
 			m_password = parameter->GetValue();
 		}
+
+		for (CompletedFile& completedFile : m_postInfo->GetNzbInfo()->GetCompletedFiles())
+		{
+			if (!Util::EmptyStr(completedFile.GetRarInfo()))
+			{
+				m_indexedVolumes.emplace_back(completedFile.GetFilename());
+
+				RarVolume volume("");
+				if (volume.Deserialize(completedFile.GetRarInfo()) && volume.GetVolumeNo() > 0)
+				{
+					m_nonFirstVolumes.emplace_back(completedFile.GetFilename());
+				}
+			}
+		}
 	}
 
 	m_infoName.Format("unpack for %s", *m_name);
@@ -203,7 +218,7 @@ void UnpackController::UnpackArchives(EUnpacker unpacker, bool multiVolumes)
 
 	if (!m_unpackOk && !m_unpackStartError && !m_unpackSpaceError &&
 		(m_unpackDecryptError || m_unpackPasswordError) &&
-		(!GetTerminated() || m_autoTerminated) &&
+		(!IsTerminated() || m_autoTerminated) &&
 		m_password.Empty() && !Util::EmptyStr(g_Options->GetUnpackPassFile()))
 	{
 		DiskFile infile;
@@ -233,6 +248,7 @@ void UnpackController::UnpackArchives(EUnpacker unpacker, bool multiVolumes)
 				m_unpackDecryptError = false;
 				m_unpackPasswordError = false;
 				m_autoTerminated = false;
+				m_workersTerminated = false;
 				PrintMessage(Message::mkInfo, "Trying password %s for %s", password, *m_name);
 				ExecuteUnpack(unpacker, password, multiVolumes);
 			}
@@ -248,7 +264,14 @@ void UnpackController::ExecuteUnpack(EUnpacker unpacker, const char* password, b
 	switch (unpacker)
 	{
 		case upUnrar:
-			ExecuteUnrar(password);
+			if (g_Options->GetUnpackThreads() > 1 && m_rarSets.size() > 1)
+			{
+				ExecuteParallelUnrar(password);
+			}
+			else
+			{
+				ExecuteUnrar(password);
+			}
 			break;
 
 		case upSevenZip:
@@ -289,7 +312,7 @@ void UnpackController::ExecuteUnrar(const char* password)
 		params.emplace_back("-o+");
 	}
 
-	params.emplace_back("*.rar");
+	params.emplace_back(!m_archiveSet.Empty() ? *m_archiveSet : "*.rar");
 	m_unpackExtendedDir = FileSystem::MakeExtendedPath(m_unpackDir, true);
 	params.push_back(*BString<1024>("%s%c", *m_unpackExtendedDir, PATH_SEPARATOR));
 	SetArgs(std::move(params));
@@ -315,6 +338,86 @@ void UnpackController::ExecuteUnrar(const char* password)
 	}
 }
 
+/**
+ * Unpacks independent rar-sets in parallel, each set with its own unrar-process.
+ * Sets unpacked successfully are not unpacked again when trying further passwords.
+ */
+void UnpackController::ExecuteParallelUnrar(const char* password)
+{
+	FileList archives;
+	for (CString& archive : m_rarSets)
+	{
+		if (!m_unpackedSets.Exists(archive))
+		{
+			archives.emplace_back(*archive);
+		}
+	}
+
+	int threads = std::min(g_Options->GetUnpackThreads(), (int)archives.size());
+	PrintMessage(Message::mkInfo, "Unpacking %i rar-sets using %i unrar-processes", (int)archives.size(), threads);
+
+	m_unpacker = upUnrar;
+	m_workersTerminated = false;
+	bool unpackOk = true;
+	bool startError = false;
+	bool spaceError = false;
+
+	SetProgressLabel("");
+	m_postInfo->SetStageProgress(0);
+
+	WorkerPool pool(threads);
+	pool.Execute((int)archives.size(),
+		[&](int index)
+		{
+			UnpackController worker;
+			worker.m_owner = this;
+			worker.m_postInfo = m_postInfo;
+			worker.m_name = *m_name;
+			worker.m_infoName = *m_infoName;
+			worker.m_destDir = *m_destDir;
+			worker.m_unpackDir = *m_unpackDir;
+			worker.m_archiveSet = *archives[index];
+			worker.SetInfoName(worker.m_infoName);
+			worker.SetWorkingDir(worker.m_destDir);
+
+			{
+				Guard guard(m_workersMutex);
+				if (IsStopped())
+				{
+					unpackOk = false;
+					return;
+				}
+				m_workers.push_back(&worker);
+			}
+
+			worker.ExecuteUnrar(password);
+
+			Guard guard(m_workersMutex);
+			m_workers.erase(std::find(m_workers.begin(), m_workers.end(), &worker));
+			if (worker.m_unpackOk)
+			{
+				m_unpackedSets.emplace_back(*archives[index]);
+			}
+			unpackOk &= worker.m_unpackOk;
+			startError |= worker.m_unpackStartError;
+			spaceError |= worker.m_unpackSpaceError;
+			m_unpackDecryptError |= worker.m_unpackDecryptError;
+			m_unpackPasswordError |= worker.m_unpackPasswordError;
+			m_autoTerminated |= worker.m_autoTerminated;
+			m_workersTerminated |= worker.GetTerminated();
+		},
+		[&](int completed, int lastIndex)
+		{
+			m_postInfo->SetStageProgress(completed * 1000 / (int)archives.size());
+		});
+
+	SetProgressLabel("");
+
+	m_unpackOk = unpackOk && !IsStopped();
+	m_unpackStartError = startError;
+	m_unpackSpaceError = spaceError;
+}
+
 void UnpackController::ExecuteSevenZip(const char* password, bool multiVolumes)
 {
 	// Format:
@@ -498,8 +601,6 @@ bool UnpackController::JoinFile(const char* fragBaseName)
 	int64 totalSize = firstSegmentSize * (count - 1) + difSegmentSize;
 	int64 written = 0;
 
-	CharBuffer buffer(1024 * 50);
-
 	bool ok = true;
 	for (int i = min; i <= max; i++)
 	{
@@ -515,11 +616,10 @@ bool UnpackController::JoinFile(const char* fragBaseName)
 		DiskFile inFile;
 		if (inFile.Open(fragFilename, DiskFile::omRead))
 		{
-			int cnt = buffer.Size();
-			while (cnt == buffer.Size())
+			// copy in chunks to update progress
+			int64 cnt;
+			while ((cnt = outFile.CopyFrom(inFile, 1024 * 1024 * 16)) > 0)
 			{
-				cnt = (int)inFile.Read(buffer, buffer.Size());
-				outFile.Write(buffer, cnt);
 				written += cnt;
 				m_postInfo->SetStageProgress(int(written * 1000 / totalSize));
 			}
@@ -564,7 +664,7 @@ void UnpackController::Completed()
 			(m_postInfo->GetNzbInfo()->GetParStatus() <= NzbInfo::psSkipped ||
 			 !m_postInfo->GetNzbInfo()->GetParFull()) &&
 			!m_unpackStartError && !m_unpackSpaceError && !m_unpackPasswordError &&
-			(!GetTerminated() || m_autoTerminated) && m_hasParFiles)
+			(!IsTerminated() || m_autoTerminated) && m_hasParFiles)
 		{
 			RequestParCheck(!m_password.Empty() ||
 				Util::EmptyStr(g_Options->GetUnpackPassFile()) || m_passListTried ||
@@ -637,6 +737,8 @@ void UnpackController::CheckArchiveFiles()
 	RegEx regExSevenZipMulti(".*\\.7z\\.[0-9]+$");
 	RegEx regExSplitExt(".*\\.[a-z,0-9]{3}\\.[0-9]{3}$");
 
+	FileList rarFiles;
+
 	DirBrowser dir(m_destDir);
 	while (const char* filename = dir.Next())
 	{
@@ -647,6 +749,11 @@ void UnpackController::CheckArchiveFiles()
 			const char* ext = strrchr(filename, '.');
 			int extNum = ext ? atoi(ext + 1) : -1;
 
+			if (regExRar.Match(filename) || regExRarMultiSeq.Match(filename))
+			{
+				rarFiles.emplace_back(filename);
+			}
+
 			if (regExRar.Match(filename))
 			{
 				m_hasRarFiles = true;
@@ -669,12 +776,86 @@ void UnpackController::CheckArchiveFiles()
 			}
 			else if (!m_hasRenamedArchiveFiles && !regExRarMultiSeq.Match(filename) &&
 				!Util::MatchFileExt(filename, g_Options->GetUnpackIgnoreExt(), ",;") &&
-				FileHasRarSignature(fullFilename))
+				(m_indexedVolumes.Exists(filename) || FileHasRarSignature(fullFilename)))
 			{
 				m_hasRenamedArchiveFiles = true;
 			}
 		}
 	}
+
+	FindRarSets(rarFiles);
+}
+
+/**
+ * Rar-sets are unpacked in parallel only if the rar-index of nzb proves that the
+ * volumes form separate sets: the headers of all volumes must be indexed and
+ * each volume must belong to the set which unrar finds by the name of its first
+ * volume. Otherwise (for example with obfuscated volume names) "m_rarSets"
+ * remains empty and all volumes are unpacked with one unrar-process.
+ */
+void UnpackController::FindRarSets(FileList& rarFiles)
+{
+	FileList firstVolumes;
+	for (CString& filename : rarFiles)
+	{
+		if (!m_indexedVolumes.Exists(filename))
+		{
+			return;
+		}
+
+		if (!m_nonFirstVolumes.Exists(filename))
+		{
+			if (strcmp(FirstVolumeName(filename), filename))
+			{
+				return;
+			}
+			firstVolumes.emplace_back(*filename);
+		}
+	}
+
+	for (CString& filename : rarFiles)
+	{
+		if (m_nonFirstVolumes.Exists(filename) && !firstVolumes.Exists(FirstVolumeName(filename)))
+		{
+			return;
+		}
+	}
+
+	if (firstVolumes.size() > 1)
+	{
+		m_rarSets = std::move(firstVolumes);
+	}
+}
+
+/**
+ * Returns the name of the first volume of a rar-set as derived by unrar
+ * from the name of the given volume, or an empty string if the name doesn't
+ * follow the volume naming schemes.
+ */
+CString UnpackController::FirstVolumeName(const char* filename)
+{
+	RegEx regExRarPart(".*\\.part([0-9]+)\\.rar$");
+	RegEx regExRarMultiSeq(".*\\.[r-z][0-9][0-9]$");
+
+	if (regExRarPart.Match(filename))
+	{
+		// new naming: "name.part001.rar" with the same number of digits
+		int digits = regExRarPart.GetMatchLen(1);
+		return CString::FormatStr("%.*s%0*i.rar", regExRarPart.GetMatchStart(1), filename, digits, 1);
+	}
+
+	if (regExRarMultiSeq.Match(filename))
+	{
+		// old naming: "name.rar", "name.r00", "name.r01", ...
+		return CString::FormatStr("%.*s.rar", (int)(strlen(filename) - 4), filename);
+	}
+
+	if (Util::EndsWith(filename, ".rar", false))
+	{
+		return filename;
+	}
+
+	return "";
 }
 
 bool UnpackController::FileHasRarSignature(const char* filename)
@@ -826,7 +1007,7 @@ bool UnpackController::ReadLine(char* buf, int bufSize, FILE* stream)
 				}
 				printed = true;
 			}
-			if (strchr(backspace, '%'))
+			if (strchr(backspace, '%') && !m_owner)
 			{
 				int percent = atoi(backspace + 1);
 				m_postInfo->SetStageProgress(percent * 10);
@@ -924,7 +1105,16 @@ void UnpackController::Stop()
 {
 	debug("Stopping unpack");
 	Thread::Stop();
-	Terminate();
+
+	Guard guard(m_workersMutex);
+	if (m_workers.empty())
+	{
+		Terminate();
+	}
+	for (UnpackController* worker : m_workers)
+	{
+		worker->Stop();
+	}
 }
 
 void UnpackController::SetProgressLabel(const char* progressLabel)
@@ -90,9 +90,19 @@ private:
 	bool m_unpackDirCreated = false;
 	bool m_passListTried = false;
 	FileList m_joinedFiles;
+	FileList m_indexedVolumes;
+	FileList m_nonFirstVolumes;
+	FileList m_rarSets;
+	FileList m_unpackedSets;
+	UnpackController* m_owner = nullptr;
+	CString m_archiveSet;
+	bool m_workersTerminated = false;
+	Mutex m_workersMutex;
+	std::vector<UnpackController*> m_workers;
 
 	void ExecuteUnpack(EUnpacker unpacker, const char* password, bool multiVolumes);
 	void ExecuteUnrar(const char* password);
+	void ExecuteParallelUnrar(const char* password);
 	void ExecuteSevenZip(const char* password, bool multiVolumes);
 	void UnpackArchives(EUnpacker unpacker, bool multiVolumes);
 	void JoinSplittedFiles();
@@ -106,6 +116,9 @@ private:
 	void RequestParCheck(bool forceRepair);
 #endif
 	bool FileHasRarSignature(const char* filename);
+	void FindRarSets(FileList& rarFiles);
+	CString FirstVolumeName(const char* filename);
+	bool IsTerminated() { return GetTerminated() || m_workersTerminated; }
 	bool PrepareCmdParams(const char* command, ParamList* params, const char* infoName);
 };
 
@@ -113,7 +113,7 @@ void DirectParLoader::Run()
 
 	GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
 
-	NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
+	NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
 	if (nzbInfo)
 	{
 		// nzb is still in queue
@@ -133,7 +133,7 @@ void DirectParLoader::LoadParFile(const char* parFile)
 
 	GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
 
-	NzbInfo* nzbInfo = downloadQueue->GetQueue()->Find(m_nzbId);
+	NzbInfo* nzbInfo = downloadQueue->FindNzb(m_nzbId);
 	if (!nzbInfo)
 	{
 		// nzb isn't in queue anymore
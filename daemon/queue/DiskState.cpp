@@ -25,9 +25,10 @@
 #include "Log.h"
 #include "Util.h"
 #include "FileSystem.h"
+#include "PerfStats.h"
 
 static const char* FORMATVERSION_SIGNATURE = "nzbget diskstate file version ";
-const int DISKSTATE_QUEUE_VERSION = 62;
+const int DISKSTATE_QUEUE_VERSION = 63;
 const int DISKSTATE_FILE_VERSION = 6;
 const int DISKSTATE_STATS_VERSION = 3;
 const int DISKSTATE_FEEDS_VERSION = 3;
@@ -37,6 +38,7 @@ class StateDiskFile : public DiskFile
 public:
 	int64 PrintLine(const char* format, ...) PRINTF_SYNTAX(2);
 	char* ReadLine(char* buffer, int64 size);
+	char* ReadLine(CharBuffer& buffer);
 	int ScanLine(const char* format, ...) SCANF_SYNTAX(2);
 };
 
@@ -79,6 +81,36 @@ char* StateDiskFile::ReadLine(char* buffer, int64 size)
 	return buffer;
 }
 
+/*
+ * Reads the whole line, the buffer grows as needed.
+ */
+char* StateDiskFile::ReadLine(CharBuffer& buffer)
+{
+	if (buffer.Size() < 2)
+	{
+		buffer.Reserve(1024);
+	}
+
+	int len = 0;
+	while (DiskFile::ReadLine(buffer + len, buffer.Size() - len))
+	{
+		len += strlen(buffer + len);
+		if (buffer[len - 1] == '\n')
+		{
+			buffer[len - 1] = 0;
+			return buffer;
+		}
+		if (len < buffer.Size() - 1)
+		{
+			// last line without line ending
+			return buffer;
+		}
+		buffer.Reserve(buffer.Size() * 2);
+	}
+
+	return len > 0 ? *buffer : nullptr;
+}
+
 /*
 * Standard "fscanf" scans beoynd current line if the next line is empty.
 * This wrapper fixes that.
@@ -262,6 +294,8 @@ StateDiskFile* StateFile::BeginRead()
  */
 bool DiskState::SaveDownloadQueue(DownloadQueue* downloadQueue, bool saveHistory)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	debug("Saving queue and history to disk");
 
 	bool ok = true;
@@ -424,6 +458,8 @@ error:
 
 bool DiskState::SaveDownloadProgress(DownloadQueue* downloadQueue)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	int count = 0;
 	for (NzbInfo* nzbInfo : downloadQueue->GetQueue())
 	{
@@ -593,6 +629,7 @@ void DiskState::SaveNzbInfo(NzbInfo* nzbInfo, StateDiskFile& outfile)
 			completedFile.GetParSetId() ? completedFile.GetParSetId() : "");
 		outfile.PrintLine("%s", completedFile.GetFilename());
 		outfile.PrintLine("%s", completedFile.GetOrigname() ? completedFile.GetOrigname() : "");
+		outfile.PrintLine("%s", completedFile.GetRarInfo() ? completedFile.GetRarInfo() : "");
 	}
 
 	outfile.PrintLine("%i", (int)nzbInfo->GetParameters()->size());
@@ -846,6 +883,8 @@ bool DiskState::LoadNzbInfo(NzbInfo* nzbInfo, Servers* servers, StateDiskFile& i
 		char* parSetId = nullptr;
 		char filenameBuf[1024];
 		char origName[1024];
+		CharBuffer rarInfo(CompletedFile::MAX_RARINFO_SIZE + 2);
+		rarInfo[0] = '\0';
 
 		if (formatVersion >= 49)
 		{
@@ -889,6 +928,10 @@ bool DiskState::LoadNzbInfo(NzbInfo* nzbInfo, Servers* servers, StateDiskFile& i
 				fileName = filenameBuf;
 				if (!infile.ReadLine(origName, sizeof(origName))) goto error;
 			}
+			if (formatVersion >= 63)
+			{
+				if (!infile.ReadLine(rarInfo, rarInfo.Size())) goto error;
+			}
 		}
 
 		nzbInfo->GetCompletedFiles()->emplace_back(id, fileName,
@@ -896,6 +939,10 @@ bool DiskState::LoadNzbInfo(NzbInfo* nzbInfo, Servers* servers, StateDiskFile& i
 			(CompletedFile::EStatus)status, crc, (bool)parFile,
 			Util::EmptyStr(hash16k) ? nullptr : hash16k,
 			Util::EmptyStr(parSetId) ? nullptr : parSetId);
+		if (!Util::EmptyStr(rarInfo))
+		{
+			nzbInfo->GetCompletedFiles()->back().SetRarInfo(rarInfo);
+		}
 	}
 
 	nzbInfo->GetParameters()->clear();
@@ -1019,6 +1066,8 @@ error:
 
 bool DiskState::SaveFile(FileInfo* fileInfo)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	debug("Saving FileInfo %i to disk", fileInfo->GetId());
 
 	BString<100> filename("%i", fileInfo->GetId());
@@ -1150,6 +1199,7 @@ bool DiskState::LoadFileInfo(FileInfo* fileInfo, StateDiskFile& infile, int form
 	if (articles)
 	{
 		if (infile.ScanLine("%i", &size) != 1) goto error;
+		fileInfo->GetArticles()->reserve(size);
 		for (int i = 0; i < size; i++)
 		{
 			int PartNumber, PartSize;
@@ -1157,11 +1207,7 @@ bool DiskState::LoadFileInfo(FileInfo* fileInfo, StateDiskFile& infile, int form
 
 			if (!infile.ReadLine(buf, sizeof(buf))) goto error;
 
-			std::unique_ptr<ArticleInfo> articleInfo = std::make_unique<ArticleInfo>();
-			articleInfo->SetPartNumber(PartNumber);
-			articleInfo->SetSize(PartSize);
-			articleInfo->SetMessageId(buf);
-			fileInfo->GetArticles()->push_back(std::move(articleInfo));
+			fileInfo->GetArticles()->Add(PartNumber, PartSize, buf);
 		}
 	}
 
@@ -1174,6 +1220,8 @@ error:
 
 bool DiskState::SaveFileState(FileInfo* fileInfo, bool completed)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	debug("Saving FileState %i to disk", fileInfo->GetId());
 
 	BString<100> filename("%i%s", fileInfo->GetId(), completed ? "c" : "s");
@@ -1276,13 +1324,14 @@ bool DiskState::LoadFileState(FileInfo* fileInfo, Servers* servers, StateDiskFil
 
 	int size;
 	if (infile.ScanLine("%i", &size) != 1) goto error;
+	if (!hasArticles)
+	{
+		fileInfo->GetArticles()->reserve(size);
+	}
 	for (int i = 0; i < size; i++)
 	{
-		if (!hasArticles)
-		{
-			fileInfo->GetArticles()->push_back(std::make_unique<ArticleInfo>());
-		}
-		std::unique_ptr<ArticleInfo>& pa = fileInfo->GetArticles()->at(i);
+		ArticleInfo* pa = hasArticles ? fileInfo->GetArticles()->at(i) :
+			fileInfo->GetArticles()->Add(0, 0, nullptr);
 
 		int statusInt;
 
@@ -1358,7 +1407,9 @@ void DiskState::DiscardFiles(NzbInfo* nzbInfo, bool deleteLog)
 	{
 		BString<1024> filename;
 		filename.Format("%s%cn%i.log", g_Options->GetQueueDir(), PATH_SEPARATOR, nzbInfo->GetId());
+		g_Log->CloseFile(filename);
 		FileSystem::DeleteFile(filename);
+		DiscardLogIndex(nzbInfo->GetId());
 	}
 }
 
@@ -1666,6 +1717,8 @@ void DiskState::CleanupQueueDir(DownloadQueue* downloadQueue)
  */
 bool DiskState::SaveFeeds(Feeds* feeds, FeedHistory* feedHistory)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	debug("Saving feeds state to disk");
 
 	StateFile stateFile("feeds", DISKSTATE_FEEDS_VERSION, true);
@@ -1840,6 +1893,8 @@ void DiskState::CalcFileStats(DownloadQueue* downloadQueue, int formatVersion)
 
 bool DiskState::SaveAllFileInfos(DownloadQueue* downloadQueue)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	bool ok = true;
 	StateFile stateFile("files", DISKSTATE_FILE_VERSION, true);
 	if (!downloadQueue->GetQueue()->empty())
@@ -1996,6 +2051,8 @@ error:
 
 bool DiskState::SaveStats(Servers* servers, ServerVolumes* serverVolumes)
 {
+	PerfTimer timer(PerfStats::pmStateSave);
+
 	debug("Saving stats to disk");
 
 	StateFile stateFile("stats", DISKSTATE_STATS_VERSION, true);
@@ -2408,13 +2465,6 @@ void DiskState::AppendNzbMessage(int nzbId, Message::EKind kind, const char* tex
 {
 	BString<1024> logFilename("%s%cn%i.log", g_Options->GetQueueDir(), PATH_SEPARATOR, nzbId);
 
-	StateDiskFile outfile;
-	if (!outfile.Open(logFilename, StateDiskFile::omAppend))
-	{
-		error("Error saving log: Could not create file %s", *logFilename);
-		return;
-	}
-
 	const char* messageType[] = { "INFO", "WARNING", "ERROR", "DEBUG", "DETAIL"};
 
 	BString<1024> tmp2;
@@ -2436,12 +2486,18 @@ void DiskState::AppendNzbMessage(int nzbId, Message::EKind kind, const char* tex
 	BString<100> time;
 	Util::FormatTime(rawtime, time, 100);
 
-	outfile.Print("%s\t%u\t%s\t%s%s", *time, (int)tm, messageType[kind], *tmp2, LINE_ENDING);
-
-	outfile.Close();
+	// written asynchronously by the log writer
+	CString line = CString::FormatStr("%s\t%u\t%s\t%s%s", *time, (int)tm, messageType[kind], *tmp2, LINE_ENDING);
+	g_Log->AppendFile(logFilename, kind, line);
 }
 
-void DiskState::LoadNzbMessages(int nzbId, MessageList* messages)
+/*
+ * Loads all messages or only the last "nrEntries" messages or the messages
+ * starting with "idFrom". The message ids are line numbers in the log-file;
+ * the line positions are kept in an index so that only the requested lines
+ * are read and parsed.
+ */
+void DiskState::LoadNzbMessages(int nzbId, MessageList* messages, int idFrom, int nrEntries)
 {
 	// Important:
 	//   - Other threads may be writing into the log-file at any time;
@@ -2449,6 +2505,9 @@ void DiskState::LoadNzbMessages(int nzbId, MessageList* messages)
 
 	BString<1024> logFilename("%s%cn%i.log", g_Options->GetQueueDir(), PATH_SEPARATOR, nzbId);
 
+	// make sure all queued messages are in the file
+	g_Log->FlushFiles();
+
 	if (!FileSystem::FileExists(logFilename))
 	{
 		return;
@@ -2461,9 +2520,47 @@ void DiskState::LoadNzbMessages(int nzbId, MessageList* messages)
 		return;
 	}
 
-	int id = 0;
-	char line[1024];
-	while (infile.ReadLine(line, sizeof(line)))
+	int firstLine = 0;
+	int lineCount = 0;
+	int64 position = 0;
+	{
+		Guard guard(m_logIndexMutex);
+
+		if (m_logIndexes.size() > 100 && m_logIndexes.find(nzbId) == m_logIndexes.end())
+		{
+			// indexes for logs viewed long time ago aren't worth keeping
+			m_logIndexes.clear();
+		}
+
+		LogIndex& index = m_logIndexes[nzbId];
+		if (!UpdateLogIndex(infile, index))
+		{
+			error("Error reading log: could not read file %s", *logFilename);
+			m_logIndexes.erase(nzbId);
+			return;
+		}
+
+		lineCount = (int)index.offsets.size();
+		if (nrEntries > 0)
+		{
+			firstLine = std::max(lineCount - nrEntries, 0);
+		}
+		else if (idFrom > 0)
+		{
+			firstLine = std::min(idFrom - 1, lineCount);
+		}
+		position = firstLine < lineCount ? index.offsets[firstLine] : index.size;
+	}
+
+	if (!infile.Seek(position))
+	{
+		error("Error reading log: could not read file %s", *logFilename);
+		return;
+	}
+
+	int id = firstLine;
+	CharBuffer line(2048);
+	while (id < lineCount && infile.ReadLine(line))
 	{
 		Util::TrimRight(line);
 
@@ -2511,3 +2608,56 @@ exit:
 	infile.Close();
 	return;
 }
+
+/*
+ * Adds positions of lines written since the last update. Only complete lines
+ * are indexed, a line being written at the moment is picked up next time.
+ */
+bool DiskState::UpdateLogIndex(DiskFile& infile, LogIndex& index)
+{
+	if (!infile.Seek(0, DiskFile::soEnd))
+	{
+		return false;
+	}
+
+	int64 fileSize = infile.Position();
+	if (fileSize < index.size)
+	{
+		// the file was recreated
+		index.size = 0;
+		index.offsets.clear();
+	}
+
+	if (fileSize == index.size || !infile.Seek(index.size))
+	{
+		return fileSize == index.size;
+	}
+
+	CharBuffer buffer(64 * 1024);
+	int64 position = index.size;
+	int64 lineStart = index.size;
+	while (position < fileSize)
+	{
+		int64 len = infile.Read(buffer, std::min((int64)buffer.Size(), fileSize - position));
+		if (len <= 0)
+		{
+			break;
+		}
+
+		for (const char* p = buffer, *end = buffer + len; (p = (const char*)memchr(p, '\n', end - p)); p++)
+		{
+			index.offsets.push_back(lineStart);
+			lineStart = position + (p - buffer) + 1;
+		}
+		position += len;
+	}
+
+	index.size = lineStart;
+	return true;
+}
+
+void DiskState::DiscardLogIndex(int nzbId)
+{
+	Guard guard(m_logIndexMutex);
+	m_logIndexes.erase(nzbId);
+}
@@ -55,9 +55,20 @@ public:
 	void WriteCacheFlag();
 	void DeleteCacheFlag();
 	void AppendNzbMessage(int nzbId, Message::EKind kind, const char* text);
-	void LoadNzbMessages(int nzbId, MessageList* messages);
+	void LoadNzbMessages(int nzbId, MessageList* messages, int idFrom = 0, int nrEntries = 0);
 
 private:
+	/* Positions of lines in a per-nzb log-file; extended as the file grows. */
+	struct LogIndex
+	{
+		int64 size = 0;
+		std::vector<int64> offsets;
+	};
+	typedef std::unordered_map<int, LogIndex> LogIndexMap;
+
+	LogIndexMap m_logIndexes;
+	Mutex m_logIndexMutex;
+
 	bool SaveFileInfo(FileInfo* fileInfo, StateDiskFile& outfile, bool articles);
 	bool LoadFileInfo(FileInfo* fileInfo, StateDiskFile& outfile, int formatVersion, bool fileSummary, bool articles);
 	bool SaveFileState(FileInfo* fileInfo, StateDiskFile& outfile, bool completed);
@@ -86,6 +97,8 @@ private:
 	void SaveServerStats(ServerStatList* serverStatList, StateDiskFile& outfile);
 	bool LoadServerStats(ServerStatList* serverStatList, Servers* servers, StateDiskFile& infile);
 	void CleanupQueueDir(DownloadQueue* downloadQueue);
+	bool UpdateLogIndex(DiskFile& infile, LogIndex& index);
+	void DiscardLogIndex(int nzbId);
 };
 
 extern DiskState* g_DiskState;
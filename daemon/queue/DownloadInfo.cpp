@@ -777,6 +777,29 @@ void ArticleInfo::DiscardSegment()
 }
 
 
+ArticleInfo* ArticleList::Add(int partNumber, int size, const char* messageId)
+{
+	m_articles.emplace_back(partNumber, size, messageId ? m_messageIds.Add(messageId) : nullptr);
+	return &m_articles.back();
+}
+
+void ArticleList::reserve(int count, int messageIdSize)
+{
+	m_articles.reserve(count);
+	if (messageIdSize > 0)
+	{
+		m_messageIds.Reserve(messageIdSize);
+	}
+}
+
+void ArticleList::clear()
+{
+	// release the memory, not only the elements
+	Articles().swap(m_articles);
+	m_messageIds.Clear();
+}
+
+
 void FileInfo::SetId(int id)
 {
 	m_id = id;
@@ -901,6 +924,152 @@ const char* HistoryInfo::GetName()
 }
 
 
+/*
+ * Id lookups use indexes mapping ids to list positions. An index is rebuilt
+ * when the queue reports a structural change (see GetRevision). Every hit is
+ * verified, and misses are trusted only if the list size hasn't changed since
+ * the index was built, so changes made without increasing the revision
+ * cause a rebuild instead of a wrong result.
+ */
+void DownloadQueue::BuildNzbIndex()
+{
+	m_nzbIndex.clear();
+	int pos = 0;
+	for (NzbInfo* nzbInfo : &m_queue)
+	{
+		m_nzbIndex[nzbInfo->GetId()] = pos++;
+	}
+	m_nzbIndexRevision = m_revision;
+}
+
+void DownloadQueue::BuildFileIndex()
+{
+	m_fileIndex.clear();
+	int nzbPos = 0;
+	for (NzbInfo* nzbInfo : &m_queue)
+	{
+		int filePos = 0;
+		for (FileInfo* fileInfo : nzbInfo->GetFileList())
+		{
+			m_fileIndex[fileInfo->GetId()] = {nzbPos, filePos++};
+		}
+		nzbPos++;
+	}
+	m_fileIndexRevision = m_revision;
+}
+
+void DownloadQueue::BuildHistoryIndex()
+{
+	m_historyIndex.clear();
+	int pos = 0;
+	for (HistoryInfo* historyInfo : &m_history)
+	{
+		m_historyIndex[historyInfo->GetId()] = pos++;
+	}
+	m_historyIndexRevision = m_revision;
+}
+
+NzbInfo* DownloadQueue::FindNzb(int id)
+{
+	if (m_nzbIndexRevision != m_revision)
+	{
+		BuildNzbIndex();
+	}
+
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		PositionIndex::iterator it = m_nzbIndex.find(id);
+		if (it != m_nzbIndex.end() && it->second < (int)m_queue.size() &&
+			m_queue[it->second]->GetId() == id)
+		{
+			return m_queue[it->second].get();
+		}
+
+		if (attempt > 0 || (it == m_nzbIndex.end() && m_nzbIndex.size() == m_queue.size()))
+		{
+			break;
+		}
+		BuildNzbIndex();
+	}
+
+	return nullptr;
+}
+
+FileInfo* DownloadQueue::FindFile(int id)
+{
+	if (m_fileIndexRevision != m_revision)
+	{
+		BuildFileIndex();
+	}
+
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		FilePositionIndex::iterator it = m_fileIndex.find(id);
+		if (it != m_fileIndex.end() && it->second.first < (int)m_queue.size())
+		{
+			FileList* fileList = m_queue[it->second.first]->GetFileList();
+			if (it->second.second < (int)fileList->size() &&
+				(*fileList)[it->second.second]->GetId() == id)
+			{
+				return (*fileList)[it->second.second].get();
+			}
+		}
+
+		if (attempt > 0)
+		{
+			break;
+		}
+
+		if (it == m_fileIndex.end())
+		{
+			uint32 fileCount = 0;
+			for (NzbInfo* nzbInfo : &m_queue)
+			{
+				fileCount += nzbInfo->GetFileList()->size();
+			}
+			if (fileCount == m_fileIndex.size())
+			{
+				break;
+			}
+		}
+		BuildFileIndex();
+	}
+
+	return nullptr;
+}
+
+HistoryInfo* DownloadQueue::FindHistory(int id)
+{
+	int pos = FindHistoryPosition(id);
+	return pos > -1 ? m_history[pos].get() : nullptr;
+}
+
+int DownloadQueue::FindHistoryPosition(int id)
+{
+	if (m_historyIndexRevision != m_revision)
+	{
+		BuildHistoryIndex();
+	}
+
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		PositionIndex::iterator it = m_historyIndex.find(id);
+		if (it != m_historyIndex.end() && it->second < (int)m_history.size() &&
+			m_history[it->second]->GetId() == id)
+		{
+			return it->second;
+		}
+
+		if (attempt > 0 || (it == m_historyIndex.end() && m_historyIndex.size() == m_history.size()))
+		{
+			break;
+		}
+		BuildHistoryIndex();
+	}
+
+	return -1;
+}
+
 void DownloadQueue::CalcRemainingSize(int64* remaining, int64* remainingForced)
 {
 	int64 remainingSize = 0;
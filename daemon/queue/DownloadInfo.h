@@ -27,6 +27,7 @@
 #include "Observer.h"
 #include "Log.h"
 #include "Thread.h"
+#include "PerfStats.h"
 
 class NzbInfo;
 class DownloadQueue;
@@ -82,11 +83,10 @@ public:
 		aiFailed
 	};
 
-	void SetPartNumber(int s) { m_partNumber = s; }
+	ArticleInfo(int partNumber, int size, const char* messageId) :
+		m_messageId(messageId), m_partNumber(partNumber), m_size(size) {}
 	int GetPartNumber() { return m_partNumber; }
 	const char* GetMessageId() { return m_messageId; }
-	void SetMessageId(const char* messageId) { m_messageId = messageId; }
-	void SetSize(int size) { m_size = size; }
 	int GetSize() { return m_size; }
 	void AttachSegment(std::unique_ptr<SegmentData> content, int64 offset, int size);
 	void DiscardSegment();
@@ -95,26 +95,65 @@ public:
 	int64 GetSegmentOffset() { return m_segmentOffset; }
 	void SetSegmentSize(int segmentSize) { m_segmentSize = segmentSize; }
 	int GetSegmentSize() { return m_segmentSize; }
-	EStatus GetStatus() { return m_status; }
-	void SetStatus(EStatus Status) { m_status = Status; }
+	EStatus GetStatus() { return (EStatus)m_status; }
+	void SetStatus(EStatus Status) { m_status = (uint8)Status; }
 	const char* GetResultFilename() { return m_resultFilename; }
 	void SetResultFilename(const char* resultFilename) { m_resultFilename = resultFilename; }
 	uint32 GetCrc() { return m_crc; }
 	void SetCrc(uint32 crc) { m_crc = crc; }
 
 private:
-	int m_partNumber;
-	CString m_messageId;
-	int m_size = 0;
+	// members are ordered by size to avoid padding: large queues hold millions of articles
+	const char* m_messageId;
 	std::unique_ptr<SegmentData> m_segmentContent;
 	int64 m_segmentOffset = 0;
-	int m_segmentSize = 0;
-	EStatus m_status = aiUndefined;
 	CString m_resultFilename;
+	int m_partNumber;
+	int m_size;
+	int m_segmentSize = 0;
 	uint32 m_crc = 0;
+	uint8 m_status = aiUndefined;
 };
 
-typedef std::vector<std::unique_ptr<ArticleInfo>> ArticleList;
+/*
+Articles of a file are stored in one contiguous array, the message-ids in a
+string pool owned by the list. Pointers to articles remain valid as long as
+no articles are added; the list is filled only when loading or parsing a file
+and is either cleared or left untouched while articles are being downloaded.
+ */
+class ArticleList
+{
+public:
+	typedef std::vector<ArticleInfo> Articles;
+
+	class iterator
+	{
+	public:
+		iterator(Articles::iterator baseIterator) : m_baseIterator(baseIterator) {}
+		ArticleInfo* operator*() { return &*m_baseIterator; }
+		iterator& operator++() { ++m_baseIterator; return *this; }
+		bool operator!=(const iterator& other) { return m_baseIterator != other.m_baseIterator; }
+
+	private:
+		Articles::iterator m_baseIterator;
+	};
+
+	ArticleInfo* Add(int partNumber, int size, const char* messageId);
+	void reserve(int count, int messageIdSize = 0);
+	void clear();
+	int size() { return (int)m_articles.size(); }
+	bool empty() { return m_articles.empty(); }
+	ArticleInfo* at(int index) { return &m_articles.at(index); }
+	iterator begin() { return iterator(m_articles.begin()); }
+	iterator end() { return iterator(m_articles.end()); }
+
+private:
+	Articles m_articles;
+	StringPool m_messageIds;
+};
+
+inline ArticleList::iterator begin(ArticleList* articles) { return articles->begin(); }
+inline ArticleList::iterator end(ArticleList* articles) { return articles->end(); }
 
 class FileInfo
 {
@@ -198,6 +237,8 @@ public:
 	void SetHash16k(const char* hash16k) { m_hash16k = hash16k; }
 	const char* GetParSetId() { return m_parSetId; }
 	void SetParSetId(const char* parSetId) { m_parSetId = parSetId; }
+	const char* GetRarInfo() { return m_rarInfo; }
+	void SetRarInfo(const char* rarInfo) { m_rarInfo = rarInfo; }
 	bool GetFlushLocked() { return m_flushLocked; }
 	void SetFlushLocked(bool flushLocked) { m_flushLocked = flushLocked; }
 
@@ -240,6 +281,7 @@ private:
 	uint32 m_crc = 0;
 	CString m_hash16k;
 	CString m_parSetId;
+	CString m_rarInfo;
 	bool m_flushLocked = false;
 
 	static int m_idGen;
@@ -276,6 +318,11 @@ public:
 	void SetHash16k(const char* hash16k) { m_hash16k = hash16k; }
 	const char* GetParSetId() { return m_parSetId; }
 	void SetParSetId(const char* parSetId) { m_parSetId = parSetId; }
+	// serialized rar-headers, see RarVolume::Serialize; volumes with
+	// very long file lists are not indexed
+	static const int MAX_RARINFO_SIZE = 16 * 1024;
+	const char* GetRarInfo() { return m_rarInfo; }
+	void SetRarInfo(const char* rarInfo) { m_rarInfo = rarInfo; }
 
 private:
 	int m_id;
@@ -286,6 +333,7 @@ private:
 	bool m_parFile;
 	CString m_hash16k;
 	CString m_parSetId;
+	CString m_rarInfo;
 };
 
 typedef std::deque<CompletedFile> CompletedFileList;
@@ -778,6 +826,43 @@ public:
 	typedef std::vector<CString> ParredFiles;
 	typedef std::vector<CString> ExtractedArchives;
 
+	/*
+	 * Source file of a par-set verified during download (option DirectParCheck).
+	 * Good files need no verification by par-checker, for damaged files
+	 * the downloaded articles tell which blocks are valid.
+	 */
+	class DirectParFile
+	{
+	public:
+		struct Segment
+		{
+			bool m_success;
+			int64 m_offset;
+			int m_size;
+			uint32 m_crc;
+
+			Segment(bool success, int64 offset, int size, uint32 crc) :
+				m_success(success), m_offset(offset), m_size(size), m_crc(crc) {}
+		};
+
+		typedef std::vector<Segment> SegmentList;
+
+		DirectParFile(const char* filename, int64 size, CompletedFile::EStatus status) :
+			m_filename(filename), m_size(size), m_status(status) {}
+		const char* GetFilename() { return m_filename; }
+		int64 GetSize() { return m_size; }
+		CompletedFile::EStatus GetStatus() { return m_status; }
+		SegmentList* GetSegments() { return &m_segments; }
+
+	private:
+		CString m_filename;
+		int64 m_size;
+		CompletedFile::EStatus m_status;
+		SegmentList m_segments;
+	};
+
+	typedef std::deque<DirectParFile> DirectParFiles;
+
 	NzbInfo* GetNzbInfo() { return m_nzbInfo; }
 	void SetNzbInfo(NzbInfo* nzbInfo) { m_nzbInfo = nzbInfo; }
 	EStage GetStage() { return m_stage; }
@@ -812,10 +897,13 @@ public:
 	void SetLastUnpackStatus(int unpackStatus) { m_lastUnpackStatus = unpackStatus; }
 	bool GetNeedParCheck() { return m_needParCheck; }
 	void SetNeedParCheck(bool needParCheck) { m_needParCheck = needParCheck; }
+	EStage GetWaitStage() { return m_waitStage; }
+	void SetWaitStage(EStage waitStage) { m_waitStage = waitStage; }
 	Thread* GetPostThread() { return m_postThread; }
 	void SetPostThread(Thread* postThread) { m_postThread = postThread; }
 	ParredFiles* GetParredFiles() { return &m_parredFiles; }
 	ExtractedArchives* GetExtractedArchives() { return &m_extractedArchives; }
+	DirectParFiles* GetDirectParFiles() { return &m_directParFiles; }
 
 private:
 	NzbInfo* m_nzbInfo = nullptr;
@@ -829,6 +917,7 @@ private:
 	bool m_passListTried = false;
 	int m_lastUnpackStatus = 0;
 	bool m_needParCheck = false;
+	EStage m_waitStage = ptQueued;
 	EStage m_stage = ptQueued;
 	CString m_progressLabel = "";
 	int m_fileProgress = 0;
@@ -838,6 +927,7 @@ private:
 	Thread* m_postThread = nullptr;
 	ParredFiles m_parredFiles;
 	ExtractedArchives m_extractedArchives;
+	DirectParFiles m_directParFiles;
 };
 
 typedef std::vector<int> IdList;
@@ -921,7 +1011,23 @@ private:
 
 typedef UniqueDeque<HistoryInfo> HistoryList;
 
-typedef GuardedPtr<DownloadQueue> GuardedDownloadQueue;
+/*
+ * Records the time spent waiting for the queue lock and the time the lock
+ * was held (see PerfStats).
+ */
+class GuardedDownloadQueue : public GuardedPtr<DownloadQueue>
+{
+public:
+	GuardedDownloadQueue(DownloadQueue* ptr, Mutex* mutex, int64 waitStart, const char* file, int line) :
+		GuardedPtr(ptr, mutex, file, line), m_lockTime(PerfStats::Record(PerfStats::pmQueueLockWait, waitStart)) {}
+	GuardedDownloadQueue(GuardedDownloadQueue&& other) : GuardedPtr(std::move(other)),
+		m_lockTime(other.m_lockTime) { other.m_locked = false; }
+	~GuardedDownloadQueue() { if (m_locked) PerfStats::Record(PerfStats::pmQueueLockHold, m_lockTime); }
+
+private:
+	int64 m_lockTime;
+	bool m_locked = true;
+};
 
 class DownloadQueue : public Subject
 {
@@ -1014,7 +1120,12 @@ public:
 	};
 
 	static bool IsLoaded() { return g_Loaded; }
-	static GuardedDownloadQueue Guard() { return GuardedDownloadQueue(g_DownloadQueue, &g_DownloadQueue->m_lockMutex); }
+	static GuardedDownloadQueue Guard(const char* file = CALLER_FILE, int line = CALLER_LINE)
+		{ return GuardedDownloadQueue(g_DownloadQueue, &g_DownloadQueue->m_lockMutex, PerfStats::Now(), file, line); }
+	// collecting of lock wait and hold times per call site, see Mutex::EnableProfiling
+	void EnableLockProfiling() { m_lockMutex.EnableProfiling(); }
+	// must be accessed only while the queue is locked
+	LockProfile* GetLockProfile() { return m_lockMutex.GetProfile(); }
 	NzbList* GetQueue() { return &m_queue; }
 	HistoryList* GetHistory() { return &m_history; }
 	virtual bool EditEntry(int ID, EEditAction action, const char* args) = 0;
@@ -1022,6 +1133,15 @@ public:
 	virtual void HistoryChanged() = 0;
 	virtual void Save() = 0;
 	virtual void SaveChanged() = 0;
+	// revision is increased on every structural change of queue or history
+	// (items added, deleted, moved or renamed) and is used to invalidate lookup indexes
+	int GetRevision() { return m_revision; }
+	void Changed() { m_revision++; }
+	NzbInfo* FindNzb(int id);
+	FileInfo* FindFile(int id);
+	HistoryInfo* FindHistory(int id);
+	// position of the item in history list or -1 if not found
+	int FindHistoryPosition(int id);
 	void CalcRemainingSize(int64* remaining, int64* remainingForced);
 
 protected:
@@ -1033,9 +1153,23 @@ protected:
 private:
 	NzbList m_queue;
 	HistoryList m_history;
+	typedef std::unordered_map<int, int> PositionIndex;
+	typedef std::unordered_map<int, std::pair<int, int>> FilePositionIndex;
+
 	Mutex m_lockMutex;
+	int m_revision = 0;
+	PositionIndex m_nzbIndex;
+	FilePositionIndex m_fileIndex;
+	PositionIndex m_historyIndex;
+	int m_nzbIndexRevision = -1;
+	int m_fileIndexRevision = -1;
+	int m_historyIndexRevision = -1;
 
 	static DownloadQueue* g_DownloadQueue;
+
+	void BuildNzbIndex();
+	void BuildFileIndex();
+	void BuildHistoryIndex();
 	static bool g_Loaded;
 };
 
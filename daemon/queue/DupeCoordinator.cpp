@@ -35,6 +35,169 @@ bool DupeCoordinator::SameNameOrKey(const char* name1, const char* dupeKey1,
 		(!hasDupeKeys && !strcasecmp(name1, name2));
 }
 
+void DupeCoordinator::DupeIndex::Clear()
+{
+	m_names.clear();
+	m_keylessNames.clear();
+	m_keys.clear();
+}
+
+std::string DupeCoordinator::DupeIndex::Normalize(const char* str)
+{
+	std::string result(str ? str : "");
+	for (char& ch : result)
+	{
+		ch = tolower((uchar)ch);
+	}
+	return result;
+}
+
+const DupeCoordinator::DupeIndex::PositionList* DupeCoordinator::DupeIndex::FindKey(IndexMap& map, const char* str)
+{
+	IndexMap::iterator it = map.find(Normalize(str));
+	return it != map.end() ? &it->second : nullptr;
+}
+
+void DupeCoordinator::DupeIndex::Add(int position, const char* name, const char* dupeKey)
+{
+	std::string normName = Normalize(name);
+	m_names[normName].push_back(position);
+	if (Util::EmptyStr(dupeKey))
+	{
+		m_keylessNames[normName].push_back(position);
+	}
+	else
+	{
+		m_keys[Normalize(dupeKey)].push_back(position);
+	}
+}
+
+/*
+ * Returns positions of all entries for which "SameNameOrKey" would be true:
+ * - if the dupe key is empty - all entries with the same name;
+ * - otherwise - all entries with the same dupe key plus entries
+ *   having no dupe key but the same name.
+ */
+DupeCoordinator::DupeIndex::PositionList DupeCoordinator::DupeIndex::Find(const char* name, const char* dupeKey)
+{
+	PositionList result;
+
+	if (Util::EmptyStr(dupeKey))
+	{
+		const PositionList* names = FindKey(m_names, name);
+		if (names)
+		{
+			result = *names;
+		}
+		return result;
+	}
+
+	const PositionList* keys = FindKey(m_keys, dupeKey);
+	const PositionList* names = FindKey(m_keylessNames, name);
+	if (keys && names)
+	{
+		result.reserve(keys->size() + names->size());
+		std::merge(keys->begin(), keys->end(), names->begin(), names->end(), std::back_inserter(result));
+	}
+	else if (keys)
+	{
+		result = *keys;
+	}
+	else if (names)
+	{
+		result = *names;
+	}
+
+	return result;
+}
+
+/*
+ * The indexes are rebuilt only when the download queue reports a structural change
+ * (see DownloadQueue::GetRevision), lookups between the changes don't need to scan
+ * queue and history.
+ * The indexes store list positions, which every insert or removal shifts, so they
+ * are not updated incrementally. A rebuild is a single pass over queue and history,
+ * the same work the old code did for every lookup; it is paid at most once per
+ * change while lookups come in bursts (feed refresh, adding many nzb-files).
+ */
+void DupeCoordinator::UpdateIndex(DownloadQueue* downloadQueue)
+{
+	if (m_indexRevision == downloadQueue->GetRevision())
+	{
+		return;
+	}
+
+	m_queueIndex.Clear();
+	int position = 0;
+	for (NzbInfo* nzbInfo : downloadQueue->GetQueue())
+	{
+		m_queueIndex.Add(position++, nzbInfo->GetName(), nzbInfo->GetDupeKey());
+	}
+
+	m_historyIndex.Clear();
+	position = 0;
+	for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+	{
+		if (historyInfo->GetKind() == HistoryInfo::hkDup)
+		{
+			m_historyIndex.Add(position, historyInfo->GetDupInfo()->GetName(), historyInfo->GetDupInfo()->GetDupeKey());
+		}
+		else if (historyInfo->GetKind() == HistoryInfo::hkNzb || historyInfo->GetKind() == HistoryInfo::hkUrl)
+		{
+			m_historyIndex.Add(position, historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey());
+		}
+		position++;
+	}
+
+	m_indexRevision = downloadQueue->GetRevision();
+}
+
+RawNzbList DupeCoordinator::FindQueueDupes(DownloadQueue* downloadQueue, const char* name, const char* dupeKey)
+{
+	UpdateIndex(downloadQueue);
+
+	RawNzbList result;
+	NzbList* queue = downloadQueue->GetQueue();
+	for (int position : m_queueIndex.Find(name, dupeKey))
+	{
+		NzbInfo* nzbInfo = position < (int)queue->size() ? (*queue)[position].get() : nullptr;
+		if (nzbInfo && SameNameOrKey(nzbInfo->GetName(), nzbInfo->GetDupeKey(), name, dupeKey))
+		{
+			result.push_back(nzbInfo);
+		}
+	}
+
+	return result;
+}
+
+std::vector<HistoryInfo*> DupeCoordinator::FindHistoryDupes(DownloadQueue* downloadQueue,
+	const char* name, const char* dupeKey)
+{
+	UpdateIndex(downloadQueue);
+
+	std::vector<HistoryInfo*> result;
+	HistoryList* history = downloadQueue->GetHistory();
+	for (int position : m_historyIndex.Find(name, dupeKey))
+	{
+		HistoryInfo* historyInfo = position < (int)history->size() ? (*history)[position].get() : nullptr;
+		if (!historyInfo)
+		{
+			continue;
+		}
+
+		bool same = historyInfo->GetKind() == HistoryInfo::hkDup ?
+			SameNameOrKey(historyInfo->GetDupInfo()->GetName(), historyInfo->GetDupInfo()->GetDupeKey(), name, dupeKey) :
+			historyInfo->GetKind() != HistoryInfo::hkUnknown &&
+			SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(), name, dupeKey);
+		if (same)
+		{
+			result.push_back(historyInfo);
+		}
+	}
+
+	return result;
+}
+
 /**
   Check if the title was already downloaded or is already queued:
   - if there is a duplicate with exactly same content (via hash-check)
@@ -96,9 +259,10 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 	// if download has empty dupekey and empty dupescore - check if download queue
 	// or history have an item with the same name and non empty dupekey or dupescore and
 	// take these properties from this item
-	if (Util::EmptyStr(nzbInfo->GetDupeKey()) && nzbInfo->GetDupeScore() == 0)
+	bool inheritDupeProps = Util::EmptyStr(nzbInfo->GetDupeKey()) && nzbInfo->GetDupeScore() == 0;
+	if (inheritDupeProps)
 	{
-		for (NzbInfo* queuedNzbInfo : downloadQueue->GetQueue())
+		for (NzbInfo* queuedNzbInfo : FindQueueDupes(downloadQueue, nzbInfo->GetName(), nullptr))
 		{
 			if (!strcmp(queuedNzbInfo->GetName(), nzbInfo->GetName()) &&
 				(!Util::EmptyStr(queuedNzbInfo->GetDupeKey()) || queuedNzbInfo->GetDupeScore() != 0))
@@ -113,7 +277,7 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 	}
 	if (Util::EmptyStr(nzbInfo->GetDupeKey()) && nzbInfo->GetDupeScore() == 0)
 	{
-		for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+		for (HistoryInfo* historyInfo : FindHistoryDupes(downloadQueue, nzbInfo->GetName(), nullptr))
 		{
 			if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
 				!strcmp(historyInfo->GetNzbInfo()->GetName(), nzbInfo->GetName()) &&
@@ -137,6 +301,11 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 			}
 		}
 	}
+	if (inheritDupeProps && (!Util::EmptyStr(nzbInfo->GetDupeKey()) || nzbInfo->GetDupeScore() != 0))
+	{
+		// dupe indexes must not keep the item under its old (empty) key
+		downloadQueue->Changed();
+	}
 
 	// find duplicates in history
 
@@ -145,9 +314,36 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 	bool sameContent = false;
 	const char* dupeName = nullptr;
 
-	// find duplicates in history having exactly same content
-	// also: nzb-files having duplicates marked as good are skipped
+	// nzb-files having duplicates marked as good are skipped
 	// also (only in score mode): nzb-files having success-duplicates in dup-history but not having duplicates in recent history are skipped
+	HistoryInfo* nameDupe = nullptr;
+	bool nameGood = false;
+	for (HistoryInfo* historyInfo : FindHistoryDupes(downloadQueue, nzbInfo->GetName(), nzbInfo->GetDupeKey()))
+	{
+		if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
+			historyInfo->GetNzbInfo()->GetDupeMode() != dmForce &&
+			historyInfo->GetNzbInfo()->GetMarkStatus() == NzbInfo::ksGood)
+		{
+			nameDupe = historyInfo;
+			nameGood = true;
+			break;
+		}
+
+		if (historyInfo->GetKind() == HistoryInfo::hkDup &&
+			historyInfo->GetDupInfo()->GetDupeMode() != dmForce &&
+			(historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood ||
+			 (nzbInfo->GetDupeMode() == dmScore &&
+			  historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsSuccess &&
+			  nzbInfo->GetDupeScore() <= historyInfo->GetDupInfo()->GetDupeScore())))
+		{
+			nameDupe = historyInfo;
+			nameGood = historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood;
+			break;
+		}
+	}
+
+	// find duplicates in history having exactly same content;
+	// the first found item (either by content or by name) determines the result
 	for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
 	{
 		if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
@@ -174,30 +370,11 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 			break;
 		}
 
-		if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
-			historyInfo->GetNzbInfo()->GetDupeMode() != dmForce &&
-			historyInfo->GetNzbInfo()->GetMarkStatus() == NzbInfo::ksGood &&
-			SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(),
-				nzbInfo->GetName(), nzbInfo->GetDupeKey()))
+		if (historyInfo == nameDupe)
 		{
 			skip = true;
-			good = true;
-			dupeName = historyInfo->GetNzbInfo()->GetName();
-			break;
-		}
-
-		if (historyInfo->GetKind() == HistoryInfo::hkDup &&
-			historyInfo->GetDupInfo()->GetDupeMode() != dmForce &&
-			(historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood ||
-			 (nzbInfo->GetDupeMode() == dmScore &&
-			  historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsSuccess &&
-			  nzbInfo->GetDupeScore() <= historyInfo->GetDupInfo()->GetDupeScore())) &&
-			SameNameOrKey(historyInfo->GetDupInfo()->GetName(), historyInfo->GetDupInfo()->GetDupeKey(),
-				nzbInfo->GetName(), nzbInfo->GetDupeKey()))
-		{
-			skip = true;
-			good = historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood;
-			dupeName = historyInfo->GetDupInfo()->GetName();
+			good = nameGood;
+			dupeName = historyInfo->GetName();
 			break;
 		}
 	}
@@ -211,13 +388,11 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 	if (!sameContent && !good && nzbInfo->GetDupeMode() == dmScore)
 	{
 		// nzb-files having success-duplicates in recent history (with different content) are added to history for backup
-		for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+		for (HistoryInfo* historyInfo : FindHistoryDupes(downloadQueue, nzbInfo->GetName(), nzbInfo->GetDupeKey()))
 		{
 			if ((historyInfo->GetKind() == HistoryInfo::hkNzb ||
 				 historyInfo->GetKind() == HistoryInfo::hkUrl) &&
 				historyInfo->GetNzbInfo()->GetDupeMode() != dmForce &&
-				SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(),
-					nzbInfo->GetName(), nzbInfo->GetDupeKey()) &&
 				nzbInfo->GetDupeScore() <= historyInfo->GetNzbInfo()->GetDupeScore() &&
 				historyInfo->GetNzbInfo()->IsDupeSuccess())
 			{
@@ -264,18 +439,15 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 	// only one item remains in queue and another one is moved to history as dupe-backup
 	if (nzbInfo->GetDupeMode() == dmScore)
 	{
-		// find duplicates in download queue
-		int index = 0;
-		for (NzbList::iterator it = downloadQueue->GetQueue()->begin(); it != downloadQueue->GetQueue()->end(); index++)
+		// find duplicates in download queue;
+		// the list of candidates is collected in advance because the queue is modified in the loop
+		for (NzbInfo* queuedNzbInfo : FindQueueDupes(downloadQueue, nzbInfo->GetName(), nzbInfo->GetDupeKey()))
 		{
-			NzbInfo* queuedNzbInfo = (*it++).get();
 			if (queuedNzbInfo != nzbInfo &&
 				queuedNzbInfo->GetDeleteStatus() == NzbInfo::dsNone &&
 				(queuedNzbInfo->GetKind() == NzbInfo::nkNzb ||
 				 (queuedNzbInfo->GetKind() == NzbInfo::nkUrl && nzbInfo->GetKind() == NzbInfo::nkUrl)) &&
-				queuedNzbInfo->GetDupeMode() != dmForce &&
-				SameNameOrKey(queuedNzbInfo->GetName(), queuedNzbInfo->GetDupeKey(),
-					nzbInfo->GetName(), nzbInfo->GetDupeKey()))
+				queuedNzbInfo->GetDupeMode() != dmForce)
 			{
 				// if queue has a duplicate with the same or higher score - the new item
 				// is moved to history as dupe-backup
@@ -295,13 +467,8 @@ void DupeCoordinator::NzbFound(DownloadQueue* downloadQueue, NzbInfo* nzbInfo)
 					// the existing queue item is moved to history as dupe-backup
 					info("Moving collection %s with lower duplicate score to history", queuedNzbInfo->GetName());
 					queuedNzbInfo->SetDeleteStatus(NzbInfo::dsDupe);
-					int oldSize = downloadQueue->GetQueue()->size();
 					downloadQueue->EditEntry(queuedNzbInfo->GetId(),
 						DownloadQueue::eaGroupDelete, nullptr);
-					int newSize = downloadQueue->GetQueue()->size();
-					index += oldSize == newSize ? 1 : 0;
-					it = downloadQueue->GetQueue()->begin() + index;
-					index--;
 				}
 			}
 		}
@@ -331,14 +498,14 @@ void DupeCoordinator::ReturnBestDupe(DownloadQueue* downloadQueue, NzbInfo* nzbI
 	// check if history (recent or dup) has other success-duplicates or good-duplicates
 	bool dupeFound = false;
 	int historyScore = 0;
-	for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+	std::vector<HistoryInfo*> historyDupes = FindHistoryDupes(downloadQueue, nzbName, dupeKey);
+	for (HistoryInfo* historyInfo : historyDupes)
 	{
 		bool goodDupe = false;
 
 		if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
 			historyInfo->GetNzbInfo()->GetDupeMode() != dmForce &&
-			historyInfo->GetNzbInfo()->IsDupeSuccess() &&
-			SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(), nzbName, dupeKey))
+			historyInfo->GetNzbInfo()->IsDupeSuccess())
 		{
 			if (!dupeFound || historyInfo->GetNzbInfo()->GetDupeScore() > historyScore)
 			{
@@ -351,8 +518,7 @@ void DupeCoordinator::ReturnBestDupe(DownloadQueue* downloadQueue, NzbInfo* nzbI
 		if (historyInfo->GetKind() == HistoryInfo::hkDup &&
 			historyInfo->GetDupInfo()->GetDupeMode() != dmForce &&
 			(historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsSuccess ||
-			 historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood) &&
-			SameNameOrKey(historyInfo->GetDupInfo()->GetName(), historyInfo->GetDupInfo()->GetDupeKey(), nzbName, dupeKey))
+			 historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood))
 		{
 			if (!dupeFound || historyInfo->GetDupInfo()->GetDupeScore() > historyScore)
 			{
@@ -372,12 +538,11 @@ void DupeCoordinator::ReturnBestDupe(DownloadQueue* downloadQueue, NzbInfo* nzbI
 	// check if duplicates exist in download queue
 	bool queueDupe = false;
 	int queueScore = 0;
-	for (NzbInfo* queuedNzbInfo : downloadQueue->GetQueue())
+	for (NzbInfo* queuedNzbInfo : FindQueueDupes(downloadQueue, nzbName, dupeKey))
 	{
 		if (queuedNzbInfo != nzbInfo &&
 			queuedNzbInfo->GetKind() == NzbInfo::nkNzb &&
 			queuedNzbInfo->GetDupeMode() != dmForce &&
-			SameNameOrKey(queuedNzbInfo->GetName(), queuedNzbInfo->GetDupeKey(), nzbName, dupeKey) &&
 			(!queueDupe || queuedNzbInfo->GetDupeScore() > queueScore))
 		{
 			queueScore = queuedNzbInfo->GetDupeScore();
@@ -388,7 +553,7 @@ void DupeCoordinator::ReturnBestDupe(DownloadQueue* downloadQueue, NzbInfo* nzbI
 	// find dupe-backup with highest score, whose score is also higher than other
 	// success-duplicates and higher than already queued items
 	HistoryInfo* historyDupe = nullptr;
-	for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+	for (HistoryInfo* historyInfo : historyDupes)
 	{
 		if ((historyInfo->GetKind() == HistoryInfo::hkNzb ||
 			 historyInfo->GetKind() == HistoryInfo::hkUrl) &&
@@ -398,8 +563,7 @@ void DupeCoordinator::ReturnBestDupe(DownloadQueue* downloadQueue, NzbInfo* nzbI
 			historyInfo->GetNzbInfo()->GetMarkStatus() != NzbInfo::ksBad &&
 			(!dupeFound || historyInfo->GetNzbInfo()->GetDupeScore() > historyScore) &&
 			(!queueDupe || historyInfo->GetNzbInfo()->GetDupeScore() > queueScore) &&
-			(!historyDupe || historyInfo->GetNzbInfo()->GetDupeScore() > historyDupe->GetNzbInfo()->GetDupeScore()) &&
-			SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(), nzbName, dupeKey))
+			(!historyDupe || historyInfo->GetNzbInfo()->GetDupeScore() > historyDupe->GetNzbInfo()->GetDupeScore()))
 		{
 			historyDupe = historyInfo;
 		}
@@ -472,31 +636,30 @@ void DupeCoordinator::HistoryCleanup(DownloadQueue* downloadQueue, HistoryInfo*
 		markHistoryInfo->GetKind() == HistoryInfo::hkDup ? markHistoryInfo->GetDupInfo()->GetName() :
 		nullptr;
 	bool changed = false;
-	int index = 0;
+
+	// history items are replaced in place, positions of other items remain valid
+	UpdateIndex(downloadQueue);
+	HistoryList* history = downloadQueue->GetHistory();
+	DupeIndex::PositionList positions = m_historyIndex.Find(nzbName, dupeKey);
 
 	// traversing in a reverse order to delete items in order they were added to history
 	// (just to produce the log-messages in a more logical order)
-	for (HistoryList::reverse_iterator it = downloadQueue->GetHistory()->rbegin(); it != downloadQueue->GetHistory()->rend(); )
+	for (DupeIndex::PositionList::reverse_iterator it = positions.rbegin(); it != positions.rend(); it++)
 	{
-		HistoryInfo* historyInfo = (*it).get();
+		int position = *it;
+		HistoryInfo* historyInfo = position < (int)history->size() ? (*history)[position].get() : nullptr;
 
-		if ((historyInfo->GetKind() == HistoryInfo::hkNzb ||
+		if (historyInfo &&
+			(historyInfo->GetKind() == HistoryInfo::hkNzb ||
 			 historyInfo->GetKind() == HistoryInfo::hkUrl) &&
 			historyInfo->GetNzbInfo()->GetDupeMode() != dmForce &&
 			historyInfo->GetNzbInfo()->GetDeleteStatus() == NzbInfo::dsDupe &&
 			historyInfo != markHistoryInfo &&
 			SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(), nzbName, dupeKey))
 		{
-			g_HistoryCoordinator->HistoryHide(downloadQueue, historyInfo, index);
-			index++;
-			it = downloadQueue->GetHistory()->rbegin() + index;
+			g_HistoryCoordinator->HistoryHide(downloadQueue, historyInfo, (int)history->size() - 1 - position);
 			changed = true;
 		}
-		else
-		{
-			it++;
-			index++;
-		}
 	}
 
 	if (changed)
@@ -512,26 +675,22 @@ DupeCoordinator::EDupeStatus DupeCoordinator::GetDupeStatus(DownloadQueue* downl
 	EDupeStatus statuses = dsNone;
 
 	// find duplicates in download queue
-	for (NzbInfo* nzbInfo : downloadQueue->GetQueue())
+	for (NzbInfo* nzbInfo : FindQueueDupes(downloadQueue, name, dupeKey))
 	{
-		if (SameNameOrKey(name, dupeKey, nzbInfo->GetName(), nzbInfo->GetDupeKey()))
+		if (nzbInfo->GetSuccessArticles() + nzbInfo->GetFailedArticles() > 0)
 		{
-			if (nzbInfo->GetSuccessArticles() + nzbInfo->GetFailedArticles() > 0)
-			{
-				statuses = (EDupeStatus)(statuses | dsDownloading);
-			}
-			else
-			{
-				statuses = (EDupeStatus)(statuses | dsQueued);
-			}
+			statuses = (EDupeStatus)(statuses | dsDownloading);
+		}
+		else
+		{
+			statuses = (EDupeStatus)(statuses | dsQueued);
 		}
 	}
 
 	// find duplicates in history
-	for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+	for (HistoryInfo* historyInfo : FindHistoryDupes(downloadQueue, name, dupeKey))
 	{
-		if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
-			SameNameOrKey(name, dupeKey, historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey()))
+		if (historyInfo->GetKind() == HistoryInfo::hkNzb)
 		{
 			const char* textStatus = historyInfo->GetNzbInfo()->MakeTextStatus(true);
 			if (!strncasecmp(textStatus, "SUCCESS", 7))
@@ -548,8 +707,7 @@ DupeCoordinator::EDupeStatus DupeCoordinator::GetDupeStatus(DownloadQueue* downl
 			}
 		}
 
-		if (historyInfo->GetKind() == HistoryInfo::hkDup &&
-			SameNameOrKey(name, dupeKey, historyInfo->GetDupInfo()->GetName(), historyInfo->GetDupInfo()->GetDupeKey()))
+		if (historyInfo->GetKind() == HistoryInfo::hkDup)
 		{
 			if (historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsSuccess ||
 				historyInfo->GetDupInfo()->GetStatus() == DupInfo::dsGood)
@@ -577,12 +735,10 @@ RawNzbList DupeCoordinator::ListHistoryDupes(DownloadQueue* downloadQueue, NzbIn
 	}
 
 	// find duplicates in history
-	for (HistoryInfo* historyInfo : downloadQueue->GetHistory())
+	for (HistoryInfo* historyInfo : FindHistoryDupes(downloadQueue, nzbInfo->GetName(), nzbInfo->GetDupeKey()))
 	{
 		if (historyInfo->GetKind() == HistoryInfo::hkNzb &&
-			historyInfo->GetNzbInfo()->GetDupeMode() != dmForce &&
-			SameNameOrKey(historyInfo->GetNzbInfo()->GetName(), historyInfo->GetNzbInfo()->GetDupeKey(),
-				nzbInfo->GetName(), nzbInfo->GetDupeKey()))
+			historyInfo->GetNzbInfo()->GetDupeMode() != dmForce)
 		{
 			dupeList.push_back(historyInfo->GetNzbInfo());
 		}
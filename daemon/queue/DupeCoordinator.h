@@ -42,10 +42,42 @@ public:
 	EDupeStatus GetDupeStatus(DownloadQueue* downloadQueue, const char* name, const char* dupeKey);
 	RawNzbList ListHistoryDupes(DownloadQueue* downloadQueue, NzbInfo* nzbInfo);
 
+	/*
+	 * Hash index from normalized (lower case) name and dupe key to positions of
+	 * entries in a list. Positions are returned in ascending order, so lookups
+	 * visit matching entries in the same order as a full scan of the list would.
+	 */
+	class DupeIndex
+	{
+	public:
+		typedef std::vector<int> PositionList;
+
+		void Clear();
+		void Add(int position, const char* name, const char* dupeKey);
+		PositionList Find(const char* name, const char* dupeKey);
+
+	private:
+		typedef std::unordered_map<std::string, PositionList> IndexMap;
+
+		IndexMap m_names;
+		IndexMap m_keylessNames;
+		IndexMap m_keys;
+
+		static std::string Normalize(const char* str);
+		static const PositionList* FindKey(IndexMap& map, const char* str);
+	};
+
 private:
+	DupeIndex m_queueIndex;
+	DupeIndex m_historyIndex;
+	int m_indexRevision = -1;
+
 	void ReturnBestDupe(DownloadQueue* downloadQueue, NzbInfo* nzbInfo, const char* nzbName, const char* dupeKey);
 	void HistoryCleanup(DownloadQueue* downloadQueue, HistoryInfo* markHistoryInfo);
 	bool SameNameOrKey(const char* name1, const char* dupeKey1, const char* name2, const char* dupeKey2);
+	void UpdateIndex(DownloadQueue* downloadQueue);
+	RawNzbList FindQueueDupes(DownloadQueue* downloadQueue, const char* name, const char* dupeKey);
+	std::vector<HistoryInfo*> FindHistoryDupes(DownloadQueue* downloadQueue, const char* name, const char* dupeKey);
 };
 
 extern DupeCoordinator* g_DupeCoordinator;
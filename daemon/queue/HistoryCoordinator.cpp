@@ -231,7 +231,7 @@ void HistoryCoordinator::PrepareEdit(DownloadQueue* downloadQueue, IdList* idLis
 	{
 		for (int id : *idList)
 		{
-			HistoryInfo* historyInfo = downloadQueue->GetHistory()->Find(id);
+			HistoryInfo* historyInfo = downloadQueue->FindHistory(id);
 			if (historyInfo && historyInfo->GetKind() == HistoryInfo::hkNzb)
 			{
 				historyInfo->GetNzbInfo()->SetMarkStatus(NzbInfo::ksBad);
@@ -248,74 +248,74 @@ bool HistoryCoordinator::EditList(DownloadQueue* downloadQueue, IdList* idList,
 
 	for (int id : *idList)
 	{
-		for (HistoryList::iterator itHistory = downloadQueue->GetHistory()->begin(); itHistory != downloadQueue->GetHistory()->end(); itHistory++)
+		int pos = downloadQueue->FindHistoryPosition(id);
+		if (pos < 0)
 		{
-			HistoryInfo* historyInfo = (*itHistory).get();
-			if (historyInfo->GetId() == id)
-			{
-				ok = true;
+			continue;
+		}
 
-				switch (action)
-				{
-					case DownloadQueue::eaHistoryDelete:
-					case DownloadQueue::eaHistoryFinalDelete:
-						HistoryDelete(downloadQueue, itHistory, historyInfo, action == DownloadQueue::eaHistoryFinalDelete);
-						break;
-
-					case DownloadQueue::eaHistoryReturn:
-						HistoryReturn(downloadQueue, itHistory, historyInfo);
-						break;
-
-					case DownloadQueue::eaHistoryProcess:
-						HistoryProcess(downloadQueue, itHistory, historyInfo);
-						break;
-
-					case DownloadQueue::eaHistoryRedownload:
-						HistoryRedownload(downloadQueue, itHistory, historyInfo, false);
-						break;
-
-					case DownloadQueue::eaHistoryRetryFailed:
-						HistoryRetry(downloadQueue, itHistory, historyInfo, true, false);
-						break;
-
-					case DownloadQueue::eaHistorySetParameter:
-						ok = HistorySetParameter(historyInfo, args);
-						break;
-
- 					case DownloadQueue::eaHistorySetCategory:
-						ok = HistorySetCategory(historyInfo, args);
-						break;
-
- 					case DownloadQueue::eaHistorySetName:
-						ok = HistorySetName(historyInfo, args);
-						break;
-
-					case DownloadQueue::eaHistorySetDupeKey:
-					case DownloadQueue::eaHistorySetDupeScore:
-					case DownloadQueue::eaHistorySetDupeMode:
-					case DownloadQueue::eaHistorySetDupeBackup:
-						HistorySetDupeParam(historyInfo, action, args);
-						break;
-
-					case DownloadQueue::eaHistoryMarkBad:
-						g_DupeCoordinator->HistoryMark(downloadQueue, historyInfo, NzbInfo::ksBad);
-						break;
-
-					case DownloadQueue::eaHistoryMarkGood:
-						g_DupeCoordinator->HistoryMark(downloadQueue, historyInfo, NzbInfo::ksGood);
-						break;
-
-					case DownloadQueue::eaHistoryMarkSuccess:
-						g_DupeCoordinator->HistoryMark(downloadQueue, historyInfo, NzbInfo::ksSuccess);
-						break;
-
-					default:
-						// nothing, just to avoid compiler warning
-						break;
-				}
+		HistoryList::iterator itHistory = downloadQueue->GetHistory()->begin() + pos;
+		HistoryInfo* historyInfo = itHistory->get();
+
+		ok = true;
 
+		switch (action)
+		{
+			case DownloadQueue::eaHistoryDelete:
+			case DownloadQueue::eaHistoryFinalDelete:
+				HistoryDelete(downloadQueue, itHistory, historyInfo, action == DownloadQueue::eaHistoryFinalDelete);
+				break;
+
+			case DownloadQueue::eaHistoryReturn:
+				HistoryReturn(downloadQueue, itHistory, historyInfo);
+				break;
+
+			case DownloadQueue::eaHistoryProcess:
+				HistoryProcess(downloadQueue, itHistory, historyInfo);
+				break;
+
+			case DownloadQueue::eaHistoryRedownload:
+				HistoryRedownload(downloadQueue, itHistory, historyInfo, false);
+				break;
+
+			case DownloadQueue::eaHistoryRetryFailed:
+				HistoryRetry(downloadQueue, itHistory, historyInfo, true, false);
+				break;
+
+			case DownloadQueue::eaHistorySetParameter:
+				ok = HistorySetParameter(historyInfo, args);
+				break;
+
+			case DownloadQueue::eaHistorySetCategory:
+				ok = HistorySetCategory(historyInfo, args);
+				break;
+
+			case DownloadQueue::eaHistorySetName:
+				ok = HistorySetName(historyInfo, args);
+				break;
+
+			case DownloadQueue::eaHistorySetDupeKey:
+			case DownloadQueue::eaHistorySetDupeScore:
+			case DownloadQueue::eaHistorySetDupeMode:
+			case DownloadQueue::eaHistorySetDupeBackup:
+				HistorySetDupeParam(historyInfo, action, args);
+				break;
+
+			case DownloadQueue::eaHistoryMarkBad:
+				g_DupeCoordinator->HistoryMark(downloadQueue, historyInfo, NzbInfo::ksBad);
+				break;
+
+			case DownloadQueue::eaHistoryMarkGood:
+				g_DupeCoordinator->HistoryMark(downloadQueue, historyInfo, NzbInfo::ksGood);
+				break;
+
+			case DownloadQueue::eaHistoryMarkSuccess:
+				g_DupeCoordinator->HistoryMark(downloadQueue, historyInfo, NzbInfo::ksSuccess);
+				break;
+
+			default:
+				// nothing, just to avoid compiler warning
 				break;
-			}
 		}
 	}
 
@@ -356,6 +356,7 @@ void HistoryCoordinator::HistoryDelete(DownloadQueue* downloadQueue, HistoryList
 	if (final || !g_Options->GetDupeCheck() || historyInfo->GetKind() == HistoryInfo::hkUrl)
 	{
 		downloadQueue->GetHistory()->erase(itHistory);
+		downloadQueue->Changed();
 	}
 	else
 	{
@@ -416,6 +417,7 @@ void HistoryCoordinator::MoveToQueue(DownloadQueue* downloadQueue, HistoryList::
 	nzbInfo->SetFinalDir("");
 
 	downloadQueue->GetHistory()->erase(itHistory);
+	downloadQueue->Changed();
 	// the object "pHistoryInfo" is released few lines later, after the call to "NZBDownloaded"
 	nzbInfo->PrintMessage(Message::mkInfo, "%s returned from history back to download queue", *nicename);
 
@@ -441,6 +443,7 @@ void HistoryCoordinator::HistoryRedownload(DownloadQueue* downloadQueue, History
 		nzbInfo->SetDupeHint(nzbInfo->GetDupeHint() == NzbInfo::dhNone ? NzbInfo::dhRedownloadManual : nzbInfo->GetDupeHint());
 		downloadQueue->GetQueue()->Add(std::unique_ptr<NzbInfo>(nzbInfo), true);
 		downloadQueue->GetHistory()->erase(itHistory);
+		downloadQueue->Changed();
 
 		DownloadQueue::Aspect aspect = {DownloadQueue::eaUrlReturned, downloadQueue, nzbInfo, nullptr};
 		downloadQueue->Notify(&aspect);
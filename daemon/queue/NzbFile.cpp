@@ -44,66 +44,14 @@ void NzbFile::LogDebugInfo()
 	info(" NZBFile %s", *m_fileName);
 }
 
-void NzbFile::AddArticle(FileInfo* fileInfo, std::unique_ptr<ArticleInfo> articleInfo)
+void NzbFile::AddFileInfo(std::unique_ptr<FileInfo> fileInfo, int64 size, int64 missedSize,
+	int totalArticles, int missedArticles)
 {
-	int index = articleInfo->GetPartNumber() - 1;
-
-	// make Article-List big enough
-	if (index >= (int)fileInfo->GetArticles()->size())
-	{
-		fileInfo->GetArticles()->resize(index + 1);
-	}
-
-	(*fileInfo->GetArticles())[index] = std::move(articleInfo);
-}
-
-void NzbFile::AddFileInfo(std::unique_ptr<FileInfo> fileInfo)
-{
-	// calculate file size and delete empty articles
-
-	int64 size = 0;
-	int64 missedSize = 0;
-	int64 oneSize = 0;
-	int uncountedArticles = 0;
-	int missedArticles = 0;
-	int totalArticles = (int)fileInfo->GetArticles()->size();
-	int i = 0;
-	for (ArticleList::iterator it = fileInfo->GetArticles()->begin(); it != fileInfo->GetArticles()->end(); )
-	{
-		ArticleInfo* article = (*it).get();
-		if (!article)
-		{
-			fileInfo->GetArticles()->erase(it);
-			it = fileInfo->GetArticles()->begin() + i;
-			missedArticles++;
-			if (oneSize > 0)
-			{
-				missedSize += oneSize;
-			}
-			else
-			{
-				uncountedArticles++;
-			}
-		}
-		else
-		{
-			size += article->GetSize();
-			if (oneSize == 0)
-			{
-				oneSize = article->GetSize();
-			}
-			it++;
-			i++;
-		}
-	}
-
 	if (fileInfo->GetArticles()->empty())
 	{
 		return;
 	}
 
-	missedSize += uncountedArticles * oneSize;
-	size += missedSize;
 	fileInfo->SetNzbInfo(m_nzbInfo.get());
 	fileInfo->SetSize(size);
 	fileInfo->SetRemainingSize(size - missedSize);
@@ -433,237 +381,1115 @@ void NzbFile::ReadPassword()
 	}
 }
 
-#ifdef WIN32
 bool NzbFile::Parse()
 {
-	CoInitialize(nullptr);
-
-	HRESULT hr;
+	if (m_xmlParser || !ParseStream())
+	{
+		// the file uses XML features the streaming parser doesn't handle or is not
+		// well-formed; the XML parser takes care of such files and reports errors
+		debug("Parsing %s with XML parser", *m_fileName);
+		ResetNzbInfo();
+		if (!ParseXml())
+		{
+			return false;
+		}
+	}
 
-	MSXML::IXMLDOMDocumentPtr doc;
-	hr = doc.CreateInstance(MSXML::CLSID_DOMDocument);
-	if (FAILED(hr))
+	if (m_nzbInfo->GetFileList()->empty())
 	{
+		m_nzbInfo->AddMessage(Message::mkError, BString<1024>(
+			"Error parsing nzb-file %s: file has no content", FileSystem::BaseFileName(m_fileName)));
 		return false;
 	}
 
-	// Load the XML document file...
-	doc->put_resolveExternals(VARIANT_FALSE);
-	doc->put_validateOnParse(VARIANT_FALSE);
-	doc->put_async(VARIANT_FALSE);
+	ProcessFiles();
 
-	_variant_t vFilename(*WString(*m_fileName));
+	return true;
+}
 
-	// 1. first trying to load via filename without URL-encoding (certain charaters doesn't work when encoded)
-	VARIANT_BOOL success = doc->load(vFilename);
-	if (success == VARIANT_FALSE)
-	{
-		// 2. now trying filename encoded as URL
-		char url[2048];
-		EncodeUrl(m_fileName, url, 2048);
-		debug("url=\"%s\"", url);
-		_variant_t vUrl(url);
+void NzbFile::ResetNzbInfo()
+{
+	CString category = m_nzbInfo->GetCategory();
+	m_nzbInfo = std::make_unique<NzbInfo>();
+	m_nzbInfo->SetFilename(m_fileName);
+	m_nzbInfo->SetCategory(category);
+	m_nzbInfo->BuildDestDirName();
+	m_fileInfo.reset();
+	m_segmentPending = false;
+	m_password = nullptr;
+	m_hasPassword = false;
+}
 
-		success = doc->load(vUrl);
-	}
+/*
+ * Streaming nzb parser.
+ *
+ * Tokenizes the memory mapped file in one pass without building a DOM or
+ * calling back per text chunk. Segments of the current file are collected as
+ * plain records with message-ids interned into one string arena; sorting and
+ * removal of duplicate segments happen once per file when the file element ends.
+ *
+ * The parser handles the subset of XML used by nzb-files. The results are the
+ * same as from the SAX-handlers of the XML parser: entities are decoded,
+ * attribute values are normalized and text content is trimmed per chunk.
+ * For anything else (DTD internal subset, CDATA, unknown entities, encodings
+ * other than UTF-8, malformed documents) ParseStream returns "false" and the
+ * file is parsed with the XML parser instead.
+ */
 
-	if (success == VARIANT_FALSE)
+enum ECharClass
+{
+	ccBlank = 1,
+	ccNameStart = 2,
+	ccName = 4,
+	ccAttrSpecial = 8, // characters needing special handling in attribute values
+	ccValidate = 16 // control and non-ASCII characters
+};
+
+class CharClassTable
+{
+public:
+	CharClassTable()
 	{
-		_bstr_t r(doc->GetparseError()->reason);
-		const char* errMsg = r;
-		m_nzbInfo->AddMessage(Message::mkError, BString<1024>("Error parsing nzb-file %s: %s",
-			FileSystem::BaseFileName(m_fileName), errMsg));
-		return false;
+		for (int ch = 0; ch < 256; ch++)
+		{
+			bool nameStart = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_' ||
+				ch == ':' || ch >= 0x80;
+			m_classes[ch] =
+				(ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' ? ccBlank : 0) |
+				(nameStart ? ccNameStart | ccName : 0) |
+				((ch >= '0' && ch <= '9') || ch == '.' || ch == '-' ? ccName : 0) |
+				(ch == '&' || ch == '<' || ch == '\n' || ch == '\r' || ch == '\t' ? ccAttrSpecial : 0) |
+				((ch < 0x20 && ch != '\n' && ch != '\r' && ch != '\t') || ch >= 0x80 ? ccValidate : 0);
+		}
 	}
 
-	if (!ParseNzb(doc))
-	{
-		return false;
-	}
+	bool Is(char ch, int charClass) const { return m_classes[(uchar)ch] & charClass; }
 
-	if (m_nzbInfo->GetFileList()->empty())
+private:
+	uint8 m_classes[256];
+};
+
+static const CharClassTable CharClasses;
+
+static bool IsBlank(char ch)
+{
+	return CharClasses.Is(ch, ccBlank);
+}
+
+static bool IsNameChar(char ch, bool first)
+{
+	return CharClasses.Is(ch, first ? ccNameStart : ccName);
+}
+
+static bool ReadName(const char*& p, const char* end)
+{
+	if (p >= end || !IsNameChar(*p, true))
 	{
-		m_nzbInfo->AddMessage(Message::mkError, BString<1024>(
-			"Error parsing nzb-file %s: file has no content", FileSystem::BaseFileName(m_fileName)));
 		return false;
 	}
-
-	ProcessFiles();
-
+	for (p++; p < end && IsNameChar(*p, false); p++) ;
 	return true;
 }
 
-void NzbFile::EncodeUrl(const char* filename, char* url, int bufLen)
+static bool SameName(const char* name, int len, const char* str)
 {
-	WString widefilename(filename);
+	return !strncmp(name, str, len) && str[len] == '\0';
+}
 
-	char* end = url + bufLen;
-	for (wchar_t* p = widefilename; *p && url < end - 3; p++)
+static const char* FindStr(const char* p, const char* end, const char* str)
+{
+	int len = strlen(str);
+	while (end - p >= len)
 	{
-		wchar_t ch = *p;
-		if (('0' <= ch && ch <= '9') ||
-			('a' <= ch && ch <= 'z') ||
-			('A' <= ch && ch <= 'Z') ||
-			ch == '-' || ch == '.' || ch == '_' || ch == '~')
+		p = (const char*)memchr(p, *str, end - p - len + 1);
+		if (!p)
 		{
-			*url++ = (char)ch;
+			return nullptr;
 		}
-		else
+		if (!strncmp(p, str, len))
 		{
-			*url++ = '%';
-			uint32 a = (uint32)ch >> 4;
-			*url++ = a > 9 ? a - 10 + 'A' : a + '0';
-			a = ch & 0xF;
-			*url++ = a > 9 ? a - 10 + 'A' : a + '0';
+			return p;
 		}
+		p++;
 	}
-	*url = '\0';
+	return nullptr;
 }
 
-bool NzbFile::ParseNzb(IUnknown* nzb)
+static bool ValidXmlChar(uint32 ch)
 {
-	MSXML::IXMLDOMDocumentPtr doc = nzb;
-	MSXML::IXMLDOMNodePtr root = doc->documentElement;
-
-	MSXML::IXMLDOMNodePtr node = root->selectSingleNode("/nzb/head/meta[@type='password']");
-	if (node)
-	{
-		_bstr_t password(node->Gettext());
-		m_password = password;
-	}
+	return ch == 0x9 || ch == 0xA || ch == 0xD || (ch >= 0x20 && ch <= 0xD7FF) ||
+		(ch >= 0xE000 && ch <= 0xFFFD) || (ch >= 0x10000 && ch <= 0x10FFFF);
+}
 
-	MSXML::IXMLDOMNodeListPtr fileList = root->selectNodes("/nzb/file");
-	for (int i = 0; i < fileList->Getlength(); i++)
+/**
+ * Checks that the buffer is valid UTF-8 and contains only characters allowed in XML.
+ */
+static bool ValidXmlText(const char* p, const char* end)
+{
+	while (p < end)
 	{
-		node = fileList->Getitem(i);
-		MSXML::IXMLDOMNodePtr attribute = node->Getattributes()->getNamedItem("subject");
-		if (!attribute) return false;
-		_bstr_t subject(attribute->Gettext());
-
-		std::unique_ptr<FileInfo> fileInfo = std::make_unique<FileInfo>();
-		fileInfo->SetSubject(subject);
-
-		attribute = node->Getattributes()->getNamedItem("date");
-		if (attribute)
+		// fast path for printable ASCII
+		while (p < end && !CharClasses.Is(*p, ccValidate)) p++;
+		if (p >= end)
 		{
-			_bstr_t date(attribute->Gettext());
-			fileInfo->SetTime(atoi(date));
+			break;
 		}
 
-		MSXML::IXMLDOMNodeListPtr groupList = node->selectNodes("groups/group");
-		for (int g = 0; g < groupList->Getlength(); g++)
+		uchar ch = *p;
+		if (ch < 0x80)
 		{
-			MSXML::IXMLDOMNodePtr node = groupList->Getitem(g);
-			_bstr_t group = node->Gettext();
-			fileInfo->GetGroups()->push_back((const char*)group);
+			return false;
 		}
 
-		MSXML::IXMLDOMNodeListPtr segmentList = node->selectNodes("segments/segment");
-		for (int g = 0; g < segmentList->Getlength(); g++)
+		int len;
+		uint32 code;
+		if ((ch & 0xE0) == 0xC0)
 		{
-			MSXML::IXMLDOMNodePtr node = segmentList->Getitem(g);
-			_bstr_t bid = node->Gettext();
-			BString<1024> id("<%s>", (const char*)bid);
-
-			MSXML::IXMLDOMNodePtr attribute = node->Getattributes()->getNamedItem("number");
-			if (!attribute) return false;
-			_bstr_t number(attribute->Gettext());
-
-			attribute = node->Getattributes()->getNamedItem("bytes");
-			if (!attribute) return false;
-			_bstr_t bytes(attribute->Gettext());
+			len = 2;
+			code = ch & 0x1F;
+		}
+		else if ((ch & 0xF0) == 0xE0)
+		{
+			len = 3;
+			code = ch & 0x0F;
+		}
+		else if ((ch & 0xF8) == 0xF0)
+		{
+			len = 4;
+			code = ch & 0x07;
+		}
+		else
+		{
+			return false;
+		}
 
-			int partNumber = atoi(number);
-			int lsize = atoi(bytes);
+		if (end - p < len)
+		{
+			return false;
+		}
 
-			if (partNumber > 0)
+		for (int i = 1; i < len; i++)
+		{
+			if ((p[i] & 0xC0) != 0x80)
 			{
-				std::unique_ptr<ArticleInfo> article = std::make_unique<ArticleInfo>();
-				article->SetPartNumber(partNumber);
-				article->SetMessageId(id);
-				article->SetSize(lsize);
-				AddArticle(fileInfo.get(), std::move(article));
+				return false;
 			}
+			code = (code << 6) | (p[i] & 0x3F);
+		}
+
+		if ((len == 2 && code < 0x80) || (len == 3 && code < 0x800) || (len == 4 && code < 0x10000) ||
+			!ValidXmlChar(code))
+		{
+			return false;
 		}
 
-		AddFileInfo(std::move(fileInfo));
+		p += len;
 	}
+
 	return true;
 }
 
-#else
-
-bool NzbFile::Parse()
+/**
+ * Skips xml-declaration if present; only UTF-8 encoded documents are accepted.
+ */
+static bool SkipXmlDeclaration(const char*& p, const char* end)
 {
-#ifdef DISABLE_LIBXML2
-	error("Could not parse rss feed, program was compiled without libxml2 support");
-	return false;
-#else
-	xmlSAXHandler SAX_handler = {0};
-	SAX_handler.startElement = reinterpret_cast<startElementSAXFunc>(SAX_StartElement);
-	SAX_handler.endElement = reinterpret_cast<endElementSAXFunc>(SAX_EndElement);
-	SAX_handler.characters = reinterpret_cast<charactersSAXFunc>(SAX_characters);
-	SAX_handler.error = reinterpret_cast<errorSAXFunc>(SAX_error);
-	SAX_handler.getEntity = reinterpret_cast<getEntitySAXFunc>(SAX_getEntity);
-
-	m_ignoreNextError = false;
-
-	int ret = xmlSAXUserParseFile(&SAX_handler, this, m_fileName);
-
-	if (ret != 0)
+	if (end - p < 6 || strncmp(p, "<?xml", 5) || !IsBlank(p[5]))
 	{
-		m_nzbInfo->AddMessage(Message::mkError, BString<1024>(
-			"Error parsing nzb-file %s", FileSystem::BaseFileName(m_fileName)));
-		return false;
+		return true;
 	}
 
-	if (m_nzbInfo->GetFileList()->empty())
+	const char* close = FindStr(p, end, "?>");
+	if (!close)
 	{
-		m_nzbInfo->AddMessage(Message::mkError, BString<1024>(
-			"Error parsing nzb-file %s: file has no content", FileSystem::BaseFileName(m_fileName)));
 		return false;
 	}
 
-	ProcessFiles();
+	const char* encoding = FindStr(p, close, "encoding");
+	if (encoding)
+	{
+		encoding += 8;
+		while (encoding < close && (IsBlank(*encoding) || *encoding == '=')) encoding++;
+		if (encoding >= close || (*encoding != '"' && *encoding != '\''))
+		{
+			return false;
+		}
+		const char* value = encoding + 1;
+		const char* valueEnd = (const char*)memchr(value, *encoding, close - value);
+		if (!valueEnd ||
+			!((valueEnd - value == 5 && !strncasecmp(value, "utf-8", 5)) ||
+			  (valueEnd - value == 4 && !strncasecmp(value, "utf8", 4))))
+		{
+			return false;
+		}
+	}
 
+	p = close + 2;
 	return true;
-#endif
 }
 
-void NzbFile::Parse_StartElement(const char *name, const char **atts)
+static const char* SkipDoctype(const char* p, const char* end)
 {
-	BString<1024> tagAttrMessage("Malformed nzb-file, tag <%s> must have attributes", name);
-
-	m_tagContent.Clear();
+	while (p < end)
+	{
+		char ch = *p;
+		if (ch == '"' || ch == '\'')
+		{
+			p = (const char*)memchr(p + 1, ch, end - p - 1);
+			if (!p)
+			{
+				return nullptr;
+			}
+		}
+		else if (ch == '[')
+		{
+			// internal subset may declare entities, leave it to XML parser
+			return nullptr;
+		}
+		else if (ch == '>')
+		{
+			return p + 1;
+		}
+		p++;
+	}
+	return nullptr;
+}
 
-	if (!strcmp("file", name))
+/**
+ * Decodes predefined entity or character reference at "p" into "out" (UTF-8).
+ * Returns the length of decoded text or 0 if the reference is not supported.
+ */
+static int DecodeEntity(const char*& p, const char* end, char* out)
+{
+	const char* name = p + 1;
+	const char* semicolon = (const char*)memchr(name, ';', std::min(end - name, (ptrdiff_t)32));
+	if (!semicolon)
 	{
-		m_fileInfo = std::make_unique<FileInfo>();
-		m_fileInfo->SetFilename(m_fileName);
+		return 0;
+	}
+	int len = (int)(semicolon - name);
+	p = semicolon + 1;
 
-		if (!atts)
+	if (len > 1 && *name == '#')
+	{
+		bool hex = name[1] == 'x';
+		const char* digits = name + (hex ? 2 : 1);
+		if (digits == semicolon)
 		{
-			m_nzbInfo->AddMessage(Message::mkWarning, tagAttrMessage);
-			return;
+			return 0;
 		}
 
-		for (int i = 0; atts[i]; i += 2)
+		uint32 code = 0;
+		for (const char* d = digits; d < semicolon; d++)
 		{
-			const char* attrname = atts[i];
-			const char* attrvalue = atts[i + 1];
-			if (!strcmp("subject", attrname))
-			{
-				m_fileInfo->SetSubject(attrvalue);
-			}
-			if (!strcmp("date", attrname))
+			int digit = *d >= '0' && *d <= '9' ? *d - '0' :
+				hex && *d >= 'a' && *d <= 'f' ? *d - 'a' + 10 :
+				hex && *d >= 'A' && *d <= 'F' ? *d - 'A' + 10 : -1;
+			if (digit < 0 || code > 0x10FFFF)
 			{
-				m_fileInfo->SetTime(atoi(attrvalue));
+				return 0;
 			}
+			code = code * (hex ? 16 : 10) + digit;
 		}
-	}
-	else if (!strcmp("segment", name))
-	{
-		if (!m_fileInfo)
+
+		if (!ValidXmlChar(code))
+		{
+			return 0;
+		}
+
+		if (code < 0x80)
+		{
+			out[0] = (char)code;
+			return 1;
+		}
+		else if (code < 0x800)
+		{
+			out[0] = (char)(0xC0 | (code >> 6));
+			out[1] = (char)(0x80 | (code & 0x3F));
+			return 2;
+		}
+		else if (code < 0x10000)
+		{
+			out[0] = (char)(0xE0 | (code >> 12));
+			out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+			out[2] = (char)(0x80 | (code & 0x3F));
+			return 3;
+		}
+		else
+		{
+			out[0] = (char)(0xF0 | (code >> 18));
+			out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+			out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+			out[3] = (char)(0x80 | (code & 0x3F));
+			return 4;
+		}
+	}
+
+	*out = SameName(name, len, "amp") ? '&' : SameName(name, len, "lt") ? '<' :
+		SameName(name, len, "gt") ? '>' : SameName(name, len, "quot") ? '"' :
+		SameName(name, len, "apos") ? '\'' : '\0';
+
+	return *out ? 1 : 0;
+}
+
+bool NzbFile::ParseStream()
+{
+	// the file is read into memory rather than mapped: a file truncated
+	// by another process while mapped would crash the program with SIGBUS
+	CharBuffer buffer;
+	if (!FileSystem::LoadFileIntoBuffer(m_fileName, buffer, false) || buffer.Size() == 0)
+	{
+		return false;
+	}
+
+	const char* p = buffer;
+	const char* end = p + buffer.Size();
+
+	// UTF-8 byte order mark
+	if (end - p >= 3 && !strncmp(p, "\xEF\xBB\xBF", 3))
+	{
+		p += 3;
+	}
+
+	bool ok = ValidXmlText(p, end) && SkipXmlDeclaration(p, end) && Stream_Document(p, end);
+
+	// free parser buffers, the object may live for a while
+	SegmentRecords().swap(m_segments);
+	std::string().swap(m_idArena);
+	std::string().swap(m_content);
+	std::string().swap(m_attrValues);
+	StreamAttrs().swap(m_attrs);
+
+	return ok;
+}
+
+bool NzbFile::Stream_Document(const char* p, const char* end)
+{
+	TagStack tags;
+	bool hasRoot = false;
+
+	while (p < end)
+	{
+		if (*p != '<')
+		{
+			const char* text = p;
+			p = (const char*)memchr(p, '<', end - p);
+			if (!p)
+			{
+				p = end;
+			}
+
+			if (tags.empty())
+			{
+				// only whitespace is allowed outside of root element
+				for (; text < p; text++)
+				{
+					if (!IsBlank(*text))
+					{
+						return false;
+					}
+				}
+			}
+			else if (!Stream_Text(text, p))
+			{
+				return false;
+			}
+		}
+		else if (end - p < 2)
+		{
+			return false;
+		}
+		else if (p[1] == '/')
+		{
+			if (!Stream_EndTag(p, end, tags))
+			{
+				return false;
+			}
+		}
+		else if (p[1] == '?')
+		{
+			// processing instruction, target names starting with "xml" are reserved
+			const char* close = FindStr(p + 2, end, "?>");
+			const char* target = p + 2;
+			if (!close || !ReadName(target, close) || !strncasecmp(p + 2, "xml", 3))
+			{
+				return false;
+			}
+			p = close + 2;
+		}
+		else if (p[1] != '!')
+		{
+			if (tags.empty() && hasRoot)
+			{
+				return false;
+			}
+			hasRoot = true;
+			if (!Stream_StartTag(p, end, tags))
+			{
+				return false;
+			}
+		}
+		else if (end - p >= 4 && !strncmp(p, "<!--", 4))
+		{
+			const char* close = FindStr(p + 4, end, "--");
+			if (!close || end - close < 3 || close[2] != '>')
+			{
+				return false;
+			}
+			p = close + 3;
+		}
+		else if (end - p >= 9 && !strncmp(p, "<!DOCTYPE", 9))
+		{
+			p = hasRoot ? nullptr : SkipDoctype(p + 9, end);
+			if (!p)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// CDATA-section or other markup
+			return false;
+		}
+	}
+
+	return hasRoot && tags.empty();
+}
+
+bool NzbFile::Stream_StartTag(const char*& p, const char* end, TagStack& tags)
+{
+	p++;
+	const char* name = p;
+	if (!ReadName(p, end))
+	{
+		return false;
+	}
+	int nameLen = (int)(p - name);
+
+	m_attrs.clear();
+	m_attrValues.clear();
+
+	while (true)
+	{
+		const char* blank = p;
+		while (p < end && IsBlank(*p)) p++;
+		if (p >= end)
+		{
+			return false;
+		}
+
+		if (*p == '>')
+		{
+			p++;
+			tags.emplace_back(name, nameLen);
+			return Stream_StartElement(name, nameLen);
+		}
+
+		if (*p == '/')
+		{
+			if (end - p < 2 || p[1] != '>')
+			{
+				return false;
+			}
+			p += 2;
+			return Stream_StartElement(name, nameLen) && Stream_EndElement(name, nameLen);
+		}
+
+		// attributes must be separated by whitespace
+		const char* attrName = p;
+		if (blank == p || !ReadName(p, end))
+		{
+			return false;
+		}
+		int attrLen = (int)(p - attrName);
+
+		for (StreamAttr& attr : m_attrs)
+		{
+			if (attr.m_nameLen == attrLen && !strncmp(attr.m_name, attrName, attrLen))
+			{
+				return false;
+			}
+		}
+
+		while (p < end && IsBlank(*p)) p++;
+		if (p >= end || *p != '=')
+		{
+			return false;
+		}
+		p++;
+		while (p < end && IsBlank(*p)) p++;
+
+		m_attrs.push_back({attrName, attrLen, (int)m_attrValues.size()});
+		if (!Stream_AttrValue(p, end))
+		{
+			return false;
+		}
+	}
+}
+
+bool NzbFile::Stream_EndTag(const char*& p, const char* end, TagStack& tags)
+{
+	p += 2;
+	const char* name = p;
+	if (!ReadName(p, end))
+	{
+		return false;
+	}
+	int nameLen = (int)(p - name);
+
+	while (p < end && IsBlank(*p)) p++;
+	if (p >= end || *p != '>' || tags.empty() ||
+		tags.back().second != nameLen || strncmp(tags.back().first, name, nameLen))
+	{
+		return false;
+	}
+	p++;
+	tags.pop_back();
+
+	return Stream_EndElement(name, nameLen);
+}
+
+bool NzbFile::Stream_AttrValue(const char*& p, const char* end)
+{
+	if (p >= end || (*p != '"' && *p != '\''))
+	{
+		return false;
+	}
+
+	char quote = *p++;
+	char decoded[4];
+
+	while (p < end && *p != quote)
+	{
+		const char* run = p;
+		while (p < end && *p != quote && !CharClasses.Is(*p, ccAttrSpecial)) p++;
+		m_attrValues.append(run, p - run);
+		if (p >= end || *p == quote)
+		{
+			break;
+		}
+
+		char ch = *p;
+		if (ch == '&')
+		{
+			int len = DecodeEntity(p, end, decoded);
+			if (!len)
+			{
+				return false;
+			}
+			m_attrValues.append(decoded, len);
+			continue;
+		}
+		else if (ch == '<')
+		{
+			return false;
+		}
+		else if (ch == '\r' || ch == '\n' || ch == '\t')
+		{
+			// attribute value normalization
+			if (ch == '\r' && p + 1 < end && p[1] == '\n')
+			{
+				p++;
+			}
+			ch = ' ';
+		}
+		m_attrValues.push_back(ch);
+		p++;
+	}
+
+	if (p >= end)
+	{
+		return false;
+	}
+
+	p++;
+	m_attrValues.push_back('\0');
+	return true;
+}
+
+bool NzbFile::Stream_Text(const char* p, const char* end)
+{
+	// sequence "]]>" is not allowed in text
+	for (const char* gt = p; (gt = (const char*)memchr(gt, '>', end - gt)); gt++)
+	{
+		if (gt - p >= 2 && gt[-1] == ']' && gt[-2] == ']')
+		{
+			return false;
+		}
+	}
+
+	// entities are passed as separate chunks, each chunk is trimmed on its own
+	char decoded[4];
+	while (true)
+	{
+		const char* amp = (const char*)memchr(p, '&', end - p);
+		Stream_AppendText(p, (int)((amp ? amp : end) - p));
+		if (!amp)
+		{
+			return true;
+		}
+
+		p = amp;
+		int len = DecodeEntity(p, end, decoded);
+		if (!len)
+		{
+			return false;
+		}
+		Stream_AppendText(decoded, len);
+	}
+}
+
+void NzbFile::Stream_AppendText(const char* text, int len)
+{
+	// like the XML parser pass the text before line break CR-LF as a separate chunk
+	const char* cr = (const char*)memchr(text, '\r', len);
+	if (cr && cr + 1 < text + len && cr[1] == '\n')
+	{
+		Stream_AppendText(text, (int)(cr - text));
+		Stream_AppendText(cr + 1, len - (int)(cr - text) - 1);
+		return;
+	}
+
+	while (len > 0 && IsBlank(*text))
+	{
+		text++;
+		len--;
+	}
+	while (len > 0 && IsBlank(text[len - 1]))
+	{
+		len--;
+	}
+
+	if (!cr)
+	{
+		m_content.append(text, len);
+		return;
+	}
+
+	// line ending normalization
+	for (const char* p = text; p < text + len; p++)
+	{
+		m_content.push_back(*p == '\r' ? '\n' : *p);
+	}
+}
+
+const char* NzbFile::Stream_FindAttr(const char* name)
+{
+	for (StreamAttr& attr : m_attrs)
+	{
+		if (SameName(attr.m_name, attr.m_nameLen, name))
+		{
+			return m_attrValues.c_str() + attr.m_valueOffset;
+		}
+	}
+	return nullptr;
+}
+
+bool NzbFile::Stream_StartElement(const char* name, int len)
+{
+	m_content.clear();
+
+	if (SameName(name, len, "file"))
+	{
+		if (m_fileInfo)
+		{
+			// nested file elements
+			return false;
+		}
+
+		m_fileInfo = std::make_unique<FileInfo>();
+		m_fileInfo->SetFilename(m_fileName);
+		m_segments.clear();
+		m_idArena.clear();
+
+		if (m_attrs.empty())
+		{
+			m_nzbInfo->AddMessage(Message::mkWarning, "Malformed nzb-file, tag <file> must have attributes");
+			return true;
+		}
+
+		const char* subject = Stream_FindAttr("subject");
+		if (subject)
+		{
+			m_fileInfo->SetSubject(subject);
+		}
+
+		const char* date = Stream_FindAttr("date");
+		if (date)
+		{
+			m_fileInfo->SetTime(atoi(date));
+		}
+	}
+	else if (SameName(name, len, "segment"))
+	{
+		if (m_inSegment)
+		{
+			// nested segment elements
+			return false;
+		}
+		m_inSegment = true;
+
+		if (!m_fileInfo)
+		{
+			m_nzbInfo->AddMessage(Message::mkWarning, "Malformed nzb-file, tag <segment> without tag <file>");
+			return true;
+		}
+
+		if (m_attrs.empty())
+		{
+			m_nzbInfo->AddMessage(Message::mkWarning, "Malformed nzb-file, tag <segment> must have attributes");
+			return true;
+		}
+
+		const char* bytes = Stream_FindAttr("bytes");
+		const char* number = Stream_FindAttr("number");
+		int64 lsize = bytes ? atol(bytes) : -1;
+		int partNumber = number ? atol(number) : -1;
+
+		if (partNumber > 0)
+		{
+			m_segments.push_back({partNumber, (int)lsize, -1});
+			m_segmentPending = true;
+		}
+	}
+	else if (SameName(name, len, "meta"))
+	{
+		if (m_attrs.empty())
+		{
+			m_nzbInfo->AddMessage(Message::mkWarning, "Malformed nzb-file, tag <meta> must have attributes");
+			return true;
+		}
+
+		StreamAttr& attr = m_attrs.front();
+		m_hasPassword = SameName(attr.m_name, attr.m_nameLen, "type") &&
+			!strcmp(m_attrValues.c_str() + attr.m_valueOffset, "password");
+	}
+
+	return true;
+}
+
+bool NzbFile::Stream_EndElement(const char* name, int len)
+{
+	if (SameName(name, len, "file"))
+	{
+		AddFileInfo();
+	}
+	else if (SameName(name, len, "group"))
+	{
+		if (m_fileInfo)
+		{
+			m_fileInfo->GetGroups()->emplace_back(m_content.empty() ? nullptr : m_content.c_str());
+		}
+		m_content.clear();
+	}
+	else if (SameName(name, len, "segment"))
+	{
+		m_inSegment = false;
+		if (m_fileInfo && m_segmentPending)
+		{
+			AddSegmentId(m_content.c_str(), (int)m_content.size());
+		}
+		m_segmentPending = false;
+	}
+	else if (SameName(name, len, "meta") && m_hasPassword)
+	{
+		m_password = m_content.c_str();
+	}
+
+	return true;
+}
+
+void NzbFile::AddSegmentId(const char* id, int len)
+{
+	// message-id in angle brackets, limited to the same length as other code paths use
+	int start = (int)m_idArena.size();
+	m_idArena.push_back('<');
+	m_idArena.append(id, len);
+	m_idArena.push_back('>');
+	if ((int)m_idArena.size() - start > 1023)
+	{
+		m_idArena.resize(start + 1023);
+	}
+	m_idArena.push_back('\0');
+	m_segments.back().m_idOffset = start;
+}
+
+void NzbFile::AddFileInfo()
+{
+	// same as placing articles by part number: the last segment wins if numbers repeat
+	std::stable_sort(m_segments.begin(), m_segments.end(),
+		[](const SegmentRecord& first, const SegmentRecord& second)
+		{
+			return first.m_partNumber < second.m_partNumber;
+		});
+
+	int64 size = 0;
+	int64 missedSize = 0;
+	int64 oneSize = 0;
+	int uncountedArticles = 0;
+	int missedArticles = 0;
+	int totalArticles = 0;
+	int uniqueCount = 0;
+
+	for (int i = 0; i < (int)m_segments.size(); i++)
+	{
+		SegmentRecord& segment = m_segments[i];
+		if (i + 1 < (int)m_segments.size() && m_segments[i + 1].m_partNumber == segment.m_partNumber)
+		{
+			segment.m_partNumber = 0;
+			continue;
+		}
+
+		int gap = segment.m_partNumber - totalArticles - 1;
+		missedArticles += gap;
+		if (oneSize > 0)
+		{
+			missedSize += gap * oneSize;
+		}
+		else
+		{
+			uncountedArticles += gap;
+		}
+
+		size += segment.m_size;
+		if (oneSize == 0)
+		{
+			oneSize = segment.m_size;
+		}
+
+		totalArticles = segment.m_partNumber;
+		uniqueCount++;
+	}
+
+	missedSize += uncountedArticles * oneSize;
+	size += missedSize;
+
+	ArticleList* articles = m_fileInfo->GetArticles();
+	articles->reserve(uniqueCount, (int)m_idArena.size());
+	for (SegmentRecord& segment : m_segments)
+	{
+		if (segment.m_partNumber > 0)
+		{
+			articles->Add(segment.m_partNumber, segment.m_size,
+				segment.m_idOffset >= 0 ? m_idArena.c_str() + segment.m_idOffset : nullptr);
+		}
+	}
+
+	m_segments.clear();
+	m_idArena.clear();
+
+	AddFileInfo(std::move(m_fileInfo), size, missedSize, totalArticles, missedArticles);
+}
+
+#ifdef WIN32
+bool NzbFile::ParseXml()
+{
+	CoInitialize(nullptr);
+
+	HRESULT hr;
+
+	MSXML::IXMLDOMDocumentPtr doc;
+	hr = doc.CreateInstance(MSXML::CLSID_DOMDocument);
+	if (FAILED(hr))
+	{
+		return false;
+	}
+
+	// Load the XML document file...
+	doc->put_resolveExternals(VARIANT_FALSE);
+	doc->put_validateOnParse(VARIANT_FALSE);
+	doc->put_async(VARIANT_FALSE);
+
+	_variant_t vFilename(*WString(*m_fileName));
+
+	// 1. first trying to load via filename without URL-encoding (certain charaters doesn't work when encoded)
+	VARIANT_BOOL success = doc->load(vFilename);
+	if (success == VARIANT_FALSE)
+	{
+		// 2. now trying filename encoded as URL
+		char url[2048];
+		EncodeUrl(m_fileName, url, 2048);
+		debug("url=\"%s\"", url);
+		_variant_t vUrl(url);
+
+		success = doc->load(vUrl);
+	}
+
+	if (success == VARIANT_FALSE)
+	{
+		_bstr_t r(doc->GetparseError()->reason);
+		const char* errMsg = r;
+		m_nzbInfo->AddMessage(Message::mkError, BString<1024>("Error parsing nzb-file %s: %s",
+			FileSystem::BaseFileName(m_fileName), errMsg));
+		return false;
+	}
+
+	return ParseNzb(doc);
+}
+
+void NzbFile::EncodeUrl(const char* filename, char* url, int bufLen)
+{
+	WString widefilename(filename);
+
+	char* end = url + bufLen;
+	for (wchar_t* p = widefilename; *p && url < end - 3; p++)
+	{
+		wchar_t ch = *p;
+		if (('0' <= ch && ch <= '9') ||
+			('a' <= ch && ch <= 'z') ||
+			('A' <= ch && ch <= 'Z') ||
+			ch == '-' || ch == '.' || ch == '_' || ch == '~')
+		{
+			*url++ = (char)ch;
+		}
+		else
+		{
+			*url++ = '%';
+			uint32 a = (uint32)ch >> 4;
+			*url++ = a > 9 ? a - 10 + 'A' : a + '0';
+			a = ch & 0xF;
+			*url++ = a > 9 ? a - 10 + 'A' : a + '0';
+		}
+	}
+	*url = '\0';
+}
+
+bool NzbFile::ParseNzb(IUnknown* nzb)
+{
+	MSXML::IXMLDOMDocumentPtr doc = nzb;
+	MSXML::IXMLDOMNodePtr root = doc->documentElement;
+
+	MSXML::IXMLDOMNodePtr node = root->selectSingleNode("/nzb/head/meta[@type='password']");
+	if (node)
+	{
+		_bstr_t password(node->Gettext());
+		m_password = password;
+	}
+
+	MSXML::IXMLDOMNodeListPtr fileList = root->selectNodes("/nzb/file");
+	for (int i = 0; i < fileList->Getlength(); i++)
+	{
+		node = fileList->Getitem(i);
+		MSXML::IXMLDOMNodePtr attribute = node->Getattributes()->getNamedItem("subject");
+		if (!attribute) return false;
+		_bstr_t subject(attribute->Gettext());
+
+		m_fileInfo = std::make_unique<FileInfo>();
+		m_fileInfo->SetSubject(subject);
+		m_segments.clear();
+		m_idArena.clear();
+
+		attribute = node->Getattributes()->getNamedItem("date");
+		if (attribute)
+		{
+			_bstr_t date(attribute->Gettext());
+			m_fileInfo->SetTime(atoi(date));
+		}
+
+		MSXML::IXMLDOMNodeListPtr groupList = node->selectNodes("groups/group");
+		for (int g = 0; g < groupList->Getlength(); g++)
+		{
+			MSXML::IXMLDOMNodePtr node = groupList->Getitem(g);
+			_bstr_t group = node->Gettext();
+			m_fileInfo->GetGroups()->push_back((const char*)group);
+		}
+
+		MSXML::IXMLDOMNodeListPtr segmentList = node->selectNodes("segments/segment");
+		for (int g = 0; g < segmentList->Getlength(); g++)
+		{
+			MSXML::IXMLDOMNodePtr node = segmentList->Getitem(g);
+			_bstr_t bid = node->Gettext();
+			const char* id = bid;
+
+			MSXML::IXMLDOMNodePtr attribute = node->Getattributes()->getNamedItem("number");
+			if (!attribute) return false;
+			_bstr_t number(attribute->Gettext());
+
+			attribute = node->Getattributes()->getNamedItem("bytes");
+			if (!attribute) return false;
+			_bstr_t bytes(attribute->Gettext());
+
+			int partNumber = atoi(number);
+			int lsize = atoi(bytes);
+
+			if (partNumber > 0)
+			{
+				m_segments.push_back({partNumber, lsize, -1});
+				AddSegmentId(id, (int)strlen(id));
+			}
+		}
+
+		AddFileInfo();
+	}
+	return true;
+}
+
+#else
+
+bool NzbFile::ParseXml()
+{
+#ifdef DISABLE_LIBXML2
+	error("Could not parse rss feed, program was compiled without libxml2 support");
+	return false;
+#else
+	xmlSAXHandler SAX_handler = {0};
+	SAX_handler.startElement = reinterpret_cast<startElementSAXFunc>(SAX_StartElement);
+	SAX_handler.endElement = reinterpret_cast<endElementSAXFunc>(SAX_EndElement);
+	SAX_handler.characters = reinterpret_cast<charactersSAXFunc>(SAX_characters);
+	SAX_handler.error = reinterpret_cast<errorSAXFunc>(SAX_error);
+	SAX_handler.getEntity = reinterpret_cast<getEntitySAXFunc>(SAX_getEntity);
+
+	m_ignoreNextError = false;
+
+	int ret = xmlSAXUserParseFile(&SAX_handler, this, m_fileName);
+
+	if (ret != 0)
+	{
+		m_nzbInfo->AddMessage(Message::mkError, BString<1024>(
+			"Error parsing nzb-file %s", FileSystem::BaseFileName(m_fileName)));
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+void NzbFile::Parse_StartElement(const char *name, const char **atts)
+{
+	BString<1024> tagAttrMessage("Malformed nzb-file, tag <%s> must have attributes", name);
+
+	m_tagContent.Clear();
+
+	if (!strcmp("file", name))
+	{
+		m_fileInfo = std::make_unique<FileInfo>();
+		m_fileInfo->SetFilename(m_fileName);
+		m_segments.clear();
+		m_idArena.clear();
+
+		if (!atts)
+		{
+			m_nzbInfo->AddMessage(Message::mkWarning, tagAttrMessage);
+			return;
+		}
+
+		for (int i = 0; atts[i]; i += 2)
+		{
+			const char* attrname = atts[i];
+			const char* attrvalue = atts[i + 1];
+			if (!strcmp("subject", attrname))
+			{
+				m_fileInfo->SetSubject(attrvalue);
+			}
+			if (!strcmp("date", attrname))
+			{
+				m_fileInfo->SetTime(atoi(attrvalue));
+			}
+		}
+	}
+	else if (!strcmp("segment", name))
+	{
+		if (!m_fileInfo)
 		{
 			m_nzbInfo->AddMessage(Message::mkWarning, "Malformed nzb-file, tag <segment> without tag <file>");
 			return;
@@ -695,11 +1521,8 @@ void NzbFile::Parse_StartElement(const char *name, const char **atts)
 		if (partNumber > 0)
 		{
 			// new segment, add it!
-			std::unique_ptr<ArticleInfo> article = std::make_unique<ArticleInfo>();
-			article->SetPartNumber(partNumber);
-			article->SetSize(lsize);
-			m_article = article.get();
-			AddArticle(m_fileInfo.get(), std::move(article));
+			m_segments.push_back({partNumber, (int)lsize, -1});
+			m_segmentPending = true;
 		}
 	}
 	else if (!strcmp("meta", name))
@@ -718,8 +1541,11 @@ void NzbFile::Parse_EndElement(const char *name)
 	if (!strcmp("file", name))
 	{
 		// Close the file element, add the new file to file-list
-		AddFileInfo(std::move(m_fileInfo));
-		m_article = nullptr;
+		if (m_fileInfo)
+		{
+			AddFileInfo();
+		}
+		m_segmentPending = false;
 	}
 	else if (!strcmp("group", name))
 	{
@@ -734,16 +1560,15 @@ void NzbFile::Parse_EndElement(const char *name)
 	}
 	else if (!strcmp("segment", name))
 	{
-		if (!m_fileInfo || !m_article)
+		if (!m_fileInfo || !m_segmentPending)
 		{
 			// error: bad nzb-file
 			return;
 		}
 
 		// Get the #text part
-		BString<1024> id("<%s>", *m_tagContent);
-		m_article->SetMessageId(id);
-		m_article = nullptr;
+		AddSegmentId(*m_tagContent ? *m_tagContent : "", m_tagContent.Length());
+		m_segmentPending = false;
 	}
 	else if (!strcmp("meta", name) && m_hasPassword)
 	{
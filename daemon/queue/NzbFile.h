@@ -33,31 +33,75 @@ public:
 	const char* GetFileName() const { return m_fileName; }
 	std::unique_ptr<NzbInfo> DetachNzbInfo() { return std::move(m_nzbInfo); }
 	const char* GetPassword() { return m_password; }
+	void SetXmlParser(bool xmlParser) { m_xmlParser = xmlParser; }
 
 	void LogDebugInfo();
 
 private:
+	struct SegmentRecord
+	{
+		int m_partNumber;
+		int m_size;
+		int m_idOffset;
+	};
+
+	struct StreamAttr
+	{
+		const char* m_name;
+		int m_nameLen;
+		int m_valueOffset;
+	};
+
+	typedef std::vector<SegmentRecord> SegmentRecords;
+	typedef std::vector<StreamAttr> StreamAttrs;
+	typedef std::vector<std::pair<const char*, int>> TagStack;
+
 	std::unique_ptr<NzbInfo> m_nzbInfo;
 	CString m_fileName;
 	CString m_password;
+	bool m_xmlParser = false;
+	std::unique_ptr<FileInfo> m_fileInfo;
+	bool m_hasPassword = false;
 
-	void AddArticle(FileInfo* fileInfo, std::unique_ptr<ArticleInfo> articleInfo);
-	void AddFileInfo(std::unique_ptr<FileInfo> fileInfo);
+	// segments of current file, message-ids are stored in the arena
+	SegmentRecords m_segments;
+	std::string m_idArena;
+
+	// streaming parser state
+	std::string m_content;
+	StreamAttrs m_attrs;
+	std::string m_attrValues;
+	bool m_inSegment = false;
+	bool m_segmentPending = false;
+
+	void AddSegmentId(const char* id, int len);
+	void AddFileInfo();
+	void AddFileInfo(std::unique_ptr<FileInfo> fileInfo, int64 size, int64 missedSize,
+		int totalArticles, int missedArticles);
 	void ParseSubject(FileInfo* fileInfo, bool TryQuotes);
 	void BuildFilenames();
 	void ProcessFiles();
 	void CalcHashes();
 	bool HasDuplicateFilenames();
 	void ReadPassword();
+	void ResetNzbInfo();
+	bool ParseXml();
+	bool ParseStream();
+	bool Stream_Document(const char* p, const char* end);
+	bool Stream_StartTag(const char*& p, const char* end, TagStack& tags);
+	bool Stream_EndTag(const char*& p, const char* end, TagStack& tags);
+	bool Stream_AttrValue(const char*& p, const char* end);
+	bool Stream_Text(const char* p, const char* end);
+	void Stream_AppendText(const char* text, int len);
+	bool Stream_StartElement(const char* name, int len);
+	bool Stream_EndElement(const char* name, int len);
+	const char* Stream_FindAttr(const char* name);
 #ifdef WIN32
 	bool ParseNzb(IUnknown* nzb);
 	static void EncodeUrl(const char* filename, char* url, int bufLen);
 #else
-	std::unique_ptr<FileInfo> m_fileInfo;
-	ArticleInfo* m_article = nullptr;
 	StringBuilder m_tagContent;
 	bool m_ignoreNextError;
-	bool m_hasPassword = false;
 
 	static void SAX_StartElement(NzbFile* file, const char *name, const char **atts);
 	static void SAX_EndElement(NzbFile* file, const char *name);
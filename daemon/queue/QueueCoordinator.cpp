@@ -31,11 +31,14 @@
 #include "FileSystem.h"
 #include "Decoder.h"
 #include "StatMeter.h"
+#include "PerfStats.h"
 
 bool QueueCoordinator::CoordinatorDownloadQueue::EditEntry(
 	int ID, EEditAction action, const char* args)
 {
-	return m_owner->m_queueEditor.EditEntry(&m_owner->m_downloadQueue, ID, action, args);
+	bool ret = m_owner->m_queueEditor.EditEntry(&m_owner->m_downloadQueue, ID, action, args);
+	Changed();
+	return ret;
 }
 
 bool QueueCoordinator::CoordinatorDownloadQueue::EditList(
@@ -44,6 +47,7 @@ bool QueueCoordinator::CoordinatorDownloadQueue::EditList(
 	m_massEdit = true;
 	bool ret = m_owner->m_queueEditor.EditList(&m_owner->m_downloadQueue, idList, nameList, matchMode, action, args);
 	m_massEdit = false;
+	Changed();
 	if (m_wantSave)
 	{
 		Save();
@@ -53,6 +57,8 @@ bool QueueCoordinator::CoordinatorDownloadQueue::EditList(
 
 void QueueCoordinator::CoordinatorDownloadQueue::Save()
 {
+	Changed();
+
 	if (m_massEdit)
 	{
 		m_wantSave = true;
@@ -187,6 +193,11 @@ void QueueCoordinator::Run()
 {
 	debug("Entering QueueCoordinator-loop");
 
+	if (g_Options->GetLockProfiling())
+	{
+		m_downloadQueue.EnableLockProfiling();
+	}
+
 	Load();
 	AdjustDownloadsLimit();
 	bool wasStandBy = true;
@@ -403,6 +414,8 @@ NzbInfo* QueueCoordinator::AddNzbFileToQueue(std::unique_ptr<NzbInfo> nzbInfo, N
 		downloadQueue->GetQueue()->Remove(urlInfo);
 	}
 
+	downloadQueue->Changed();
+
 	if (deleteStatus == NzbInfo::dsNone)
 	{
 		addedNzb->PrintMessage(Message::mkInfo, "Collection %s added to queue", addedNzb->GetName());
@@ -418,7 +431,7 @@ NzbInfo* QueueCoordinator::AddNzbFileToQueue(std::unique_ptr<NzbInfo> nzbInfo, N
 	{
 		// in a case if none of listeners did already delete the temporary object - we do it ourselves
 		downloadQueue->GetQueue()->Remove(addedNzb);
-		if (!downloadQueue->GetHistory()->Find(addedNzb->GetId()))
+		if (!downloadQueue->FindHistory(addedNzb->GetId()))
 		{
 			addedNzb = nullptr;
 		}
@@ -506,6 +519,8 @@ void QueueCoordinator::Stop()
  */
 bool QueueCoordinator::GetNextArticle(DownloadQueue* downloadQueue, FileInfo* &fileInfo, ArticleInfo* &articleInfo)
 {
+	PerfTimer timer(PerfStats::pmNextArticle);
+
 	// find an unpaused file with the highest priority, then take the next article from the file.
 	// if the file doesn't have any articles left for download, we store that fact and search again,
 	// ignoring all files which were previously marked as not having any articles.
@@ -612,7 +627,7 @@ bool QueueCoordinator::GetNextFirstArticle(NzbInfo* nzbInfo, FileInfo* &fileInfo
 			}
 			if (!fileInfo1->GetArticles()->empty())
 			{
-				ArticleInfo* article = fileInfo1->GetArticles()->at(0).get();
+				ArticleInfo* article = fileInfo1->GetArticles()->at(0);
 				if (article->GetStatus() == ArticleInfo::aiUndefined)
 				{
 					fileInfo = fileInfo1;
@@ -869,6 +884,7 @@ void QueueCoordinator::DeleteFileInfo(DownloadQueue* downloadQueue, FileInfo* fi
 			fileInfo->GetOrigname(), fileStatus,
 			fileStatus == CompletedFile::cfSuccess ? fileInfo->GetCrc() : 0,
 			fileInfo->GetParFile(), fileInfo->GetHash16k(), fileInfo->GetParSetId());
+		fileInfo->GetNzbInfo()->GetCompletedFiles()->back().SetRarInfo(fileInfo->GetRarInfo());
 	}
 
 	if (g_Options->GetDirectRename())
@@ -1046,6 +1062,20 @@ void QueueCoordinator::LogDebugInfo()
 	{
 		articleDownloader->LogDebugInfo();
 	}
+
+	if (LockProfile* lockProfile = downloadQueue->GetLockProfile())
+	{
+		info("   ---------- Queue lock (top call sites by hold time)");
+		LockProfile::SiteList sites = lockProfile->GetSites();
+		for (int i = 0; i < (int)sites.size() && i < 20; i++)
+		{
+			LockProfile::Site& site = sites[i];
+			info("    %s:%i: %" PRIi64 " locks, hold %.1f ms (max %.3f ms), wait %.1f ms (max %.3f ms)",
+				FileSystem::BaseFileName(site.file), site.line, site.count,
+				site.holdTime / 1000000.0, site.maxHold / 1000000.0,
+				site.waitTime / 1000000.0, site.maxWait / 1000000.0);
+		}
+	}
 }
 
 void QueueCoordinator::ResetHangingDownloads()
@@ -65,7 +65,7 @@ private:
 		virtual bool EditEntry(int ID, EEditAction action, const char* args);
 		virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
 			EEditAction action, const char* args);
-		virtual void HistoryChanged() { m_historyChanged = true; }
+		virtual void HistoryChanged() { m_historyChanged = true; Changed(); }
 		virtual void Save();
 		virtual void SaveChanged();
 	private:
@@ -198,19 +198,6 @@ bool GroupSorter::operator()(const std::unique_ptr<NzbInfo>& refNzbInfo1, const
 }
 
 
-FileInfo* QueueEditor::FindFileInfo(int id)
-{
-	for (NzbInfo* nzbInfo : m_downloadQueue->GetQueue())
-	{
-		FileInfo* fileInfo = nzbInfo->GetFileList()->Find(id);
-		if (fileInfo)
-		{
-			return fileInfo;
-		}
-	}
-	return nullptr;
-}
-
 void QueueEditor::PauseUnpauseEntry(FileInfo* fileInfo, bool pause)
 {
 	fileInfo->SetPaused(pause);
@@ -604,7 +591,7 @@ void QueueEditor::PrepareList(ItemList* itemList, IdList* idList,
 		{
 			if (minId <= id && id <= maxId)
 			{
-				FileInfo* fileInfo = FindFileInfo(id);
+				FileInfo* fileInfo = m_downloadQueue->FindFile(id);
 				if (fileInfo)
 				{
 					itemList->emplace_back(fileInfo, nullptr, offset);
@@ -635,12 +622,10 @@ void QueueEditor::PrepareList(ItemList* itemList, IdList* idList,
 		{
 			if (minId <= id && id <= maxId)
 			{
-				for (NzbInfo* nzbInfo : m_downloadQueue->GetQueue())
+				NzbInfo* nzbInfo = m_downloadQueue->FindNzb(id);
+				if (nzbInfo)
 				{
-					if (id == nzbInfo->GetId())
-					{
-						itemList->emplace_back(nullptr, nzbInfo, offset);
-					}
+					itemList->emplace_back(nullptr, nzbInfo, offset);
 				}
 			}
 		}
@@ -779,7 +764,7 @@ bool QueueEditor::EditGroup(NzbInfo* nzbInfo, DownloadQueue::EEditAction action,
 
 	if ((action == DownloadQueue::eaGroupDelete || action == DownloadQueue::eaGroupDupeDelete || action == DownloadQueue::eaGroupFinalDelete) &&
 		// NZBInfo could have been destroyed already
-		m_downloadQueue->GetQueue()->Find(id))
+		m_downloadQueue->FindNzb(id))
 	{
 		DownloadQueue::Aspect deleteAspect = { DownloadQueue::eaNzbDeleted, m_downloadQueue, nzbInfo, nullptr };
 		m_downloadQueue->Notify(&deleteAspect);
@@ -45,7 +45,6 @@ private:
 
 	DownloadQueue* m_downloadQueue;
 
-	FileInfo* FindFileInfo(int id);
 	bool InternEditList(ItemList* itemList, IdList* idList, DownloadQueue::EEditAction action, const char* args);
 	void PrepareList(ItemList* itemList, IdList* idList, DownloadQueue::EEditAction action, int offset);
 	bool BuildIdListFromNameList(IdList* idList, NameList* nameList, DownloadQueue::EMatchMode matchMode, DownloadQueue::EEditAction action);
@@ -419,6 +419,7 @@ void UrlCoordinator::AddUrlToQueue(std::unique_ptr<NzbInfo> nzbInfo, bool addFir
 	if (addedNzb->GetDeleteStatus() != NzbInfo::dsManual)
 	{
 		downloadQueue->GetQueue()->Add(std::move(nzbInfo), addFirst);
+		downloadQueue->Changed();
 
 		DownloadQueue::Aspect addedAspect = {DownloadQueue::eaUrlAdded, downloadQueue, addedNzb, nullptr};
 		downloadQueue->Notify(&addedAspect);
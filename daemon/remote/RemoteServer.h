@@ -25,6 +25,7 @@
 #include "Thread.h"
 #include "Connection.h"
 #include "Observer.h"
+#include "WebServer.h"
 
 class RequestProcessor;
 
@@ -58,6 +59,7 @@ public:
 private:
 	bool m_tls;
 	std::unique_ptr<Connection> m_connection;
+	WebResponseBuffers m_webBuffers;
 
 	bool ServWebRequest(const char* signature);
 	void Execute();
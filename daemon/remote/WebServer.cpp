@@ -25,6 +25,7 @@
 #include "Options.h"
 #include "Util.h"
 #include "FileSystem.h"
+#include "PerfStats.h"
 
 #ifndef DISABLE_PARCHECK
 #include "par2cmdline.h"
@@ -35,10 +36,16 @@ static const char* ERR_HTTP_OK = "200 OK";
 static const char* ERR_HTTP_NOT_MODIFIED = "304 Not Modified";
 static const char* ERR_HTTP_BAD_REQUEST = "400 Bad Request";
 static const char* ERR_HTTP_NOT_FOUND = "404 Not Found";
+static const char* ERR_HTTP_INTERNAL_SERVER_ERROR = "500 Internal Server Error";
 static const char* ERR_HTTP_SERVICE_UNAVAILABLE = "503 Service Unavailable";
 
 static const int MAX_UNCOMPRESSED_SIZE = 500;
+static const int MAX_CACHED_ASSET_SIZE = 4 * 1024 * 1024;
+static const int64 MAX_ASSET_CACHE_SIZE = 32 * 1024 * 1024;
+static const int GZIP_BLOCK_SIZE = 64 * 1024;
+static const int MAX_KEPT_RESPONSE_BUFFER = 1024 * 1024;
 char WebProcessor::m_serverAuthToken[3][49];
+WebAssetCache WebProcessor::m_assetCache;
 
 //*****************************************************************
 // WebProcessor
@@ -98,9 +105,10 @@ void WebProcessor::Execute()
 	ParseUrl();
 
 	m_rpcRequest = XmlRpcProcessor::IsRpcRequest(m_url);
+	m_metricsRequest = !strcmp(m_url, "/metrics");
 	m_authorized = CheckCredentials();
 
-	if ((!g_Options->GetFormAuth() || m_rpcRequest) && !m_authorized)
+	if ((!g_Options->GetFormAuth() || m_rpcRequest || m_metricsRequest) && !m_authorized)
 	{
 		SendAuthResponse();
 		return;
@@ -325,12 +333,22 @@ void WebProcessor::Dispatch()
 	if (m_rpcRequest)
 	{
 		XmlRpcProcessor processor;
+		processor.SetResponseBuffer(m_buffers->GetRpcResponse());
 		processor.SetRequest(m_request);
 		processor.SetHttpMethod(m_httpMethod == hmGet ? XmlRpcProcessor::hmGet : XmlRpcProcessor::hmPost);
 		processor.SetUserAccess((XmlRpcProcessor::EUserAccess)m_userAccess);
 		processor.SetUrl(m_url);
 		processor.Execute();
-		SendBodyResponse(processor.GetResponse(), strlen(processor.GetResponse()), processor.GetContentType(), processor.IsSafeMethod());
+		const char* parts[] = { processor.GetResponseHeader(), processor.GetResponse(), processor.GetResponseFooter() };
+		int partLens[] = { (int)strlen(parts[0]), processor.GetResponseLen(), (int)strlen(parts[2]) };
+		SendBodyResponse(parts, partLens, 3, processor.GetContentType(), processor.IsSafeMethod());
+		m_buffers->Trim();
+		return;
+	}
+
+	if (m_metricsRequest && m_httpMethod == hmGet && m_userAccess != uaAdd)
+	{
+		SendMetricsResponse();
 		return;
 	}
 
@@ -368,6 +386,40 @@ void WebProcessor::Dispatch()
 	}
 }
 
+/*
+ * Timings collected by PerfStats in Prometheus text exposition format.
+ */
+void WebProcessor::SendMetricsResponse()
+{
+	PerfStats::SummaryList summaries = PerfStats::Collect();
+
+	StringBuilder body;
+	body.Append(
+		"# HELP nzbget_duration_seconds Duration of instrumented operations.\n"
+		"# TYPE nzbget_duration_seconds summary\n");
+	for (PerfStats::Summary& summary : summaries)
+	{
+		body.AppendFmt(
+			"nzbget_duration_seconds{operation=\"%s\",quantile=\"0.5\"} %.9f\n"
+			"nzbget_duration_seconds{operation=\"%s\",quantile=\"0.99\"} %.9f\n"
+			"nzbget_duration_seconds_sum{operation=\"%s\"} %.9f\n"
+			"nzbget_duration_seconds_count{operation=\"%s\"} %" PRIi64 "\n",
+			summary.name, summary.p50 / 1e9, summary.name, summary.p99 / 1e9,
+			summary.name, summary.total / 1e9, summary.name, summary.count);
+	}
+
+	body.Append(
+		"# HELP nzbget_duration_max_seconds Longest duration of instrumented operations.\n"
+		"# TYPE nzbget_duration_max_seconds gauge\n");
+	for (PerfStats::Summary& summary : summaries)
+	{
+		body.AppendFmt("nzbget_duration_max_seconds{operation=\"%s\"} %.9f\n",
+			summary.name, summary.max / 1e9);
+	}
+
+	SendBodyResponse(body, body.Length(), "text/plain; version=0.0.4", false);
+}
+
 void WebProcessor::SendAuthResponse()
 {
 	const char* AUTH_RESPONSE_HEADER =
@@ -456,7 +508,161 @@ void WebProcessor::SendRedirectResponse(const char* url)
 	m_connection->Send(responseHeader, responseHeader.Length());
 }
 
+static void MakeETag(const char** parts, const int* partLens, int partCount, BString<100>& eTag)
+{
+#ifndef DISABLE_PARCHECK
+	Par2::MD5Hash hash;
+	Par2::MD5Context md5;
+	for (int i = 0; i < partCount; i++)
+	{
+		md5.Update(parts[i], partLens[i]);
+	}
+	md5.Final(hash);
+	eTag.Format("\"%s\"", hash.print().c_str());
+#else
+	uint32 hash = 0;
+	for (int i = 0; i < partCount; i++)
+	{
+		hash = Util::HashBJ96(parts[i], partLens[i], hash);
+	}
+	eTag.Format("\"%x\"", hash);
+#endif
+}
+
 void WebProcessor::SendBodyResponse(const char* body, int bodyLen, const char* contentType, bool cachable)
+{
+	SendBodyResponse(&body, &bodyLen, 1, contentType, cachable);
+}
+
+/*
+ * The body can consist of multiple parts, which are sent (or compressed)
+ * one after another without being copied into one buffer.
+ */
+void WebProcessor::SendBodyResponse(const char** parts, const int* partLens, int partCount,
+	const char* contentType, bool cachable)
+{
+	BString<100> eTag;
+	if (cachable)
+	{
+		MakeETag(parts, partLens, partCount, eTag);
+		if (m_oldETag && !strcmp(eTag, m_oldETag))
+		{
+			SendContentResponse(nullptr, nullptr, 0, contentType, false, false, eTag, true);
+			return;
+		}
+	}
+
+#ifndef DISABLE_GZIP
+	int64 bodyLen = 0;
+	for (int i = 0; i < partCount; i++)
+	{
+		bodyLen += partLens[i];
+	}
+
+	if (m_gzip && bodyLen > MAX_UNCOMPRESSED_SIZE)
+	{
+		SendGZipResponse(parts, partLens, partCount, contentType, cachable ? *eTag : nullptr);
+		return;
+	}
+#endif
+
+	SendContentResponse(parts, partLens, partCount, contentType, false, false,
+		cachable ? *eTag : nullptr, false);
+}
+
+#ifndef DISABLE_GZIP
+/*
+ * Small responses are compressed into one block and sent with "Content-Length".
+ * Larger responses are sent in chunks as they are compressed, with the same
+ * compression stream and buffer used for all requests of the connection.
+ */
+void WebProcessor::SendGZipResponse(const char** parts, const int* partLens, int partCount,
+	const char* contentType, const char* eTag)
+{
+	GZipStream* gzipStream = m_buffers->GetGZipStream();
+	gzipStream->Reset();
+
+	bool chunked = false;
+	for (int i = 0; i < partCount; i++)
+	{
+		gzipStream->Write(parts[i], partLens[i], i == partCount - 1);
+
+		while (true)
+		{
+			const void* outBuf;
+			int outLen;
+			GZipStream::EStatus status = gzipStream->Read(&outBuf, &outLen);
+
+			if (status == GZipStream::zlError)
+			{
+				if (!chunked)
+				{
+					SendContentResponse(parts, partLens, partCount, contentType, false, false, eTag, false);
+				}
+				else
+				{
+					// the response can't be completed anymore
+					m_keepAlive = false;
+				}
+				return;
+			}
+
+			if (!chunked && status == GZipStream::zlFinished)
+			{
+				const char* body = (const char*)outBuf;
+				SendContentResponse(&body, &outLen, 1, contentType, true, false, eTag, false);
+				return;
+			}
+
+			if (outLen == 0)
+			{
+				// needs next part
+				break;
+			}
+
+			if (!chunked)
+			{
+				if (!m_http11)
+				{
+					// chunked transfer encoding isn't supported by HTTP/1.0 clients
+					SendContentResponse(parts, partLens, partCount, contentType, false, false, eTag, false);
+					return;
+				}
+
+				SendContentResponse(nullptr, nullptr, 0, contentType, true, true, eTag, false);
+				chunked = true;
+			}
+
+			BString<100> chunkHeader("%x\r\n", outLen);
+			const char* chunkParts[] = { chunkHeader, (const char*)outBuf, "\r\n" };
+			int chunkLens[] = { chunkHeader.Length(), outLen, 2 };
+			if (!m_connection->Send(chunkParts, chunkLens, 3))
+			{
+				return;
+			}
+
+			if (status == GZipStream::zlFinished)
+			{
+				m_connection->Send("0\r\n\r\n", 5);
+				return;
+			}
+		}
+	}
+
+	// the stream must have been finished with the last part
+	if (chunked)
+	{
+		m_keepAlive = false;
+	}
+	else
+	{
+		SendErrorResponse(ERR_HTTP_INTERNAL_SERVER_ERROR, true);
+	}
+}
+#endif
+
+void WebProcessor::SendContentResponse(const char** parts, const int* partLens, int partCount,
+	const char* contentType, bool gzip, bool chunked, const char* eTag, bool unchanged)
 {
 	const char* RESPONSE_HEADER =
 		"HTTP/1.1 %s\r\n"
@@ -468,61 +674,33 @@ void WebProcessor::SendBodyResponse(const char* body, int bodyLen, const char* c
 		"Access-Control-Allow-Headers: Content-Type, Authorization\r\n"
 		"Set-Cookie: Auth-Type=%s\r\n"
 		"Set-Cookie: Auth-Token=%s; HttpOnly\r\n"
-		"Content-Length: %i\r\n"
+		"%s"					// Content-Length: xxx or Transfer-Encoding: chunked
 		"%s"					// Content-Type: xxx
 		"%s"					// Content-Encoding: gzip
 		"%s"					// ETag
 		"Server: nzbget-%s\r\n"
 		"\r\n";
 
-	BString<1024> eTagHeader;
-	bool unchanged = false;
-
-	if (cachable)
+	BString<1024> lengthHeader;
+	if (chunked)
 	{
-		BString<1024> newETag;
-
-#ifndef DISABLE_PARCHECK
-		Par2::MD5Hash hash;
-		Par2::MD5Context md5;
-		md5.Update(body, bodyLen);
-		md5.Final(hash);
-		newETag.Format("\"%s\"", hash.print().c_str());
-#else
-		uint32 hash = Util::HashBJ96(body, bodyLen, 0);
-		newETag.Format("\"%x\"", hash);
-#endif
-
-		unchanged = m_oldETag && !strcmp(newETag, m_oldETag);
-		if (unchanged)
+		lengthHeader = "Transfer-Encoding: chunked\r\n";
+	}
+	else
+	{
+		int64 bodyLen = 0;
+		for (int i = 0; i < partCount; i++)
 		{
-			body = "";
-			bodyLen = 0;
+			bodyLen += partLens[i];
 		}
-		eTagHeader.Format("ETag: %s\r\n", *newETag);
+		lengthHeader.Format("Content-Length: %" PRId64 "\r\n", bodyLen);
 	}
 
-#ifndef DISABLE_GZIP
-	CharBuffer gbuf;
-	bool gzip = m_gzip && bodyLen > MAX_UNCOMPRESSED_SIZE;
-	if (gzip)
+	BString<1024> eTagHeader;
+	if (eTag)
 	{
-		uint32 outLen = ZLib::GZipLen(bodyLen);
-		gbuf.Reserve(outLen);
-		int gzippedLen = ZLib::GZip(body, bodyLen, *gbuf, outLen);
-		if (gzippedLen > 0 && gzippedLen < bodyLen)
-		{
-			body = gbuf;
-			bodyLen = gzippedLen;
-		}
-		else
-		{
-			gzip = false;
-		}
+		eTagHeader.Format("ETag: %s\r\n", eTag);
 	}
-#else
-	bool gzip = false;
-#endif
 
 	BString<1024> contentTypeHeader;
 	if (contentType)
@@ -536,86 +714,84 @@ void WebProcessor::SendBodyResponse(const char* body, int bodyLen, const char* c
 		m_origin.Str(),
 		g_Options->GetFormAuth() ? "form" : "http",
 		m_authorized ? m_serverAuthToken[m_userAccess] : "",
-		bodyLen,
+		*lengthHeader,
 		*contentTypeHeader,
 		gzip ? "Content-Encoding: gzip\r\n" : "",
-		cachable ? *eTagHeader : "",
+		*eTagHeader,
 		Util::VersionRevision());
 
 	debug("[%s] (%s) %s", *m_url, *m_oldETag, *responseHeader);
 
 	// Send the request answer
-	m_connection->Send(responseHeader, responseHeader.Length());
-	m_connection->Send(body, bodyLen);
+	std::vector<const char*> sendParts = { responseHeader };
+	std::vector<int> sendLens = { responseHeader.Length() };
+	sendParts.insert(sendParts.end(), parts, parts + partCount);
+	sendLens.insert(sendLens.end(), partLens, partLens + partCount);
+	m_connection->Send(sendParts.data(), sendLens.data(), (int)sendParts.size());
 }
 
-void WebProcessor::SendSingleFileResponse()
+void WebProcessor::SendAssetResponse(const WebAssetCache::FileList& filenames, const char* contentType)
 {
-	const char *defRes = "";
-	if (m_url[strlen(m_url)-1] == '/')
-	{
-		// default file in directory (if not specified) is "index.html"
-		defRes = "index.html";
-	}
-
-	BString<1024> filename("%s%s%s", g_Options->GetWebDir(), *m_url, defRes);
-
-	debug("serving file: %s", *filename);
-
-	CharBuffer body;
-	if (!FileSystem::LoadFileIntoBuffer(filename, body, true))
+	CString missingFile;
+	std::shared_ptr<WebAssetCache::Asset> asset = m_assetCache.Get(m_url, filenames, contentType, missingFile);
+	if (!asset)
 	{
 		// do not print warnings "404 not found" for certain files
+		const char* filename = FileSystem::BaseFileName(missingFile);
 		bool ignorable = !strcmp(filename, "package-info.json") ||
 			!strcmp(filename, "favicon.ico") ||
 			!strncmp(filename, "apple-touch-icon", 16);
 
-		SendErrorResponse(ERR_HTTP_NOT_FOUND, ignorable);
+		if (!ignorable)
+		{
+			BString<1024> resource("/%s", filename);
+			warn("Web-Server: %s, Resource: %s", ERR_HTTP_NOT_FOUND,
+				filenames.size() > 1 ? *resource : *m_url);
+		}
+		SendErrorResponse(ERR_HTTP_NOT_FOUND, false);
 		return;
 	}
 
-	const char* contentType = DetectContentType(filename);
-	int len = body.Size() - 1;
+	bool unchanged = m_oldETag && !strcmp(asset->GetETag(), m_oldETag);
+	bool gzip = !unchanged && m_gzip && asset->GetGzipBody();
+	const char* body = gzip ? asset->GetGzipBody() : asset->GetBody();
+	int bodyLen = gzip ? asset->GetGzipBodyLen() : asset->GetBodyLen();
+	SendContentResponse(&body, &bodyLen, unchanged ? 0 : 1, asset->GetContentType(),
+		gzip, false, asset->GetETag(), unchanged);
+}
 
-#ifdef DEBUG
-	if (contentType && !strcmp(contentType, "text/html"))
+void WebProcessor::SendSingleFileResponse()
+{
+	const char *defRes = "";
+	if (m_url[strlen(m_url)-1] == '/')
 	{
-		Util::ReduceStr(body, "<!-- %if-debug%", "");
-		Util::ReduceStr(body, "<!-- %if-not-debug% -->", "<!--");
-		Util::ReduceStr(body, "<!-- %end% -->", "-->");
-		Util::ReduceStr(body, "%end% -->", "");
-		len = strlen(body);
+		// default file in directory (if not specified) is "index.html"
+		defRes = "index.html";
 	}
-#endif
 
-	SendBodyResponse(body, len, contentType, true);
+	BString<1024> filename("%s%s%s", g_Options->GetWebDir(), *m_url, defRes);
+
+	debug("serving file: %s", *filename);
+
+	WebAssetCache::FileList filenames;
+	filenames.emplace_back(filename);
+	SendAssetResponse(filenames, DetectContentType(filename));
 }
 
 void WebProcessor::SendMultiFileResponse()
 {
 	debug("serving multiple files: %s", *m_url);
 
-	StringBuilder response;
-	char* filelist = strchr(m_url, '?');
-	*filelist++ = '\0';
+	WebAssetCache::FileList filenames;
+	const char* filelist = strchr(m_url, '?') + 1;
 
 	Tokenizer tok(filelist, "+");
 	while (const char* filename = tok.Next())
 	{
-		BString<1024> diskFilename("%s%c%s", g_Options->GetWebDir(), PATH_SEPARATOR, filename);
-
-		CharBuffer body;
-		if (!FileSystem::LoadFileIntoBuffer(diskFilename, body, true))
-		{
-			warn("Web-Server: %s, Resource: /%s", ERR_HTTP_NOT_FOUND, filename);
-			SendErrorResponse(ERR_HTTP_NOT_FOUND, false);
-			return;
-		}
-
-		response.Append(body);
+		filenames.emplace_back(BString<1024>("%s%c%s", g_Options->GetWebDir(), PATH_SEPARATOR, filename));
 	}
 
-	SendBodyResponse(response, response.Length(), DetectContentType(m_url), true);
+	SendAssetResponse(filenames, DetectContentType(m_url));
 }
 
 const char* WebProcessor::DetectContentType(const char* filename)
@@ -649,3 +825,163 @@ const char* WebProcessor::DetectContentType(const char* filename)
 	}
 	return nullptr;
 }
+
+
+//*****************************************************************
+// WebAssetCache
+
+bool WebAssetCache::Asset::IsActual()
+{
+	for (Source& source : m_sources)
+	{
+		int64 size = -1;
+		if (FileSystem::FileTime(source.filename, &size) != source.time || size != source.size)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<WebAssetCache::Asset> WebAssetCache::Get(const char* url, const FileList& filenames,
+	const char* contentType, CString& missingFile)
+{
+	std::shared_ptr<Asset> asset;
+	{
+		Guard guard(m_assetsMutex);
+		AssetMap::iterator it = m_assets.find(url);
+		if (it != m_assets.end())
+		{
+			asset = it->second;
+		}
+	}
+
+	// checking files outside of lock to not block other requests
+	if (asset && asset->IsActual())
+	{
+		return asset;
+	}
+
+	asset = Load(filenames, contentType, missingFile);
+
+	Guard guard(m_assetsMutex);
+
+	AssetMap::iterator it = m_assets.find(url);
+	if (it != m_assets.end())
+	{
+		m_memorySize -= it->second->GetMemorySize();
+		m_assets.erase(it);
+	}
+
+	if (asset && asset->GetBodyLen() <= MAX_CACHED_ASSET_SIZE)
+	{
+		if (m_memorySize + asset->GetMemorySize() > MAX_ASSET_CACHE_SIZE)
+		{
+			// the web-interface has only few files, that many assets can come only from
+			// unusual requests; starting over is simpler than tracking usage of entries
+			m_assets.clear();
+			m_memorySize = 0;
+		}
+		m_assets[url] = asset;
+		m_memorySize += asset->GetMemorySize();
+	}
+
+	return asset;
+}
+
+void WebAssetCache::Clear()
+{
+	Guard guard(m_assetsMutex);
+	m_assets.clear();
+	m_memorySize = 0;
+}
+
+std::shared_ptr<WebAssetCache::Asset> WebAssetCache::Load(const FileList& filenames,
+	const char* contentType, CString& missingFile)
+{
+	std::shared_ptr<Asset> asset = std::make_shared<Asset>();
+	asset->m_contentType = contentType;
+
+	int bodyLen = 0;
+	for (const CString& filename : filenames)
+	{
+		// the stamps are taken before reading so that a file modified in between
+		// causes reloading on next request
+		int64 size = -1;
+		int64 time = FileSystem::FileTime(filename, &size);
+
+		CharBuffer content;
+		if (time == -1 || !FileSystem::LoadFileIntoBuffer(filename, content, false) ||
+			content.Size() > INT_MAX - 1 - bodyLen)
+		{
+			missingFile = *filename;
+			return nullptr;
+		}
+
+		asset->m_body.Reserve(bodyLen + content.Size() + 1);
+		memcpy(asset->m_body + bodyLen, content, content.Size());
+		bodyLen += content.Size();
+		asset->m_body[bodyLen] = '\0';
+
+		asset->m_sources.push_back({*filename, size, time});
+	}
+	asset->m_bodyLen = bodyLen;
+
+#ifdef DEBUG
+	if (contentType && !strcmp(contentType, "text/html"))
+	{
+		Util::ReduceStr(asset->m_body, "<!-- %if-debug%", "");
+		Util::ReduceStr(asset->m_body, "<!-- %if-not-debug% -->", "<!--");
+		Util::ReduceStr(asset->m_body, "<!-- %end% -->", "-->");
+		Util::ReduceStr(asset->m_body, "%end% -->", "");
+		asset->m_bodyLen = strlen(asset->m_body);
+	}
+#endif
+
+	const char* body = asset->m_body;
+	MakeETag(&body, &asset->m_bodyLen, 1, asset->m_eTag);
+
+#ifndef DISABLE_GZIP
+	if (asset->m_bodyLen > MAX_UNCOMPRESSED_SIZE)
+	{
+		uint32 outLen = ZLib::GZipLen(asset->m_bodyLen);
+		asset->m_gzipBody.Reserve(outLen);
+		int gzippedLen = ZLib::GZip(asset->m_body, asset->m_bodyLen, asset->m_gzipBody, outLen);
+		if (gzippedLen > 0 && gzippedLen < asset->m_bodyLen)
+		{
+			asset->m_gzipBody.Reserve(gzippedLen);
+			asset->m_gzipBodyLen = gzippedLen;
+		}
+		else
+		{
+			asset->m_gzipBody.Clear();
+		}
+	}
+#endif
+
+	return asset;
+}
+
+
+//*****************************************************************
+// WebResponseBuffers
+
+#ifndef DISABLE_GZIP
+GZipStream* WebResponseBuffers::GetGZipStream()
+{
+	if (!m_gzipStream)
+	{
+		m_gzipStream = std::make_unique<GZipStream>(GZIP_BLOCK_SIZE);
+	}
+	return m_gzipStream.get();
+}
+#endif
+
+void WebResponseBuffers::Trim()
+{
+	// don't hold the memory of an unusually large response until the connection is closed
+	if (m_rpcResponse.Capacity() > MAX_KEPT_RESPONSE_BUFFER)
+	{
+		m_rpcResponse.Clear();
+	}
+}
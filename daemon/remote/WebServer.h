@@ -23,6 +23,83 @@
 
 #include "NString.h"
 #include "Connection.h"
+#include "Thread.h"
+#include "Util.h"
+
+/*
+Static files of web-interface kept in memory together with their compressed
+variant and ETag. An asset is reloaded when any of its source files changes.
+ */
+class WebAssetCache
+{
+public:
+	typedef std::vector<CString> FileList;
+
+	class Asset
+	{
+	public:
+		const char* GetBody() { return m_body; }
+		int GetBodyLen() { return m_bodyLen; }
+		const char* GetGzipBody() { return m_gzipBody; }
+		int GetGzipBodyLen() { return m_gzipBodyLen; }
+		const char* GetETag() { return m_eTag; }
+		const char* GetContentType() { return m_contentType; }
+		int GetMemorySize() { return m_bodyLen + m_gzipBodyLen; }
+
+	private:
+		struct Source
+		{
+			CString filename;
+			int64 size;
+			int64 time;
+		};
+		typedef std::vector<Source> SourceList;
+
+		SourceList m_sources;
+		CharBuffer m_body;
+		int m_bodyLen = 0;
+		CharBuffer m_gzipBody;
+		int m_gzipBodyLen = 0;
+		BString<100> m_eTag;
+		const char* m_contentType = nullptr;
+
+		bool IsActual();
+
+		friend class WebAssetCache;
+	};
+
+	std::shared_ptr<Asset> Get(const char* url, const FileList& filenames, const char* contentType,
+		CString& missingFile);
+	void Clear();
+
+private:
+	typedef std::map<std::string, std::shared_ptr<Asset>> AssetMap;
+
+	AssetMap m_assets;
+	int64 m_memorySize = 0;
+	Mutex m_assetsMutex;
+
+	std::shared_ptr<Asset> Load(const FileList& filenames, const char* contentType, CString& missingFile);
+};
+
+/*
+Buffers reused for all requests received via the same connection.
+ */
+class WebResponseBuffers
+{
+public:
+	StringBuilder* GetRpcResponse() { return &m_rpcResponse; }
+#ifndef DISABLE_GZIP
+	GZipStream* GetGZipStream();
+#endif
+	void Trim();
+
+private:
+	StringBuilder m_rpcResponse;
+#ifndef DISABLE_GZIP
+	std::unique_ptr<GZipStream> m_gzipStream;
+#endif
+};
 
 class WebProcessor
 {
@@ -39,6 +116,8 @@ public:
 	void SetConnection(Connection* connection) { m_connection = connection; }
 	void SetUrl(const char* url) { m_url = url; }
 	void SetHttpMethod(EHttpMethod httpMethod) { m_httpMethod = httpMethod; }
+	void SetHttp11(bool http11) { m_http11 = http11; }
+	void SetBuffers(WebResponseBuffers* buffers) { m_buffers = buffers; }
 	bool GetKeepAlive() { return m_keepAlive; }
 
 private:
@@ -55,6 +134,7 @@ private:
 	EHttpMethod m_httpMethod;
 	EUserAccess m_userAccess;
 	bool m_rpcRequest;
+	bool m_metricsRequest;
 	bool m_authorized;
 	bool m_gzip;
 	CString m_origin;
@@ -62,17 +142,31 @@ private:
 	char m_authInfo[256+1];
 	char m_authToken[48+1];
 	static char m_serverAuthToken[3][48+1];
+	static WebAssetCache m_assetCache;
 	CString m_forwardedFor;
 	CString m_oldETag;
 	bool m_keepAlive = false;
+	bool m_http11 = false;
+	WebResponseBuffers m_ownBuffers;
+	WebResponseBuffers* m_buffers = &m_ownBuffers;
 
 	void Dispatch();
 	void SendAuthResponse();
+	void SendMetricsResponse();
 	void SendOptionsResponse();
 	void SendErrorResponse(const char* errCode, bool printWarning);
 	void SendSingleFileResponse();
 	void SendMultiFileResponse();
 	void SendBodyResponse(const char* body, int bodyLen, const char* contentType, bool cachable);
+	void SendBodyResponse(const char** parts, const int* partLens, int partCount,
+		const char* contentType, bool cachable);
+	void SendAssetResponse(const WebAssetCache::FileList& filenames, const char* contentType);
+	void SendContentResponse(const char** parts, const int* partLens, int partCount,
+		const char* contentType, bool gzip, bool chunked, const char* eTag, bool unchanged);
+#ifndef DISABLE_GZIP
+	void SendGZipResponse(const char** parts, const int* partLens, int partCount,
+		const char* contentType, const char* eTag);
+#endif
 	void SendRedirectResponse(const char* url);
 	const char* DetectContentType(const char* filename);
 	bool IsAuthorizedIp(const char* remoteAddr);
@@ -36,6 +36,8 @@
 #include "QueueScript.h"
 #include "CommandScript.h"
 #include "UrlCoordinator.h"
+#include "PrePostProcessor.h"
+#include "PerfStats.h"
 
 extern void ExitProc();
 extern void Reload();
@@ -193,7 +195,12 @@ class HistoryXmlCommand: public NzbInfoXmlCommand
 public:
 	virtual void Execute();
 private:
+	typedef std::vector<HistoryInfo*> HistoryItems;
+
 	const char* DetectStatus(HistoryInfo* historyInfo);
+	bool MatchFilter(HistoryInfo* historyInfo, const char* status, const char* category, WildMask* textMask);
+	void SortItems(HistoryItems& items, const char* sort);
+	void AppendHistoryItem(HistoryInfo* historyInfo);
 };
 
 class UrlQueueXmlCommand: public SafeXmlCommand
@@ -283,6 +290,24 @@ public:
 	virtual void Execute();
 };
 
+class PerfStatsXmlCommand: public SafeXmlCommand
+{
+public:
+	virtual void Execute();
+};
+
+class LockProfileXmlCommand: public SafeXmlCommand
+{
+public:
+	virtual void Execute();
+};
+
+class ResetLockProfileXmlCommand: public XmlCommand
+{
+public:
+	virtual void Execute();
+};
+
 class LoadLogXmlCommand: public LogXmlCommand
 {
 protected:
@@ -347,6 +372,11 @@ bool XmlRpcProcessor::IsRpcRequest(const char* url)
 
 void XmlRpcProcessor::Execute()
 {
+	// the buffer may be reused from previous request: keep the capacity but empty the content
+	m_response->Reserve(1024 * 10 - 1);
+	m_response->SetLength(0);
+	m_response->Append("");
+
 	m_protocol = rpUndefined;
 	if (!strcmp(m_url, "/xmlrpc") || !strncmp(m_url, "/xmlrpc/", 8))
 	{
@@ -424,6 +454,7 @@ void XmlRpcProcessor::Dispatch()
 	else
 	{
 		std::unique_ptr<XmlCommand> command = CreateCommand(methodName);
+		command->SetResponseBuffer(m_response);
 		command->SetRequest(request);
 		command->SetProtocol(m_protocol);
 		command->SetHttpMethod(m_httpMethod);
@@ -433,8 +464,11 @@ void XmlRpcProcessor::Dispatch()
 		bool safeToExecute = m_safeMethod || m_httpMethod == XmlRpcProcessor::hmPost || m_protocol == XmlRpcProcessor::rpJsonPRpc;
 		if (safeToExecute || command->IsError())
 		{
-			command->Execute();
-			BuildResponse(command->GetResponse(), command->GetCallbackFunc(), command->GetFault(), requestId);
+			{
+				PerfTimer timer(PerfStats::pmRpcCommand);
+				command->Execute();
+			}
+			BuildResponse(command->GetCallbackFunc(), command->GetFault(), requestId);
 		}
 		else
 		{
@@ -446,7 +480,7 @@ void XmlRpcProcessor::Dispatch()
 void XmlRpcProcessor::MutliCall()
 {
 	bool error = false;
-	StringBuilder response;
+	StringBuilder& response = *m_response;
 
 	response.Append("<array><data>");
 
@@ -471,7 +505,10 @@ void XmlRpcProcessor::MutliCall()
 		std::unique_ptr<XmlCommand> command = CreateCommand(methodName);
 		command->SetRequest(requestPtr);
 		m_safeMethod |= command->IsSafeMethod();
-		command->Execute();
+		{
+			PerfTimer timer(PerfStats::pmRpcCommand);
+			command->Execute();
+		}
 
 		debug("MutliCall, Response=%s", command->GetResponse());
 
@@ -500,12 +537,15 @@ void XmlRpcProcessor::MutliCall()
 	else
 	{
 		response.Append("</data></array>");
-		BuildResponse(response, "", false, nullptr);
+		BuildResponse("", false, nullptr);
 	}
 }
 
-void XmlRpcProcessor::BuildResponse(const char* response, const char* callbackFunc,
-	bool fault, const char* requestId)
+/*
+ * The response envelope is kept separately from the response content,
+ * which is sent directly from the buffer filled by the command.
+ */
+void XmlRpcProcessor::BuildResponse(const char* callbackFunc, bool fault, const char* requestId)
 {
 	const char XML_HEADER[] = "<?xml version=\"1.0\"?>\n<methodResponse>\n";
 	const char XML_FOOTER[] = "</methodResponse>";
@@ -535,35 +575,36 @@ void XmlRpcProcessor::BuildResponse(const char* response, const char* callbackFu
 	const char* closeTag = fault ? (xmlRpc ? XML_FAULT_CLOSE : JSON_FAULT_CLOSE ) : (xmlRpc ? XML_OK_CLOSE : JSON_OK_CLOSE);
 	const char* callbackFooter = m_protocol == rpJsonPRpc ? JSONP_CALLBACK_FOOTER : "";
 
-	debug("Response=%s", response);
+	debug("Response=%s", GetResponse());
 
+	m_responseHeader.Clear();
 	if (callbackFunc)
 	{
-		m_response.Append(callbackFunc);
+		m_responseHeader.Append(callbackFunc);
 	}
-	m_response.Append(callbackHeader);
-	m_response.Append(header);
+	m_responseHeader.Append(callbackHeader);
+	m_responseHeader.Append(header);
 	if (!xmlRpc && requestId && *requestId)
 	{
-		m_response.Append(JSON_ID_OPEN);
-		m_response.Append(requestId);
-		m_response.Append(JSON_ID_CLOSE);
+		m_responseHeader.Append(JSON_ID_OPEN);
+		m_responseHeader.Append(requestId);
+		m_responseHeader.Append(JSON_ID_CLOSE);
 	}
-	m_response.Append(openTag);
-	m_response.Append(response);
-	m_response.Append(closeTag);
-	m_response.Append(footer);
-	m_response.Append(callbackFooter);
+	m_responseHeader.Append(openTag);
+
+	m_responseFooter.Format("%s%s%s", closeTag, footer, callbackFooter);
 
 	m_contentType = xmlRpc ? "text/xml" : "application/json";
 }
 
 void XmlRpcProcessor::BuildErrorResponse(int errCode, const char* errText)
 {
+	m_response->SetLength(0);
 	ErrorXmlCommand command(errCode, errText);
+	command.SetResponseBuffer(m_response);
 	command.SetProtocol(m_protocol);
 	command.Execute();
-	BuildResponse(command.GetResponse(), "", command.GetFault(), nullptr);
+	BuildResponse("", command.GetFault(), nullptr);
 }
 
 std::unique_ptr<XmlCommand> XmlRpcProcessor::CreateCommand(const char* methodName)
@@ -740,6 +781,18 @@ std::unique_ptr<XmlCommand> XmlRpcProcessor::CreateCommand(const char* methodNam
 	{
 		command = std::make_unique<ResetServerVolumeXmlCommand>();
 	}
+	else if (!strcasecmp(methodName, "perfstats"))
+	{
+		command = std::make_unique<PerfStatsXmlCommand>();
+	}
+	else if (!strcasecmp(methodName, "lockprofile"))
+	{
+		command = std::make_unique<LockProfileXmlCommand>();
+	}
+	else if (!strcasecmp(methodName, "resetlockprofile"))
+	{
+		command = std::make_unique<ResetLockProfileXmlCommand>();
+	}
 	else if (!strcasecmp(methodName, "testserver"))
 	{
 		command = std::make_unique<TestServerXmlCommand>();
@@ -766,7 +819,7 @@ std::unique_ptr<XmlCommand> XmlRpcProcessor::CreateCommand(const char* methodNam
 
 XmlCommand::XmlCommand()
 {
-	m_response.Reserve(1024 * 10 - 1);
+	m_ownResponse.Reserve(1024 * 10 - 1);
 }
 
 bool XmlCommand::IsJson()
@@ -776,14 +829,14 @@ bool XmlCommand::IsJson()
 
 void XmlCommand::AppendResponse(const char* part)
 {
-	m_response.Append(part);
+	m_response->Append(part);
 }
 
 void XmlCommand::AppendFmtResponse(const char* format, ...)
 {
 	va_list args;
 	va_start(args, format);
-	m_response.AppendFmtV(format, args);
+	m_response->AppendFmtV(format, args);
 	va_end(args);
 }
 
@@ -791,8 +844,25 @@ void XmlCommand::AppendCondResponse(const char* part, bool cond)
 {
 	if (cond)
 	{
-		m_response.Append(part);
+		m_response->Append(part);
+	}
+}
+
+void XmlCommand::AppendEncodedResponse(const char* str)
+{
+	int len = IsJson() ? WebUtil::JsonEncodeLen(str) : WebUtil::XmlEncodeLen(str);
+	int curLen = m_response->Length();
+	m_response->Reserve(curLen + len);
+	char* output = (char*)*m_response + curLen;
+	if (IsJson())
+	{
+		WebUtil::JsonEncode(str, output);
+	}
+	else
+	{
+		WebUtil::XmlEncode(str, output);
 	}
+	m_response->SetLength(curLen + len);
 }
 
 void XmlCommand::BuildErrorResponse(int errCode, const char* errText, ...)
@@ -819,7 +889,7 @@ void XmlCommand::BuildErrorResponse(int errCode, const char* errText, ...)
 	va_end(ap);
 
 	BString<1024> content(IsJson() ? JSON_RESPONSE_ERROR_BODY : XML_RESPONSE_ERROR_BODY,
-		errCode, *EncodeStr(fullText));
+		errCode, EncodeStr(fullText));
 
 	AppendResponse(content);
 
@@ -1058,21 +1128,32 @@ const char* XmlCommand::BoolToStr(bool value)
 	return IsJson() ? (value ? "true" : "false") : (value ? "1" : "0");
 }
 
-CString XmlCommand::EncodeStr(const char* str)
+/*
+ * Most strings don't need escaping and are used as is; the encoded strings
+ * are allocated from a pool living as long as the command.
+ */
+const char* XmlCommand::EncodeStr(const char* str)
 {
 	if (!str)
 	{
 		return "";
 	}
 
-	CString result;
+	int len = strlen(str);
+	int encodedLen = IsJson() ? WebUtil::JsonEncodeLen(str) : WebUtil::XmlEncodeLen(str);
+	if (encodedLen == len)
+	{
+		return str;
+	}
+
+	char* result = m_encodePool.Allocate(encodedLen + 1);
 	if (IsJson())
 	{
-		result = WebUtil::JsonEncode(str);
+		WebUtil::JsonEncode(str, result);
 	}
 	else
 	{
-		result = WebUtil::XmlEncode(str);
+		WebUtil::XmlEncode(str, result);
 	}
 	return result;
 }
@@ -1227,6 +1308,12 @@ void StatusXmlCommand::Execute()
 		"<member><name>ResumeTime</name><value><i4>%i</i4></value></member>\n"
 		"<member><name>FeedActive</name><value><boolean>%s</boolean></value></member>\n"
 		"<member><name>QueueScriptCount</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>PostCpuJobs</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>PostCpuLimit</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>PostDiskJobs</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>PostDiskLimit</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>PostScriptJobs</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>PostScriptLimit</name><value><i4>%i</i4></value></member>\n"
 		"<member><name>NewsServers</name><value><array><data>\n";
 
 	const char* XML_STATUS_END =
@@ -1276,6 +1363,12 @@ void StatusXmlCommand::Execute()
 		"\"ResumeTime\" : %i,\n"
 		"\"FeedActive\" : %s,\n"
 		"\"QueueScriptCount\" : %i,\n"
+		"\"PostCpuJobs\" : %i,\n"
+		"\"PostCpuLimit\" : %i,\n"
+		"\"PostDiskJobs\" : %i,\n"
+		"\"PostDiskLimit\" : %i,\n"
+		"\"PostScriptJobs\" : %i,\n"
+		"\"PostScriptLimit\" : %i,\n"
 		"\"NewsServers\" : [\n";
 
 	const char* JSON_STATUS_END =
@@ -1296,6 +1389,7 @@ void StatusXmlCommand::Execute()
 
 	int postJobCount = 0;
 	int urlCount = 0;
+	int classJobs[PrePostProcessor::rcScript + 1] = {0};
 	int64 remainingSize, forcedSize;
 	{
 		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
@@ -1303,6 +1397,10 @@ void StatusXmlCommand::Execute()
 		{
 			postJobCount += nzbInfo->GetPostInfo() ? 1 : 0;
 			urlCount += nzbInfo->GetKind() == NzbInfo::nkUrl ? 1 : 0;
+			if (nzbInfo->GetPostInfo() && nzbInfo->GetPostInfo()->GetWorking())
+			{
+				classJobs[PrePostProcessor::GetStageClass(nzbInfo->GetPostInfo()->GetStage())]++;
+			}
 		}
 		downloadQueue->CalcRemainingSize(&remainingSize, &forcedSize);
 	}
@@ -1357,6 +1455,12 @@ void StatusXmlCommand::Execute()
 	bool feedActive = g_FeedCoordinator->HasActiveDownloads();
 	int queuedScripts = g_QueueScriptCoordinator->GetQueueSize();
 
+	// class limits are used only by post-processing strategy "staged"
+	bool staged = g_Options->GetPostStrategy() == Options::ppStaged;
+	int cpuLimit = staged ? PrePostProcessor::GetClassLimit(PrePostProcessor::rcCpu) : 0;
+	int diskLimit = staged ? PrePostProcessor::GetClassLimit(PrePostProcessor::rcDisk) : 0;
+	int scriptLimit = staged ? PrePostProcessor::GetClassLimit(PrePostProcessor::rcScript) : 0;
+
 	AppendFmtResponse(IsJson() ? JSON_STATUS_START : XML_STATUS_START,
 		remainingSizeLo, remainingSizeHi, remainingMBytes, forcedSizeLo,
 		forcedSizeHi, forcedMBytes, downloadedSizeLo, downloadedSizeHi, downloadedMBytes,
@@ -1367,7 +1471,9 @@ void StatusXmlCommand::Execute()
 		BoolToStr(downloadPaused), BoolToStr(downloadPaused), BoolToStr(downloadPaused),
 		BoolToStr(serverStandBy), BoolToStr(postPaused), BoolToStr(scanPaused), BoolToStr(quotaReached),
 		freeDiskSpaceLo, freeDiskSpaceHi,	freeDiskSpaceMB, serverTime, resumeTime,
-		BoolToStr(feedActive), queuedScripts);
+		BoolToStr(feedActive), queuedScripts,
+		classJobs[PrePostProcessor::rcCpu], cpuLimit, classJobs[PrePostProcessor::rcDisk], diskLimit,
+		classJobs[PrePostProcessor::rcScript], scriptLimit);
 
 	int index = 0;
 	for (NewsServer* server : g_ServerPool->GetServers())
@@ -1444,7 +1550,7 @@ void LogXmlCommand::Execute()
 		AppendCondResponse(",\n", IsJson() && index++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_LOG_ITEM : XML_LOG_ITEM,
 			message.GetId(), messageType[message.GetKind()], message.GetTime(),
-			*EncodeStr(message.GetText()));
+			EncodeStr(message.GetText()));
 	}
 
 	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
@@ -1542,7 +1648,7 @@ void ListFilesXmlCommand::Execute()
 				uint32 remainingSizeLo, remainingSizeHi;
 				Util::SplitInt64(fileInfo->GetSize(), &fileSizeHi, &fileSizeLo);
 				Util::SplitInt64(fileInfo->GetRemainingSize(), &remainingSizeHi, &remainingSizeLo);
-				CString xmlNzbNicename = EncodeStr(fileInfo->GetNzbInfo()->GetName());
+				const char* xmlNzbNicename = EncodeStr(fileInfo->GetNzbInfo()->GetName());
 
 				int progress = fileInfo->GetFailedSize() == 0 && fileInfo->GetSuccessSize() == 0 ? 0 :
 					(int)(1000 - fileInfo->GetRemainingSize() * 1000 / (fileInfo->GetSize() - fileInfo->GetMissedSize()));
@@ -1552,9 +1658,9 @@ void ListFilesXmlCommand::Execute()
 					fileInfo->GetId(), fileSizeLo, fileSizeHi, remainingSizeLo, remainingSizeHi,
 					fileInfo->GetTime(), BoolToStr(fileInfo->GetFilenameConfirmed()),
 					BoolToStr(fileInfo->GetPaused()), fileInfo->GetNzbInfo()->GetId(),
-					*xmlNzbNicename, *xmlNzbNicename, *EncodeStr(fileInfo->GetNzbInfo()->GetFilename()),
-					*EncodeStr(fileInfo->GetSubject()), *EncodeStr(fileInfo->GetFilename()),
-					*EncodeStr(fileInfo->GetNzbInfo()->GetDestDir()), *EncodeStr(fileInfo->GetNzbInfo()->GetCategory()),
+					xmlNzbNicename, xmlNzbNicename, EncodeStr(fileInfo->GetNzbInfo()->GetFilename()),
+					EncodeStr(fileInfo->GetSubject()), EncodeStr(fileInfo->GetFilename()),
+					EncodeStr(fileInfo->GetNzbInfo()->GetDestDir()), EncodeStr(fileInfo->GetNzbInfo()->GetCategory()),
 					fileInfo->GetNzbInfo()->GetPriority(), fileInfo->GetActiveDownloads(), progress);
 			}
 		}
@@ -1735,14 +1841,14 @@ void NzbInfoXmlCommand::AppendNzbInfoFields(NzbInfo* nzbInfo)
 
 	int messageCount = nzbInfo->GetMessageCount() > 0 ? nzbInfo->GetMessageCount() : nzbInfo->GetCachedMessageCount();
 
-	CString xmlNzbNicename = EncodeStr(nzbInfo->GetName());
+	const char* xmlNzbNicename = EncodeStr(nzbInfo->GetName());
 	const char* exParStatus = nzbInfo->GetExtraParBlocks() > 0 ? "RECIPIENT" : nzbInfo->GetExtraParBlocks() < 0 ? "DONOR" : "NONE";
 
 	AppendFmtResponse(IsJson() ? JSON_NZB_ITEM_START : XML_NZB_ITEM_START,
-			nzbInfo->GetId(), *xmlNzbNicename, *xmlNzbNicename, kindName[nzbInfo->GetKind()],
-			*EncodeStr(nzbInfo->GetUrl()), *EncodeStr(nzbInfo->GetFilename()),
-			*EncodeStr(nzbInfo->GetDestDir()), *EncodeStr(nzbInfo->GetFinalDir()),
-			*EncodeStr(nzbInfo->GetCategory()), parStatusName[nzbInfo->GetParStatus()], exParStatus,
+			nzbInfo->GetId(), xmlNzbNicename, xmlNzbNicename, kindName[nzbInfo->GetKind()],
+			EncodeStr(nzbInfo->GetUrl()), EncodeStr(nzbInfo->GetFilename()),
+			EncodeStr(nzbInfo->GetDestDir()), EncodeStr(nzbInfo->GetFinalDir()),
+			EncodeStr(nzbInfo->GetCategory()), parStatusName[nzbInfo->GetParStatus()], exParStatus,
 			unpackStatusName[nzbInfo->GetUnpackStatus()], moveStatusName[nzbInfo->GetMoveStatus()],
 			scriptStatusName[nzbInfo->GetScriptStatuses()->CalcTotalStatus()],
 			deleteStatusName[nzbInfo->GetDeleteStatus()], markStatusName[nzbInfo->GetMarkStatus()],
@@ -1751,7 +1857,7 @@ void NzbInfoXmlCommand::AppendNzbInfoFields(NzbInfo* nzbInfo)
 			nzbInfo->GetMinTime(), nzbInfo->GetMaxTime(),
 			nzbInfo->GetTotalArticles(), nzbInfo->GetCurrentSuccessArticles(), nzbInfo->GetCurrentFailedArticles(),
 			nzbInfo->CalcHealth(), nzbInfo->CalcCriticalHealth(false),
-			*EncodeStr(nzbInfo->GetDupeKey()), nzbInfo->GetDupeScore(), dupeModeName[nzbInfo->GetDupeMode()],
+			EncodeStr(nzbInfo->GetDupeKey()), nzbInfo->GetDupeScore(), dupeModeName[nzbInfo->GetDupeMode()],
 			BoolToStr(nzbInfo->GetDeleteStatus() != NzbInfo::dsNone),
 			downloadedSizeLo, downloadedSizeHi, downloadedSizeMB, nzbInfo->GetDownloadSec(),
 			nzbInfo->GetPostTotalSec() + (nzbInfo->GetPostInfo() && nzbInfo->GetPostInfo()->GetStartTime() ?
@@ -1764,7 +1870,7 @@ void NzbInfoXmlCommand::AppendNzbInfoFields(NzbInfo* nzbInfo)
 	{
 		AppendCondResponse(",\n", IsJson() && paramIndex++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_PARAMETER_ITEM : XML_PARAMETER_ITEM,
-			*EncodeStr(parameter.GetName()), *EncodeStr(parameter.GetValue()));
+			EncodeStr(parameter.GetName()), EncodeStr(parameter.GetValue()));
 	}
 
 	AppendResponse(IsJson() ? JSON_NZB_ITEM_SCRIPT_START : XML_NZB_ITEM_SCRIPT_START);
@@ -1775,7 +1881,7 @@ void NzbInfoXmlCommand::AppendNzbInfoFields(NzbInfo* nzbInfo)
 	{
 		AppendCondResponse(",\n", IsJson() && scriptIndex++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_SCRIPT_ITEM : XML_SCRIPT_ITEM,
-			*EncodeStr(scriptStatus.GetName()), *EncodeStr(scriptStatusName[scriptStatus.GetStatus()]));
+			EncodeStr(scriptStatus.GetName()), EncodeStr(scriptStatusName[scriptStatus.GetStatus()]));
 	}
 
 	AppendResponse(IsJson() ? JSON_NZB_ITEM_STATS_START : XML_NZB_ITEM_STATS_START);
@@ -1854,7 +1960,7 @@ void NzbInfoXmlCommand::AppendPostInfoFields(PostInfo* postInfo, int logEntries,
 	{
 		time_t curTime = Util::CurrentTime();
 
-		AppendFmtResponse(itemStart, *EncodeStr(postInfo->GetProgressLabel()),
+		AppendFmtResponse(itemStart, EncodeStr(postInfo->GetProgressLabel()),
 			postInfo->GetStageProgress(),
 			postInfo->GetStageTime() ? curTime - postInfo->GetStageTime() : 0,
 			postInfo->GetStartTime() ? curTime - postInfo->GetStartTime() : 0);
@@ -1885,7 +1991,7 @@ void NzbInfoXmlCommand::AppendPostInfoFields(PostInfo* postInfo, int logEntries,
 				AppendCondResponse(",\n", IsJson() && index++ > 0);
 				AppendFmtResponse(IsJson() ? JSON_LOG_ITEM : XML_LOG_ITEM,
 					message.GetId(), messageType[message.GetKind()], message.GetTime(),
-					*EncodeStr(message.GetText()));
+					EncodeStr(message.GetText()));
 			}
 		}
 	}
@@ -2336,7 +2442,7 @@ void PostQueueXmlCommand::Execute()
 
 		AppendCondResponse(",\n", IsJson() && index++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_POSTQUEUE_ITEM_START : XML_POSTQUEUE_ITEM_START,
-			nzbInfo->GetId(), *EncodeStr(postInfo->GetNzbInfo()->GetName()),
+			nzbInfo->GetId(), EncodeStr(postInfo->GetNzbInfo()->GetName()),
 			postStageName[postInfo->GetStage()], postInfo->GetFileProgress());
 
 		AppendNzbInfoFields(postInfo->GetNzbInfo());
@@ -2409,12 +2515,162 @@ void ScanXmlCommand::Execute()
 	BuildBoolResponse(true);
 }
 
-// struct[] history(bool hidden)
-// Parameter "hidden" is optional (new in v12)
+// struct[] history(bool hidden, int offset, int limit, string status, string category, string text, string sort)
+// Parameter "hidden" is optional (new in v12), other parameters are optional too (new in v22):
+//   - "status" filters by status ("FAILURE") or status with details ("FAILURE/PAR");
+//   - "category" filters by category, "text" by a part of the name (case insensitive);
+//   - "sort" is one of "time", "name", "size", "category", "status"; with prefix "-" the order
+//     is descending; without sorting the entries are returned in the history order (newest first);
+//   - "offset" and "limit" select a page of matching entries, limit 0 returns all entries.
+//     To find out if there are more pages request one entry more than needed.
 void HistoryXmlCommand::Execute()
 {
+	bool dup = false;
+	int offset = 0;
+	int limit = 0;
+	char* status = nullptr;
+	char* category = nullptr;
+	char* text = nullptr;
+	char* sort = nullptr;
+
+	NextParamAsBool(&dup);
+	if (NextParamAsInt(&offset) && NextParamAsInt(&limit))
+	{
+		// the filter parameters are optional, each one is decoded as soon as it is read
+		for (char** param : {&status, &category, &text, &sort})
+		{
+			if (!NextParamAsStr(param))
+			{
+				break;
+			}
+			DecodeStr(*param);
+		}
+	}
+
+	if (offset < 0 || limit < 0)
+	{
+		BuildErrorResponse(2, "Invalid parameter");
+		return;
+	}
+
+	std::unique_ptr<WildMask> textMask;
+	if (!Util::EmptyStr(text))
+	{
+		textMask = std::make_unique<WildMask>(BString<1024>("*%s*", text));
+	}
+
+	bool sorted = !Util::EmptyStr(sort);
+	int pageEnd = limit > 0 ? (int)std::min((int64)offset + limit, (int64)INT_MAX) : INT_MAX;
+	// without sorting the page is known as soon as enough entries are found
+	int maxCount = sorted ? INT_MAX : pageEnd;
+
 	AppendResponse(IsJson() ? "[\n" : "<array><data>\n");
 
+	GuardedDownloadQueue guard = DownloadQueue::Guard();
+
+	HistoryItems items;
+	for (HistoryInfo* historyInfo : guard->GetHistory())
+	{
+		if ((historyInfo->GetKind() != HistoryInfo::hkDup || dup) &&
+			MatchFilter(historyInfo, status, category, textMask.get()))
+		{
+			items.push_back(historyInfo);
+			if ((int)items.size() >= maxCount)
+			{
+				break;
+			}
+		}
+	}
+
+	if (sorted)
+	{
+		SortItems(items, sort);
+	}
+
+	int end = std::min((int)items.size(), pageEnd);
+	for (int i = offset; i < end; i++)
+	{
+		AppendCondResponse(",\n", IsJson() && i > offset);
+		AppendHistoryItem(items[i]);
+	}
+
+	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
+}
+
+bool HistoryXmlCommand::MatchFilter(HistoryInfo* historyInfo, const char* status,
+	const char* category, WildMask* textMask)
+{
+	if (!Util::EmptyStr(status))
+	{
+		// "FAILURE" matches all failures, "FAILURE/PAR" only this one
+		const char* itemStatus = DetectStatus(historyInfo);
+		int len = strlen(status);
+		if (strncmp(itemStatus, status, len) || (itemStatus[len] != '\0' && itemStatus[len] != '/'))
+		{
+			return false;
+		}
+	}
+
+	if (!Util::EmptyStr(category) &&
+		(historyInfo->GetKind() == HistoryInfo::hkDup ||
+		 strcasecmp(historyInfo->GetNzbInfo()->GetCategory(), category)))
+	{
+		return false;
+	}
+
+	return !textMask || textMask->Match(historyInfo->GetName());
+}
+
+void HistoryXmlCommand::SortItems(HistoryItems& items, const char* sort)
+{
+	bool descending = *sort == '-';
+	if (descending)
+	{
+		sort++;
+	}
+
+	auto itemSize = [](HistoryInfo* historyInfo)
+	{
+		return historyInfo->GetKind() == HistoryInfo::hkDup ? historyInfo->GetDupInfo()->GetSize() :
+			historyInfo->GetNzbInfo()->GetSize();
+	};
+
+	auto itemCategory = [](HistoryInfo* historyInfo)
+	{
+		return historyInfo->GetKind() == HistoryInfo::hkDup ? "" : historyInfo->GetNzbInfo()->GetCategory();
+	};
+
+	auto compare = [&](HistoryInfo* item1, HistoryInfo* item2)
+	{
+		int64 diff = 0;
+		if (!strcasecmp(sort, "name"))
+		{
+			diff = strcasecmp(item1->GetName(), item2->GetName());
+		}
+		else if (!strcasecmp(sort, "size"))
+		{
+			diff = itemSize(item1) - itemSize(item2);
+		}
+		else if (!strcasecmp(sort, "category"))
+		{
+			diff = strcasecmp(itemCategory(item1), itemCategory(item2));
+		}
+		else if (!strcasecmp(sort, "status"))
+		{
+			diff = strcmp(DetectStatus(item1), DetectStatus(item2));
+		}
+		else
+		{
+			diff = (int64)item1->GetTime() - (int64)item2->GetTime();
+		}
+		return descending ? diff > 0 : diff < 0;
+	};
+
+	std::stable_sort(items.begin(), items.end(), compare);
+}
+
+void HistoryXmlCommand::AppendHistoryItem(HistoryInfo* historyInfo)
+{
 	const char* XML_HISTORY_ITEM_START =
 		"<value><struct>\n"
 		"<member><name>ID</name><value><i4>%i</i4></value></member>\n"					// Deprecated, use "NZBID" instead
@@ -2476,59 +2732,41 @@ void HistoryXmlCommand::Execute()
 	const char* dupStatusName[] = { "UNKNOWN", "SUCCESS", "FAILURE", "DELETED", "DUPE", "BAD", "GOOD" };
 	const char* dupeModeName[] = { "SCORE", "ALL", "FORCE" };
 
-	bool dup = false;
-	NextParamAsBool(&dup);
+	NzbInfo* nzbInfo = nullptr;
 
-	int index = 0;
+	const char* status = DetectStatus(historyInfo);
 
-	GuardedDownloadQueue guard = DownloadQueue::Guard();
-	for (HistoryInfo* historyInfo : guard->GetHistory())
+	if (historyInfo->GetKind() == HistoryInfo::hkNzb ||
+		historyInfo->GetKind() == HistoryInfo::hkUrl)
 	{
-		if (historyInfo->GetKind() == HistoryInfo::hkDup && !dup)
-		{
-			continue;
-		}
-
-		NzbInfo* nzbInfo = nullptr;
-
-		const char* status = DetectStatus(historyInfo);
-
-		AppendCondResponse(",\n", IsJson() && index++ > 0);
-
-		if (historyInfo->GetKind() == HistoryInfo::hkNzb ||
-			historyInfo->GetKind() == HistoryInfo::hkUrl)
-		{
-			nzbInfo = historyInfo->GetNzbInfo();
-
-			AppendFmtResponse(IsJson() ? JSON_HISTORY_ITEM_START : XML_HISTORY_ITEM_START,
-				historyInfo->GetId(), *EncodeStr(historyInfo->GetName()), nzbInfo->GetParkedFileCount(),
-				BoolToStr(nzbInfo->GetCompletedFiles()->size()), historyInfo->GetTime(), status);
-		}
-		else if (historyInfo->GetKind() == HistoryInfo::hkDup)
-		{
-			DupInfo* dupInfo = historyInfo->GetDupInfo();
+		nzbInfo = historyInfo->GetNzbInfo();
 
-			uint32 fileSizeHi, fileSizeLo, fileSizeMB;
-			Util::SplitInt64(dupInfo->GetSize(), &fileSizeHi, &fileSizeLo);
-			fileSizeMB = (int)(dupInfo->GetSize() / 1024 / 1024);
+		AppendFmtResponse(IsJson() ? JSON_HISTORY_ITEM_START : XML_HISTORY_ITEM_START,
+			historyInfo->GetId(), EncodeStr(historyInfo->GetName()), nzbInfo->GetParkedFileCount(),
+			BoolToStr(nzbInfo->GetCompletedFiles()->size()), historyInfo->GetTime(), status);
+	}
+	else if (historyInfo->GetKind() == HistoryInfo::hkDup)
+	{
+		DupInfo* dupInfo = historyInfo->GetDupInfo();
 
-			AppendFmtResponse(IsJson() ? JSON_HISTORY_DUP_ITEM : XML_HISTORY_DUP_ITEM,
-				historyInfo->GetId(), historyInfo->GetId(), "DUP", *EncodeStr(historyInfo->GetName()),
-				historyInfo->GetTime(), fileSizeLo, fileSizeHi, fileSizeMB,
-				*EncodeStr(dupInfo->GetDupeKey()), dupInfo->GetDupeScore(),
-				dupeModeName[dupInfo->GetDupeMode()], dupStatusName[dupInfo->GetStatus()],
-				status);
-		}
+		uint32 fileSizeHi, fileSizeLo, fileSizeMB;
+		Util::SplitInt64(dupInfo->GetSize(), &fileSizeHi, &fileSizeLo);
+		fileSizeMB = (int)(dupInfo->GetSize() / 1024 / 1024);
 
-		if (nzbInfo)
-		{
-			AppendNzbInfoFields(nzbInfo);
-		}
+		AppendFmtResponse(IsJson() ? JSON_HISTORY_DUP_ITEM : XML_HISTORY_DUP_ITEM,
+			historyInfo->GetId(), historyInfo->GetId(), "DUP", EncodeStr(historyInfo->GetName()),
+			historyInfo->GetTime(), fileSizeLo, fileSizeHi, fileSizeMB,
+			EncodeStr(dupInfo->GetDupeKey()), dupInfo->GetDupeScore(),
+			dupeModeName[dupInfo->GetDupeMode()], dupStatusName[dupInfo->GetStatus()],
+			status);
+	}
 
-		AppendResponse(IsJson() ? JSON_HISTORY_ITEM_END : XML_HISTORY_ITEM_END);
+	if (nzbInfo)
+	{
+		AppendNzbInfoFields(nzbInfo);
 	}
 
-	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
+	AppendResponse(IsJson() ? JSON_HISTORY_ITEM_END : XML_HISTORY_ITEM_END);
 }
 
 const char* HistoryXmlCommand::DetectStatus(HistoryInfo* historyInfo)
@@ -2585,8 +2823,8 @@ void UrlQueueXmlCommand::Execute()
 		{
 			AppendCondResponse(",\n", IsJson() && index++ > 0);
 			AppendFmtResponse(IsJson() ? JSON_URLQUEUE_ITEM : XML_URLQUEUE_ITEM,
-				nzbInfo->GetId(), *EncodeStr(nzbInfo->GetFilename()), *EncodeStr(nzbInfo->GetUrl()),
-				*EncodeStr(nzbInfo->GetName()), *EncodeStr(nzbInfo->GetCategory()), nzbInfo->GetPriority());
+				nzbInfo->GetId(), EncodeStr(nzbInfo->GetFilename()), EncodeStr(nzbInfo->GetUrl()),
+				EncodeStr(nzbInfo->GetName()), EncodeStr(nzbInfo->GetCategory()), nzbInfo->GetPriority());
 		}
 	}
 
@@ -2614,12 +2852,12 @@ void ConfigXmlCommand::Execute()
 
 	for (Options::OptEntry& optEntry : g_Options->GuardOptEntries())
 	{
-		CString xmlValue = EncodeStr(m_userAccess == XmlRpcProcessor::uaRestricted &&
+		const char* xmlValue = EncodeStr(m_userAccess == XmlRpcProcessor::uaRestricted &&
 			optEntry.Restricted() ? "***" : optEntry.GetValue());
 
 		AppendCondResponse(",\n", IsJson() && index++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_CONFIG_ITEM : XML_CONFIG_ITEM,
-			*EncodeStr(optEntry.GetName()), *xmlValue);
+			EncodeStr(optEntry.GetName()), xmlValue);
 	}
 
 	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
@@ -2653,12 +2891,12 @@ void LoadConfigXmlCommand::Execute()
 
 	for (Options::OptEntry& optEntry: optEntries)
 	{
-		CString xmlValue = EncodeStr(m_userAccess == XmlRpcProcessor::uaRestricted &&
+		const char* xmlValue = EncodeStr(m_userAccess == XmlRpcProcessor::uaRestricted &&
 			optEntry.Restricted() ? "***" : optEntry.GetValue());
 
 		AppendCondResponse(",\n", IsJson() && index++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_CONFIG_ITEM : XML_CONFIG_ITEM,
-			*EncodeStr(optEntry.GetName()), *xmlValue);
+			EncodeStr(optEntry.GetName()), xmlValue);
 	}
 
 	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
@@ -2743,16 +2981,16 @@ void ConfigTemplatesXmlCommand::Execute()
 	{
 		AppendCondResponse(",\n", IsJson() && index++ > 0);
 		AppendFmtResponse(IsJson() ? JSON_CONFIG_ITEM : XML_CONFIG_ITEM,
-			*EncodeStr(configTemplate.GetScript()->GetName()),
-			*EncodeStr(configTemplate.GetScript()->GetDisplayName()),
+			EncodeStr(configTemplate.GetScript()->GetName()),
+			EncodeStr(configTemplate.GetScript()->GetDisplayName()),
 			BoolToStr(configTemplate.GetScript()->GetPostScript()),
 			BoolToStr(configTemplate.GetScript()->GetScanScript()),
 			BoolToStr(configTemplate.GetScript()->GetQueueScript()),
 			BoolToStr(configTemplate.GetScript()->GetSchedulerScript()),
 			BoolToStr(configTemplate.GetScript()->GetFeedScript()),
-			*EncodeStr(configTemplate.GetScript()->GetQueueEvents()),
-			*EncodeStr(configTemplate.GetScript()->GetTaskTime()),
-			*EncodeStr(configTemplate.GetTemplate()));
+			EncodeStr(configTemplate.GetScript()->GetQueueEvents()),
+			EncodeStr(configTemplate.GetScript()->GetTaskTime()),
+			EncodeStr(configTemplate.GetTemplate()));
 	}
 
 	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
@@ -2890,12 +3128,12 @@ void ViewFeedXmlCommand::Execute()
 
 			AppendCondResponse(",\n", IsJson() && index++ > 0);
 			AppendFmtResponse(IsJson() ? JSON_FEED_ITEM : XML_FEED_ITEM,
-				*EncodeStr(feedItemInfo.GetTitle()), *EncodeStr(feedItemInfo.GetFilename()),
-				*EncodeStr(feedItemInfo.GetUrl()), sizeLo, sizeHi, sizeMB,
-				*EncodeStr(feedItemInfo.GetCategory()), *EncodeStr(feedItemInfo.GetAddCategory()),
+				EncodeStr(feedItemInfo.GetTitle()), EncodeStr(feedItemInfo.GetFilename()),
+				EncodeStr(feedItemInfo.GetUrl()), sizeLo, sizeHi, sizeMB,
+				EncodeStr(feedItemInfo.GetCategory()), EncodeStr(feedItemInfo.GetAddCategory()),
 				BoolToStr(feedItemInfo.GetPauseNzb()), feedItemInfo.GetPriority(), feedItemInfo.GetTime(),
 				matchStatusType[feedItemInfo.GetMatchStatus()], feedItemInfo.GetMatchRule(),
-				*EncodeStr(feedItemInfo.GetDupeKey()), feedItemInfo.GetDupeScore(),
+				EncodeStr(feedItemInfo.GetDupeKey()), feedItemInfo.GetDupeScore(),
 				dupeModeType[feedItemInfo.GetDupeMode()], statusType[feedItemInfo.GetStatus()]);
 		}
 	}
@@ -3005,9 +3243,8 @@ void ReadUrlXmlCommand::Execute()
 	{
 		CharBuffer fileContent;
 		FileSystem::LoadFileIntoBuffer(tempFileName, fileContent, true);
-		CString xmlContent = EncodeStr(fileContent);
 		AppendResponse(IsJson() ? "\"" : "<string>");
-		AppendResponse(xmlContent);
+		AppendEncodedResponse(fileContent);
 		AppendResponse(IsJson() ? "\"" : "</string>");
 	}
 	else
@@ -3026,9 +3263,8 @@ void CheckUpdatesXmlCommand::Execute()
 
 	if (ok)
 	{
-		CString xmlContent = EncodeStr(updateInfo);
 		AppendResponse(IsJson() ? "\"" : "<string>");
-		AppendResponse(xmlContent);
+		AppendEncodedResponse(updateInfo);
 		AppendResponse(IsJson() ? "\"" : "</string>");
 	}
 	else
@@ -3240,6 +3476,122 @@ void ResetServerVolumeXmlCommand::Execute()
 	BuildBoolResponse(ok);
 }
 
+// struct[] perfstats();
+void PerfStatsXmlCommand::Execute()
+{
+	const char* XML_PERFSTATS_ITEM =
+		"<value><struct>\n"
+		"<member><name>Name</name><value><string>%s</string></value></member>\n"
+		"<member><name>CountLo</name><value><i4>%u</i4></value></member>\n"
+		"<member><name>CountHi</name><value><i4>%u</i4></value></member>\n"
+		"<member><name>TotalUSecLo</name><value><i4>%u</i4></value></member>\n"
+		"<member><name>TotalUSecHi</name><value><i4>%u</i4></value></member>\n"
+		"<member><name>P50USec</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>P99USec</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>MaxUSec</name><value><i4>%i</i4></value></member>\n"
+		"</struct></value>\n";
+
+	const char* JSON_PERFSTATS_ITEM =
+		"{\n"
+		"\"Name\" : \"%s\",\n"
+		"\"CountLo\" : %u,\n"
+		"\"CountHi\" : %u,\n"
+		"\"TotalUSecLo\" : %u,\n"
+		"\"TotalUSecHi\" : %u,\n"
+		"\"P50USec\" : %i,\n"
+		"\"P99USec\" : %i,\n"
+		"\"MaxUSec\" : %i\n"
+		"}";
+
+	AppendResponse(IsJson() ? "[\n" : "<array><data>\n");
+
+	int index = 0;
+	for (PerfStats::Summary& summary : PerfStats::Collect())
+	{
+		uint32 countHi, countLo, totalHi, totalLo;
+		Util::SplitInt64(summary.count, &countHi, &countLo);
+		Util::SplitInt64(summary.total / 1000, &totalHi, &totalLo);
+
+		AppendCondResponse(",\n", IsJson() && index++ > 0);
+		AppendFmtResponse(IsJson() ? JSON_PERFSTATS_ITEM : XML_PERFSTATS_ITEM,
+			summary.name, countLo, countHi, totalLo, totalHi,
+			(int)std::min(summary.p50 / 1000, (int64)INT_MAX), (int)std::min(summary.p99 / 1000, (int64)INT_MAX),
+			(int)std::min(summary.max / 1000, (int64)INT_MAX));
+	}
+
+	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
+}
+
+// struct[] lockprofile();
+void LockProfileXmlCommand::Execute()
+{
+	const char* XML_LOCKSITE_ITEM =
+		"<value><struct>\n"
+		"<member><name>File</name><value><string>%s</string></value></member>\n"
+		"<member><name>Line</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>CountLo</name><value><i4>%u</i4></value></member>\n"
+		"<member><name>CountHi</name><value><i4>%u</i4></value></member>\n"
+		"<member><name>HoldMSec</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>MaxHoldUSec</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>WaitMSec</name><value><i4>%i</i4></value></member>\n"
+		"<member><name>MaxWaitUSec</name><value><i4>%i</i4></value></member>\n"
+		"</struct></value>\n";
+
+	const char* JSON_LOCKSITE_ITEM =
+		"{\n"
+		"\"File\" : \"%s\",\n"
+		"\"Line\" : %i,\n"
+		"\"CountLo\" : %u,\n"
+		"\"CountHi\" : %u,\n"
+		"\"HoldMSec\" : %i,\n"
+		"\"MaxHoldUSec\" : %i,\n"
+		"\"WaitMSec\" : %i,\n"
+		"\"MaxWaitUSec\" : %i\n"
+		"}";
+
+	LockProfile::SiteList sites;
+	{
+		GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
+		LockProfile* lockProfile = downloadQueue->GetLockProfile();
+		if (!lockProfile)
+		{
+			BuildErrorResponse(3, "Lock profiling is disabled");
+			return;
+		}
+		sites = lockProfile->GetSites();
+	}
+
+	AppendResponse(IsJson() ? "[\n" : "<array><data>\n");
+
+	int index = 0;
+	for (LockProfile::Site& site : sites)
+	{
+		uint32 countHi, countLo;
+		Util::SplitInt64(site.count, &countHi, &countLo);
+
+		AppendCondResponse(",\n", IsJson() && index++ > 0);
+		AppendFmtResponse(IsJson() ? JSON_LOCKSITE_ITEM : XML_LOCKSITE_ITEM,
+			FileSystem::BaseFileName(site.file), site.line, countLo, countHi,
+			(int)std::min(site.holdTime / 1000000, (int64)INT_MAX), (int)std::min(site.maxHold / 1000, (int64)INT_MAX),
+			(int)std::min(site.waitTime / 1000000, (int64)INT_MAX), (int)std::min(site.maxWait / 1000, (int64)INT_MAX));
+	}
+
+	AppendResponse(IsJson() ? "\n]" : "</data></array>\n");
+}
+
+// bool resetlockprofile();
+void ResetLockProfileXmlCommand::Execute()
+{
+	GuardedDownloadQueue downloadQueue = DownloadQueue::Guard();
+	LockProfile* lockProfile = downloadQueue->GetLockProfile();
+	if (lockProfile)
+	{
+		lockProfile->Reset();
+	}
+
+	BuildBoolResponse(lockProfile != nullptr);
+}
+
 // struct[] loadlog(nzbid, logidfrom, logentries)
 void LoadLogXmlCommand::Execute()
 {
@@ -3257,8 +3609,7 @@ void LoadLogXmlCommand::Execute()
 
 GuardedMessageList LoadLogXmlCommand::GuardMessages()
 {
-	// TODO: optimize for m_iIDFrom and m_iNrEntries
-	g_DiskState->LoadNzbMessages(m_nzbId, &m_messages);
+	g_DiskState->LoadNzbMessages(m_nzbId, &m_messages, m_idFrom, m_nrEntries);
 
 	if (m_messages.empty())
 	{
@@ -3268,7 +3619,7 @@ GuardedMessageList LoadLogXmlCommand::GuardMessages()
 		// which will be released later in LoadLogXmlCommand::Execute().
 
 		m_downloadQueue = std::make_unique<GuardedDownloadQueue>(DownloadQueue::Guard());
-		m_nzbInfo = (*m_downloadQueue)->GetQueue()->Find(m_nzbId);
+		m_nzbInfo = (*m_downloadQueue)->FindNzb(m_nzbId);
 		if (m_nzbInfo)
 		{
 			return m_nzbInfo->GuardCachedMessages();
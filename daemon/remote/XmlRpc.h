@@ -56,7 +56,11 @@ public:
 	void SetUserAccess(EUserAccess userAccess) { m_userAccess = userAccess; }
 	void SetUrl(const char* url);
 	void SetRequest(char* request) { m_request = request; }
-	const char* GetResponse() { return m_response; }
+	void SetResponseBuffer(StringBuilder* response) { m_response = response; }
+	const char* GetResponseHeader() { return m_responseHeader; }
+	const char* GetResponse() { return *m_response; }
+	int GetResponseLen() { return m_response->Length(); }
+	const char* GetResponseFooter() { return m_responseFooter; }
 	const char* GetContentType() { return m_contentType; }
 	static bool IsRpcRequest(const char* url);
 	bool IsSafeMethod() { return m_safeMethod; };
@@ -68,13 +72,16 @@ private:
 	EHttpMethod m_httpMethod = hmPost;
 	EUserAccess m_userAccess;
 	CString m_url;
-	StringBuilder m_response;
+	StringBuilder m_ownResponse;
+	StringBuilder* m_response = &m_ownResponse;
+	StringBuilder m_responseHeader;
+	BString<100> m_responseFooter;
 	bool m_safeMethod = false;
 
 	void Dispatch();
 	std::unique_ptr<XmlCommand> CreateCommand(const char* methodName);
 	void MutliCall();
-	void BuildResponse(const char* response, const char* callbackFunc, bool fault, const char* requestId);
+	void BuildResponse(const char* callbackFunc, bool fault, const char* requestId);
 	void BuildErrorResponse(int errCode, const char* errText);
 };
 
@@ -89,7 +96,8 @@ public:
 	void SetProtocol(XmlRpcProcessor::ERpcProtocol protocol) { m_protocol = protocol; }
 	void SetHttpMethod(XmlRpcProcessor::EHttpMethod httpMethod) { m_httpMethod = httpMethod; }
 	void SetUserAccess(XmlRpcProcessor::EUserAccess userAccess) { m_userAccess = userAccess; }
-	const char* GetResponse() { return m_response; }
+	void SetResponseBuffer(StringBuilder* response) { m_response = response; }
+	const char* GetResponse() { return *m_response; }
 	const char* GetCallbackFunc() { return m_callbackFunc; }
 	bool GetFault() { return m_fault; }
 	virtual bool IsSafeMethod() { return false; };
@@ -99,7 +107,9 @@ protected:
 	char* m_request = nullptr;
 	char* m_requestPtr = nullptr;
 	char* m_callbackFunc = nullptr;
-	StringBuilder m_response;
+	StringBuilder m_ownResponse;
+	StringBuilder* m_response = &m_ownResponse;
+	StringPool m_encodePool;
 	bool m_fault = false;
 	XmlRpcProcessor::ERpcProtocol m_protocol = XmlRpcProcessor::rpUndefined;
 	XmlRpcProcessor::EHttpMethod m_httpMethod;
@@ -111,13 +121,14 @@ protected:
 	void AppendResponse(const char* part);
 	void AppendFmtResponse(const char* format, ...);
 	void AppendCondResponse(const char* part, bool cond);
+	void AppendEncodedResponse(const char* str);
 	bool IsJson();
 	bool NextParamAsInt(int* value);
 	bool NextParamAsBool(bool* value);
 	bool NextParamAsStr(char** valueBuf);
 	char* XmlNextValue(char* xml, const char* tag, int* valueLength);
 	const char* BoolToStr(bool value);
-	CString EncodeStr(const char* str);
+	const char* EncodeStr(const char* str);
 	void DecodeStr(char* str);
 };
 
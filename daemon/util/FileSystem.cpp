@@ -483,14 +483,7 @@ bool FileSystem::CopyFile(const char* srcFilename, const char* dstFilename)
 		return false;
 	}
 
-	CharBuffer buffer(1024 * 50);
-
-	int cnt = buffer.Size();
-	while (cnt == buffer.Size())
-	{
-		cnt = (int)infile.Read(buffer, buffer.Size());
-		outfile.Write(buffer, cnt);
-	}
+	outfile.CopyFrom(infile);
 
 	infile.Close();
 	outfile.Close();
@@ -663,6 +656,69 @@ int64 FileSystem::FileSize(const char* filename)
 #endif
 }
 
+void FileSystem::WillNeed(const char* filename, int64 headSize, int64 tailSize)
+{
+#ifdef POSIX_FADV_WILLNEED
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1)
+	{
+		return;
+	}
+
+	struct stat buffer;
+	if (!fstat(fd, &buffer))
+	{
+		posix_fadvise(fd, 0, headSize, POSIX_FADV_WILLNEED);
+		if (tailSize > 0 && buffer.st_size > headSize)
+		{
+			int64 tailStart = buffer.st_size > tailSize ? buffer.st_size - tailSize : 0;
+			posix_fadvise(fd, tailStart, buffer.st_size - tailStart, POSIX_FADV_WILLNEED);
+		}
+	}
+
+	// the read ahead started by the hint isn't cancelled when the file is closed
+	close(fd);
+#endif
+}
+
+/* Returns modification stamp of the file or -1 if the file doesn't exist.
+ * The unit of the stamp is platform specific, the value is suitable only for comparing.
+ * The size of the file is returned in "size" (if not null) from the same call to the OS. */
+int64 FileSystem::FileTime(const char* filename, int64* size)
+{
+#ifdef WIN32
+	WIN32_FIND_DATAW findData;
+	HANDLE handle = FindFirstFileW(UtfPathToWidePath(filename), &findData);
+	if (handle != INVALID_HANDLE_VALUE)
+	{
+		int64 stamp = ((int64)(findData.ftLastWriteTime.dwHighDateTime) << 32) + findData.ftLastWriteTime.dwLowDateTime;
+		if (size)
+		{
+			*size = ((int64)(findData.nFileSizeHigh) << 32) + findData.nFileSizeLow;
+		}
+		FindClose(handle);
+		return stamp;
+	}
+	return -1;
+#else
+	struct stat buffer;
+	if (stat(filename, &buffer))
+	{
+		return -1;
+	}
+	if (size)
+	{
+		*size = buffer.st_size;
+	}
+	// with nanoseconds: files rewritten within the same second must have different stamps
+#ifdef __APPLE__
+	return (int64)buffer.st_mtimespec.tv_sec * 1000000000 + buffer.st_mtimespec.tv_nsec;
+#else
+	return (int64)buffer.st_mtim.tv_sec * 1000000000 + buffer.st_mtim.tv_nsec;
+#endif
+#endif
+}
+
 int64 FileSystem::FreeDiskSize(const char* path)
 {
 #ifdef WIN32
@@ -1224,3 +1280,136 @@ bool DiskFile::Sync(CString& errmsg)
 	return FileSystem::FlushFileBuffers(fileno(m_file), errmsg);
 }
 
+/*
+ * Copies data from the current position of "infile" to the current position of this file;
+ * "size" -1 copies until the end of "infile". Returns the number of copied bytes.
+ * If possible the data is copied by the kernel without passing it through user space;
+ * file systems supporting reflinks (btrfs, XFS) may even share the data blocks.
+ * Otherwise (or if the kernel copy fails) the data is copied via buffer.
+ */
+int64 DiskFile::CopyFrom(DiskFile& infile, int64 size)
+{
+	int64 copied = 0;
+
+#ifdef HAVE_COPY_FILE_RANGE
+	static const int64 COPY_CHUNK = 256 * 1024 * 1024;
+
+	if (Flush())
+	{
+		loff_t inOffset = infile.Position();
+		loff_t outOffset = Position();
+		bool eof = false;
+		while (size < 0 || copied < size)
+		{
+			ssize_t cnt = copy_file_range(fileno(infile.m_file), &inOffset, fileno(m_file), &outOffset,
+				(size_t)(size < 0 ? COPY_CHUNK : std::min(size - copied, COPY_CHUNK)), 0);
+			if (cnt <= 0)
+			{
+				// on error (not supported by kernel or file system, or cross-device copy)
+				// continue with buffered copy. Some kernels return 0 instead of an error for
+				// unsupported files (such as in procfs), therefore end of file is only
+				// trusted after something was copied.
+				eof = cnt == 0 && copied > 0;
+				break;
+			}
+			copied += cnt;
+		}
+
+		// copy_file_range doesn't update file positions if offsets are passed
+		infile.Seek(inOffset);
+		Seek(outOffset);
+
+		if (eof || copied == size)
+		{
+			return copied;
+		}
+	}
+#endif
+
+	CharBuffer buffer(1024 * 64);
+	while (size < 0 || copied < size)
+	{
+		int64 cnt = infile.Read(buffer, size < 0 ? buffer.Size() : std::min(size - copied, (int64)buffer.Size()));
+		if (cnt <= 0 || Write(buffer, cnt) != cnt)
+		{
+			break;
+		}
+		copied += cnt;
+	}
+
+	return copied;
+}
+
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef WIN32
+	if (!FileSystem::LoadFileIntoBuffer(filename, m_buffer, false))
+	{
+		return false;
+	}
+	m_data = m_buffer;
+	m_size = m_buffer.Size();
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	struct stat buffer;
+	if (fstat(fd, &buffer) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	m_size = buffer.st_size;
+	if (m_size == 0)
+	{
+		// empty files can't be mapped
+		m_data = "";
+		close(fd);
+		return true;
+	}
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		m_size = 0;
+		return false;
+	}
+
+#ifdef MADV_SEQUENTIAL
+	madvise(data, m_size, MADV_SEQUENTIAL);
+#endif
+
+	m_data = (const char*)data;
+	m_mapped = true;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef WIN32
+	m_buffer.Clear();
+#else
+	if (m_mapped)
+	{
+		munmap((void*)m_data, m_size);
+		m_mapped = false;
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -55,7 +55,11 @@ public:
 	static CString GetCurrentDirectory();
 	static bool SetCurrentDirectory(const char* dirFilename);
 	static int64 FileSize(const char* filename);
+	static int64 FileTime(const char* filename, int64* size = nullptr);
 	static int64 FreeDiskSize(const char* path);
+
+	/* Ask the OS to read ahead the beginning and the end of the file */
+	static void WillNeed(const char* filename, int64 headSize, int64 tailSize);
 	static bool DirEmpty(const char* dirFilename);
 	static bool RenameBak(const char* filename, const char* bakPart, bool removeOldExtension, CString& newName);
 #ifndef WIN32
@@ -148,9 +152,35 @@ public:
 	bool SetWriteBuffer(int size);
 	bool Flush();
 	bool Sync(CString& errmsg);
+	int64 CopyFrom(DiskFile& infile, int64 size = -1);
 
 private:
 	FILE* m_file = nullptr;
 };
 
+/*
+Read-only view of a whole file. The file is mapped into memory if the
+platform supports it, otherwise it is loaded into a buffer.
+ */
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	~MappedFile();
+	bool Open(const char* filename);
+	void Close();
+	const char* GetData() { return m_data; }
+	int64 GetSize() { return m_size; }
+
+private:
+	const char* m_data = nullptr;
+	int64 m_size = 0;
+#ifdef WIN32
+	CharBuffer m_buffer;
+#else
+	bool m_mapped = false;
+#endif
+};
+
 #endif
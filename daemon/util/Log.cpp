@@ -35,6 +35,16 @@ Log::Log()
 
 Log::~Log()
 {
+	if (m_writer)
+	{
+		// let the writer save all queued lines
+		m_writer->Stop();
+		while (m_writer->IsRunning())
+		{
+			Util::Sleep(10);
+		}
+	}
+
 	g_Log = nullptr;
 }
 
@@ -53,7 +63,7 @@ void Log::LogDebugInfo()
 	info("--------------------------------------------");
 }
 
-void Log::Filelog(const char* msg, ...)
+void Log::Filelog(Message::EKind kind, const char* msg, ...)
 {
 	if (m_logFilename.Empty())
 	{
@@ -84,6 +94,43 @@ void Log::Filelog(const char* msg, ...)
 
 	m_lastWritten = rawtime;
 
+	char line[1200];
+#ifdef DEBUG
+#ifdef WIN32
+	uint64 processId = GetCurrentProcessId();
+	uint64 threadId = GetCurrentThreadId();
+#else
+	uint64 processId = (uint64)getpid();
+	uint64 threadId = (uint64)pthread_self();
+#endif
+	snprintf(line, sizeof(line), "%s\t%" PRIu64 "\t%" PRIu64 "\t%s%s", time, processId, threadId, tmp2, LINE_ENDING);
+#else
+	snprintf(line, sizeof(line), "%s\t%s%s", time, tmp2, LINE_ENDING);
+#endif
+	line[sizeof(line)-1] = '\0';
+
+	if (m_writer)
+	{
+		int dropped = m_writer->TakeDropped();
+		if (dropped > 0)
+		{
+			BString<1024> warning("%s\tWARNING\t%i log messages were not written due to overload%s",
+				time, dropped, LINE_ENDING);
+			m_writer->Append(m_logFilename, Message::mkWarning, warning, false);
+		}
+
+		if (kind == Message::mkError)
+		{
+			// errors must be on disk even if the program terminates right after them
+			m_writer->Write(m_logFilename, line);
+		}
+		else
+		{
+			m_writer->Append(m_logFilename, kind, line, false);
+		}
+		return;
+	}
+
 	if (!m_logFile)
 	{
 		m_logFile = std::make_unique<DiskFile>();
@@ -96,21 +143,57 @@ void Log::Filelog(const char* msg, ...)
 	}
 
 	m_logFile->Seek(0, DiskFile::soEnd);
+	m_logFile->Write(line, strlen(line));
+	m_logFile->Flush();
+}
 
-#ifdef DEBUG
-#ifdef WIN32
-	uint64 processId = GetCurrentProcessId();
-	uint64 threadId = GetCurrentThreadId();
-#else
-	uint64 processId = (uint64)getpid();
-	uint64 threadId = (uint64)pthread_self();
-#endif
-	m_logFile->Print("%s\t%" PRIu64 "\t%" PRIu64 "\t%s%s", time, processId, threadId, tmp2, LINE_ENDING);
-#else
-	m_logFile->Print("%s\t%s%s", time, tmp2, LINE_ENDING);
-#endif
+void Log::StartWriter()
+{
+	if (m_writer)
+	{
+		return;
+	}
 
-	m_logFile->Flush();
+	std::unique_ptr<LogWriter> writer = std::make_unique<LogWriter>();
+	writer->Start();
+
+	Guard guard(m_logMutex);
+	m_writer = std::move(writer);
+	m_logFile.reset();
+}
+
+void Log::AppendFile(const char* filename, Message::EKind kind, const char* line)
+{
+	if (m_writer)
+	{
+		m_writer->Append(filename, kind, line, true);
+		return;
+	}
+
+	DiskFile file;
+	if (!file.Open(filename, DiskFile::omAppend))
+	{
+		error("Error saving log: Could not create file %s", filename);
+		return;
+	}
+
+	file.Write(line, strlen(line));
+}
+
+void Log::FlushFiles()
+{
+	if (m_writer)
+	{
+		m_writer->Flush();
+	}
+}
+
+void Log::CloseFile(const char* filename)
+{
+	if (m_writer)
+	{
+		m_writer->CloseFile(filename);
+	}
 }
 
 void Log::IntervalCheck()
@@ -176,7 +259,7 @@ void debug(const char* msg, ...)
 	}
 	if (messageTarget == Options::mtLog || messageTarget == Options::mtBoth)
 	{
-		g_Log->Filelog("DEBUG\t%s", *tmp2);
+		g_Log->Filelog(Message::mkDebug, "DEBUG\t%s", *tmp2);
 	}
 }
 #endif
@@ -200,7 +283,7 @@ void error(const char* msg, ...)
 	}
 	if (messageTarget == Options::mtLog || messageTarget == Options::mtBoth)
 	{
-		g_Log->Filelog("ERROR\t%s", tmp2);
+		g_Log->Filelog(Message::mkError, "ERROR\t%s", tmp2);
 	}
 }
 
@@ -223,7 +306,7 @@ void warn(const char* msg, ...)
 	}
 	if (messageTarget == Options::mtLog || messageTarget == Options::mtBoth)
 	{
-		g_Log->Filelog("WARNING\t%s", tmp2);
+		g_Log->Filelog(Message::mkWarning, "WARNING\t%s", tmp2);
 	}
 }
 
@@ -246,7 +329,7 @@ void info(const char* msg, ...)
 	}
 	if (messageTarget == Options::mtLog || messageTarget == Options::mtBoth)
 	{
-		g_Log->Filelog("INFO\t%s", tmp2);
+		g_Log->Filelog(Message::mkInfo, "INFO\t%s", tmp2);
 	}
 }
 
@@ -269,7 +352,7 @@ void detail(const char* msg, ...)
 	}
 	if (messageTarget == Options::mtLog || messageTarget == Options::mtBoth)
 	{
-		g_Log->Filelog("DETAIL\t%s", tmp2);
+		g_Log->Filelog(Message::mkDetail, "DETAIL\t%s", tmp2);
 	}
 }
 
@@ -406,7 +489,7 @@ void Log::InitOptions()
 
 		if (target == Options::mtLog || target == Options::mtBoth)
 		{
-			Filelog("%s\t%s", messageType[message.GetKind()], message.GetText());
+			Filelog(message.GetKind(), "%s\t%s", messageType[message.GetKind()], message.GetText());
 		}
 
 		if (target == Options::mtLog || target == Options::mtNone)
@@ -434,3 +517,223 @@ void Log::UnregisterDebuggable(Debuggable* debuggable)
 	Guard guard(m_debugMutex);
 	m_debuggables.remove(debuggable);
 }
+
+
+LogWriter::LogWriter(int capacity) : m_capacity(capacity)
+{
+}
+
+LogWriter::~LogWriter()
+{
+}
+
+void LogWriter::Append(const char* filename, Message::EKind kind, const char* line, bool reportErrors)
+{
+	{
+		Guard guard(m_queueMutex);
+
+		if ((int)m_queue.size() >= m_capacity && (kind == Message::mkDetail || kind == Message::mkDebug))
+		{
+			m_dropped++;
+			return;
+		}
+
+		m_queue.emplace_back(filename, line, reportErrors);
+		m_queued++;
+	}
+
+	m_queueCond.NotifyOne();
+}
+
+void LogWriter::Write(const char* filename, const char* line)
+{
+	Lines lines;
+
+	// the lock on files prevents the writer thread from taking the queue until
+	// the line is written
+	Guard filesGuard(m_filesMutex);
+
+	{
+		Guard guard(m_queueMutex);
+		Lines otherLines;
+		for (Line& queuedLine : m_queue)
+		{
+			(!strcmp(queuedLine.m_filename, filename) ? lines : otherLines).push_back(std::move(queuedLine));
+		}
+		m_queue.swap(otherLines);
+		m_written += lines.size();
+	}
+	m_writtenCond.NotifyAll();
+
+	lines.emplace_back(filename, line, false);
+
+	// errors of the log-file itself are not reported into the log
+	std::vector<CString> failedFiles;
+	WriteLines(lines, Util::CurrentTime(), failedFiles);
+}
+
+void LogWriter::Flush()
+{
+	Guard guard(m_queueMutex);
+	int64 queued = m_queued;
+	m_queueCond.NotifyOne();
+	m_writtenCond.Wait(m_queueMutex, [&]{ return m_written >= queued || !IsRunning(); });
+}
+
+void LogWriter::CloseFile(const char* filename)
+{
+	Flush();
+
+	Guard guard(m_filesMutex);
+	m_files.erase(std::remove_if(m_files.begin(), m_files.end(),
+		[filename](OpenFile& openFile)
+		{
+			return !strcmp(openFile.m_filename, filename);
+		}),
+		m_files.end());
+}
+
+int LogWriter::TakeDropped()
+{
+	Guard guard(m_queueMutex);
+	int dropped = m_dropped;
+	m_dropped = 0;
+	return dropped;
+}
+
+void LogWriter::Stop()
+{
+	Thread::Stop();
+	Guard guard(m_queueMutex);
+	m_queueCond.NotifyAll();
+}
+
+void LogWriter::Run()
+{
+	while (true)
+	{
+		{
+			Guard guard(m_queueMutex);
+			m_queueCond.WaitFor(m_queueMutex, 1000, [&]{ return !m_queue.empty() || IsStopped(); });
+		}
+
+		int written = WriteQueue();
+
+		// keep going until all lines queued before stopping are written
+		if (written == 0 && IsStopped())
+		{
+			break;
+		}
+	}
+
+	Guard guard(m_filesMutex);
+	CloseIdleFiles(0, true);
+}
+
+int LogWriter::WriteQueue()
+{
+	time_t curTime = Util::CurrentTime();
+	Lines batch;
+	std::vector<CString> failedFiles;
+
+	{
+		Guard filesGuard(m_filesMutex);
+
+		{
+			Guard guard(m_queueMutex);
+			batch.swap(m_queue);
+		}
+
+		WriteLines(batch, curTime, failedFiles);
+		CloseIdleFiles(curTime, false);
+
+		Guard guard(m_queueMutex);
+		m_written += batch.size();
+	}
+
+	m_writtenCond.NotifyAll();
+
+	// reported after releasing the lock on files since errors are written synchronously
+	for (CString& filename : failedFiles)
+	{
+		error("Error saving log: Could not create file %s", *filename);
+	}
+
+	return (int)batch.size();
+}
+
+void LogWriter::WriteLines(Lines& lines, time_t curTime, std::vector<CString>& failedFiles)
+{
+	for (Line& line : lines)
+	{
+		DiskFile* file = GetFile(line, curTime, failedFiles);
+		if (file)
+		{
+			file->Write(line.m_text, strlen(line.m_text));
+		}
+	}
+
+	for (OpenFile& openFile : m_files)
+	{
+		if (openFile.m_dirty)
+		{
+			openFile.m_file->Flush();
+			openFile.m_dirty = false;
+		}
+	}
+}
+
+DiskFile* LogWriter::GetFile(Line& line, time_t curTime, std::vector<CString>& failedFiles)
+{
+	OpenFiles::iterator pos = std::find_if(m_files.begin(), m_files.end(),
+		[&line](OpenFile& openFile)
+		{
+			return !strcmp(openFile.m_filename, line.m_filename);
+		});
+
+	if (pos == m_files.end())
+	{
+		std::unique_ptr<DiskFile> file = std::make_unique<DiskFile>();
+		if (!file->Open(line.m_filename, DiskFile::omAppend))
+		{
+			if (line.m_reportErrors)
+			{
+				failedFiles.push_back(std::move(line.m_filename));
+			}
+			else
+			{
+				perror(line.m_filename);
+			}
+			return nullptr;
+		}
+
+		if ((int)m_files.size() >= MAX_OPEN_FILES)
+		{
+			// close the least recently used file
+			m_files.erase(std::min_element(m_files.begin(), m_files.end(),
+				[](OpenFile& file1, OpenFile& file2)
+				{
+					return file1.m_lastUsed < file2.m_lastUsed;
+				}));
+		}
+
+		m_files.push_back({std::move(line.m_filename), std::move(file), curTime, false});
+		pos = m_files.end() - 1;
+	}
+
+	pos->m_lastUsed = curTime;
+	pos->m_dirty = true;
+	return pos->m_file.get();
+}
+
+void LogWriter::CloseIdleFiles(time_t curTime, bool all)
+{
+	// files not written for more than a second are closed to allow other programs
+	// to rotate or delete them
+	m_files.erase(std::remove_if(m_files.begin(), m_files.end(),
+		[curTime, all](OpenFile& openFile)
+		{
+			return all || std::abs(curTime - openFile.m_lastUsed) > 1;
+		}),
+		m_files.end());
+}
@@ -72,6 +72,72 @@ typedef GuardedPtr<MessageList> GuardedMessageList;
 class Debuggable;
 class DiskFile;
 
+/*
+ * Appends lines to log-files in a background thread.
+ * Logging threads only put lines into a bounded queue, the writer takes them
+ * in batches, keeps recently used files open and flushes each file once per batch.
+ * When the queue is full detail and debug lines are dropped; other lines are
+ * always queued.
+ * Lines passed to Write are written by the calling thread immediately, after
+ * the lines of the same file still waiting in the queue.
+ */
+class LogWriter : public Thread
+{
+public:
+	static const int QUEUE_CAPACITY = 10000;
+	static const int MAX_OPEN_FILES = 16;
+
+	LogWriter(int capacity = QUEUE_CAPACITY);
+	~LogWriter();
+	void Append(const char* filename, Message::EKind kind, const char* line, bool reportErrors);
+	void Write(const char* filename, const char* line);
+	void Flush();
+	void CloseFile(const char* filename);
+	int TakeDropped();
+	virtual void Stop();
+
+protected:
+	virtual void Run();
+
+private:
+	struct Line
+	{
+		CString m_filename;
+		CString m_text;
+		bool m_reportErrors;
+
+		Line(const char* filename, const char* text, bool reportErrors) :
+			m_filename(filename), m_text(text), m_reportErrors(reportErrors) {}
+	};
+
+	struct OpenFile
+	{
+		CString m_filename;
+		std::unique_ptr<DiskFile> m_file;
+		time_t m_lastUsed;
+		bool m_dirty;
+	};
+
+	typedef std::vector<Line> Lines;
+	typedef std::vector<OpenFile> OpenFiles;
+
+	int m_capacity;
+	Lines m_queue;
+	Mutex m_queueMutex;
+	ConditionVar m_queueCond;
+	ConditionVar m_writtenCond;
+	int64 m_queued = 0;
+	int64 m_written = 0;
+	int m_dropped = 0;
+	OpenFiles m_files;
+	Mutex m_filesMutex;
+
+	int WriteQueue();
+	void WriteLines(Lines& lines, time_t curTime, std::vector<CString>& failedFiles);
+	DiskFile* GetFile(Line& line, time_t curTime, std::vector<CString>& failedFiles);
+	void CloseIdleFiles(time_t curTime, bool all);
+};
+
 class Log
 {
 public:
@@ -85,6 +151,10 @@ public:
 	void UnregisterDebuggable(Debuggable* debuggable);
 	void LogDebugInfo();
 	void IntervalCheck();
+	void StartWriter();
+	void AppendFile(const char* filename, Message::EKind kind, const char* line);
+	void FlushFiles();
+	void CloseFile(const char* filename);
 
 private:
 	typedef std::list<Debuggable*> Debuggables;
@@ -95,6 +165,7 @@ private:
 	Mutex m_debugMutex;
 	CString m_logFilename;
 	std::unique_ptr<DiskFile> m_logFile;
+	std::unique_ptr<LogWriter> m_writer;
 	uint32 m_idGen = 0;
 	time_t m_lastWritten = 0;
 	bool m_optInit = false;
@@ -102,7 +173,7 @@ private:
 	bool m_extraDebug;
 #endif
 
-	void Filelog(const char* msg, ...) PRINTF_SYNTAX(2);
+	void Filelog(Message::EKind kind, const char* msg, ...) PRINTF_SYNTAX(3);
 	void AddMessage(Message::EKind kind, const char* text);
 	void RotateLog();
 
@@ -401,3 +401,54 @@ void StringBuilder::AppendFmtV(const char* format, va_list ap)
 template class BString<1024>;
 template class BString<100>;
 template class BString<20>;
+
+const char* StringPool::Add(const char* str, int len)
+{
+	if (len == 0)
+	{
+		len = strlen(str);
+	}
+
+	char* data = Allocate(len + 1);
+	memcpy(data, str, len);
+	data[len] = '\0';
+
+	return data;
+}
+
+char* StringPool::Allocate(int size)
+{
+	if (m_blocks.empty() || m_blockUsed + size > m_blockSize)
+	{
+		// blocks grow up to 64 KB, larger strings get own blocks
+		NewBlock(std::max(size, std::min(m_blockSize * 2, 64 * 1024)));
+	}
+
+	char* data = m_blocks.back().get() + m_blockUsed;
+	m_blockUsed += size;
+
+	return data;
+}
+
+void StringPool::Reserve(int size)
+{
+	if (m_blocks.empty() || m_blockUsed + size > m_blockSize)
+	{
+		NewBlock(size);
+	}
+}
+
+void StringPool::Clear()
+{
+	m_blocks.clear();
+	m_blockSize = 0;
+	m_blockUsed = 0;
+}
+
+void StringPool::NewBlock(int size)
+{
+	size = std::max(size, 256);
+	m_blocks.emplace_back(new char[size]);
+	m_blockSize = size;
+	m_blockUsed = 0;
+}
@@ -162,6 +162,29 @@ protected:
 	int m_size = 0;
 };
 
+/*
+Pool for many small strings having the same lifetime. The strings are stored
+in large blocks without memory overhead per string; the pointers returned by
+"Add" remain valid until the pool is cleared.
+ */
+class StringPool
+{
+public:
+	const char* Add(const char* str, int len = 0);
+	char* Allocate(int size);
+	void Reserve(int size);
+	void Clear();
+
+private:
+	typedef std::vector<std::unique_ptr<char[]>> Blocks;
+
+	Blocks m_blocks;
+	int m_blockSize = 0;
+	int m_blockUsed = 0;
+
+	void NewBlock(int size);
+};
+
 #ifdef DEBUG
 // helper declarations to identify incorrect calls to "free" at compile time
 #ifdef WIN32
@@ -0,0 +1,285 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+#include "PerfStats.h"
+#include "Thread.h"
+
+static const int MAX_EXPONENT = 40;
+static const int BUCKET_COUNT = MAX_EXPONENT * 4;
+
+static const char* METRIC_NAMES[PerfStats::METRIC_COUNT] =
+{
+	"queue_next_article",
+	"queue_lock_wait",
+	"queue_lock_hold",
+	"decode",
+	"article_write",
+	"cache_flush",
+	"state_save",
+	"rpc_command"
+};
+
+static int BucketIndex(int64 value)
+{
+	if (value < 4)
+	{
+		return value < 0 ? 0 : (int)value;
+	}
+
+#ifdef __GNUC__
+	int exponent = 63 - __builtin_clzll((uint64)value);
+#else
+	int exponent = 2;
+	while ((value >> (exponent + 1)) != 0)
+	{
+		exponent++;
+	}
+#endif
+
+	if (exponent > MAX_EXPONENT)
+	{
+		return BUCKET_COUNT - 1;
+	}
+
+	return (exponent - 1) * 4 + (int)((value >> (exponent - 2)) & 3);
+}
+
+static int64 BucketUpperBound(int index)
+{
+	if (index < 4)
+	{
+		return index;
+	}
+
+	int exponent = index / 4 + 1;
+	return ((int64)(5 + index % 4) << (exponent - 2)) - 1;
+}
+
+struct HistogramTotals
+{
+	uint64 buckets[BUCKET_COUNT] = {};
+	int64 total = 0;
+	int64 max = 0;
+};
+
+/*
+ * Each histogram has only one writer (its thread), which updates the counters
+ * without atomic read-modify-write operations. Readers may see a slightly
+ * outdated state but never torn values.
+ */
+class Histogram
+{
+public:
+	Histogram();
+	void Add(int64 value);
+	void AddTo(HistogramTotals& totals);
+
+private:
+	std::atomic<uint64> m_buckets[BUCKET_COUNT];
+	std::atomic<int64> m_total;
+	std::atomic<int64> m_max;
+};
+
+Histogram::Histogram()
+{
+	for (std::atomic<uint64>& bucket : m_buckets)
+	{
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	m_total.store(0, std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+void Histogram::Add(int64 value)
+{
+	std::atomic<uint64>& bucket = m_buckets[BucketIndex(value)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	m_total.store(m_total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	if (value > m_max.load(std::memory_order_relaxed))
+	{
+		m_max.store(value, std::memory_order_relaxed);
+	}
+}
+
+void Histogram::AddTo(HistogramTotals& totals)
+{
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		totals.buckets[i] += m_buckets[i].load(std::memory_order_relaxed);
+	}
+	totals.total += m_total.load(std::memory_order_relaxed);
+	totals.max = std::max(totals.max, m_max.load(std::memory_order_relaxed));
+}
+
+class ThreadHistograms;
+
+struct PerfRegistry
+{
+	Mutex mutex;
+	std::vector<ThreadHistograms*> threads;
+	HistogramTotals finished[PerfStats::METRIC_COUNT];
+};
+
+// never destroyed: threads may still record or finish during program exit
+static PerfRegistry* Registry()
+{
+	static PerfRegistry* registry = new PerfRegistry();
+	return registry;
+}
+
+/*
+ * Histograms of one thread, allocated on first use of each metric.
+ * The thread registers itself on first use and moves its counters into
+ * the common totals when it ends.
+ */
+class ThreadHistograms
+{
+public:
+	ThreadHistograms();
+	~ThreadHistograms();
+	Histogram* Get(PerfStats::EMetric metric);
+	void AddTo(HistogramTotals* totals);
+
+private:
+	std::atomic<Histogram*> m_histograms[PerfStats::METRIC_COUNT];
+};
+
+ThreadHistograms::ThreadHistograms()
+{
+	for (std::atomic<Histogram*>& histogram : m_histograms)
+	{
+		histogram.store(nullptr, std::memory_order_relaxed);
+	}
+
+	PerfRegistry* registry = Registry();
+	Guard guard(registry->mutex);
+	registry->threads.push_back(this);
+}
+
+ThreadHistograms::~ThreadHistograms()
+{
+	PerfRegistry* registry = Registry();
+	{
+		Guard guard(registry->mutex);
+		registry->threads.erase(std::find(registry->threads.begin(), registry->threads.end(), this));
+		AddTo(registry->finished);
+	}
+
+	for (std::atomic<Histogram*>& histogram : m_histograms)
+	{
+		delete histogram.load(std::memory_order_relaxed);
+	}
+}
+
+Histogram* ThreadHistograms::Get(PerfStats::EMetric metric)
+{
+	Histogram* histogram = m_histograms[metric].load(std::memory_order_relaxed);
+	if (!histogram)
+	{
+		histogram = new Histogram();
+		m_histograms[metric].store(histogram, std::memory_order_release);
+	}
+	return histogram;
+}
+
+void ThreadHistograms::AddTo(HistogramTotals* totals)
+{
+	for (int i = 0; i < PerfStats::METRIC_COUNT; i++)
+	{
+		if (Histogram* histogram = m_histograms[i].load(std::memory_order_acquire))
+		{
+			histogram->AddTo(totals[i]);
+		}
+	}
+}
+
+static thread_local ThreadHistograms g_ThreadHistograms;
+
+int64 PerfStats::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64 PerfStats::Record(EMetric metric, int64 start)
+{
+	int64 now = Now();
+	Add(metric, now - start);
+	return now;
+}
+
+void PerfStats::Add(EMetric metric, int64 duration)
+{
+	g_ThreadHistograms.Get(metric)->Add(duration);
+}
+
+const char* PerfStats::GetName(EMetric metric)
+{
+	return METRIC_NAMES[metric];
+}
+
+static int64 Percentile(const HistogramTotals& totals, int64 count, int permille)
+{
+	int64 rank = (count * permille + 999) / 1000;
+	int64 seen = 0;
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		seen += totals.buckets[i];
+		if (seen >= rank)
+		{
+			return std::min(BucketUpperBound(i), totals.max);
+		}
+	}
+	return totals.max;
+}
+
+PerfStats::SummaryList PerfStats::Collect()
+{
+	HistogramTotals totals[METRIC_COUNT];
+
+	{
+		PerfRegistry* registry = Registry();
+		Guard guard(registry->mutex);
+		for (int i = 0; i < METRIC_COUNT; i++)
+		{
+			totals[i] = registry->finished[i];
+		}
+		for (ThreadHistograms* threadHistograms : registry->threads)
+		{
+			threadHistograms->AddTo(totals);
+		}
+	}
+
+	SummaryList summaries;
+	for (int i = 0; i < METRIC_COUNT; i++)
+	{
+		int64 count = 0;
+		for (uint64 bucket : totals[i].buckets)
+		{
+			count += bucket;
+		}
+
+		summaries.push_back({METRIC_NAMES[i], count, totals[i].total,
+			Percentile(totals[i], count, 500), Percentile(totals[i], count, 990), totals[i].max});
+	}
+
+	return summaries;
+}
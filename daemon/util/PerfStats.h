@@ -0,0 +1,80 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+/*
+ * Always-on timing of hot paths.
+ * Durations are collected into log-linear histograms (four buckets per power
+ * of two, in nanoseconds) kept separately for each thread, so that recording
+ * doesn't need any locking. Histograms of finished threads are merged into
+ * a common one. Percentiles are estimated from bucket bounds with an error
+ * of at most 25%.
+ */
+class PerfStats
+{
+public:
+	enum EMetric
+	{
+		pmNextArticle,
+		pmQueueLockWait,
+		pmQueueLockHold,
+		pmDecode,
+		pmArticleWrite,
+		pmCacheFlush,
+		pmStateSave,
+		pmRpcCommand
+	};
+	static const int METRIC_COUNT = pmRpcCommand + 1;
+
+	struct Summary
+	{
+		const char* name;
+		int64 count;
+		int64 total;
+		int64 p50;
+		int64 p99;
+		int64 max;
+	};
+	typedef std::vector<Summary> SummaryList;
+
+	// monotonic time in nanoseconds
+	static int64 Now();
+	// records the time elapsed since "start" and returns the current time
+	static int64 Record(EMetric metric, int64 start);
+	static void Add(EMetric metric, int64 duration);
+	static SummaryList Collect();
+	static const char* GetName(EMetric metric);
+};
+
+class PerfTimer
+{
+public:
+	PerfTimer(PerfStats::EMetric metric) : m_metric(metric), m_start(PerfStats::Now()) {}
+	PerfTimer(const PerfTimer&) = delete;
+	~PerfTimer() { PerfStats::Record(m_metric, m_start); }
+
+private:
+	PerfStats::EMetric m_metric;
+	int64 m_start;
+};
+
+#endif
@@ -592,6 +592,32 @@ void ScriptController::StartProcess(int* pipein, int* pipeout)
 	}
 #endif
 
+#ifdef USE_POSIX_SPAWN
+	// posix_spawn doesn't copy page tables of the (potentially very large) parent
+	// process and doesn't need the child watchdog workaround required for fork.
+	pid_t pid = 0;
+	int err = SpawnProcess(&pid, script, workingDir, argdata, envdata, pin, pout);
+	if (err == EACCES)
+	{
+		PrintMessage(Message::mkWarning, "Fixing permissions for %s", script);
+		FileSystem::FixExecPermission(script);
+		err = SpawnProcess(&pid, script, workingDir, argdata, envdata, pin, pout);
+	}
+
+	if (err)
+	{
+		PrintMessage(Message::mkError, "Could not start %s: %s", script, strerror(err));
+		*pipein = -1;
+		close(pin[0]);
+		close(pin[1]);
+		if (m_needWrite)
+		{
+			close(pout[0]);
+			close(pout[1]);
+		}
+		return;
+	}
+#else
 	debug("forking");
 	pid_t pid = fork();
 
@@ -663,6 +689,7 @@ void ScriptController::StartProcess(int* pipein, int* pipeout)
 		fsync(1);
 		_exit(FORK_ERROR_EXIT_CODE);
 	}
+#endif
 
 	// continue the first instance
 	debug("forked");
@@ -679,6 +706,137 @@ void ScriptController::StartProcess(int* pipein, int* pipeout)
 #endif
 }
 
+#ifdef USE_POSIX_SPAWN
+int ScriptController::SpawnProcess(pid_t* pid, const char* script, const char* workingDir,
+	char* const* argdata, char* const* envdata, int* pin, int* pout)
+{
+	// posix_spawnp would search the program in PATH of this process, whereas execvp
+	// in the forked child used PATH of the child environment
+	CString filename;
+	if (!FindProgram(script, workingDir, envdata, filename))
+	{
+		return ENOENT;
+	}
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+
+	// make the pipeout to be the same as stdout and stderr
+	posix_spawn_file_actions_adddup2(&actions, pin[1], 1);
+	posix_spawn_file_actions_adddup2(&actions, pin[1], 2);
+	posix_spawn_file_actions_addclose(&actions, pin[0]);
+	posix_spawn_file_actions_addclose(&actions, pin[1]);
+
+	if (m_needWrite)
+	{
+		// make the pipein to be the same as stdin
+		posix_spawn_file_actions_adddup2(&actions, pout[0], 0);
+		posix_spawn_file_actions_addclose(&actions, pout[0]);
+		posix_spawn_file_actions_addclose(&actions, pout[1]);
+	}
+
+	// the forked child ignored chdir-errors, the spawned child would fail instead
+	if (FileSystem::DirectoryExists(workingDir))
+	{
+		posix_spawn_file_actions_addchdir_np(&actions, workingDir);
+	}
+
+	// create new process group (see Terminate() where it is used)
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+
+	int err = posix_spawn(pid, filename, &actions, &attr, argdata, envdata);
+
+	if (err == ENOEXEC)
+	{
+		// like execvp: executable files without "#!" are shell scripts
+		std::vector<char*> shellArgs;
+		shellArgs.push_back((char*)"/bin/sh");
+		shellArgs.push_back(filename);
+		for (char* const* arg = argdata + 1; *arg; arg++)
+		{
+			shellArgs.push_back(*arg);
+		}
+		shellArgs.push_back(nullptr);
+		err = posix_spawn(pid, "/bin/sh", &actions, &attr, shellArgs.data(), envdata);
+	}
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+
+	return err;
+}
+
+/*
+ * Locates the program the way execvp does, but using PATH from the given
+ * environment. Relative directories in PATH refer to the working directory of
+ * the child process. Programs specified with a path are returned as is.
+ * If only files without execute permission are found the first of them is
+ * returned, so that the start fails with EACCES like with execvp.
+ */
+bool ScriptController::FindProgram(const char* program, const char* workingDir,
+	char* const* envdata, CString& filename)
+{
+	if (strchr(program, '/'))
+	{
+		filename = program;
+		return true;
+	}
+
+	const char* path = "/bin:/usr/bin";
+	for (char* const* env = envdata; *env; env++)
+	{
+		if (!strncmp(*env, "PATH=", 5))
+		{
+			path = *env + 5;
+			break;
+		}
+	}
+
+	bool changeDir = FileSystem::DirectoryExists(workingDir);
+	CString notExecutable;
+	for (const char* dir = path; dir; )
+	{
+		const char* end = strchr(dir, ':');
+		int len = end ? (int)(end - dir) : strlen(dir);
+
+		// empty entry means current directory
+		BString<1024> directory;
+		directory.Set(len > 0 ? dir : ".", len > 0 ? len : 1);
+
+		BString<1024> candidate;
+		if (directory[0] != '/' && changeDir)
+		{
+			candidate.Format("%s/%s/%s", workingDir, *directory, program);
+		}
+		else
+		{
+			candidate.Format("%s/%s", *directory, program);
+		}
+
+		struct stat buffer;
+		if (!stat(candidate, &buffer) && S_ISREG(buffer.st_mode))
+		{
+			if (!access(candidate, X_OK))
+			{
+				filename = *candidate;
+				return true;
+			}
+			if (notExecutable.Empty())
+			{
+				notExecutable = *candidate;
+			}
+		}
+
+		dir = end ? end + 1 : nullptr;
+	}
+
+	filename = std::move(notExecutable);
+	return !filename.Empty();
+}
+#endif
+
 int ScriptController::WaitProcess()
 {
 #ifdef WIN32
@@ -85,6 +85,12 @@ protected:
 	void Write(const char* str);
 #ifdef WIN32
 	void BuildCommandLine(char* cmdLineBuf, int bufSize);
+#endif
+#ifdef USE_POSIX_SPAWN
+	int SpawnProcess(pid_t* pid, const char* script, const char* workingDir,
+		char* const* argdata, char* const* envdata, int* pin, int* pout);
+	static bool FindProgram(const char* program, const char* workingDir,
+		char* const* envdata, CString& filename);
 #endif
 	void UnregisterRunningScript();
 
@@ -21,11 +21,78 @@
 #include "nzbget.h"
 #include "Log.h"
 #include "Thread.h"
+#include "PerfStats.h"
 
 int Thread::m_threadCount = 1; // take the main program thread into account
 std::unique_ptr<Mutex> Thread::m_threadMutex;
 
 
+void Mutex::EnableProfiling()
+{
+	m_mutexObj.lock();
+	if (!m_profile)
+	{
+		m_profile = std::make_unique<LockProfile>();
+	}
+	m_profiling = true;
+	m_mutexObj.unlock();
+}
+
+void Mutex::ProfiledLock(const char* file, int line)
+{
+	int64 waitStart = PerfStats::Now();
+	m_mutexObj.lock();
+	int64 now = PerfStats::Now();
+
+	LockProfile::Site& site = m_profile->m_sites.emplace(std::make_pair(file, line),
+		LockProfile::Site{file, line, 0, 0, 0, 0, 0}).first->second;
+	site.count++;
+	site.waitTime += now - waitStart;
+	site.maxWait = std::max(site.maxWait, now - waitStart);
+
+	m_profile->m_holder = &site;
+	m_profile->m_lockTime = now;
+}
+
+void Mutex::ProfiledUnlock()
+{
+	// the mutex may have been locked before the profiling was enabled or without source location
+	LockProfile::Site* site = m_profile->m_holder;
+	if (site)
+	{
+		int64 holdTime = PerfStats::Now() - m_profile->m_lockTime;
+		site->holdTime += holdTime;
+		site->maxHold = std::max(site->maxHold, holdTime);
+		m_profile->m_holder = nullptr;
+	}
+}
+
+LockProfile::SiteList LockProfile::GetSites()
+{
+	SiteList sites;
+	for (SiteMap::value_type& item : m_sites)
+	{
+		if (item.second.count > 0)
+		{
+			sites.push_back(item.second);
+		}
+	}
+
+	std::sort(sites.begin(), sites.end(),
+		[](const Site& site1, const Site& site2) { return site1.holdTime > site2.holdTime; });
+
+	return sites;
+}
+
+// the sites are kept since the current holder refers to one of them
+void LockProfile::Reset()
+{
+	for (SiteMap::value_type& item : m_sites)
+	{
+		item.second = Site{item.second.file, item.second.line, 0, 0, 0, 0, 0};
+	}
+}
+
 void Thread::Init()
 {
 	debug("Initializing global thread data");
@@ -132,3 +199,101 @@ int Thread::GetThreadCount()
 	Guard guard(m_threadMutex);
 	return m_threadCount;
 }
+
+
+class WorkerPoolThread : public Thread
+{
+public:
+	WorkerPoolThread(WorkerPool* owner) : m_owner(owner) {}
+
+protected:
+	virtual void Run() { m_owner->Work(); }
+
+private:
+	WorkerPool* m_owner;
+};
+
+void WorkerPool::Execute(int jobCount, JobFunc job, ProgressFunc progress)
+{
+	m_job = std::move(job);
+	m_jobCount = jobCount;
+	m_nextJob = 0;
+	m_completed = 0;
+	m_lastCompleted = -1;
+	m_stopped = false;
+
+	int threads = std::min(m_maxThreads, jobCount);
+	if (threads <= 1)
+	{
+		for (int index = 0; index < jobCount && !m_stopped; index++)
+		{
+			m_job(index);
+			if (progress)
+			{
+				progress(index + 1, index);
+			}
+		}
+		return;
+	}
+
+	m_activeThreads = threads;
+	for (int i = 0; i < threads; i++)
+	{
+		WorkerPoolThread* thread = new WorkerPoolThread(this);
+		thread->SetAutoDestroy(true);
+		thread->Start();
+	}
+
+	int reported = 0;
+	while (true)
+	{
+		int completed;
+		int lastIndex;
+		bool finished;
+		{
+			Guard guard(m_mutex);
+			m_completedCond.WaitFor(m_mutex, 100, [&]{ return m_activeThreads == 0 || m_completed > reported; });
+			completed = m_completed;
+			lastIndex = m_lastCompleted;
+			finished = m_activeThreads == 0;
+		}
+
+		if (progress && completed > reported)
+		{
+			progress(completed, lastIndex);
+			reported = completed;
+		}
+
+		if (finished)
+		{
+			break;
+		}
+	}
+}
+
+void WorkerPool::Work()
+{
+	while (true)
+	{
+		int index;
+		{
+			Guard guard(m_mutex);
+			if (m_stopped || m_nextJob >= m_jobCount)
+			{
+				// notifying under lock guarantees that the pool isn't destroyed before
+				// the worker releases the mutex; it doesn't access the pool afterwards
+				m_activeThreads--;
+				m_completedCond.NotifyAll();
+				return;
+			}
+			index = m_nextJob++;
+		}
+
+		m_job(index);
+
+		Guard guard(m_mutex);
+		m_completed++;
+		m_lastCompleted = index;
+		m_completedCond.NotifyAll();
+	}
+}
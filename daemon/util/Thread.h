@@ -22,16 +22,69 @@
 #ifndef THREAD_H
 #define THREAD_H
 
+// Source location of the caller when used as default argument
+#if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#define CALLER_FILE __builtin_FILE()
+#define CALLER_LINE __builtin_LINE()
+#else
+#define CALLER_FILE ""
+#define CALLER_LINE 0
+#endif
+
+/*
+ * Wait and hold times of a mutex per call site (source location of the lock).
+ * Updated and read only while the mutex is locked.
+ */
+class LockProfile
+{
+public:
+	struct Site
+	{
+		const char* file;
+		int line;
+		int64 count;
+		int64 waitTime;
+		int64 maxWait;
+		int64 holdTime;
+		int64 maxHold;
+	};
+	typedef std::vector<Site> SiteList;
+
+	// call sites ordered by total hold time, most expensive first
+	SiteList GetSites();
+	void Reset();
+
+private:
+	typedef std::map<std::pair<const char*, int>, Site> SiteMap;
+
+	SiteMap m_sites;
+	Site* m_holder = nullptr;
+	int64 m_lockTime = 0;
+
+	friend class Mutex;
+};
+
 class Mutex
 {
 public:
 	Mutex() {};
 	Mutex(const Mutex&) = delete;
 	void Lock() { m_mutexObj.lock(); }
-	void Unlock() { m_mutexObj.unlock(); }
+	void Lock(const char* file, int line) { if (m_profiling) ProfiledLock(file, line); else m_mutexObj.lock(); }
+	void Unlock() { if (m_profiling) ProfiledUnlock(); m_mutexObj.unlock(); }
+	// Starts collecting of wait and hold times for locks made with source location.
+	// Not suitable for mutexes used with condition variables.
+	void EnableProfiling();
+	// must be accessed only while the mutex is locked
+	LockProfile* GetProfile() { return m_profile.get(); }
 
 private:
 	std::mutex m_mutexObj;
+	std::atomic<bool> m_profiling{false};
+	std::unique_ptr<LockProfile> m_profile;
+
+	void ProfiledLock(const char* file, int line);
+	void ProfiledUnlock();
 
 	friend class ConditionVar;
 };
@@ -40,9 +93,12 @@ class Guard
 {
 public:
 	Guard() : m_mutex(nullptr) {}
-	Guard(Mutex& mutex) : m_mutex(&mutex) { if (m_mutex) m_mutex->Lock(); }
-	Guard(Mutex* mutex) : m_mutex(mutex) { if (m_mutex) m_mutex->Lock(); }
-	Guard(std::unique_ptr<Mutex>& mutex) : m_mutex(mutex.get()) { if (m_mutex) m_mutex->Lock(); }
+	Guard(Mutex& mutex, const char* file = CALLER_FILE, int line = CALLER_LINE) :
+		m_mutex(&mutex) { if (m_mutex) m_mutex->Lock(file, line); }
+	Guard(Mutex* mutex, const char* file = CALLER_FILE, int line = CALLER_LINE) :
+		m_mutex(mutex) { if (m_mutex) m_mutex->Lock(file, line); }
+	Guard(std::unique_ptr<Mutex>& mutex, const char* file = CALLER_FILE, int line = CALLER_LINE) :
+		m_mutex(mutex.get()) { if (m_mutex) m_mutex->Lock(file, line); }
 	Guard(Guard&& other) : m_mutex(other.m_mutex) { other.m_mutex = nullptr; }
 	Guard(const Guard&) = delete;
 	~Guard() { Unlock(); }
@@ -59,7 +115,8 @@ template<typename T>
 class GuardedPtr
 {
 public:
-	GuardedPtr(T* ptr, Mutex* mutex) : m_ptr(ptr), m_mutex(mutex) { if (m_mutex) m_mutex->Lock(); }
+	GuardedPtr(T* ptr, Mutex* mutex, const char* file = CALLER_FILE, int line = CALLER_LINE) :
+		m_ptr(ptr), m_mutex(mutex) { if (m_mutex) m_mutex->Lock(file, line); }
 	GuardedPtr(GuardedPtr&& other) : m_ptr(other.m_ptr), m_mutex(other.m_mutex) { other.m_mutex = nullptr; }
 	GuardedPtr(const GuardedPtr& other) = delete;
 	~GuardedPtr() { Unlock(); }
@@ -133,4 +190,44 @@ private:
 	void thread_handler();
 };
 
+/*
+ * Executes independent jobs using a bounded number of threads.
+ * Jobs are identified by index; callers store the results by index to
+ * keep them in a deterministic order regardless of completion order.
+ * The calling thread waits for completion and reports the progress: the number
+ * of completed jobs and the index of the job completed last (jobs complete
+ * out of order).
+ */
+class WorkerPool
+{
+public:
+	typedef std::function<void(int index)> JobFunc;
+	typedef std::function<void(int completed, int lastIndex)> ProgressFunc;
+
+	// Number of threads for jobs dominated by open/read latency rather than by CPU,
+	// such as reading headers of many files, especially on network storage
+	static const int IO_THREADS = 8;
+
+	WorkerPool(int maxThreads) : m_maxThreads(maxThreads) {}
+	WorkerPool(const WorkerPool&) = delete;
+	void Execute(int jobCount, JobFunc job, ProgressFunc progress = nullptr);
+	void Stop() { m_stopped = true; }
+
+private:
+	int m_maxThreads;
+	JobFunc m_job;
+	int m_jobCount = 0;
+	int m_nextJob = 0;
+	int m_completed = 0;
+	int m_lastCompleted = -1;
+	int m_activeThreads = 0;
+	std::atomic<bool> m_stopped{false};
+	Mutex m_mutex;
+	ConditionVar m_completedCond;
+
+	void Work();
+
+	friend class WorkerPoolThread;
+};
+
 #endif
@@ -731,6 +731,14 @@ uint32 WebUtil::DecodeBase64(char* inputBuffer, int inputBufferLength, char* out
 */
 
 CString WebUtil::XmlEncode(const char* raw)
+{
+	CString result;
+	result.Reserve(XmlEncodeLen(raw));
+	XmlEncode(raw, result);
+	return result;
+}
+
+int WebUtil::XmlEncodeLen(const char* raw)
 {
 	// calculate the required outputstring-size based on number of xml-entities and their sizes
 	int reqSize = strlen(raw);
@@ -759,11 +767,12 @@ CString WebUtil::XmlEncode(const char* raw)
 		}
 	}
 
-	CString result;
-	result.Reserve(reqSize);
+	return reqSize;
+}
 
+void WebUtil::XmlEncode(const char* raw, char* output)
+{
 	// copy string
-	char* output = result;
 	for (const char* p = raw; ; p++)
 	{
 		uchar ch = *p;
@@ -847,8 +856,6 @@ CString WebUtil::XmlEncode(const char* raw)
 BreakLoop:
 
 	*output = '\0';
-
-	return result;
 }
 
 void WebUtil::XmlDecode(char* raw)
@@ -1004,6 +1011,14 @@ BreakLoop:
 }
 
 CString WebUtil::JsonEncode(const char* raw)
+{
+	CString result;
+	result.Reserve(JsonEncodeLen(raw));
+	JsonEncode(raw, result);
+	return result;
+}
+
+int WebUtil::JsonEncodeLen(const char* raw)
 {
 	// calculate the required outputstring-size based on number of escape-entities and their sizes
 	int reqSize = strlen(raw);
@@ -1031,11 +1046,12 @@ CString WebUtil::JsonEncode(const char* raw)
 		}
 	}
 
-	CString result;
-	result.Reserve(reqSize);
+	return reqSize;
+}
 
+void WebUtil::JsonEncode(const char* raw, char* output)
+{
 	// copy string
-	char* output = result;
 	for (const char* p = raw; ; p++)
 	{
 		uchar ch = *p;
@@ -1120,8 +1136,6 @@ CString WebUtil::JsonEncode(const char* raw)
 BreakLoop:
 
 	*output = '\0';
-
-	return result;
 }
 
 void WebUtil::JsonDecode(char* raw)
@@ -1744,6 +1758,82 @@ uint32 ZLib::GZip(const void* inputBuffer, int inputBufferLength, void* outputBu
 	return total_out;
 }
 
+GZipStream::GZipStream(int bufferSize) :
+	m_bufferSize(bufferSize)
+{
+	m_outputBuffer = std::make_unique<Bytef[]>(bufferSize);
+
+	/* add 16 to MAX_WBITS to enforce gzip format */
+	int ret = deflateInit2(&m_zStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+	m_active = ret == Z_OK;
+
+	Reset();
+}
+
+GZipStream::~GZipStream()
+{
+	if (m_active)
+	{
+		deflateEnd(&m_zStream);
+	}
+}
+
+void GZipStream::Reset()
+{
+	if (m_active)
+	{
+		m_active = deflateReset(&m_zStream) == Z_OK;
+	}
+	m_zStream.next_out = (Bytef*)m_outputBuffer.get();
+	m_zStream.avail_out = m_bufferSize;
+	m_last = false;
+}
+
+void GZipStream::Write(const void* inputBuffer, int inputBufferLength, bool last)
+{
+	m_zStream.next_in = (Bytef*)inputBuffer;
+	m_zStream.avail_in = inputBufferLength;
+	m_last = last;
+}
+
+GZipStream::EStatus GZipStream::Read(const void** outputBuffer, int* outputBufferLength)
+{
+	*outputBufferLength = 0;
+
+	if (!m_active)
+	{
+		return zlError;
+	}
+
+	if (m_zStream.avail_out == 0)
+	{
+		// the previous block was full and has been returned
+		m_zStream.next_out = (Bytef*)m_outputBuffer.get();
+		m_zStream.avail_out = m_bufferSize;
+	}
+
+	int ret = deflate(&m_zStream, m_last ? Z_FINISH : Z_NO_FLUSH);
+
+	switch (ret)
+	{
+		case Z_STREAM_END:
+			*outputBufferLength = m_bufferSize - m_zStream.avail_out;
+			*outputBuffer = m_outputBuffer.get();
+			return zlFinished;
+
+		case Z_OK:
+		case Z_BUF_ERROR:
+			if (m_zStream.avail_out == 0)
+			{
+				*outputBufferLength = m_bufferSize;
+				*outputBuffer = m_outputBuffer.get();
+			}
+			return zlOK;
+	}
+
+	return zlError;
+}
+
 GUnzipStream::GUnzipStream(int BufferSize) :
 	m_bufferSize(BufferSize)
 {
@@ -103,6 +103,17 @@ public:
 	*/
 	static CString XmlEncode(const char* raw);
 
+	/*
+	* Returns the length of string produced by "XmlEncode", which equals
+	* to the length of raw-string if the string doesn't need encoding.
+	*/
+	static int XmlEncodeLen(const char* raw);
+
+	/*
+	* Encodes into output-buffer which must be large enough (see "XmlEncodeLen").
+	*/
+	static void XmlEncode(const char* raw, char* output);
+
 	/*
 	* Decodes string from xml.
 	* The string is decoded on the place overwriting the content of raw-data.
@@ -137,6 +148,17 @@ public:
 	*/
 	static CString JsonEncode(const char* raw);
 
+	/*
+	* Returns the length of string produced by "JsonEncode", which equals
+	* to the length of raw-string if the string doesn't need encoding.
+	*/
+	static int JsonEncodeLen(const char* raw);
+
+	/*
+	* Encodes into output-buffer which must be large enough (see "JsonEncodeLen").
+	*/
+	static void JsonEncode(const char* raw, char* output);
+
 	/*
 	* Decodes JSON-string.
 	* The string is decoded on the place overwriting the content of raw-data.
@@ -266,6 +288,44 @@ public:
 	static uint32 GZip(const void* inputBuffer, int inputBufferLength, void* outputBuffer, int outputBufferLength);
 };
 
+class GZipStream
+{
+public:
+	enum EStatus
+	{
+		zlError,
+		zlFinished,
+		zlOK
+	};
+
+	GZipStream(int bufferSize);
+	~GZipStream();
+
+	/*
+	* start new stream; the object (and its memory) can be reused for many streams.
+	*/
+	void Reset();
+
+	/*
+	* set next memory block for compression; "last" must be set for the last block.
+	*/
+	void Write(const void* inputBuffer, int inputBufferLength, bool last);
+
+	/*
+	* get next compressed memory block. The block is returned when the output buffer is full
+	* or when the stream is finished (status "zlFinished").
+	* outputBufferLength - if it is "0" the next block must be provided via "Write".
+	*/
+	EStatus Read(const void** outputBuffer, int* outputBufferLength);
+
+private:
+	z_stream m_zStream = {0};
+	std::unique_ptr<Bytef[]> m_outputBuffer;
+	int m_bufferSize;
+	bool m_active = false;
+	bool m_last = false;
+};
+
 class GUnzipStream
 {
 public:
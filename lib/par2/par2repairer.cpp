@@ -52,6 +52,9 @@ Par2Repairer::Par2Repairer(std::ostream& cout, std::ostream& cerr):
   missingfilecount = 0;
 
   inputbuffer = 0;
+  repairpasses = 0;
+  plannedreadsize = 0;
+  plannedwritesize = 0;
   outputbuffer = 0;
 
   noiselevel = CommandLine::nlNormal;
@@ -2245,20 +2248,57 @@ bool Par2Repairer::ComputeRSmatrix(void)
   return success;  
 }
 
-// Allocate memory buffers for reading and writing data to disk.
-bool Par2Repairer::AllocateBuffers(size_t memorylimit)
+// Pick the chunk size for the memory limit. Each pass reads one chunk of
+// every input block, so the number of passes decides how many times the
+// input files are swept. The passes are balanced so that the last one
+// does not process only a small remainder, and chunks are rounded up to
+// whole pages if the memory limit permits.
+void Par2Repairer::PlanRepair(size_t memorylimit)
 {
-  // Would single pass processing use too much memory
-  if (blocksize * missingblockcount > memorylimit)
+  u64 maxchunk = ~3 & (memorylimit / (missingblockcount > 0 ? missingblockcount : 1));
+  if (maxchunk < 4)
+    maxchunk = 4;
+
+  repairpasses = (u32)((blocksize + maxchunk - 1) / maxchunk);
+  chunksize = (((blocksize + repairpasses - 1) / repairpasses) + 3) & ~(u64)3;
+
+  u64 pagechunk = (chunksize + 4095) & ~(u64)4095;
+  if (repairpasses > 1 && pagechunk <= maxchunk)
   {
-    // Pick a size that is small enough
-    chunksize = ~3 & (memorylimit / missingblockcount);
+    chunksize = pagechunk;
+    repairpasses = (u32)((blocksize + chunksize - 1) / chunksize);
   }
-  else
+
+  // Input blocks are read only if there is anything to reconstruct or
+  // if they have to be copied to a target file
+  plannedreadsize = 0;
+  plannedwritesize = 0;
+  vector<DataBlock*>::iterator copyblock = copyblocks.begin();
+  for (vector<DataBlock*>::iterator inputblock = inputblocks.begin(); inputblock != inputblocks.end(); ++inputblock)
   {
-    chunksize = (size_t)blocksize;
+    bool copy = copyblock != copyblocks.end() && (*copyblock)->IsSet();
+    if (missingblockcount > 0 || copy)
+      plannedreadsize += (*inputblock)->GetLength();
+    if (copy)
+      plannedwritesize += (*copyblock)->GetLength();
+    if (copyblock != copyblocks.end())
+      ++copyblock;
+  }
+  for (vector<DataBlock*>::iterator outputblock = outputblocks.begin(); outputblock != outputblocks.end(); ++outputblock)
+  {
+    plannedwritesize += (*outputblock)->GetLength();
   }
 
+  if (noiselevel > CommandLine::nlQuiet)
+    cout << "Repair plan: " << repairpasses << " pass(es) of " << chunksize << " bytes, reading "
+         << plannedreadsize << " bytes, writing " << plannedwritesize << " bytes" << endl;
+}
+
+// Allocate memory buffers for reading and writing data to disk.
+bool Par2Repairer::AllocateBuffers(size_t memorylimit)
+{
+  PlanRepair(memorylimit);
+
   // Allocate the two buffers
   inputbuffer = new u8[(size_t)chunksize];
   outputbuffer = new u8[(size_t)chunksize * missingblockcount];
@@ -2332,35 +2372,43 @@ bool Par2Repairer::ProcessData(u64 blockoffset, size_t blocklength)
 
       if (!RepairData(inputindex, blocklength))
       {
-      // For each output block
-      for (u32 outputindex=0; outputindex<missingblockcount; outputindex++)
-      {
-        // Select the appropriate part of the output buffer
-        void *outbuf = &((u8*)outputbuffer)[chunksize * outputindex];
-
-        // Process the data
-        rs.Process(blocklength, inputindex, inputbuffer, outputindex, outbuf);
-
-        if (noiselevel > CommandLine::nlQuiet)
+        // Process the input in tiles, so that each tile stays in the
+        // cache while it is multiplied into all of the output blocks
+        for (size_t tileoffset=0; tileoffset<blocklength && !cancelled; tileoffset+=repairtilesize)
         {
-          // Update a progress indicator
-          u32 oldfraction = (u32)(1000 * progress / totaldata);
-          progress += blocklength;
-          u32 newfraction = (u32)(1000 * progress / totaldata);
+          size_t tilelength = min(repairtilesize, blocklength - tileoffset);
+          const void *tile = &((const u8*)inputbuffer)[tileoffset];
 
-          if (oldfraction != newfraction)
+          // For each output block
+          for (u32 outputindex=0; outputindex<missingblockcount; outputindex++)
           {
-            cout << "Repairing: " << newfraction/10 << '.' << newfraction%10 << "%\r" << flush;
-	    sig_progress(newfraction);
+            // Select the appropriate part of the output buffer
+            void *outbuf = &((u8*)outputbuffer)[chunksize * outputindex + tileoffset];
+
+            // Process the data
+            rs.Process(tilelength, inputindex, tile, outputindex, outbuf);
 
-            if (cancelled)
+            if (noiselevel > CommandLine::nlQuiet)
             {
-              break;
+              // Update a progress indicator
+              u32 oldfraction = (u32)(1000 * progress / totaldata);
+              progress += tilelength;
+              u32 newfraction = (u32)(1000 * progress / totaldata);
+
+              if (oldfraction != newfraction)
+              {
+                cout << "Repairing: " << newfraction/10 << '.' << newfraction%10 << "%\r" << flush;
+	    sig_progress(newfraction);
+
+                if (cancelled)
+                {
+                  break;
+                }
+              }
             }
           }
         }
       }
-      }
 
       if (cancelled)
       {
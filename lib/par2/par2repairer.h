@@ -24,6 +24,9 @@
 
 namespace Par2 {
 
+// Size of the input tiles processed through the RS matrix at once.
+static const size_t repairtilesize = 65536;
+
 class Par2Repairer
 {
 public:
@@ -113,6 +116,9 @@ protected:
   // the appropriate Reed Solomon matrix.
   bool ComputeRSmatrix(void);
 
+  // Pick the chunk size for the memory limit and compute the planned I/O volume.
+  void PlanRepair(size_t memorylimit);
+
   // Allocate memory buffers for reading and writing data to disk.
   bool AllocateBuffers(size_t memorylimit);
 
@@ -165,6 +171,9 @@ protected:
 
   u64                       blocksize;               // The block size.
   u64                       chunksize;               // How much of a block can be processed.
+  u32                       repairpasses;            // How many chunks each block is processed in.
+  u64                       plannedreadsize;         // How much data the repair reads from disk.
+  u64                       plannedwritesize;        // How much data the repair writes to disk.
   u32                       sourceblockcount;        // The total number of blocks
   u32                       availableblockcount;     // How many undamaged blocks have been found
   u32                       missingblockcount;       // How many blocks are missing
@@ -0,0 +1,413 @@
+#!/usr/bin/env python3
+#
+#  This file is part of nzbget. See <http://nzbget.net>.
+#
+#  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+End-to-end download throughput benchmark.
+
+Generates a dataset of random files and nzbs for them (nserv -z), serves the
+articles from a pre-encoded segment store of nserv on loopback, downloads the
+dataset with nzbget driven over JSON-RPC and reports:
+  - download speed (MB/s, from adding the nzb until download completion);
+  - CPU time of nzbget per GB downloaded;
+  - peak resident memory and peak thread count of nzbget;
+  - time until the nzb is post-processed and moved to history.
+
+CPU, memory and thread statistics are read from /proc and are only available
+on Linux.
+
+Parameters accepting comma separated lists are combined, every combination
+is a separate run. Example:
+  download_benchmark.py --size 2048 --connections 4,16 --tls no,yes \\
+      --article-cache 0,500 --json results.json
+
+To catch regressions compare with results of a previous run:
+  download_benchmark.py --compare results.json --tolerance 10
+
+NZBGet doesn't pipeline article requests, each connection waits for the
+response before sending the next request. Option "--latency" sets response
+latency of nserv, which simulates the round trip time to a real news server
+and shows how well the downloader hides it with more connections.
+"""
+
+import argparse
+import base64
+import itertools
+import json
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import time
+import urllib.request
+
+nzbget_srcdir = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+exe_ext = '.exe' if os.name == 'nt' else ''
+
+nserv_port = 16791
+control_port = 16789
+dataset_name = 'benchmark'
+
+def parse_args():
+	parser = argparse.ArgumentParser(description='NZBGet download throughput benchmark')
+	parser.add_argument('--nzbget', default=nzbget_srcdir + '/nzbget' + exe_ext, help='path to nzbget binary')
+	parser.add_argument('--workdir', default=nzbget_srcdir + '/tests/testdata/benchmark.temp', help='directory for dataset and downloads')
+	parser.add_argument('--size', type=int, default=1024, help='dataset size in megabytes (default 1024)')
+	parser.add_argument('--file-size', type=int, default=100, help='size of files in dataset in megabytes (default 100)')
+	parser.add_argument('--segment-size', type=int, default=768000, help='article size in bytes (default 768000)')
+	parser.add_argument('--connections', default='8', help='number of connections (list)')
+	parser.add_argument('--tls', default='no', help='use TLS, yes/no (list)')
+	parser.add_argument('--article-cache', default='500', help='option ArticleCache in megabytes (list)')
+	parser.add_argument('--direct-write', default='yes', help='option DirectWrite, yes/no (list)')
+	parser.add_argument('--latency', default='0', help='nserv response latency in milliseconds (list)')
+	parser.add_argument('--option', action='append', default=[], help='additional nzbget option Name=Value (repeatable)')
+	parser.add_argument('--repeat', type=int, default=1, help='number of runs per combination, the median is reported')
+	parser.add_argument('--timeout', type=int, default=3600, help='max time per run in seconds')
+	parser.add_argument('--json', help='save results into file')
+	parser.add_argument('--compare', help='compare with results saved in file, exit with code 1 on regressions')
+	parser.add_argument('--tolerance', type=float, default=10, help='allowed deviation from compared results in percent (default 10)')
+	return parser.parse_args()
+
+def split_list(value):
+	return [item.strip() for item in value.split(',') if item.strip()]
+
+def wait_port(port, process, timeout):
+	start = time.time()
+	while time.time() - start < timeout:
+		if process.poll() is not None:
+			return False
+		try:
+			socket.create_connection(('127.0.0.1', port), 1).close()
+			return True
+		except socket.error:
+			time.sleep(0.2)
+	return False
+
+class Dataset:
+
+	def __init__(self, args):
+		self.args = args
+		self.datadir = args.workdir + '/data'
+		self.nzb_filename = self.datadir + '/' + dataset_name + '.nzb'
+		self.store_filename = args.workdir + '/segments.store'
+		self.size = 0
+
+	def prepare(self):
+		info = {'size': self.args.size, 'file_size': self.args.file_size, 'segment_size': self.args.segment_size}
+		info_filename = self.args.workdir + '/dataset.json'
+		if os.path.exists(self.nzb_filename) and os.path.exists(info_filename) and json.load(open(info_filename)) == info:
+			self.size = self.dataset_size()
+			return
+
+		print('Generating dataset (%i MB)' % self.args.size)
+		shutil.rmtree(self.datadir, True)
+		os.makedirs(self.datadir + '/' + dataset_name)
+		remaining = self.args.size * 1024 * 1024
+		num = 1
+		while remaining > 0:
+			filesize = min(remaining, self.args.file_size * 1024 * 1024)
+			with open('%s/%s/%s.%03i' % (self.datadir, dataset_name, dataset_name, num), 'wb') as f:
+				written = 0
+				while written < filesize:
+					block = min(filesize - written, 16 * 1024 * 1024)
+					f.write(os.urandom(block))
+					written += block
+			remaining -= filesize
+			num += 1
+
+		if 0 != subprocess.call([self.args.nzbget, '--nserv', '-d', self.datadir, '-v', '1', '-z', str(self.args.segment_size), '-q']):
+			sys.exit('Dataset generation failed')
+
+		json.dump(info, open(info_filename, 'w'))
+		self.size = self.dataset_size()
+
+	def dataset_size(self):
+		total = 0
+		for filename in os.listdir(self.datadir + '/' + dataset_name):
+			total += os.path.getsize(self.datadir + '/' + dataset_name + '/' + filename)
+		return total
+
+class NServ:
+
+	def __init__(self, args, dataset, tls, latency):
+		cmd = [args.nzbget, '--nserv', '-d', dataset.datadir, '-p', str(nserv_port), '-v', '0',
+			'-z', str(args.segment_size), '-a', dataset.store_filename, '-w', str(latency)]
+		if tls:
+			cert, key = self.create_certificate(args.workdir)
+			cmd += ['-s', cert, key]
+		else:
+			cmd += ['-e']
+		# the segment store is built on first start, that may take a while
+		self.process = subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL)
+		if not wait_port(nserv_port, self.process, 1800):
+			self.stop()
+			raise Exception('Could not start nserv')
+
+	def create_certificate(self, workdir):
+		cert = workdir + '/nserv.crt'
+		key = workdir + '/nserv.key'
+		if not os.path.exists(cert):
+			if 0 != subprocess.call(['openssl', 'req', '-x509', '-newkey', 'rsa:2048', '-nodes', '-days', '3650',
+				'-subj', '/CN=127.0.0.1', '-keyout', key, '-out', cert], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL):
+				raise Exception('Could not create certificate for nserv (openssl required for TLS)')
+		return cert, key
+
+	def stop(self):
+		self.process.kill()
+		self.process.wait()
+
+class Nzbget:
+
+	def __init__(self, args, options):
+		self.args = args
+		self.maindir = args.workdir + '/nzbget'
+		self.url = 'http://127.0.0.1:%i/jsonrpc' % control_port
+		self.prepare(options)
+		self.process = subprocess.Popen([args.nzbget, '-c', self.maindir + '/nzbget.conf', '-s', '-o', 'outputmode=log'],
+			stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL)
+		if not wait_port(control_port, self.process, 30):
+			self.stop()
+			raise Exception('Could not start nzbget')
+		if self.rpc('status')['DownloadPaused']:
+			log = open(self.maindir + '/nzbget.log').read()
+			self.stop()
+			raise Exception('NZBGet paused download due to errors in configuration:\n' + log)
+
+	def prepare(self, options):
+		shutil.rmtree(self.maindir, True)
+		os.makedirs(self.maindir)
+		config = open(self.maindir + '/nzbget.conf', 'w')
+		config.write('MainDir=' + self.maindir + '\n')
+		config.write('DestDir=${MainDir}/complete\n')
+		config.write('InterDir=${MainDir}/intermediate\n')
+		config.write('TempDir=${MainDir}/temp\n')
+		config.write('QueueDir=${MainDir}/queue\n')
+		config.write('NzbDir=${MainDir}/nzb\n')
+		config.write('LogFile=${MainDir}/nzbget.log\n')
+		config.write('WriteLog=append\n')
+		config.write('DetailTarget=log\n')
+		config.write('InfoTarget=log\n')
+		config.write('WarningTarget=log\n')
+		config.write('ErrorTarget=log\n')
+		config.write('DebugTarget=none\n')
+		config.write('CrashTrace=no\n')
+		config.write('ContinuePartial=no\n')
+		config.write('NzbDirInterval=0\n')
+		config.write('FlushQueue=no\n')
+		config.write('WebDir=' + nzbget_srcdir + '/webui\n')
+		config.write('ConfigTemplate=' + nzbget_srcdir + '/nzbget.conf\n')
+		config.write('ControlUsername=\n')
+		config.write('ControlPassword=\n')
+		config.write('ControlIP=127.0.0.1\n')
+		config.write('ControlPort=%i\n' % control_port)
+		config.write('Server1.Host=127.0.0.1\n')
+		config.write('Server1.Port=%i\n' % nserv_port)
+		config.write('Server1.Level=0\n')
+		config.write('CertCheck=no\n')
+		for opt in options:
+			config.write(opt + '\n')
+		config.close()
+
+	def rpc(self, method, *params):
+		request = json.dumps({'method': method, 'params': list(params)}).encode()
+		response = json.loads(urllib.request.urlopen(self.url, request, 60).read().decode())
+		if 'error' in response and response['error']:
+			raise Exception('RPC method %s failed: %s' % (method, response['error']))
+		return response['result']
+
+	def stop(self):
+		try:
+			self.rpc('shutdown')
+			self.process.wait(30)
+		except Exception:
+			self.process.kill()
+			self.process.wait()
+		shutil.rmtree(self.maindir, True)
+
+class ProcessStats:
+
+	def __init__(self, pid):
+		self.pid = pid
+		self.clock_ticks = os.sysconf('SC_CLK_TCK') if hasattr(os, 'sysconf') else 100
+		self.peak_threads = None
+		self.start_cpu = self.cpu_time()
+
+	def cpu_time(self):
+		try:
+			fields = open('/proc/%i/stat' % self.pid).read().rsplit(')', 1)[1].split()
+			# utime and stime, fields 14 and 15 of stat-file
+			return (int(fields[11]) + int(fields[12])) / float(self.clock_ticks)
+		except (IOError, IndexError):
+			return None
+
+	def status_value(self, name):
+		try:
+			for line in open('/proc/%i/status' % self.pid):
+				if line.startswith(name + ':'):
+					return int(line.split()[1])
+		except IOError:
+			pass
+		return None
+
+	def sample(self):
+		threads = self.status_value('Threads')
+		if threads is not None:
+			self.peak_threads = max(self.peak_threads or 0, threads)
+
+	def used_cpu(self):
+		end_cpu = self.cpu_time()
+		return end_cpu - self.start_cpu if end_cpu is not None and self.start_cpu is not None else None
+
+	def peak_rss(self):
+		return self.status_value('VmHWM')
+
+def run_benchmark(args, dataset, params):
+	nserv = NServ(args, dataset, params['tls'] == 'yes', params['latency'])
+	options = [
+		'Server1.Connections=%s' % params['connections'],
+		'ArticleCache=%s' % params['article_cache'],
+		'DirectWrite=%s' % params['direct_write']] + args.option
+	if params['tls'] == 'yes':
+		options.append('Server1.Encryption=yes')
+	try:
+		nzbget = Nzbget(args, options)
+	except Exception:
+		nserv.stop()
+		raise
+
+	try:
+		nzb_content = base64.standard_b64encode(open(dataset.nzb_filename, 'rb').read()).decode()
+		stats = ProcessStats(nzbget.process.pid)
+		start = time.time()
+		nzbget.rpc('append', dataset_name + '.nzb', nzb_content, 'benchmark', 0, False, False, '', 0, 'FORCE', [])
+
+		download_time = None
+		hist = None
+		while hist is None:
+			if time.time() - start > args.timeout:
+				raise Exception('Timeout')
+			time.sleep(0.1)
+			stats.sample()
+			downloading = [group for group in nzbget.rpc('listgroups', 0)
+				if group['Status'] in ('QUEUED', 'PAUSED', 'DOWNLOADING', 'FETCHING')]
+			if not downloading and download_time is None:
+				download_time = time.time() - start
+			if not downloading:
+				history = nzbget.rpc('history', False)
+				hist = history[0] if history else None
+
+		total_time = time.time() - start
+		cpu = stats.used_cpu()
+		rss = stats.peak_rss()
+		gigabytes = dataset.size / 1024.0 / 1024.0 / 1024.0
+
+		return {
+			'params': params,
+			'status': hist['Status'],
+			'speed': dataset.size / 1024.0 / 1024.0 / download_time,
+			'cpu_per_gb': cpu / gigabytes if cpu is not None else None,
+			'peak_rss_mb': rss / 1024.0 if rss is not None else None,
+			'peak_threads': stats.peak_threads,
+			'download_time': download_time,
+			'total_time': total_time
+		}
+	finally:
+		nzbget.stop()
+		nserv.stop()
+
+def median_result(results):
+	results = sorted(results, key=lambda result: result['speed'])
+	return results[len(results) // 2]
+
+def params_key(params):
+	return 'conn=%(connections)s tls=%(tls)s cache=%(article_cache)s directwrite=%(direct_write)s latency=%(latency)s' % params
+
+def format_value(value, fmt):
+	return fmt % value if value is not None else '-'
+
+def print_header():
+	print('%-60s %9s %9s %8s %7s %9s %9s  %s' % ('parameters', 'MB/s', 'CPU s/GB', 'RSS MB', 'threads', 'download', 'total', 'status'))
+
+def print_result(result):
+	print('%-60s %9s %9s %8s %7s %8ss %8ss  %s' % (params_key(result['params']),
+		format_value(result['speed'], '%.1f'), format_value(result['cpu_per_gb'], '%.2f'),
+		format_value(result['peak_rss_mb'], '%.1f'), format_value(result['peak_threads'], '%i'),
+		format_value(result['download_time'], '%.1f'), format_value(result['total_time'], '%.1f'),
+		result['status']))
+	sys.stdout.flush()
+
+def compare_results(results, baseline, tolerance):
+	base_results = dict((params_key(result['params']), result) for result in baseline)
+	regressions = 0
+	for result in results:
+		base = base_results.get(params_key(result['params']))
+		if base is None:
+			continue
+		if result['speed'] < base['speed'] * (1 - tolerance / 100.0):
+			print('REGRESSION %s: speed %.1f MB/s, was %.1f MB/s' % (params_key(result['params']), result['speed'], base['speed']))
+			regressions += 1
+		if result['cpu_per_gb'] is not None and base['cpu_per_gb'] is not None and \
+			result['cpu_per_gb'] > base['cpu_per_gb'] * (1 + tolerance / 100.0):
+			print('REGRESSION %s: CPU %.2f s/GB, was %.2f s/GB' % (params_key(result['params']), result['cpu_per_gb'], base['cpu_per_gb']))
+			regressions += 1
+	return regressions
+
+def main():
+	args = parse_args()
+	if not os.path.exists(args.nzbget):
+		sys.exit('Could not find nzbget binary at ' + args.nzbget)
+	args.workdir = os.path.abspath(args.workdir)
+	if not os.path.exists(args.workdir):
+		os.makedirs(args.workdir)
+
+	dataset = Dataset(args)
+	dataset.prepare()
+
+	combinations = [dict(zip(('connections', 'tls', 'article_cache', 'direct_write', 'latency'), values))
+		for values in itertools.product(split_list(args.connections), split_list(args.tls),
+			split_list(args.article_cache), split_list(args.direct_write), split_list(args.latency))]
+
+	print('Dataset: %.1f MB, article size %i bytes' % (dataset.size / 1024.0 / 1024.0, args.segment_size))
+	print_header()
+
+	results = []
+	failed = False
+	for params in combinations:
+		try:
+			runs = [run_benchmark(args, dataset, params) for _ in range(args.repeat)]
+		except Exception as e:
+			print('%s: %s' % (params_key(params), e))
+			return 1
+		result = median_result(runs)
+		failed = failed or any(not run['status'].startswith('SUCCESS') for run in runs)
+		results.append(result)
+		print_result(result)
+
+	if args.json:
+		json.dump(results, open(args.json, 'w'), indent=4)
+
+	if args.compare:
+		if compare_results(results, json.load(open(args.compare)), args.tolerance) > 0:
+			failed = True
+
+	return 1 if failed else 0
+
+if __name__ == '__main__':
+	sys.exit(main())
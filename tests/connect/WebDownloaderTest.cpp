@@ -0,0 +1,142 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "WebDownloader.h"
+#include "FileSystem.h"
+#include "TestUtil.h"
+
+// Serves one connection: records the request headers and sends the response
+class HttpServerMock
+{
+public:
+	HttpServerMock(const char* response);
+	~HttpServerMock();
+	int GetPort() { return m_port; }
+	const char* GetRequest() { return m_request; }
+	void Wait() { m_thread.join(); }
+
+private:
+	std::unique_ptr<Connection> m_listener;
+	std::thread m_thread;
+	CString m_response;
+	StringBuilder m_request;
+	int m_port = 0;
+
+	void Serve();
+};
+
+HttpServerMock::HttpServerMock(const char* response) : m_response(response)
+{
+	for (int port = 26100; port < 26200 && !m_port; port++)
+	{
+		m_listener = std::make_unique<Connection>("127.0.0.1", port, false);
+		m_listener->SetSuppressErrors(true);
+		if (m_listener->Bind())
+		{
+			m_port = port;
+		}
+	}
+	REQUIRE(m_port != 0);
+
+	m_thread = std::thread(&HttpServerMock::Serve, this);
+}
+
+HttpServerMock::~HttpServerMock()
+{
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void HttpServerMock::Serve()
+{
+	std::unique_ptr<Connection> connection = m_listener->Accept();
+	if (!connection)
+	{
+		return;
+	}
+
+	char line[1024];
+	while (connection->ReadLine(line, sizeof(line), nullptr) && strcmp(line, "\r\n"))
+	{
+		m_request.Append(line);
+	}
+
+	connection->Send(m_response, m_response.Length());
+	connection->Disconnect();
+	m_listener->Disconnect();
+}
+
+TEST_CASE("Web downloader: conditional request", "[WebDownloader][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	TestUtil::PrepareWorkingDir("empty");
+	BString<1024> outputFilename("%s/feed.xml", TestUtil::WorkingDir().c_str());
+
+	{
+		HttpServerMock server(
+			"HTTP/1.1 200 OK\r\n"
+			"ETag: \"abc\"\r\n"
+			"Last-Modified: Mon, 19 Oct 2026 10:00:00 GMT\r\n"
+			"Content-Length: 5\r\n"
+			"\r\n"
+			"<rss>");
+
+		WebDownloader downloader;
+		downloader.SetUrl(BString<1024>("http://127.0.0.1:%i/feed", server.GetPort()));
+		downloader.SetInfoName("feed");
+		downloader.SetOutputFilename(outputFilename);
+		REQUIRE(downloader.Download() == WebDownloader::adFinished);
+		server.Wait();
+
+		REQUIRE(strstr(server.GetRequest(), "If-None-Match") == nullptr);
+		REQUIRE(!strcmp(downloader.GetETag(), "\"abc\""));
+		REQUIRE(!strcmp(downloader.GetLastModified(), "Mon, 19 Oct 2026 10:00:00 GMT"));
+		REQUIRE(FileSystem::FileSize(outputFilename) == 5);
+	}
+
+	{
+		HttpServerMock server(
+			"HTTP/1.1 304 Not Modified\r\n"
+			"ETag: \"abc\"\r\n"
+			"\r\n");
+
+		WebDownloader downloader;
+		downloader.SetUrl(BString<1024>("http://127.0.0.1:%i/feed", server.GetPort()));
+		downloader.SetInfoName("feed");
+		downloader.SetOutputFilename(outputFilename);
+		downloader.SetIfNoneMatch("\"abc\"");
+		downloader.SetIfModifiedSince("Mon, 19 Oct 2026 10:00:00 GMT");
+		REQUIRE(downloader.Download() == WebDownloader::adNotModified);
+		server.Wait();
+
+		REQUIRE(strstr(server.GetRequest(), "If-None-Match: \"abc\"\r\n") != nullptr);
+		REQUIRE(strstr(server.GetRequest(), "If-Modified-Since: Mon, 19 Oct 2026 10:00:00 GMT\r\n") != nullptr);
+	}
+}
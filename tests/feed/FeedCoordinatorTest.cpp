@@ -0,0 +1,97 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "WorkState.h"
+#include "DupeCoordinator.h"
+#include "FeedCoordinator.h"
+
+class FeedDownloadQueueMock : public DownloadQueue
+{
+public:
+	FeedDownloadQueueMock() { Init(this); }
+	~FeedDownloadQueueMock() { Final(); }
+	virtual bool EditEntry(int ID, EEditAction action, const char* args) { return false; };
+	virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
+		EEditAction action, const char* args) { return false; }
+	virtual void HistoryChanged() { Changed(); }
+	virtual void Save() { Changed(); };
+	virtual void SaveChanged() {}
+};
+
+static void AddFeedItem(FeedItemList* feedItems, const char* title)
+{
+	feedItems->emplace_back();
+	FeedItemInfo& feedItemInfo = feedItems->back();
+	feedItemInfo.SetTitle(title);
+	feedItemInfo.SetFilename(title);
+	feedItemInfo.SetUrl(BString<1024>("http://localhost/%s.nzb", title));
+}
+
+TEST_CASE("Feed not modified", "[FeedCoordinator][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	FeedDownloadQueueMock downloadQueue;
+	DupeCoordinator dupeCoordinator;
+	g_DupeCoordinator = &dupeCoordinator;
+	WorkState workState;
+	g_WorkState = &workState;
+	FeedCoordinator feedCoordinator;
+
+	FeedInfo feedInfo(1, "Feed", "http://localhost/feed", false, 15, "-dupestatus:QUEUED",
+		false, "", 0, "");
+
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	nzbInfo->SetName("Show.S01E01");
+	downloadQueue.GetQueue()->Add(std::move(nzbInfo), false);
+	downloadQueue.Save();
+
+	std::shared_ptr<FeedItemList> feedItems = std::make_shared<FeedItemList>();
+	AddFeedItem(feedItems.get(), "Show.S01E01");
+	AddFeedItem(feedItems.get(), "Show.S01E02");
+
+	// the queued item is rejected
+	std::vector<std::unique_ptr<NzbInfo>> addedNzbs = feedCoordinator.UpdateFeed(&feedInfo, feedItems);
+	REQUIRE(addedNzbs.size() == 1);
+	REQUIRE(!strcmp(addedNzbs[0]->GetUrl(), "http://localhost/Show.S01E02.nzb"));
+	REQUIRE(feedInfo.GetFeedItems() == feedItems);
+
+	// after it has left the queue the next update accepts it, even though the server
+	// reports that the feed isn't modified
+	downloadQueue.GetQueue()->clear();
+	downloadQueue.Save();
+	addedNzbs = feedCoordinator.UpdateFeed(&feedInfo, feedInfo.GetFeedItems());
+	REQUIRE(addedNzbs.size() == 1);
+	REQUIRE(!strcmp(addedNzbs[0]->GetUrl(), "http://localhost/Show.S01E01.nzb"));
+
+	// accepted items are already in feed history
+	addedNzbs = feedCoordinator.UpdateFeed(&feedInfo, feedInfo.GetFeedItems());
+	REQUIRE(addedNzbs.empty());
+
+	g_WorkState = nullptr;
+	g_DupeCoordinator = nullptr;
+}
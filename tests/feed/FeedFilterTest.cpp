@@ -84,3 +84,118 @@ TEST_CASE("Feed filter: one liners", "[FeedFilter][Quick]")
 	TestFilter(&item, "A(k:series=GOT-${1}-${2}): Game of clowns S##E##", FeedItemInfo::msAccepted);
 	TestFilter(&item, "A(k:series=GOT-${1}-${2}): $.+S([0-9]{1,2})E([0-9]{1,2})", FeedItemInfo::msAccepted);
 }
+
+TEST_CASE("Feed filter: regex literals", "[FeedFilter][Quick]")
+{
+	FeedItemInfo item;
+	item.SetTitle("Game.of.Clowns.S02E06.REAL.1080p.HDTV.X264-Group.WEB-DL");
+	item.SetSize(1600*1024*1024);
+
+	TestFilter(&item, "$clowns", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$CLOWNS", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$clownz", FeedItemInfo::msIgnored);
+	TestFilter(&item, "$game\\.of", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$games?\\.of", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$gamex*\\.of", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$gamex{0,1}\\.of", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$gamm+e", FeedItemInfo::msIgnored);
+	TestFilter(&item, "$gam+e", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$(kings|clowns)\\.s02", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$kings|clowns", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$game(xyz)?\\.of", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$g[a-z]me", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$[[:alpha:]]+\\.s02e06", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$[]x]?clowns", FeedItemInfo::msAccepted);
+	TestFilter(&item, "$web-dl$", FeedItemInfo::msAccepted);
+	TestFilter(&item, "-$clownz", FeedItemInfo::msAccepted);
+	TestFilter(&item, "imdbid:$^0$", FeedItemInfo::msAccepted);
+	TestFilter(&item, "imdbid:*0*", FeedItemInfo::msAccepted);
+	TestFilter(&item, "attr-none:0", FeedItemInfo::msAccepted);
+}
+
+TEST_CASE("Feed filter: multiple rules", "[FeedFilter][Quick]")
+{
+	FeedItemInfo item;
+	item.SetTitle("Game.of.Clowns.S02E06.REAL.1080p.HDTV.X264-Group.WEB-DL");
+	item.SetPriority(0);
+
+	// options-rule changes priority, the following rules must see the new value
+	TestFilter(&item, "O(priority:100): clowns % R: priority:<100 % A: priority:100", FeedItemInfo::msAccepted);
+	REQUIRE(item.GetPriority() == 100);
+
+	item.SetPriority(0);
+	TestFilter(&item, "O(k:got): clowns % A: dupekey:got", FeedItemInfo::msAccepted);
+	REQUIRE(item.GetMatchRule() == 2);
+
+	TestFilter(&item, "R: kings % Q: 1080p % A: hdtv", FeedItemInfo::msAccepted);
+	REQUIRE(item.GetMatchRule() == 3);
+	TestFilter(&item, "R: kings % Q: 720p % A: hdtv", FeedItemInfo::msRejected);
+	REQUIRE(item.GetMatchRule() == 2);
+	TestFilter(&item, "A(c:${1}): $(clowns)\\.s02", FeedItemInfo::msAccepted);
+	REQUIRE(!strcmp(item.GetAddCategory(), "Clowns"));
+
+	FeedItemList items;
+	items.emplace_back();
+	items.back().SetTitle("Game.of.Clowns.S02E06.720p");
+	items.emplace_back();
+	items.back().SetTitle("Game.of.Kings.S02E06.720p");
+	items.emplace_back();
+	items.back().SetTitle("Game.of.Clowns.S02E07.1080p");
+
+	FeedFilter filter("R: 720p % A: clowns");
+	filter.Match(items);
+	REQUIRE(items[0].GetMatchStatus() == FeedItemInfo::msRejected);
+	REQUIRE(items[1].GetMatchStatus() == FeedItemInfo::msRejected);
+	REQUIRE(items[2].GetMatchStatus() == FeedItemInfo::msAccepted);
+	REQUIRE(items[2].GetMatchRule() == 2);
+}
+
+TEST_CASE("Feed filter: benchmark", "[FeedFilter][Benchmark][.]")
+{
+	const int ruleCount = 300;
+	const int itemCount = 1000;
+
+	StringBuilder filterDef;
+	for (int i = 0; i < ruleCount; i++)
+	{
+		switch (i % 4)
+		{
+			case 0:
+				filterDef.AppendFmt("R: show%i size:<100MB%%", i);
+				break;
+			case 1:
+				filterDef.AppendFmt("A(c:series): $^show%i\\.s[0-9]+e[0-9]+\\.1080p%%", i);
+				break;
+			case 2:
+				filterDef.AppendFmt("A: show%i* -cam category:*hd*%%", i);
+				break;
+			case 3:
+				filterDef.AppendFmt("O(r:10): title:*show%i.s01* age:<7d%%", i);
+				break;
+		}
+	}
+	filterDef.Append("A: *");
+
+	FeedItemList items;
+	for (int i = 0; i < itemCount; i++)
+	{
+		items.emplace_back();
+		FeedItemInfo& item = items.back();
+		item.SetTitle(BString<100>("Show%i.S%02iE%02i.1080p.HDTV.x264-Group", i, i % 10 + 1, i % 20 + 1));
+		item.SetCategory("TV > HD");
+		item.SetSize((int64)(i + 100) * 1024 * 1024);
+		item.SetTime(Util::CurrentTime() - i * 60);
+	}
+
+	FeedFilter filter(filterDef);
+
+	int64 start = Util::CurrentTicks();
+	filter.Match(items);
+	int64 elapsed = Util::CurrentTicks() - start;
+
+	WARN("Filtered " << itemCount << " items with " << ruleCount << " rules in " << elapsed / 1000 << " ms");
+	for (FeedItemInfo& item : items)
+	{
+		REQUIRE(item.GetMatchStatus() != FeedItemInfo::msIgnored);
+	}
+}
@@ -0,0 +1,222 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Util.h"
+#include "FileSystem.h"
+#include "FaultInjector.h"
+#include "TestUtil.h"
+
+static const int MAX_TRACKED_ATTEMPTS = 100000;
+
+static bool LoadScenario(FaultInjector& faults, const char* scenario)
+{
+	BString<1024> filename("%s%cscenario.txt", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, scenario, strlen(scenario)));
+	return faults.Load(filename);
+}
+
+// fault kinds chosen for a sequence of requests, one character per request
+static std::string FaultSequence(FaultInjector& faults, int serverId, int count, int repeat = 1)
+{
+	std::string result;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < repeat; j++)
+		{
+			FaultInjector::Fault fault = faults.GetArticleFault(serverId, BString<100>("<part%i@nzbget>", i));
+			result += (char)('0' + fault.kind);
+		}
+	}
+	return result;
+}
+
+TEST_CASE("Fault injector: scenario file", "[FaultInjector][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	FaultInjector faults1;
+	REQUIRE(LoadScenario(faults1, "# comment\nseed 42\n\n* missing 2.5\n2 truncate 5 30 # comment\nat 60\n1 reset 100\n"));
+
+	FaultInjector faults2;
+	REQUIRE_FALSE(LoadScenario(faults2, "* unknown 10\n"));
+	FaultInjector faults3;
+	REQUIRE_FALSE(LoadScenario(faults3, "0 missing 10\n"));
+	FaultInjector faults4;
+	REQUIRE_FALSE(LoadScenario(faults4, "* missing 101\n"));
+	FaultInjector faults5;
+	REQUIRE_FALSE(LoadScenario(faults5, "* truncate 10 150\n"));
+	FaultInjector faults6;
+	REQUIRE_FALSE(LoadScenario(faults6, "* missing\n"));
+	FaultInjector faults7;
+	REQUIRE_FALSE(LoadScenario(faults7, "at -1\n"));
+	FaultInjector faults8;
+	REQUIRE_FALSE(LoadScenario(faults8, "seed\n"));
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Fault injector: seeded choice", "[FaultInjector][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	const char* kinds[] = { "missing", "truncate", "corrupt", "stall", "reset" };
+	const int defaults[] = { 0, 50, 0, 60, 50 };
+
+	for (int i = 0; i < 5; i++)
+	{
+		INFO("fault: " << kinds[i]);
+		FaultInjector::EKind kind = (FaultInjector::EKind)(FaultInjector::fkMissing + i);
+		char kindChar = (char)('0' + kind);
+
+		// same seed - same faults
+		FaultInjector faults1;
+		REQUIRE(LoadScenario(faults1, BString<100>("seed 7\n* %s 30\n", kinds[i])));
+		std::string sequence1 = FaultSequence(faults1, 1, 200);
+		FaultInjector faults2;
+		REQUIRE(LoadScenario(faults2, BString<100>("seed 7\n* %s 30\n", kinds[i])));
+		REQUIRE(FaultSequence(faults2, 1, 200) == sequence1);
+
+		// the rate is respected roughly
+		int count = (int)std::count(sequence1.begin(), sequence1.end(), kindChar);
+		REQUIRE(count > 30);
+		REQUIRE(count < 100);
+		REQUIRE((int)std::count(sequence1.begin(), sequence1.end(), '0') == 200 - count);
+
+		// other seed, other server - other faults
+		FaultInjector faults3;
+		REQUIRE(LoadScenario(faults3, BString<100>("seed 8\n* %s 30\n", kinds[i])));
+		REQUIRE(FaultSequence(faults3, 1, 200) != sequence1);
+		REQUIRE(FaultSequence(faults1, 2, 200) != sequence1);
+
+		// retries: missing articles remain missing, other faults are chosen again
+		FaultInjector faults4;
+		REQUIRE(LoadScenario(faults4, BString<100>("seed 7\n* %s 30\n", kinds[i])));
+		std::string retries = FaultSequence(faults4, 1, 200, 2);
+		bool sameOnRetry = true;
+		for (int j = 0; j < 200; j++)
+		{
+			REQUIRE(retries[j * 2] == sequence1[j]);
+			sameOnRetry &= retries[j * 2 + 1] == retries[j * 2];
+		}
+		REQUIRE(sameOnRetry == (kind == FaultInjector::fkMissing));
+
+		// rates 0 and 100, default parameter
+		FaultInjector faults5;
+		REQUIRE(LoadScenario(faults5, BString<100>("* %s 0\n", kinds[i])));
+		REQUIRE(FaultSequence(faults5, 1, 100) == std::string(100, '0'));
+		FaultInjector faults6;
+		REQUIRE(LoadScenario(faults6, BString<100>("1 %s 100\n", kinds[i])));
+		REQUIRE(FaultSequence(faults6, 1, 100) == std::string(100, kindChar));
+		REQUIRE(FaultSequence(faults6, 2, 100) == std::string(100, '0'));
+		REQUIRE(faults6.GetArticleFault(1, "<x@nzbget>").param == defaults[i]);
+		REQUIRE(faults6.GetTlsDelay(1) == 0);
+
+		FaultInjector faults7;
+		REQUIRE(LoadScenario(faults7, BString<100>("* %s 100 20\n", kinds[i])));
+		REQUIRE(faults7.GetArticleFault(1, "<x@nzbget>").param == 20);
+	}
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Fault injector: tls delay", "[FaultInjector][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	FaultInjector faults1;
+	REQUIRE(LoadScenario(faults1, "seed 3\n2 tlsdelay 50 1500\n"));
+	std::string delays1;
+	for (int i = 0; i < 100; i++)
+	{
+		REQUIRE(faults1.GetTlsDelay(1) == 0);
+		int delay = faults1.GetTlsDelay(2);
+		REQUIRE((delay == 0 || delay == 1500));
+		delays1 += delay ? '1' : '0';
+	}
+	REQUIRE(delays1.find('0') != std::string::npos);
+	REQUIRE(delays1.find('1') != std::string::npos);
+
+	// the delay applies to connections, never to articles
+	REQUIRE(FaultSequence(faults1, 2, 100) == std::string(100, '0'));
+
+	FaultInjector faults2;
+	REQUIRE(LoadScenario(faults2, "seed 3\n2 tlsdelay 50 1500\n"));
+	std::string delays2;
+	for (int i = 0; i < 100; i++)
+	{
+		delays2 += faults2.GetTlsDelay(2) ? '1' : '0';
+	}
+	REQUIRE(delays2 == delays1);
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Fault injector: sections", "[FaultInjector][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	FaultInjector faults;
+	REQUIRE(LoadScenario(faults, "* corrupt 100\nat 0.2\n* missing 100\n"));
+	REQUIRE(faults.GetArticleFault(1, "<a@nzbget>").kind == FaultInjector::fkCorrupt);
+
+	// rules of the next section replace the previous ones
+	Util::Sleep(250);
+	REQUIRE(faults.GetArticleFault(1, "<a@nzbget>").kind == FaultInjector::fkMissing);
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Fault injector: attempt counters", "[FaultInjector][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	FaultInjector faults1;
+	REQUIRE(LoadScenario(faults1, "1 corrupt 50\n"));
+	std::string attempts1;
+	for (int i = 0; i < 25; i++)
+	{
+		attempts1 += (char)('0' + faults1.GetArticleFault(1, "<a@nzbget>").kind);
+	}
+	REQUIRE(attempts1.substr(5) != attempts1.substr(0, 20));
+
+	// when the counters are full they start over
+	FaultInjector faults2;
+	REQUIRE(LoadScenario(faults2, "1 corrupt 50\n"));
+	std::string attempts2;
+	for (int i = 0; i < 5; i++)
+	{
+		attempts2 += (char)('0' + faults2.GetArticleFault(1, "<a@nzbget>").kind);
+	}
+	for (int i = 0; i < MAX_TRACKED_ATTEMPTS; i++)
+	{
+		faults2.GetArticleFault(2, BString<100>("<%i@nzbget>", i));
+	}
+	for (int i = 0; i < 20; i++)
+	{
+		attempts2 += (char)('0' + faults2.GetArticleFault(1, "<a@nzbget>").kind);
+	}
+	REQUIRE(attempts2 == attempts1.substr(0, 5) + attempts1.substr(0, 20));
+
+	TestUtil::CleanupWorkingDir();
+}
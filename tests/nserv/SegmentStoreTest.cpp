@@ -0,0 +1,176 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "FileSystem.h"
+#include "SegmentStore.h"
+#include "YEncoder.h"
+#include "TestUtil.h"
+
+static void WriteSource(const char* filename, int len, char fill)
+{
+	std::string content;
+	for (int i = 0; i < len; i++)
+	{
+		content += (char)(fill + i % 50);
+	}
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, content.data(), len));
+}
+
+// article body as served without the store
+static std::string EncodeSegment(const char* filename, int part, int64 offset, int size)
+{
+	std::string result;
+	YEncoder encoder(filename, part, offset, size,
+		[&result](const char* buf, int size)
+		{
+			result.append(buf, size);
+		});
+	CString errmsg;
+	REQUIRE(encoder.OpenFile(errmsg));
+	encoder.WriteSegment();
+	result += ".\r\n";
+	return result;
+}
+
+static std::string StoredSegment(SegmentStore& store, const char* filename, int part, int64 offset, int size)
+{
+	BString<1024> key;
+	SegmentStore::MakeKey(key, filename, part, offset, size);
+	const SegmentStore::Segment* segment = store.Find(key);
+	return segment ? std::string(store.GetData(segment), segment->size) : "";
+}
+
+TEST_CASE("Segment store: encoding", "[SegmentStore][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> dataDir("%s%cdata", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> subDir("%s%cdata%csub", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR, PATH_SEPARATOR);
+	BString<1024> file1("%s%cfile1.dat", *dataDir, PATH_SEPARATOR);
+	BString<1024> file2("%s%cfile2.dat", *subDir, PATH_SEPARATOR);
+	BString<1024> nzbFile("%s%cfile1.nzb", *dataDir, PATH_SEPARATOR);
+	BString<1024> storeFile("%s%cstore.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	CString errmsg;
+	REQUIRE(FileSystem::ForceDirectories(subDir, errmsg));
+	WriteSource(file1, 2500, 'a');
+	WriteSource(file2, 700, 'A');
+	WriteSource(nzbFile, 100, '0');
+
+	SegmentStore store(dataDir, storeFile, 1000);
+	REQUIRE(store.Load());
+
+	// files are split into segments like NzbGenerator does it
+	REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == EncodeSegment(file1, 1, 0, 1000));
+	REQUIRE(StoredSegment(store, "file1.dat", 2, 1000, 1000) == EncodeSegment(file1, 2, 1000, 1000));
+	REQUIRE(StoredSegment(store, "file1.dat", 3, 2000, 500) == EncodeSegment(file1, 3, 2000, 500));
+	REQUIRE(StoredSegment(store, "sub/file2.dat", 1, 0, 700) == EncodeSegment(file2, 1, 0, 700));
+
+	// segments which aren't in the store
+	REQUIRE(StoredSegment(store, "file1.dat", 4, 3000, 1000) == "");
+	REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 500) == "");
+	REQUIRE(StoredSegment(store, "file1.nzb", 1, 0, 100) == "");
+	REQUIRE(StoredSegment(store, "sub", 1, 0, 700) == "");
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Segment store: index", "[SegmentStore][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> dataDir("%s%cdata", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> file1("%s%cfile1.dat", *dataDir, PATH_SEPARATOR);
+	BString<1024> storeFile("%s%cstore.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	CString errmsg;
+	REQUIRE(FileSystem::ForceDirectories(dataDir, errmsg));
+	WriteSource(file1, 2500, 'a');
+
+	std::string segment1 = EncodeSegment(file1, 1, 0, 1000);
+
+	{
+		SegmentStore store(dataDir, storeFile, 1000);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == segment1);
+	}
+
+	// mark the store to see if it is reused or built again
+	CharBuffer content;
+	REQUIRE(FileSystem::LoadFileIntoBuffer(storeFile, content, false));
+	content[0] = '#';
+	REQUIRE(FileSystem::SaveBufferIntoFile(storeFile, content, content.Size()));
+	std::string marked = "#" + segment1.substr(1);
+
+	SECTION("Unchanged files")
+	{
+		SegmentStore store(dataDir, storeFile, 1000);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == marked);
+	}
+
+	SECTION("Changed file")
+	{
+		WriteSource(file1, 2600, 'a');
+		SegmentStore store(dataDir, storeFile, 1000);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == EncodeSegment(file1, 1, 0, 1000));
+		REQUIRE(StoredSegment(store, "file1.dat", 3, 2000, 600) == EncodeSegment(file1, 3, 2000, 600));
+	}
+
+	SECTION("New file")
+	{
+		BString<1024> file2("%s%cfile2.dat", *dataDir, PATH_SEPARATOR);
+		WriteSource(file2, 700, 'A');
+		SegmentStore store(dataDir, storeFile, 1000);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == segment1);
+		REQUIRE(StoredSegment(store, "file2.dat", 1, 0, 700) == EncodeSegment(file2, 1, 0, 700));
+	}
+
+	SECTION("Other segment size")
+	{
+		SegmentStore store(dataDir, storeFile, 500);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == "");
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 500) == EncodeSegment(file1, 1, 0, 500));
+		REQUIRE(StoredSegment(store, "file1.dat", 5, 2000, 500) == EncodeSegment(file1, 5, 2000, 500));
+	}
+
+	SECTION("Truncated store")
+	{
+		REQUIRE(FileSystem::SaveBufferIntoFile(storeFile, content, 100));
+		SegmentStore store(dataDir, storeFile, 1000);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 3, 2000, 500) == EncodeSegment(file1, 3, 2000, 500));
+	}
+
+	SECTION("Missing index")
+	{
+		FileSystem::DeleteFile(BString<1024>("%s.idx", *storeFile));
+		SegmentStore store(dataDir, storeFile, 1000);
+		REQUIRE(store.Load());
+		REQUIRE(StoredSegment(store, "file1.dat", 1, 0, 1000) == segment1);
+	}
+
+	TestUtil::CleanupWorkingDir();
+}
@@ -0,0 +1,145 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "DirectParVerifier.h"
+#include "Util.h"
+
+static uint32 CalcCrc(const char* data, int size)
+{
+	Crc32 crc;
+	crc.Append((uchar*)data, size);
+	return crc.Finish();
+}
+
+static void PrepareParSet(DirectParVerifier::ParSet* parSet, const char* data)
+{
+	// 3 blocks of 100 bytes, the last block is padded with zeros
+	char block[100];
+	parSet->m_blockSize = 100;
+	parSet->m_sourceFiles.emplace_back("file.rar", "", 250);
+	for (int i = 0; i < 3; i++)
+	{
+		memset(block, 0, sizeof(block));
+		memcpy(block, data + i * 100, i < 2 ? 100 : 50);
+		parSet->m_sourceFiles.back().m_blockCrcs.push_back(CalcCrc(block, sizeof(block)));
+	}
+}
+
+TEST_CASE("Direct par-verifier: complete file", "[Par][DirectParVerifier][Quick]")
+{
+	char data[250];
+	for (int i = 0; i < 250; i++) data[i] = (char)(i * 7);
+
+	DirectParVerifier::ParSet parSet;
+	PrepareParSet(&parSet, data);
+
+	DirectParVerifier::DownloadedFile goodFile("file.rar", "", CompletedFile::cfSuccess, CalcCrc(data, 250));
+	goodFile.m_size = 250;
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &goodFile) == 0);
+
+	data[120]++;
+	DirectParVerifier::DownloadedFile badFile("file.rar", "", CompletedFile::cfSuccess, CalcCrc(data, 250));
+	badFile.m_size = 250;
+	// the checksum of the whole file can't tell the damaged block, all blocks are considered damaged
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &badFile) == 3);
+
+	DirectParVerifier::DownloadedFile shortFile("file.rar", "", CompletedFile::cfSuccess, CalcCrc(data, 200));
+	shortFile.m_size = 200;
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &shortFile) ==
+		DirectParVerifier::vrNotMatching);
+}
+
+TEST_CASE("Direct par-verifier: partial file", "[Par][DirectParVerifier][Quick]")
+{
+	char data[250];
+	for (int i = 0; i < 250; i++) data[i] = (char)(i * 7);
+
+	DirectParVerifier::ParSet parSet;
+	PrepareParSet(&parSet, data);
+
+	DirectParVerifier::DownloadedFile alignedFile("file.rar", "", CompletedFile::cfPartial, 0);
+	alignedFile.m_segments.emplace_back(true, 0, 100, 0);
+	alignedFile.m_segments.emplace_back(false, 100, 100, 0);
+	alignedFile.m_segments.emplace_back(true, 200, 50, 0);
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &alignedFile) == 1);
+
+	DirectParVerifier::DownloadedFile unalignedFile("file.rar", "", CompletedFile::cfPartial, 0);
+	unalignedFile.m_segments.emplace_back(true, 0, 60, 0);
+	unalignedFile.m_segments.emplace_back(true, 60, 60, 0);
+	unalignedFile.m_segments.emplace_back(false, 0, 0, 0);
+	unalignedFile.m_segments.emplace_back(true, 180, 60, 0);
+	unalignedFile.m_segments.emplace_back(true, 240, 10, 0);
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &unalignedFile) == 1);
+
+	DirectParVerifier::DownloadedFile lastMissingFile("file.rar", "", CompletedFile::cfPartial, 0);
+	lastMissingFile.m_segments.emplace_back(true, 0, 120, 0);
+	lastMissingFile.m_segments.emplace_back(true, 120, 120, 0);
+	lastMissingFile.m_segments.emplace_back(false, 0, 0, 0);
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &lastMissingFile) == 1);
+
+	DirectParVerifier::DownloadedFile failedFile("file.rar", "", CompletedFile::cfFailure, 0);
+	REQUIRE(DirectParVerifier::CalcDamagedBlocks(&parSet, &parSet.m_sourceFiles.front(), &failedFile) == 3);
+}
+
+TEST_CASE("Direct par-verifier: verified files", "[Par][DirectParVerifier][Quick]")
+{
+	DirectParVerifier::DownloadedFileList files;
+
+	files.emplace_back("good.rar", "", CompletedFile::cfSuccess, 0);
+	files.back().m_matched = true;
+	files.back().m_sourceFilename = "good.rar";
+	files.back().m_sourceSize = 250;
+
+	files.emplace_back("bad.rar", "", CompletedFile::cfSuccess, 0);
+	files.back().m_matched = true;
+	files.back().m_damagedBlocks = 3;
+
+	files.emplace_back("wrongsize.rar", "", CompletedFile::cfSuccess, 0);
+	files.back().m_matched = true;
+	files.back().m_damagedBlocks = DirectParVerifier::vrNotMatching;
+
+	files.emplace_back("partial.rar.renamed", "", CompletedFile::cfPartial, 0);
+	files.back().m_matched = true;
+	files.back().m_sourceFilename = "partial.rar";
+	files.back().m_sourceSize = 250;
+	files.back().m_damagedBlocks = 1;
+	files.back().m_segments.emplace_back(true, 0, 100, 1);
+	files.back().m_segments.emplace_back(false, 100, 100, 0);
+	files.back().m_segments.emplace_back(true, 200, 50, 2);
+
+	files.emplace_back("unknown.rar", "", CompletedFile::cfSuccess, 0);
+
+	PostInfo::DirectParFiles directParFiles;
+	DirectParVerifier::TakeVerifiedFiles(&files, &directParFiles);
+
+	REQUIRE(directParFiles.size() == 2);
+	REQUIRE(!strcmp(directParFiles[0].GetFilename(), "good.rar"));
+	REQUIRE(directParFiles[0].GetSize() == 250);
+	REQUIRE(directParFiles[0].GetStatus() == CompletedFile::cfSuccess);
+	REQUIRE(directParFiles[0].GetSegments()->empty());
+	REQUIRE(!strcmp(directParFiles[1].GetFilename(), "partial.rar"));
+	REQUIRE(directParFiles[1].GetStatus() == CompletedFile::cfPartial);
+	REQUIRE(directParFiles[1].GetSegments()->size() == 3);
+	REQUIRE(directParFiles[1].GetSegments()->at(2).m_crc == 2);
+}
@@ -142,3 +142,54 @@ TEST_CASE("Direct-unpack two archives", "[Rar][DirectUnpack][Unrar][Slow][TestDa
 	REQUIRE(FileSystem::FileExists((TestUtil::WorkingDir() + "/_unpack/testfile3.dat").c_str()));
 	REQUIRE(FileSystem::FileExists((TestUtil::WorkingDir() + "/_unpack/testfile5.dat").c_str()));
 }
+
+#ifndef WIN32
+TEST_CASE("Direct-unpack missing volume", "[Rar][DirectUnpack][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	// fake unrar asking for a volume which will never come
+	std::string unrarCmd = TestUtil::WorkingDir() + "/unrar.sh";
+	const char* scriptText = "#!/bin/sh\n"
+		"printf 'Insert disk with testfile3.part02.rar [C]ontinue, [Q]uit '\n"
+		"read answer\n"
+		"exit 1\n";
+	REQUIRE(FileSystem::SaveBufferIntoFile(unrarCmd.c_str(), scriptText, strlen(scriptText)));
+	chmod(unrarCmd.c_str(), S_IRWXU);
+
+	REQUIRE(FileSystem::SaveBufferIntoFile((TestUtil::WorkingDir() + "/testfile3.part01.rar").c_str(), "rar", 3));
+
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back("NzbLog=no");
+	BString<1024> unrarCmdOpt("UnrarCmd=%s", unrarCmd.c_str());
+	cmdOpts.push_back(unrarCmdOpt);
+	Options options(&cmdOpts, nullptr);
+
+	DirectUnpackDownloadQueueMock downloadQueue;
+
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	NzbInfo* nzbPtr = nzbInfo.get();
+	nzbInfo->SetName("test");
+	nzbInfo->SetDestDir(TestUtil::WorkingDir().c_str());
+	downloadQueue.GetQueue()->Add(std::move(nzbInfo), false);
+
+	{
+		// the nzb is completed before unrar asks for the next volume
+		GuardedDownloadQueue guard = DownloadQueue::Guard();
+		DirectUnpack::StartJob(nzbPtr);
+		((DirectUnpack*)nzbPtr->GetUnpackThread())->NzbDownloaded(guard, nzbPtr);
+	}
+
+	for (int i = 0; i < 500 && nzbPtr->GetDirectUnpackStatus() == NzbInfo::nsRunning; i++)
+	{
+		Util::Sleep(20);
+	}
+
+	// used to hang here: the unpack thread locked the queue twice on "Could not find volume"
+	REQUIRE(nzbPtr->GetDirectUnpackStatus() == NzbInfo::nsFailure);
+
+	// let the unpack thread finish
+	GuardedDownloadQueue guard = DownloadQueue::Guard();
+}
+#endif
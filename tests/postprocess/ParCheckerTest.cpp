@@ -147,6 +147,21 @@ TEST_CASE("Par-checker: repair successful", "[Par][ParChecker][Slow][TestData]")
 	REQUIRE(parChecker.GetParFull() == true);
 }
 
+TEST_CASE("Par-checker: repair successful using threads", "[Par][ParChecker][Slow][TestData]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("ParRepair=yes");
+	cmdOpts.push_back("ParThreads=2");
+	Options options(&cmdOpts, nullptr);
+
+	ParCheckerMock parChecker;
+	parChecker.CorruptFile("testfile.dat", 20000);
+	parChecker.CorruptFile("testfile.dat", 60000);
+	parChecker.Execute();
+
+	REQUIRE(parChecker.GetStatus() == ParChecker::psRepaired);
+}
+
 TEST_CASE("Par-checker: repair failed", "[Par][ParChecker][Slow][TestData]")
 {
 	Options::CmdOptList cmdOpts;
@@ -0,0 +1,184 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "WorkState.h"
+#include "QueueScript.h"
+#include "PrePostProcessor.h"
+
+class PostDownloadQueueMock : public DownloadQueue
+{
+public:
+	PostDownloadQueueMock() { Init(this); }
+	~PostDownloadQueueMock() { Final(); }
+	virtual bool EditEntry(int ID, EEditAction action, const char* args) { return false; };
+	virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
+		EEditAction action, const char* args) { return false; }
+	virtual void HistoryChanged() {}
+	virtual void Save() {};
+	virtual void SaveChanged() {}
+};
+
+class PrePostProcessorMock : public PrePostProcessor
+{
+public:
+	using PrePostProcessor::CanRunMoreJobs;
+	using PrePostProcessor::PickNextJob;
+	using PrePostProcessor::HasClassCapacity;
+	RawNzbList* GetActiveJobs() { return &m_activeJobs; }
+};
+
+static NzbInfo* AddPostJob(DownloadQueue* downloadQueue, const char* name, int priority,
+	PostInfo::EStage stage, PostInfo::EStage waitStage)
+{
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	nzbInfo->SetName(name);
+	nzbInfo->SetPriority(priority);
+	nzbInfo->EnterPostProcess();
+	nzbInfo->GetPostInfo()->SetStage(stage);
+	nzbInfo->GetPostInfo()->SetWaitStage(waitStage);
+	NzbInfo* result = nzbInfo.get();
+	downloadQueue->GetQueue()->Add(std::move(nzbInfo), false);
+	return result;
+}
+
+TEST_CASE("Staged post-processing: stage classes", "[PrePostProcessor][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back("PostCpuJobs=2");
+	cmdOpts.push_back("PostDiskJobs=3");
+	cmdOpts.push_back("PostScriptJobs=0");
+	Options options(&cmdOpts, nullptr);
+
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptVerifyingSources) == PrePostProcessor::rcCpu);
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptRepairing) == PrePostProcessor::rcCpu);
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptRarRenaming) == PrePostProcessor::rcDisk);
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptUnpacking) == PrePostProcessor::rcDisk);
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptMoving) == PrePostProcessor::rcDisk);
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptExecutingScript) == PrePostProcessor::rcScript);
+	REQUIRE(PrePostProcessor::GetStageClass(PostInfo::ptQueued) == PrePostProcessor::rcNone);
+
+	REQUIRE(PrePostProcessor::GetClassLimit(PrePostProcessor::rcCpu) == 2);
+	REQUIRE(PrePostProcessor::GetClassLimit(PrePostProcessor::rcDisk) == 3);
+	// a class can't be switched off completely
+	REQUIRE(PrePostProcessor::GetClassLimit(PrePostProcessor::rcScript) == 1);
+}
+
+TEST_CASE("Staged post-processing: class capacity", "[PrePostProcessor][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back("PostStrategy=staged");
+	cmdOpts.push_back("PostCpuJobs=1");
+	cmdOpts.push_back("PostDiskJobs=2");
+	cmdOpts.push_back("PostScriptJobs=1");
+	Options options(&cmdOpts, nullptr);
+
+	PostDownloadQueueMock downloadQueue;
+	PrePostProcessorMock prePostProcessor;
+	RawNzbList* activeJobs = prePostProcessor.GetActiveJobs();
+	bool allowPar = false;
+
+	REQUIRE(prePostProcessor.CanRunMoreJobs(&allowPar));
+	REQUIRE(allowPar);
+
+	// the only cpu slot is taken: no more par-jobs but other classes are still free
+	activeJobs->push_back(AddPostJob(&downloadQueue, "repair", 0, PostInfo::ptRepairing, PostInfo::ptQueued));
+	REQUIRE(prePostProcessor.CanRunMoreJobs(&allowPar));
+	REQUIRE_FALSE(allowPar);
+	REQUIRE_FALSE(prePostProcessor.HasClassCapacity(PrePostProcessor::rcCpu));
+
+	activeJobs->push_back(AddPostJob(&downloadQueue, "unpack1", 0, PostInfo::ptUnpacking, PostInfo::ptQueued));
+	REQUIRE(prePostProcessor.HasClassCapacity(PrePostProcessor::rcDisk));
+	activeJobs->push_back(AddPostJob(&downloadQueue, "unpack2", 0, PostInfo::ptMoving, PostInfo::ptQueued));
+	REQUIRE_FALSE(prePostProcessor.HasClassCapacity(PrePostProcessor::rcDisk));
+	REQUIRE(prePostProcessor.HasClassCapacity(PrePostProcessor::rcScript));
+	REQUIRE(prePostProcessor.CanRunMoreJobs(&allowPar));
+
+	// all classes are full
+	activeJobs->push_back(AddPostJob(&downloadQueue, "script", 0, PostInfo::ptExecutingScript, PostInfo::ptQueued));
+	REQUIRE_FALSE(prePostProcessor.CanRunMoreJobs(&allowPar));
+	REQUIRE_FALSE(allowPar);
+
+	// a job moving to another stage frees the slot of its previous class
+	activeJobs->at(0)->GetPostInfo()->SetStage(PostInfo::ptUnpacking);
+	REQUIRE(prePostProcessor.CanRunMoreJobs(&allowPar));
+	REQUIRE(allowPar);
+	REQUIRE(!prePostProcessor.HasClassCapacity(PrePostProcessor::rcDisk));
+}
+
+TEST_CASE("Staged post-processing: job order", "[PrePostProcessor][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back("PostStrategy=staged");
+	cmdOpts.push_back("PostCpuJobs=1");
+	cmdOpts.push_back("PostDiskJobs=1");
+	cmdOpts.push_back("PostScriptJobs=1");
+	Options options(&cmdOpts, nullptr);
+
+	PostDownloadQueueMock downloadQueue;
+	WorkState workState;
+	g_WorkState = &workState;
+	QueueScriptCoordinator queueScriptCoordinator;
+	g_QueueScriptCoordinator = &queueScriptCoordinator;
+	PrePostProcessorMock prePostProcessor;
+	RawNzbList* activeJobs = prePostProcessor.GetActiveJobs();
+
+	NzbInfo* unpacking = AddPostJob(&downloadQueue, "unpacking", 300, PostInfo::ptUnpacking, PostInfo::ptQueued);
+	NzbInfo* waitUnpack = AddPostJob(&downloadQueue, "wait-unpack", 200, PostInfo::ptRepairing, PostInfo::ptUnpacking);
+	NzbInfo* needPar = AddPostJob(&downloadQueue, "need-par", 100, PostInfo::ptQueued, PostInfo::ptQueued);
+	needPar->GetPostInfo()->SetNeedParCheck(true);
+	NzbInfo* waitScript = AddPostJob(&downloadQueue, "wait-script", 50, PostInfo::ptMoving, PostInfo::ptExecutingScript);
+	NzbInfo* queued = AddPostJob(&downloadQueue, "queued", 0, PostInfo::ptQueued, PostInfo::ptQueued);
+
+	// active jobs are never picked again, even with the highest priority
+	activeJobs->push_back(unpacking);
+
+	// disk class is full: the job waiting for unpack is skipped,
+	// the highest priority job among the remaining ones is picked
+	REQUIRE(prePostProcessor.PickNextJob(&downloadQueue, true) == needPar);
+
+	// without par-slot the par-job is skipped too
+	REQUIRE(prePostProcessor.PickNextJob(&downloadQueue, false) == waitScript);
+
+	// script class is full as well
+	activeJobs->push_back(AddPostJob(&downloadQueue, "script", -100, PostInfo::ptExecutingScript, PostInfo::ptQueued));
+	REQUIRE(prePostProcessor.PickNextJob(&downloadQueue, false) == queued);
+
+	// disk slot becomes free: the waiting job wins by priority
+	unpacking->GetPostInfo()->SetStage(PostInfo::ptExecutingScript);
+	activeJobs->erase(activeJobs->begin() + 1);
+	REQUIRE(prePostProcessor.PickNextJob(&downloadQueue, false) == waitUnpack);
+
+	// jobs paused by the user are not started
+	workState.SetPausePostProcess(true);
+	REQUIRE(prePostProcessor.PickNextJob(&downloadQueue, true) == nullptr);
+	queued->SetPriority(NzbInfo::FORCE_PRIORITY);
+	REQUIRE(prePostProcessor.PickNextJob(&downloadQueue, true) == queued);
+
+	g_QueueScriptCoordinator = nullptr;
+	g_WorkState = nullptr;
+}
@@ -110,6 +110,46 @@ TEST_CASE("Rar-reader: rar3 old naming", "[Rar][RarReader][Slow][TestData]")
 	}
 }
 
+TEST_CASE("Rar-reader: serialize", "[Rar][RarReader][Slow][TestData]")
+{
+	RarVolume volume((TestUtil::TestDataDir() + "/rarrenamer/testfile5.part02.rar").c_str());
+	REQUIRE(volume.Read() == true);
+
+	RarVolume restored("restored.rar");
+	REQUIRE(restored.Deserialize(volume.Serialize()) == true);
+	REQUIRE(restored.GetVersion() == 5);
+	REQUIRE(restored.GetMultiVolume() == true);
+	REQUIRE(restored.GetNewNaming() == true);
+	REQUIRE(restored.GetVolumeNo() == 1);
+	REQUIRE(restored.GetHasNextVolume() == volume.GetHasNextVolume());
+	REQUIRE(restored.GetFiles()->size() == volume.GetFiles()->size());
+	REQUIRE(!strcmp(restored.GetFiles()->front().GetFilename(), volume.GetFiles()->front().GetFilename()));
+	REQUIRE(restored.GetFiles()->front().GetSize() == volume.GetFiles()->front().GetSize());
+	REQUIRE(restored.GetFiles()->front().GetSplitBefore() == volume.GetFiles()->front().GetSplitBefore());
+	REQUIRE(restored.GetFiles()->front().GetSplitAfter() == volume.GetFiles()->front().GetSplitAfter());
+
+	REQUIRE(restored.Deserialize("garbage") == false);
+}
+
+TEST_CASE("Rar-reader: serialize special filenames", "[Rar][RarReader][Quick]")
+{
+	// tabs and line breaks in filenames must not break the tab-separated single-line format
+	const char* data = "5,1,1,1,1,0\t100,10,20,0,1,a%09b,c%0D%0A%25.txt\t200,0,0,1,0,plain 100%25.txt";
+
+	RarVolume volume("volume.rar");
+	REQUIRE(volume.Deserialize(data) == true);
+	REQUIRE(volume.GetFiles()->size() == 2);
+	REQUIRE(!strcmp(volume.GetFiles()->front().GetFilename(), "a\tb,c\r\n%.txt"));
+	REQUIRE(volume.GetFiles()->front().GetSize() == 100);
+	REQUIRE(volume.GetFiles()->front().GetSplitAfter() == true);
+	REQUIRE(!strcmp(volume.GetFiles()->back().GetFilename(), "plain 100%.txt"));
+	REQUIRE(!strcmp(volume.Serialize(), data));
+
+	REQUIRE(volume.Deserialize("5,1,1,1,1,0\t100,10,20,0,1,name%4") == false);
+	REQUIRE(volume.Deserialize("5,1,1,1,1,0\t100,10,20,0,1,name%zz") == false);
+	REQUIRE(volume.Deserialize("5,1,1,1,1,0\t100,10,20,0,1,name%00") == false);
+}
+
 #ifndef DISABLE_TLS
 
 TEST_CASE("Rar-reader: rar3 encrypted data", "[Rar][RarReader][Slow][TestData]")
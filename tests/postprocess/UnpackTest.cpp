@@ -0,0 +1,313 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "Unpack.h"
+#include "FileSystem.h"
+#include "Util.h"
+#include "TestUtil.h"
+
+#ifndef WIN32
+
+class UnpackDownloadQueueMock : public DownloadQueue
+{
+public:
+	UnpackDownloadQueueMock() { Init(this); }
+	~UnpackDownloadQueueMock() { Final(); }
+	virtual bool EditEntry(int ID, EEditAction action, const char* args) { return false; };
+	virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
+		EEditAction action, const char* args) { return false; }
+	virtual void HistoryChanged() {}
+	virtual void Save() {};
+	virtual void SaveChanged() {}
+};
+
+struct UnpackResult
+{
+	NzbInfo::EPostUnpackStatus status;
+	std::vector<std::string> messages;
+	std::vector<std::string> calls;
+
+	int Find(const char* text)
+	{
+		std::vector<std::string>::iterator it = std::find(messages.begin(), messages.end(), text);
+		return it != messages.end() ? (int)(it - messages.begin()) : -1;
+	}
+};
+
+static std::vector<std::string> ReadLines(const char* filename)
+{
+	std::vector<std::string> lines;
+	DiskFile infile;
+	if (infile.Open(filename, DiskFile::omRead))
+	{
+		char line[1024];
+		while (infile.ReadLine(line, sizeof(line)))
+		{
+			Util::TrimRight(line);
+			lines.push_back(line);
+		}
+	}
+	return lines;
+}
+
+// volume filename and serialized rar-headers in the rar-index of nzb (empty if not indexed)
+typedef std::vector<std::pair<std::string, std::string>> VolumeList;
+
+// two rar-sets ("first" and "second")
+static const VolumeList SeparateSets = {
+	{"first.part1.rar", "5,0,1,1,1,0"},
+	{"first.part2.rar", "5,1,1,0,1,0"},
+	{"second.rar", "5,0,0,0,0,0"}};
+
+/*
+ * Unpacks rar-sets with a fake unrar, which records its calls.
+ * The first set waits until the second set is being extracted. The given shell commands
+ * are executed when extracting the second set.
+ */
+static UnpackResult Unpack(const char* secondSetCommands, bool passFile,
+	const VolumeList& volumes = SeparateSets)
+{
+	TestUtil::PrepareWorkingDir("empty");
+	std::string workingDir = TestUtil::WorkingDir();
+	std::string destDir = workingDir + "/dest";
+	std::string unrarCmd = workingDir + "/unrar.sh";
+	std::string callsFile = workingDir + "/calls.log";
+	std::string passwordsFile = workingDir + "/passwords.txt";
+
+	CString errmsg;
+	REQUIRE(FileSystem::ForceDirectories(destDir.c_str(), errmsg));
+	for (const std::pair<std::string, std::string>& volume : volumes)
+	{
+		REQUIRE(FileSystem::SaveBufferIntoFile((destDir + "/" + volume.first).c_str(), "rar", 3));
+	}
+
+	// arguments: x -y -p<password> -o+ <archive> <unpack-dir>/
+	CString script = CString::FormatStr(
+		"#!/bin/sh\n"
+		"echo \"$5 $3\" >> \"%s\"\n"
+		"echo \"Extracting from $5\"\n"
+		"case \"$5\" in\n"
+		"first*)\n"
+		"  i=0\n"
+		"  while [ ! -f \"%s/second.started\" ] && [ $i -lt 100 ]; do sleep 0.05; i=$((i+1)); done\n"
+		"  [ -f \"%s/second.started\" ] && echo \"Second set is being extracted\"\n"
+		"  echo data > \"$6first.dat\"\n"
+		"  ;;\n"
+		"second*)\n"
+		"  touch \"%s/second.started\"\n"
+		"  %s\n"
+		"  echo data > \"$6second.dat\"\n"
+		"  ;;\n"
+		"esac\n"
+		"echo \"Done $5\"\n"
+		"echo \"All OK\"\n",
+		callsFile.c_str(), workingDir.c_str(), workingDir.c_str(), workingDir.c_str(), secondSetCommands);
+	REQUIRE(FileSystem::SaveBufferIntoFile(unrarCmd.c_str(), script, script.Length()));
+	FileSystem::FixExecPermission(unrarCmd.c_str());
+
+	CString unrarOption = CString::FormatStr("UnrarCmd=%s", unrarCmd.c_str());
+	CString passFileOption = CString::FormatStr("UnpackPassFile=%s", passwordsFile.c_str());
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back("NzbLog=no");
+	cmdOpts.push_back("UnpackThreads=2");
+	cmdOpts.push_back("UnpackCleanupDisk=yes");
+	cmdOpts.push_back(unrarOption);
+	if (passFile)
+	{
+		REQUIRE(FileSystem::SaveBufferIntoFile(passwordsFile.c_str(), "wrong\nsecret\n", 13));
+		cmdOpts.push_back(passFileOption);
+	}
+	Options options(&cmdOpts, nullptr);
+
+	UnpackDownloadQueueMock downloadQueue;
+
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	NzbInfo* nzbPtr = nzbInfo.get();
+	nzbInfo->SetName("test");
+	nzbInfo->SetDestDir(destDir.c_str());
+	nzbInfo->EnterPostProcess();
+	int id = 0;
+	for (const std::pair<std::string, std::string>& volume : volumes)
+	{
+		if (!volume.second.empty())
+		{
+			nzbInfo->GetCompletedFiles()->emplace_back(++id, volume.first.c_str(), nullptr,
+				CompletedFile::cfSuccess, 0, false, nullptr, nullptr);
+			nzbInfo->GetCompletedFiles()->back().SetRarInfo(volume.second.c_str());
+		}
+	}
+	downloadQueue.GetQueue()->Add(std::move(nzbInfo), false);
+
+	PostInfo* postInfo = nzbPtr->GetPostInfo();
+	postInfo->SetWorking(true);
+	UnpackController::StartJob(postInfo);
+
+	while (postInfo->GetWorking() || postInfo->GetPostThread()->IsRunning())
+	{
+		Util::Sleep(20);
+	}
+	delete postInfo->GetPostThread();
+	postInfo->SetPostThread(nullptr);
+
+	UnpackResult result;
+	result.status = nzbPtr->GetUnpackStatus();
+	for (Message& message : *nzbPtr->GuardCachedMessages())
+	{
+		result.messages.push_back(message.GetText());
+	}
+	result.calls = ReadLines(callsFile.c_str());
+
+	downloadQueue.GetQueue()->clear();
+
+	return result;
+}
+
+TEST_CASE("Unpack rar-sets in parallel", "[Unpack][Slow]")
+{
+	UnpackResult result = Unpack("", false);
+
+	REQUIRE(result.status == NzbInfo::usSuccess);
+	REQUIRE(result.calls.size() == 2);
+	REQUIRE(result.Find("Unrar: Second set is being extracted") > -1);
+
+	// messages of each set are kept in order and between start and completion of the job
+	int start = result.Find("Unpacking 2 rar-sets using 2 unrar-processes");
+	int completed = result.Find("Unpack for test successful");
+	REQUIRE(start > -1);
+	for (const char* archive : {"first.part1.rar", "second.rar"})
+	{
+		INFO("archive: " << archive);
+		int extracting = result.Find(BString<100>("Unrar: Extracting from %s", archive));
+		int done = result.Find(BString<100>("Unrar: Done %s", archive));
+		REQUIRE(start < extracting);
+		REQUIRE(extracting < done);
+		REQUIRE(done < completed);
+	}
+
+	std::string destDir = TestUtil::WorkingDir() + "/dest";
+	REQUIRE(FileSystem::FileExists((destDir + "/first.dat").c_str()));
+	REQUIRE(FileSystem::FileExists((destDir + "/second.dat").c_str()));
+	REQUIRE(!FileSystem::FileExists((destDir + "/second.rar").c_str()));
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Unpack rar-sets in parallel with failure", "[Unpack][Slow]")
+{
+	UnpackResult result = Unpack("echo \"Unexpected end of archive\"; exit 3", false);
+
+	// one failed set fails the whole job, no files are taken from the successful set
+	REQUIRE(result.status == NzbInfo::usFailure);
+	REQUIRE(result.calls.size() == 2);
+	REQUIRE(result.Find("Unrar: Done first.part1.rar") > -1);
+	REQUIRE(result.Find("Unrar: Done second.rar") == -1);
+	int errorCode = result.Find("Unrar error code: 3");
+	int failed = result.Find("Unpack for test failed");
+	REQUIRE(errorCode > -1);
+	REQUIRE(errorCode < failed);
+
+	std::string destDir = TestUtil::WorkingDir() + "/dest";
+	REQUIRE(!FileSystem::FileExists((destDir + "/first.dat").c_str()));
+	REQUIRE(FileSystem::FileExists((destDir + "/second.rar").c_str()));
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Unpack rar-sets in parallel with password list", "[Unpack][Slow]")
+{
+	UnpackResult result = Unpack(
+		"if [ \"$3\" != \"-psecret\" ]; then echo \"The specified password is incorrect.\"; exit 11; fi", true);
+
+	REQUIRE(result.status == NzbInfo::usSuccess);
+
+	// only the set which wasn't unpacked yet is tried with further passwords
+	REQUIRE(result.calls.size() == 4);
+	std::vector<std::string> firstRound(result.calls.begin(), result.calls.begin() + 2);
+	std::sort(firstRound.begin(), firstRound.end());
+	REQUIRE(firstRound[0] == "first.part1.rar -p-");
+	REQUIRE(firstRound[1] == "second.rar -p-");
+	REQUIRE(result.calls[2] == "second.rar -pwrong");
+	REQUIRE(result.calls[3] == "second.rar -psecret");
+
+	int tryWrong = result.Find("Trying password wrong for test");
+	int trySecret = result.Find("Trying password secret for test");
+	REQUIRE(result.Find("Unrar: Done first.part1.rar") < tryWrong);
+	REQUIRE(tryWrong < trySecret);
+	REQUIRE(trySecret < result.Find("Unrar: Done second.rar"));
+
+	std::string destDir = TestUtil::WorkingDir() + "/dest";
+	REQUIRE(FileSystem::FileExists((destDir + "/first.dat").c_str()));
+	REQUIRE(FileSystem::FileExists((destDir + "/second.dat").c_str()));
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Unpack rar-sets with obfuscated names", "[Unpack][Slow]")
+{
+	// "abc.rar" and "def.rar" are volumes of one set, which unrar can't tell from the names
+	VolumeList volumes = {
+		{"abc.rar", "5,0,1,1,1,0"},
+		{"def.rar", "5,1,1,0,1,0"},
+		{"ghi.rar", "5,0,0,0,0,0"}};
+
+	SECTION("indexed")
+	{
+	}
+
+	SECTION("not indexed")
+	{
+		for (std::pair<std::string, std::string>& volume : volumes)
+		{
+			volume.second.clear();
+		}
+	}
+
+	UnpackResult result = Unpack("", false, volumes);
+
+	// all volumes are unpacked with one unrar-process
+	REQUIRE(result.status == NzbInfo::usSuccess);
+	REQUIRE(result.calls.size() == 1);
+	REQUIRE(result.calls[0] == "*.rar -p-");
+	REQUIRE(result.Find("Unrar: Extracting from *.rar") > -1);
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Unpack rar-sets with volumes not indexed", "[Unpack][Slow]")
+{
+	VolumeList volumes = SeparateSets;
+	volumes[1].second.clear();
+
+	UnpackResult result = Unpack("", false, volumes);
+
+	REQUIRE(result.status == NzbInfo::usSuccess);
+	REQUIRE(result.calls.size() == 1);
+	REQUIRE(result.calls[0] == "*.rar -p-");
+
+	TestUtil::CleanupWorkingDir();
+}
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "DiskState.h"
+#include "FileSystem.h"
+#include "TestUtil.h"
+
+static void CheckMessages(MessageList& messages, int firstId, int lastId)
+{
+	REQUIRE(messages.size() == (size_t)(lastId - firstId + 1));
+	for (int id = firstId; id <= lastId; id++)
+	{
+		Message& message = messages.at(id - firstId);
+		REQUIRE(message.GetId() == id);
+		REQUIRE(message.GetKind() == (id % 2 ? Message::mkInfo : Message::mkWarning));
+		REQUIRE(!strcmp(message.GetText(), BString<100>("message %i", id)));
+	}
+}
+
+TEST_CASE("Nzb log", "[DiskState][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> queueDirOpt("QueueDir=%s", TestUtil::WorkingDir().c_str());
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back(queueDirOpt);
+	Options options(&cmdOpts, nullptr);
+
+	DiskState diskState;
+	const int nzbId = 7;
+
+	for (int id = 1; id <= 10; id++)
+	{
+		diskState.AppendNzbMessage(nzbId, id % 2 ? Message::mkInfo : Message::mkWarning, BString<100>("message %i", id));
+	}
+
+	MessageList messages;
+	diskState.LoadNzbMessages(nzbId, &messages);
+	CheckMessages(messages, 1, 10);
+
+	// last entries
+	messages.clear();
+	diskState.LoadNzbMessages(nzbId, &messages, 0, 3);
+	CheckMessages(messages, 8, 10);
+
+	messages.clear();
+	diskState.LoadNzbMessages(nzbId, &messages, 0, 30);
+	CheckMessages(messages, 1, 10);
+
+	// entries starting with id, also after the log has grown
+	for (int id = 11; id <= 15; id++)
+	{
+		diskState.AppendNzbMessage(nzbId, id % 2 ? Message::mkInfo : Message::mkWarning, BString<100>("message %i", id));
+	}
+
+	messages.clear();
+	diskState.LoadNzbMessages(nzbId, &messages, 9, 0);
+	CheckMessages(messages, 9, 15);
+
+	messages.clear();
+	diskState.LoadNzbMessages(nzbId, &messages, 16, 0);
+	REQUIRE(messages.empty());
+
+	// recreated log-file
+	BString<1024> logFilename("%s%cn%i.log", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR, nzbId);
+	REQUIRE(FileSystem::DeleteFile(logFilename));
+	for (int id = 1; id <= 2; id++)
+	{
+		diskState.AppendNzbMessage(nzbId, id % 2 ? Message::mkInfo : Message::mkWarning, BString<100>("message %i", id));
+	}
+
+	messages.clear();
+	diskState.LoadNzbMessages(nzbId, &messages);
+	CheckMessages(messages, 1, 2);
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Nzb log: long lines", "[DiskState][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> queueDirOpt("QueueDir=%s", TestUtil::WorkingDir().c_str());
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back(queueDirOpt);
+	Options options(&cmdOpts, nullptr);
+
+	DiskState diskState;
+	const int nzbId = 8;
+
+	// lines written by external tools may be longer than the initial read buffer
+	std::string longText(10000, 'x');
+	longText.replace(5000, 5, "<mid>");
+	std::string content = "2026-01-01 10:00:00\t1000\tINFO\tmessage 1\n"
+		"2026-01-01 10:00:01\t1001\tWARNING\t" + longText + "\n"
+		"2026-01-01 10:00:02\t1002\tINFO\tmessage 3\n";
+	BString<1024> logFilename("%s%cn%i.log", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR, nzbId);
+	REQUIRE(FileSystem::SaveBufferIntoFile(logFilename, content.c_str(), (int)content.size()));
+
+	MessageList messages;
+	diskState.LoadNzbMessages(nzbId, &messages);
+	REQUIRE(messages.size() == 3);
+	REQUIRE(!strcmp(messages.at(0).GetText(), "message 1"));
+	REQUIRE(messages.at(1).GetId() == 2);
+	REQUIRE(messages.at(1).GetKind() == Message::mkWarning);
+	REQUIRE(messages.at(1).GetText() == longText);
+	REQUIRE(messages.at(2).GetId() == 3);
+	REQUIRE(!strcmp(messages.at(2).GetText(), "message 3"));
+
+	messages.clear();
+	diskState.LoadNzbMessages(nzbId, &messages, 0, 2);
+	REQUIRE(messages.size() == 2);
+	REQUIRE(messages.at(0).GetText() == longText);
+
+	TestUtil::CleanupWorkingDir();
+}
@@ -0,0 +1,135 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "DupeCoordinator.h"
+
+class DupeDownloadQueueMock : public DownloadQueue
+{
+public:
+	DupeDownloadQueueMock() { Init(this); }
+	~DupeDownloadQueueMock() { Final(); }
+	virtual bool EditEntry(int ID, EEditAction action, const char* args) { return false; };
+	virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
+		EEditAction action, const char* args) { return false; }
+	virtual void HistoryChanged() { Changed(); }
+	virtual void Save() { Changed(); };
+	virtual void SaveChanged() {}
+};
+
+TEST_CASE("Dupe index", "[DupeCoordinator][Quick]")
+{
+	DupeCoordinator::DupeIndex index;
+	index.Add(0, "Show.S01E01", "");
+	index.Add(1, "show.s01e01", "show-1-1");
+	index.Add(2, "Other name", "SHOW-1-1");
+	index.Add(3, "SHOW.S01E01", nullptr);
+	index.Add(4, "Show.S01E02", "show-1-2");
+
+	// empty dupe key: matching by name only
+	REQUIRE(index.Find("Show.S01E01", "") == DupeCoordinator::DupeIndex::PositionList({0, 1, 3}));
+
+	// dupe key: matching by key or by name for entries without key
+	REQUIRE(index.Find("Show.S01E01", "Show-1-1") == DupeCoordinator::DupeIndex::PositionList({0, 1, 2, 3}));
+	REQUIRE(index.Find("Unknown", "show-1-1") == DupeCoordinator::DupeIndex::PositionList({1, 2}));
+	REQUIRE(index.Find("Show.S01E02", "show-x") == DupeCoordinator::DupeIndex::PositionList());
+	REQUIRE(index.Find("Show.S01E02", nullptr) == DupeCoordinator::DupeIndex::PositionList({4}));
+
+	index.Clear();
+	REQUIRE(index.Find("Show.S01E01", "").empty());
+}
+
+TEST_CASE("Dupe status", "[DupeCoordinator][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	DupeDownloadQueueMock downloadQueue;
+	DupeCoordinator dupeCoordinator;
+
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	NzbInfo* queuedNzb = nzbInfo.get();
+	nzbInfo->SetName("Show.S01E01");
+	downloadQueue.GetQueue()->Add(std::move(nzbInfo), false);
+
+	std::unique_ptr<DupInfo> dupInfo = std::make_unique<DupInfo>();
+	dupInfo->SetName("Show.S01E02");
+	dupInfo->SetDupeKey("show-1-2");
+	dupInfo->SetStatus(DupInfo::dsSuccess);
+	downloadQueue.GetHistory()->Add(std::make_unique<HistoryInfo>(std::move(dupInfo)), false);
+	downloadQueue.Save();
+
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "show.s01e01", "") == DupeCoordinator::dsQueued);
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "Show.S01E02", "") == DupeCoordinator::dsSuccess);
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "Another name", "show-1-2") == DupeCoordinator::dsSuccess);
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "Show.S01E03", "") == DupeCoordinator::dsNone);
+
+	// renaming must be picked up by the index
+	queuedNzb->SetName("Show.S01E03");
+	downloadQueue.Save();
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "show.s01e01", "") == DupeCoordinator::dsNone);
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "Show.S01E03", "") == DupeCoordinator::dsQueued);
+
+	// deleted items must be removed from the index
+	downloadQueue.GetQueue()->clear();
+	downloadQueue.Save();
+	REQUIRE(dupeCoordinator.GetDupeStatus(&downloadQueue, "Show.S01E03", "") == DupeCoordinator::dsNone);
+}
+
+TEST_CASE("Dupe properties taken from queue", "[DupeCoordinator][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	DupeDownloadQueueMock downloadQueue;
+	DupeCoordinator dupeCoordinator;
+
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	nzbInfo->SetName("Show.S01E01");
+	nzbInfo->SetDupeKey("show-1-1");
+	nzbInfo->SetDupeScore(10);
+	downloadQueue.GetQueue()->Add(std::move(nzbInfo), false);
+	downloadQueue.Save();
+
+	std::unique_ptr<NzbInfo> newNzb = std::make_unique<NzbInfo>();
+	newNzb->SetName("Show.S01E01");
+	newNzb->SetDupeScore(20);
+
+	// the item has its own score - nothing is taken
+	int revision = downloadQueue.GetRevision();
+	dupeCoordinator.NzbFound(&downloadQueue, newNzb.get());
+	REQUIRE(Util::EmptyStr(newNzb->GetDupeKey()));
+	REQUIRE(downloadQueue.GetRevision() == revision);
+
+	// dupe key and score are taken from the queued item,
+	// the index must be rebuilt to see the new key
+	newNzb->SetDupeScore(0);
+	newNzb->SetDeleteStatus(NzbInfo::dsNone);
+	dupeCoordinator.NzbFound(&downloadQueue, newNzb.get());
+	REQUIRE(!strcmp(newNzb->GetDupeKey(), "show-1-1"));
+	REQUIRE(newNzb->GetDupeScore() == 10);
+	REQUIRE(downloadQueue.GetRevision() != revision);
+}
@@ -25,6 +25,11 @@
 #include "NzbFile.h"
 #include "Options.h"
 #include "TestUtil.h"
+#include "FileSystem.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 void TestNzb(std::string testFilename)
 {
@@ -69,3 +74,202 @@ TEST_CASE("Nzb parser", "[NzbFile][TestData]")
 	TestNzb("dotless");
 	TestNzb("plain");
 }
+
+static std::string DumpNzb(NzbFile& nzbFile)
+{
+	std::unique_ptr<NzbInfo> nzbInfo = nzbFile.DetachNzbInfo();
+
+	std::string dump = BString<1024>("password=%s files=%i size=%" PRIi64 " failed=%" PRIi64 " hash=%u/%u\n",
+		nzbFile.GetPassword() ? nzbFile.GetPassword() : "(none)", nzbInfo->GetFileCount(), nzbInfo->GetSize(),
+		nzbInfo->GetFailedSize(), nzbInfo->GetFullContentHash(), nzbInfo->GetFilteredContentHash()).Str();
+
+	for (FileInfo* fileInfo : nzbInfo->GetFileList())
+	{
+		dump += BString<1024>("file subject=%s filename=%s time=%i size=%" PRIi64 " missed=%" PRIi64 " articles=%i/%i\n",
+			fileInfo->GetSubject(), fileInfo->GetFilename(), (int)fileInfo->GetTime(), fileInfo->GetSize(),
+			fileInfo->GetMissedSize(), fileInfo->GetTotalArticles(), fileInfo->GetMissedArticles()).Str();
+		for (CString& group : fileInfo->GetGroups())
+		{
+			dump += BString<1024>("group=%s\n", group ? *group : "(null)").Str();
+		}
+		for (ArticleInfo* article : fileInfo->GetArticles())
+		{
+			dump += BString<1024>("article %i %i %s\n", article->GetPartNumber(), article->GetSize(),
+				article->GetMessageId() ? article->GetMessageId() : "(null)").Str();
+		}
+	}
+
+	return dump;
+}
+
+static void TestParsersMatch(const char* filename)
+{
+	INFO(std::string("Filename: ") + filename);
+
+	NzbFile streamFile(filename, "");
+	bool streamOK = streamFile.Parse();
+
+	NzbFile xmlFile(filename, "");
+	xmlFile.SetXmlParser(true);
+	bool xmlOK = xmlFile.Parse();
+
+	REQUIRE(streamOK == xmlOK);
+	REQUIRE(DumpNzb(streamFile) == DumpNzb(xmlFile));
+}
+
+static void WriteNzb(const char* filename, std::string content, bool crlf)
+{
+	if (crlf)
+	{
+		for (size_t pos = 0; (pos = content.find('\n', pos)) != std::string::npos; pos += 2)
+		{
+			content.insert(pos, "\r");
+		}
+	}
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, content.c_str(), (int)content.length()));
+}
+
+TEST_CASE("Nzb parser: streaming and XML parsers", "[NzbFile][TestData]")
+{
+	Options::CmdOptList cmdOpts;
+	Options options(&cmdOpts, nullptr);
+
+	TestParsersMatch((TestUtil::TestDataDir() + "/nzbfile/dotless.nzb").c_str());
+	TestParsersMatch((TestUtil::TestDataDir() + "/nzbfile/plain.nzb").c_str());
+
+	TestUtil::PrepareWorkingDir("empty");
+	BString<1024> filename("%s%ctest.nzb", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+
+	const char* content =
+		"\xEF\xBB\xBF<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<!DOCTYPE nzb PUBLIC \"-//newzBin//DTD NZB 1.0//EN\" \"http://www.newzbin.com/DTD/nzb/nzb-1.0.dtd\">\n"
+		"<!-- comment -->\n"
+		"<nzb xmlns=\"http://www.newzbin.com/DTD/2003/nzb\">\n"
+		"<head>\n"
+		"\t<meta type=\"category\">TV</meta>\n"
+		"\t<meta type=\"password\"> se&amp;cret </meta>\n"
+		"</head>\n"
+		"<file poster=\"p\" date=\"1335508618\" subject=\"Entities &lt;&#x41;&#66;&gt; &apos;&quot;name.part1.rar&quot; yEnc (1/6)\">\n"
+		"<groups><group>alt.binaries.a</group><group> alt.binaries.b </group><group/></groups>\n"
+		"<segments>\n"
+		"<segment bytes=\"100\" number=\"3\">id3@host</segment>\n"
+		"<segment bytes=\"200\" number=\"1\">id1@host</segment>\n"
+		"<segment bytes=\"150\" number=\"3\">id3b@host</segment>\n"
+		"<segment bytes=\"50\" number=\"0\">ignored@host</segment>\n"
+		"<segment bytes=\"10\" number=\"6\">a &amp; b</segment>\n"
+		"</segments>\n"
+		"</file>\n"
+		"<file subject=\"Tabs\tand&#9;lines\nin&#x9;&#xA;attr.r\xC3\xBC\" date='1'>\n"
+		"<segments><segment number=\"2\" bytes=\"300\">\n"
+		"  multi\n line@host\n"
+		"</segment><segment number = \"1\" bytes=\"-1\" >x@host</segment ></segments>\n"
+		"</file>\n"
+		"<file subject=\"empty.rar\"><segments/></file>\n"
+		"<segment bytes=\"1\" number=\"1\">orphan@host</segment>\n"
+		"</nzb>\n";
+
+	WriteNzb(filename, content, false);
+	TestParsersMatch(filename);
+
+	WriteNzb(filename, content, true);
+	TestParsersMatch(filename);
+
+	// handled by XML parser
+	WriteNzb(filename, "<nzb><file subject=\"cdata.rar\"><segments>"
+		"<segment bytes=\"1\" number=\"1\"><![CDATA[cdata@host]]></segment></segments></file></nzb>", false);
+	TestParsersMatch(filename);
+
+	// malformed
+	WriteNzb(filename, "<nzb><file subject=\"a.rar\"><segments>"
+		"<segment bytes=\"1\" number=\"1\">id@host</segments></file></nzb>", false);
+	TestParsersMatch(filename);
+
+	TestUtil::CleanupWorkingDir();
+}
+
+static void WriteHugeNzb(const char* filename, int fileCount, int segmentCount)
+{
+	StringBuilder content;
+	content.Append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<nzb xmlns=\"http://www.newzbin.com/DTD/2003/nzb\">\n");
+	for (int i = 0; i < fileCount; i++)
+	{
+		content.AppendFmt("<file poster=\"poster@example.com\" date=\"1335508618\" "
+			"subject=\"[%i/%i] - &quot;huge.part%03i.rar&quot; yEnc (1/%i)\">\n"
+			"<groups>\n<group>alt.binaries.test</group>\n</groups>\n<segments>\n",
+			i + 1, fileCount, i + 1, segmentCount);
+		for (int k = 0; k < segmentCount; k++)
+		{
+			content.AppendFmt("<segment bytes=\"792%03i\" number=\"%i\">part%iof%i.Ab1Cd2Ef3Gh4Ij5Kl6@news.example.com</segment>\n",
+				k % 1000, k + 1, k + 1, i + 1);
+		}
+		content.Append("</segments>\n</file>\n");
+	}
+	content.Append("</nzb>\n");
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, content, content.Length()));
+}
+
+TEST_CASE("Nzb parser: benchmark", "[NzbFile][Benchmark][.]")
+{
+	const int fileCount = 200;
+	const int segmentCount = 1000;
+
+	Options::CmdOptList cmdOpts;
+	Options options(&cmdOpts, nullptr);
+
+	TestUtil::PrepareWorkingDir("empty");
+	BString<1024> filename("%s%chuge.nzb", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	WriteHugeNzb(filename, fileCount, segmentCount);
+
+	for (bool xmlParser : {true, false})
+	{
+		NzbFile nzbFile(filename, "");
+		nzbFile.SetXmlParser(xmlParser);
+
+		int64 start = Util::CurrentTicks();
+		REQUIRE(nzbFile.Parse());
+		int64 elapsed = Util::CurrentTicks() - start;
+
+		WARN((xmlParser ? "XML" : "Streaming") << " parser: " << fileCount * segmentCount <<
+			" segments in " << elapsed / 1000 << " ms");
+		REQUIRE(nzbFile.DetachNzbInfo()->GetTotalArticles() == fileCount * segmentCount);
+	}
+
+	TestUtil::CleanupWorkingDir();
+}
+
+static int64 AllocatedMemory()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+	return (int64)mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+TEST_CASE("Nzb parser: memory footprint", "[NzbFile][Benchmark][.]")
+{
+	const int fileCount = 500;
+	const int segmentCount = 1000;
+
+	Options::CmdOptList cmdOpts;
+	Options options(&cmdOpts, nullptr);
+
+	TestUtil::PrepareWorkingDir("empty");
+	BString<1024> filename("%s%chuge.nzb", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	WriteHugeNzb(filename, fileCount, segmentCount);
+
+	int64 memBefore = AllocatedMemory();
+	std::unique_ptr<NzbInfo> nzbInfo;
+	{
+		NzbFile nzbFile(filename, "");
+		REQUIRE(nzbFile.Parse());
+		nzbInfo = nzbFile.DetachNzbInfo();
+	}
+	int64 memAfter = AllocatedMemory();
+
+	REQUIRE(nzbInfo->GetTotalArticles() == fileCount * segmentCount);
+	WARN("Queue with " << fileCount * segmentCount << " articles uses " << (memAfter - memBefore) / 1024 << " KB, " <<
+		(memAfter - memBefore) / (fileCount * segmentCount) << " bytes per article");
+
+	TestUtil::CleanupWorkingDir();
+}
@@ -0,0 +1,170 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "QueueEditor.h"
+#include "Util.h"
+
+class EditorDownloadQueueMock : public DownloadQueue
+{
+public:
+	EditorDownloadQueueMock() { Init(this); }
+	~EditorDownloadQueueMock() { Final(); }
+	virtual bool EditEntry(int ID, EEditAction action, const char* args) { return false; };
+	virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
+		EEditAction action, const char* args) { return false; }
+	virtual void HistoryChanged() { Changed(); }
+	virtual void Save() { Changed(); };
+	virtual void SaveChanged() {}
+};
+
+static void FillQueue(DownloadQueue* downloadQueue, int nzbCount, int fileCount)
+{
+	for (int i = 0; i < nzbCount; i++)
+	{
+		std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+		nzbInfo->SetName(BString<100>("nzb-%i", i));
+		for (int j = 0; j < fileCount; j++)
+		{
+			std::unique_ptr<FileInfo> fileInfo = std::make_unique<FileInfo>();
+			fileInfo->SetNzbInfo(nzbInfo.get());
+			nzbInfo->GetFileList()->Add(std::move(fileInfo));
+		}
+		downloadQueue->GetQueue()->Add(std::move(nzbInfo));
+	}
+	downloadQueue->Save();
+}
+
+TEST_CASE("Queue id lookups", "[QueueEditor][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	EditorDownloadQueueMock downloadQueue;
+	FillQueue(&downloadQueue, 3, 4);
+
+	NzbInfo* nzbInfo = downloadQueue.GetQueue()->at(1).get();
+	FileInfo* fileInfo = nzbInfo->GetFileList()->at(2).get();
+	REQUIRE(downloadQueue.FindNzb(nzbInfo->GetId()) == nzbInfo);
+	REQUIRE(downloadQueue.FindFile(fileInfo->GetId()) == fileInfo);
+	REQUIRE(downloadQueue.FindNzb(fileInfo->GetId() + 1000) == nullptr);
+	REQUIRE(downloadQueue.FindFile(nzbInfo->GetId() + 1000) == nullptr);
+
+	// changes made without increasing the revision must not produce wrong results
+	downloadQueue.GetQueue()->erase(downloadQueue.GetQueue()->begin());
+	REQUIRE(downloadQueue.FindNzb(nzbInfo->GetId()) == nzbInfo);
+	REQUIRE(downloadQueue.FindFile(fileInfo->GetId()) == fileInfo);
+
+	std::unique_ptr<FileInfo> movedFile = std::move(nzbInfo->GetFileList()->front());
+	nzbInfo->GetFileList()->pop_front();
+	FileInfo* lastFile = movedFile.get();
+	nzbInfo->GetFileList()->Add(std::move(movedFile));
+	REQUIRE(downloadQueue.FindFile(fileInfo->GetId()) == fileInfo);
+	REQUIRE(downloadQueue.FindFile(lastFile->GetId()) == lastFile);
+
+	std::unique_ptr<NzbInfo> newNzb = std::make_unique<NzbInfo>();
+	NzbInfo* addedNzb = newNzb.get();
+	downloadQueue.GetQueue()->Add(std::move(newNzb), true);
+	REQUIRE(downloadQueue.FindNzb(addedNzb->GetId()) == addedNzb);
+
+	std::unique_ptr<HistoryInfo> historyInfo = std::make_unique<HistoryInfo>(std::move(downloadQueue.GetQueue()->back()));
+	int historyId = historyInfo->GetId();
+	downloadQueue.GetQueue()->pop_back();
+	REQUIRE(downloadQueue.FindHistory(historyId) == nullptr);
+	downloadQueue.GetHistory()->Add(std::move(historyInfo));
+	REQUIRE(downloadQueue.FindHistory(historyId) == downloadQueue.GetHistory()->front().get());
+	REQUIRE(downloadQueue.FindHistoryPosition(historyId) == 0);
+	REQUIRE(downloadQueue.FindHistoryPosition(historyId + 1000) == -1);
+	REQUIRE(downloadQueue.FindNzb(historyId) == nullptr);
+}
+
+TEST_CASE("Queue editor: edit files by id", "[QueueEditor][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	EditorDownloadQueueMock downloadQueue;
+	FillQueue(&downloadQueue, 3, 4);
+
+	IdList idList;
+	idList.push_back(downloadQueue.GetQueue()->at(0)->GetFileList()->at(1)->GetId());
+	idList.push_back(downloadQueue.GetQueue()->at(2)->GetFileList()->at(3)->GetId());
+	idList.push_back(1000000);
+
+	QueueEditor queueEditor;
+	REQUIRE(queueEditor.EditList(&downloadQueue, &idList, nullptr, DownloadQueue::mmId, DownloadQueue::eaFilePause, nullptr));
+	REQUIRE(downloadQueue.GetQueue()->at(0)->GetPausedFileCount() == 1);
+	REQUIRE(downloadQueue.GetQueue()->at(0)->GetFileList()->at(1)->GetPaused());
+	REQUIRE(downloadQueue.GetQueue()->at(1)->GetPausedFileCount() == 0);
+	REQUIRE(downloadQueue.GetQueue()->at(2)->GetFileList()->at(3)->GetPaused());
+}
+
+TEST_CASE("Queue editor: benchmark", "[QueueEditor][Benchmark][.]")
+{
+	const int nzbCount = 100;
+	const int fileCount = 1000;
+	const int editCount = 5000;
+
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	EditorDownloadQueueMock downloadQueue;
+	FillQueue(&downloadQueue, nzbCount, fileCount);
+
+	// every 20th file, from the end of the queue to the front
+	IdList fileIds;
+	for (int i = 0; i < editCount; i++)
+	{
+		int pos = nzbCount * fileCount - 1 - i * (nzbCount * fileCount / editCount);
+		fileIds.push_back(downloadQueue.GetQueue()->at(pos / fileCount)->GetFileList()->at(pos % fileCount)->GetId());
+	}
+
+	IdList nzbIds;
+	for (NzbInfo* nzbInfo : downloadQueue.GetQueue())
+	{
+		nzbIds.push_back(nzbInfo->GetId());
+	}
+
+	QueueEditor queueEditor;
+	for (DownloadQueue::EEditAction action : {DownloadQueue::eaFilePause, DownloadQueue::eaFileResume})
+	{
+		int64 start = Util::CurrentTicks();
+		REQUIRE(queueEditor.EditList(&downloadQueue, &fileIds, nullptr, DownloadQueue::mmId, action, nullptr));
+		int64 elapsed = Util::CurrentTicks() - start;
+		WARN("Editing " << editCount << " of " << nzbCount * fileCount << " files: " << elapsed / 1000 << " ms");
+	}
+
+	int64 start = Util::CurrentTicks();
+	REQUIRE(queueEditor.EditList(&downloadQueue, &nzbIds, nullptr, DownloadQueue::mmId, DownloadQueue::eaGroupPause, nullptr));
+	int64 elapsed = Util::CurrentTicks() - start;
+	WARN("Pausing " << nzbCount << " groups: " << elapsed / 1000 << " ms");
+
+	for (NzbInfo* nzbInfo : downloadQueue.GetQueue())
+	{
+		REQUIRE(nzbInfo->GetPausedFileCount() == fileCount);
+	}
+}
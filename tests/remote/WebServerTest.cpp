@@ -0,0 +1,204 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Util.h"
+#include "FileSystem.h"
+#include "WebServer.h"
+#include "TestUtil.h"
+
+static const int MAX_CACHED_ASSET_SIZE = 4 * 1024 * 1024;
+static const int MAX_ASSET_CACHE_SIZE = 32 * 1024 * 1024;
+
+// pseudo random bytes, which don't compress at all
+static std::string RandomData(int len, uint32 seed)
+{
+	std::string result;
+	result.reserve(len);
+	for (int i = 0; i < len; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		result += (char)(seed >> 16);
+	}
+	return result;
+}
+
+static void WriteAsset(const char* filename, const std::string& content)
+{
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, content.data(), (int)content.size()));
+}
+
+TEST_CASE("Web asset cache: reloading", "[WebServer][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> filename1("%s%cindex.js", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> filename2("%s%cutil.js", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	WriteAsset(filename1, "var a = 1;\n");
+	WriteAsset(filename2, "var b = 2;\n");
+
+	WebAssetCache cache;
+	WebAssetCache::FileList filenames;
+	filenames.emplace_back(*filename1);
+	filenames.emplace_back(*filename2);
+	CString missingFile;
+
+	std::shared_ptr<WebAssetCache::Asset> asset1 = cache.Get("/index.js", filenames, "text/javascript", missingFile);
+	REQUIRE(asset1);
+	REQUIRE(asset1->GetBodyLen() == 22);
+	REQUIRE(!strcmp(asset1->GetBody(), "var a = 1;\nvar b = 2;\n"));
+	REQUIRE(!strcmp(asset1->GetContentType(), "text/javascript"));
+
+	// unchanged files: the cached asset is returned
+	REQUIRE(cache.Get("/index.js", filenames, "text/javascript", missingFile) == asset1);
+
+	// same size, new modification time
+	Util::Sleep(20);
+	WriteAsset(filename2, "var c = 3;\n");
+	std::shared_ptr<WebAssetCache::Asset> asset2 = cache.Get("/index.js", filenames, "text/javascript", missingFile);
+	REQUIRE(asset2 != asset1);
+	REQUIRE(!strcmp(asset2->GetBody(), "var a = 1;\nvar c = 3;\n"));
+	REQUIRE(strcmp(asset2->GetETag(), asset1->GetETag()));
+	REQUIRE(cache.Get("/index.js", filenames, "text/javascript", missingFile) == asset2);
+
+	// size change
+	WriteAsset(filename1, "var a = 10;\n");
+	std::shared_ptr<WebAssetCache::Asset> asset3 = cache.Get("/index.js", filenames, "text/javascript", missingFile);
+	REQUIRE(asset3 != asset2);
+	REQUIRE(asset3->GetBodyLen() == 23);
+
+	// removed file
+	FileSystem::DeleteFile(filename2);
+	REQUIRE_FALSE(cache.Get("/index.js", filenames, "text/javascript", missingFile));
+	REQUIRE(!strcmp(missingFile, filename2));
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Web asset cache: ETag and gzip", "[WebServer][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> smallFilename("%s%csmall.css", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> largeFilename("%s%clarge.css", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> randomFilename("%s%crandom.png", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	WriteAsset(smallFilename, "body { color: red; }\n");
+	std::string largeContent;
+	for (int i = 0; i < 1000; i++)
+	{
+		largeContent += "body { color: red; }\n";
+	}
+	WriteAsset(largeFilename, largeContent);
+	WriteAsset(randomFilename, RandomData(10000, 1));
+
+	WebAssetCache cache;
+	CString missingFile;
+
+	std::shared_ptr<WebAssetCache::Asset> small = cache.Get("/small.css", {*smallFilename}, "text/css", missingFile);
+	REQUIRE(small);
+	// ETag is a quoted hash of the body
+	REQUIRE(strlen(small->GetETag()) > 2);
+	REQUIRE(small->GetETag()[0] == '"');
+	REQUIRE(small->GetETag()[strlen(small->GetETag()) - 1] == '"');
+	// the same content under another url has the same ETag
+	std::shared_ptr<WebAssetCache::Asset> small2 = cache.Get("/small2.css", {*smallFilename}, "text/css", missingFile);
+	REQUIRE(small2 != small);
+	REQUIRE(!strcmp(small2->GetETag(), small->GetETag()));
+
+	std::shared_ptr<WebAssetCache::Asset> large = cache.Get("/large.css", {*largeFilename}, "text/css", missingFile);
+	REQUIRE(large);
+	REQUIRE(strcmp(large->GetETag(), small->GetETag()));
+
+	std::shared_ptr<WebAssetCache::Asset> random = cache.Get("/random.png", {*randomFilename}, "image/png", missingFile);
+	REQUIRE(random);
+
+#ifndef DISABLE_GZIP
+	// too small to be worth compressing
+	REQUIRE(small->GetGzipBody() == nullptr);
+	REQUIRE(small->GetGzipBodyLen() == 0);
+
+	REQUIRE(large->GetGzipBody() != nullptr);
+	REQUIRE(large->GetGzipBodyLen() > 0);
+	REQUIRE(large->GetGzipBodyLen() < large->GetBodyLen() / 10);
+	REQUIRE(large->GetMemorySize() == large->GetBodyLen() + large->GetGzipBodyLen());
+
+	GUnzipStream unzipStream(1024 * 1024);
+	unzipStream.Write(large->GetGzipBody(), large->GetGzipBodyLen());
+	const void* outBuf;
+	int outLen;
+	REQUIRE(unzipStream.Read(&outBuf, &outLen) != GUnzipStream::zlError);
+	REQUIRE(std::string((const char*)outBuf, outLen) == largeContent);
+
+	// compressed variant isn't kept if it doesn't save anything
+	REQUIRE(random->GetGzipBody() == nullptr);
+	REQUIRE(random->GetGzipBodyLen() == 0);
+#endif
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Web asset cache: size limits", "[WebServer][Slow]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> maxFilename("%s%cmax.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> tooLargeFilename("%s%ctoolarge.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	WriteAsset(maxFilename, RandomData(MAX_CACHED_ASSET_SIZE, 1));
+	WriteAsset(tooLargeFilename, RandomData(MAX_CACHED_ASSET_SIZE + 1, 2));
+
+	WebAssetCache cache;
+	CString missingFile;
+
+	// files over the limit are served but not kept
+	std::shared_ptr<WebAssetCache::Asset> tooLarge = cache.Get("/toolarge", {*tooLargeFilename}, nullptr, missingFile);
+	REQUIRE(tooLarge);
+	REQUIRE(tooLarge->GetBodyLen() == MAX_CACHED_ASSET_SIZE + 1);
+	REQUIRE(cache.Get("/toolarge", {*tooLargeFilename}, nullptr, missingFile) != tooLarge);
+
+	// the cache can hold exactly that many assets
+	const int maxAssets = MAX_ASSET_CACHE_SIZE / MAX_CACHED_ASSET_SIZE;
+	std::vector<std::shared_ptr<WebAssetCache::Asset>> assets;
+	for (int i = 0; i < maxAssets; i++)
+	{
+		assets.push_back(cache.Get(BString<100>("/asset%i", i), {*maxFilename}, nullptr, missingFile));
+		REQUIRE(assets.back());
+		REQUIRE(assets.back()->GetMemorySize() == MAX_CACHED_ASSET_SIZE);
+	}
+	for (int i = 0; i < maxAssets; i++)
+	{
+		REQUIRE(cache.Get(BString<100>("/asset%i", i), {*maxFilename}, nullptr, missingFile) == assets[i]);
+	}
+
+	// one more asset doesn't fit: the cache starts over
+	std::shared_ptr<WebAssetCache::Asset> last = cache.Get("/last", {*maxFilename}, nullptr, missingFile);
+	REQUIRE(cache.Get("/last", {*maxFilename}, nullptr, missingFile) == last);
+	REQUIRE(cache.Get("/asset0", {*maxFilename}, nullptr, missingFile) != assets[0]);
+
+	// previously returned assets remain valid while in use
+	REQUIRE(assets[1]->GetBodyLen() == MAX_CACHED_ASSET_SIZE);
+
+	cache.Clear();
+	REQUIRE(cache.Get("/last", {*maxFilename}, nullptr, missingFile) != last);
+
+	TestUtil::CleanupWorkingDir();
+}
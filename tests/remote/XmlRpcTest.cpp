@@ -0,0 +1,173 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "DownloadInfo.h"
+#include "XmlRpc.h"
+
+class HistoryDownloadQueueMock : public DownloadQueue
+{
+public:
+	HistoryDownloadQueueMock() { Init(this); }
+	~HistoryDownloadQueueMock() { Final(); }
+	virtual bool EditEntry(int ID, EEditAction action, const char* args) { return false; };
+	virtual bool EditList(IdList* idList, NameList* nameList, EMatchMode matchMode,
+		EEditAction action, const char* args) { return false; }
+	virtual void HistoryChanged() {}
+	virtual void Save() {};
+	virtual void SaveChanged() {}
+};
+
+static NzbInfo* AddHistory(DownloadQueue* downloadQueue, const char* name, const char* category,
+	int64 size, time_t time)
+{
+	std::unique_ptr<NzbInfo> nzbInfo = std::make_unique<NzbInfo>();
+	NzbInfo* result = nzbInfo.get();
+	nzbInfo->SetName(name);
+	nzbInfo->SetCategory(category);
+	nzbInfo->SetSize(size);
+	std::unique_ptr<HistoryInfo> historyInfo = std::make_unique<HistoryInfo>(std::move(nzbInfo));
+	historyInfo->SetTime(time);
+	downloadQueue->GetHistory()->Add(std::move(historyInfo), false);
+	return result;
+}
+
+// returns names of history items in the order of the response, or "error"
+static std::string RequestHistory(const char* params)
+{
+	BString<1024> request("{\"method\": \"history\", \"params\": [%s]}", params);
+	XmlRpcProcessor processor;
+	processor.SetUrl("/jsonrpc");
+	processor.SetHttpMethod(XmlRpcProcessor::hmPost);
+	processor.SetUserAccess(XmlRpcProcessor::uaControl);
+	processor.SetRequest(request);
+	processor.Execute();
+
+	std::string response = processor.GetResponse();
+	if (strstr(processor.GetResponseHeader(), "\"error\"") || strstr(processor.GetResponseFooter(), "\"error\""))
+	{
+		return "error";
+	}
+
+	std::string names;
+	const char* field = "\n\"Name\" : \"";
+	for (size_t pos = response.find(field); pos != std::string::npos; pos = response.find(field, pos))
+	{
+		pos += strlen(field);
+		names += names.empty() ? "" : ",";
+		names += response.substr(pos, response.find('"', pos) - pos);
+	}
+	return names;
+}
+
+TEST_CASE("History paging and filtering", "[XmlRpc][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	HistoryDownloadQueueMock downloadQueue;
+
+	// history is ordered from newest to oldest
+	AddHistory(&downloadQueue, "Show.S01E03", "TV", 300, 1003)->SetMarkStatus(NzbInfo::ksGood);
+	AddHistory(&downloadQueue, "Movie.2020", "Movies", 500, 1002)->SetParStatus(NzbInfo::psFailure);
+	AddHistory(&downloadQueue, "Show.S01E02", "tv", 300, 1001)->SetUnpackStatus(NzbInfo::usFailure);
+	AddHistory(&downloadQueue, "Show.S01E01", "TV", 100, 1000)->SetDeleteStatus(NzbInfo::dsManual);
+	std::unique_ptr<DupInfo> dupInfo = std::make_unique<DupInfo>();
+	dupInfo->SetName("Show.S00E01");
+	dupInfo->SetStatus(DupInfo::dsSuccess);
+	downloadQueue.GetHistory()->Add(std::make_unique<HistoryInfo>(std::move(dupInfo)), false);
+
+	SECTION("No paging")
+	{
+		REQUIRE(RequestHistory("false") == "Show.S01E03,Movie.2020,Show.S01E02,Show.S01E01");
+		REQUIRE(RequestHistory("true") == "Show.S01E03,Movie.2020,Show.S01E02,Show.S01E01,Show.S00E01");
+		// limit 0 means no limit
+		REQUIRE(RequestHistory("false, 0, 0") == "Show.S01E03,Movie.2020,Show.S01E02,Show.S01E01");
+	}
+
+	SECTION("Paging bounds")
+	{
+		REQUIRE(RequestHistory("false, 1, 2") == "Movie.2020,Show.S01E02");
+		REQUIRE(RequestHistory("false, 2, 0") == "Show.S01E02,Show.S01E01");
+		REQUIRE(RequestHistory("false, 3, 10") == "Show.S01E01");
+		REQUIRE(RequestHistory("false, 4, 1") == "");
+		REQUIRE(RequestHistory("false, 100, 0") == "");
+		REQUIRE(RequestHistory("false, 0, 2147483647") == "Show.S01E03,Movie.2020,Show.S01E02,Show.S01E01");
+		REQUIRE(RequestHistory("false, 2147483647, 2147483647") == "");
+		REQUIRE(RequestHistory("false, -1, 1") == "error");
+		REQUIRE(RequestHistory("false, 0, -1") == "error");
+	}
+
+	SECTION("Status filter")
+	{
+		REQUIRE(RequestHistory("false, 0, 0, \"FAILURE\"") == "Movie.2020,Show.S01E02");
+		REQUIRE(RequestHistory("false, 0, 0, \"FAILURE/PAR\"") == "Movie.2020");
+		REQUIRE(RequestHistory("false, 0, 0, \"SUCCESS\"") == "Show.S01E03");
+		// the filter matches whole parts of the status only
+		REQUIRE(RequestHistory("false, 0, 0, \"FAIL\"") == "");
+		REQUIRE(RequestHistory("false, 0, 0, \"FAILURE/PA\"") == "");
+		REQUIRE(RequestHistory("true, 0, 0, \"SUCCESS\"") == "Show.S01E03,Show.S00E01");
+		// paging applies to the filtered list
+		REQUIRE(RequestHistory("false, 1, 1, \"FAILURE\"") == "Show.S01E02");
+	}
+
+	SECTION("Category filter")
+	{
+		REQUIRE(RequestHistory("true, 0, 0, \"\", \"tv\"") == "Show.S01E03,Show.S01E02,Show.S01E01");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"Movies\"") == "Movie.2020");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"Music\"") == "");
+		REQUIRE(RequestHistory("false, 0, 0, \"FAILURE\", \"TV\"") == "Show.S01E02");
+	}
+
+	SECTION("Text filter")
+	{
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"S01E0\"") == "Show.S01E03,Show.S01E02,Show.S01E01");
+		REQUIRE(RequestHistory("true, 0, 0, \"\", \"\", \"E01\"") == "Show.S01E01,Show.S00E01");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"2020\"") == "Movie.2020");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"nothing\"") == "");
+	}
+
+	SECTION("Sorting")
+	{
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"\", \"name\"") ==
+			"Movie.2020,Show.S01E01,Show.S01E02,Show.S01E03");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"\", \"-name\"") ==
+			"Show.S01E03,Show.S01E02,Show.S01E01,Movie.2020");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"\", \"time\"") ==
+			"Show.S01E01,Show.S01E02,Movie.2020,Show.S01E03");
+
+		// items with equal keys keep their history order in both directions
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"\", \"size\"") ==
+			"Show.S01E01,Show.S01E03,Show.S01E02,Movie.2020");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"\", \"-size\"") ==
+			"Movie.2020,Show.S01E03,Show.S01E02,Show.S01E01");
+		REQUIRE(RequestHistory("false, 0, 0, \"\", \"\", \"\", \"category\"") ==
+			"Movie.2020,Show.S01E03,Show.S01E02,Show.S01E01");
+
+		// paging applies to the sorted list
+		REQUIRE(RequestHistory("false, 1, 2, \"\", \"\", \"\", \"size\"") == "Show.S01E03,Show.S01E02");
+		REQUIRE(RequestHistory("false, 0, 1, \"FAILURE\", \"\", \"\", \"-size\"") == "Movie.2020");
+	}
+}
@@ -23,6 +23,8 @@
 #include "catch.h"
 
 #include "FileSystem.h"
+#include "Util.h"
+#include "TestUtil.h"
 
 #ifdef WIN32
 TEST_CASE("FileSystem: MakeCanonicalPath", "[FileSystem][Quick]")
@@ -37,3 +39,119 @@ TEST_CASE("FileSystem: MakeCanonicalPath", "[FileSystem][Quick]")
 	REQUIRE(!strcmp(FileSystem::MakeCanonicalPath("\\\\server\\Program Files\\NZBGet\\scripts\\email\\..\\..\\"), "\\\\server\\Program Files\\NZBGet\\"));
 }
 #endif
+
+TEST_CASE("FileSystem: CopyFrom", "[FileSystem][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> srcFilename("%s%csource.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> dstFilename("%s%cdest.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+
+	CharBuffer data(300000);
+	for (int i = 0; i < data.Size(); i++)
+	{
+		data[i] = (char)(i * 7);
+	}
+
+	DiskFile srcFile;
+	REQUIRE(srcFile.Open(srcFilename, DiskFile::omWrite));
+	REQUIRE(srcFile.Write(data, data.Size()) == data.Size());
+	srcFile.Close();
+
+	DiskFile outFile;
+	REQUIRE(outFile.Open(dstFilename, DiskFile::omWrite));
+	REQUIRE(outFile.Write("head", 4) == 4);
+
+	DiskFile inFile;
+	REQUIRE(inFile.Open(srcFilename, DiskFile::omRead));
+	REQUIRE(inFile.Read(data, 100) == 100);
+	REQUIRE(outFile.CopyFrom(inFile, 1000) == 1000);
+	REQUIRE(outFile.CopyFrom(inFile) == data.Size() - 1100);
+	REQUIRE(outFile.CopyFrom(inFile) == 0);
+	REQUIRE(outFile.Write("tail", 4) == 4);
+	inFile.Close();
+	outFile.Close();
+
+	REQUIRE(FileSystem::FileSize(dstFilename) == data.Size() - 100 + 8);
+
+	CharBuffer result;
+	REQUIRE(FileSystem::LoadFileIntoBuffer(dstFilename, result, false));
+	REQUIRE(!memcmp(result, "head", 4));
+	REQUIRE(!memcmp(result + result.Size() - 4, "tail", 4));
+	for (int i = 100; i < data.Size(); i++)
+	{
+		if (result[i - 100 + 4] != (char)(i * 7))
+		{
+			FAIL("data mismatch at " << i);
+		}
+	}
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("FileSystem: CopyFrom short source", "[FileSystem][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> srcFilename("%s%csource.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> dstFilename("%s%cdest.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+
+	CharBuffer data(5000);
+	memset(data, 'x', data.Size());
+
+	DiskFile srcFile;
+	REQUIRE(srcFile.Open(srcFilename, DiskFile::omWrite));
+	REQUIRE(srcFile.Write(data, data.Size()) == data.Size());
+	srcFile.Close();
+
+	DiskFile outFile;
+	DiskFile inFile;
+
+	// source file is shorter than requested
+	REQUIRE(outFile.Open(dstFilename, DiskFile::omWrite));
+	REQUIRE(inFile.Open(srcFilename, DiskFile::omRead));
+	REQUIRE(outFile.CopyFrom(inFile, 10000) == data.Size());
+	inFile.Close();
+	outFile.Close();
+	REQUIRE(FileSystem::FileSize(dstFilename) == data.Size());
+
+#ifdef __linux__
+	// files of virtual file systems report zero size and can't be copied by the kernel,
+	// the buffered copy must be used instead
+	REQUIRE(outFile.Open(dstFilename, DiskFile::omWrite));
+	REQUIRE(inFile.Open("/proc/version", DiskFile::omRead));
+	int64 copied = outFile.CopyFrom(inFile);
+	inFile.Close();
+	outFile.Close();
+	REQUIRE(copied > 0);
+	REQUIRE(FileSystem::FileSize(dstFilename) == copied);
+#endif
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("FileSystem: FileTime", "[FileSystem][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> filename("%s%cfile.dat", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+
+	int64 size = 0;
+	REQUIRE(FileSystem::FileTime(filename, &size) == -1);
+	REQUIRE(size == 0);
+
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, "12345", 5));
+	int64 time1 = FileSystem::FileTime(filename, &size);
+	REQUIRE(time1 != -1);
+	REQUIRE(size == 5);
+	REQUIRE(FileSystem::FileTime(filename) == time1);
+
+	// a file rewritten within the same second with the same size must get a different stamp
+	Util::Sleep(20);
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, "54321", 5));
+	int64 time2 = FileSystem::FileTime(filename, &size);
+	REQUIRE(time2 != time1);
+	REQUIRE(size == 5);
+
+	TestUtil::CleanupWorkingDir();
+}
@@ -0,0 +1,293 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "Log.h"
+#include "Util.h"
+#include "Connection.h"
+#include "WebServer.h"
+#include "XmlRpc.h"
+
+static const int GZIP_BLOCK_SIZE = 64 * 1024;
+
+// pseudo random hex digits, which compress only about two times
+static std::string RandomHex(int len, uint32& seed)
+{
+	std::string result;
+	result.reserve(len);
+	for (int i = 0; i < len; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		result += "0123456789abcdef"[(seed >> 16) & 15];
+	}
+	return result;
+}
+
+#ifndef DISABLE_GZIP
+static std::string Gunzip(const std::string& data)
+{
+	GUnzipStream unzipStream(GZIP_BLOCK_SIZE);
+	unzipStream.Write(data.data(), (int)data.size());
+
+	std::string result;
+	while (true)
+	{
+		const void* outBuf;
+		int outLen;
+		GUnzipStream::EStatus status = unzipStream.Read(&outBuf, &outLen);
+		if (status == GUnzipStream::zlError)
+		{
+			return "";
+		}
+		result.append((const char*)outBuf, outLen);
+		if (status == GUnzipStream::zlFinished || outLen == 0)
+		{
+			return result;
+		}
+	}
+}
+
+TEST_CASE("GZip stream", "[GZipStream][Quick]")
+{
+	uint32 seed = 1;
+	std::string part1 = RandomHex(150 * 1024, seed);
+	std::string part2 = RandomHex(150 * 1024, seed);
+
+	// the stream is reused: the second round must produce the same output as the first one
+	GZipStream gzipStream(GZIP_BLOCK_SIZE);
+	std::string firstCompressed;
+	for (int round = 0; round < 2; round++)
+	{
+		gzipStream.Reset();
+
+		std::string compressed;
+		int fullBlocks = 0;
+		bool finished = false;
+		for (const std::string* part : {&part1, &part2})
+		{
+			gzipStream.Write(part->data(), (int)part->size(), part == &part2);
+			while (!finished)
+			{
+				const void* outBuf;
+				int outLen;
+				GZipStream::EStatus status = gzipStream.Read(&outBuf, &outLen);
+				REQUIRE(status != GZipStream::zlError);
+				if (outLen == 0)
+				{
+					REQUIRE(status == GZipStream::zlOK);
+					break;
+				}
+				REQUIRE(outLen <= GZIP_BLOCK_SIZE);
+				fullBlocks += outLen == GZIP_BLOCK_SIZE ? 1 : 0;
+				compressed.append((const char*)outBuf, outLen);
+				finished = status == GZipStream::zlFinished;
+			}
+		}
+
+		INFO("round: " << round);
+		REQUIRE(finished);
+		REQUIRE(fullBlocks >= 2);
+		REQUIRE(Gunzip(compressed) == part1 + part2);
+
+		if (round == 0)
+		{
+			firstCompressed = compressed;
+		}
+		else
+		{
+			REQUIRE(compressed == firstCompressed);
+		}
+	}
+}
+
+#ifndef WIN32
+static std::string RequestLog(bool http11, int entries)
+{
+	int fds[2];
+	REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+	const char* request = "Accept-Encoding: gzip\r\n\r\n";
+	REQUIRE(write(fds[1], request, strlen(request)) == (ssize_t)strlen(request));
+
+	std::thread server([&]()
+		{
+			Connection connection(fds[0], false);
+			WebProcessor processor;
+			processor.SetConnection(&connection);
+			processor.SetUrl(BString<100>("/jsonrpc/log?IDFrom=0&NumberOfEntries=%i", entries));
+			processor.SetHttpMethod(WebProcessor::hmGet);
+			processor.SetHttp11(http11);
+			processor.Execute();
+		});
+
+	std::string response;
+	char buf[4096];
+	ssize_t len;
+	while ((len = read(fds[1], buf, sizeof(buf))) > 0)
+	{
+		response.append(buf, len);
+	}
+
+	server.join();
+	close(fds[1]);
+	return response;
+}
+
+// returns the body or an empty string if the chunked encoding is malformed
+static std::string Dechunk(const std::string& data, int* chunkCount)
+{
+	std::string result;
+	*chunkCount = 0;
+	size_t pos = 0;
+	while (true)
+	{
+		size_t lineEnd = data.find("\r\n", pos);
+		if (lineEnd == std::string::npos)
+		{
+			return "";
+		}
+		size_t chunkLen = strtoul(data.substr(pos, lineEnd - pos).c_str(), nullptr, 16);
+		pos = lineEnd + 2;
+		if (chunkLen == 0)
+		{
+			// nothing may follow the final chunk except the empty trailer
+			return data.substr(pos) == "\r\n" ? result : "";
+		}
+		if (pos + chunkLen + 2 > data.size() || data.compare(pos + chunkLen, 2, "\r\n"))
+		{
+			return "";
+		}
+		result.append(data, pos, chunkLen);
+		pos += chunkLen + 2;
+		(*chunkCount)++;
+	}
+}
+
+TEST_CASE("GZip response", "[GZipStream][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	cmdOpts.push_back("InfoTarget=screen");
+	cmdOpts.push_back("LogBuffer=1000");
+	cmdOpts.push_back("ControlPassword=");
+	Options options(&cmdOpts, nullptr);
+
+	g_Log->Clear();
+	const int entries = 400;
+	uint32 seed = 1;
+	std::vector<std::string> messages;
+	for (int i = 0; i < entries; i++)
+	{
+		messages.push_back(RandomHex(900, seed));
+		info("%s", messages.back().c_str());
+	}
+
+	SECTION("HTTP/1.1: chunked")
+	{
+		std::string response = RequestLog(true, entries);
+		size_t headerEnd = response.find("\r\n\r\n");
+		REQUIRE(headerEnd != std::string::npos);
+		std::string header = response.substr(0, headerEnd + 2);
+		REQUIRE(header.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+		REQUIRE(header.find("Content-Encoding: gzip\r\n") != std::string::npos);
+		REQUIRE(header.find("Content-Length:") == std::string::npos);
+		REQUIRE(response.size() > headerEnd + 4 + 5);
+		REQUIRE(response.compare(response.size() - 5, 5, "0\r\n\r\n") == 0);
+
+		int chunkCount;
+		std::string compressed = Dechunk(response.substr(headerEnd + 4), &chunkCount);
+		REQUIRE(chunkCount >= 2);
+		std::string body = Gunzip(compressed);
+		REQUIRE(body.find(messages.front()) != std::string::npos);
+		REQUIRE(body.find(messages.back()) != std::string::npos);
+	}
+
+	SECTION("HTTP/1.0: uncompressed")
+	{
+		std::string response = RequestLog(false, entries);
+		size_t headerEnd = response.find("\r\n\r\n");
+		REQUIRE(headerEnd != std::string::npos);
+		std::string header = response.substr(0, headerEnd + 2);
+		std::string body = response.substr(headerEnd + 4);
+		REQUIRE(header.find("Transfer-Encoding:") == std::string::npos);
+		REQUIRE(header.find("Content-Encoding:") == std::string::npos);
+		REQUIRE(header.find(BString<100>("Content-Length: %i\r\n", (int)body.size()).Str()) != std::string::npos);
+		REQUIRE(body.find(messages.front()) != std::string::npos);
+		REQUIRE(body.find(messages.back()) != std::string::npos);
+	}
+
+	SECTION("Small response: one block")
+	{
+		std::string response = RequestLog(true, 1);
+		size_t headerEnd = response.find("\r\n\r\n");
+		REQUIRE(headerEnd != std::string::npos);
+		std::string header = response.substr(0, headerEnd + 2);
+		std::string compressed = response.substr(headerEnd + 4);
+		REQUIRE(header.find("Transfer-Encoding:") == std::string::npos);
+		REQUIRE(header.find("Content-Encoding: gzip\r\n") != std::string::npos);
+		REQUIRE(header.find(BString<100>("Content-Length: %i\r\n", (int)compressed.size()).Str()) != std::string::npos);
+		REQUIRE(Gunzip(compressed).find(messages.back()) != std::string::npos);
+	}
+
+	g_Log->Clear();
+}
+#endif
+#endif
+
+class EncodeCommand : public XmlCommand
+{
+public:
+	void Execute() override {}
+	const char* Encode(const char* str) { return EncodeStr(str); }
+};
+
+TEST_CASE("Encode rpc string", "[GZipStream][Quick]")
+{
+	EncodeCommand command;
+	command.SetProtocol(XmlRpcProcessor::rpJsonRpc);
+
+	// responses are never null, even if the command doesn't produce anything
+	REQUIRE(command.GetResponse() != nullptr);
+	REQUIRE(!strcmp(command.GetResponse(), ""));
+
+	const char* plain = "plain text";
+	REQUIRE(command.Encode(plain) == plain);
+
+	const char* quoted = "say \"hello\"";
+	const char* encoded = command.Encode(quoted);
+	REQUIRE(encoded != quoted);
+	REQUIRE(!strcmp(encoded, "say \\\"hello\\\""));
+
+	// earlier results remain valid when the pool grows
+	std::string longText(10000, '<');
+	const char* encodedLong = command.Encode(longText.c_str());
+	REQUIRE(!strcmp(encoded, "say \\\"hello\\\""));
+	REQUIRE(strlen(encodedLong) == longText.size());
+
+	command.SetProtocol(XmlRpcProcessor::rpXmlRpc);
+	REQUIRE(command.Encode(plain) == plain);
+	const char* xmlEncoded = command.Encode(longText.c_str());
+	REQUIRE(xmlEncoded != longText.c_str());
+	REQUIRE(strlen(xmlEncoded) == longText.size() * 4);
+}
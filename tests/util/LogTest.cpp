@@ -0,0 +1,145 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Log.h"
+#include "Options.h"
+#include "FileSystem.h"
+#include "Util.h"
+#include "TestUtil.h"
+
+static std::string ReadLogFile(const char* filename)
+{
+	CharBuffer buffer;
+	if (!FileSystem::LoadFileIntoBuffer(filename, buffer, true))
+	{
+		return "";
+	}
+	return std::string(buffer);
+}
+
+TEST_CASE("Log writer", "[Log][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> filename1("%s%cfirst.log", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> filename2("%s%csecond.log", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+
+	LogWriter writer(3);
+
+	// the writer isn't running yet: the lines remain in the queue, details beyond capacity are dropped
+	writer.Append(filename1, Message::mkInfo, "info 1\n", false);
+	writer.Append(filename2, Message::mkDetail, "detail 1\n", false);
+	writer.Append(filename1, Message::mkDetail, "detail 2\n", false);
+	writer.Append(filename1, Message::mkDetail, "detail 3\n", false);
+	writer.Append(filename2, Message::mkError, "error 1\n", false);
+	REQUIRE(writer.TakeDropped() == 1);
+	REQUIRE(writer.TakeDropped() == 0);
+	REQUIRE(!FileSystem::FileExists(filename1));
+
+	writer.Start();
+	writer.Flush();
+	REQUIRE(ReadLogFile(filename1) == "info 1\ndetail 2\n");
+	REQUIRE(ReadLogFile(filename2) == "detail 1\nerror 1\n");
+
+	writer.Append(filename1, Message::mkInfo, "info 2\n", false);
+	writer.CloseFile(filename1);
+	REQUIRE(ReadLogFile(filename1) == "info 1\ndetail 2\ninfo 2\n");
+	REQUIRE(FileSystem::DeleteFile(filename1));
+
+	// queued lines are written before the writer stops
+	writer.Append(filename2, Message::mkInfo, "info 3\n", false);
+	writer.Stop();
+	while (writer.IsRunning())
+	{
+		Util::Sleep(10);
+	}
+	REQUIRE(ReadLogFile(filename2) == "detail 1\nerror 1\ninfo 3\n");
+	REQUIRE(!FileSystem::FileExists(filename1));
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Log writer: synchronous write", "[Log][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	BString<1024> filename1("%s%cfirst.log", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+	BString<1024> filename2("%s%csecond.log", TestUtil::WorkingDir().c_str(), PATH_SEPARATOR);
+
+	// the writer isn't running: only the queued lines of the same file are written with the line
+	LogWriter writer;
+	writer.Append(filename1, Message::mkInfo, "info 1\n", false);
+	writer.Append(filename2, Message::mkInfo, "info 2\n", false);
+	writer.Append(filename1, Message::mkInfo, "info 3\n", false);
+	writer.Write(filename1, "error 1\n");
+	REQUIRE(ReadLogFile(filename1) == "info 1\ninfo 3\nerror 1\n");
+	REQUIRE(!FileSystem::FileExists(filename2));
+
+	writer.Start();
+	writer.Flush();
+	REQUIRE(ReadLogFile(filename2) == "info 2\n");
+
+	writer.Stop();
+	while (writer.IsRunning())
+	{
+		Util::Sleep(10);
+	}
+
+	TestUtil::CleanupWorkingDir();
+}
+
+TEST_CASE("Log: errors are written synchronously", "[Log][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+
+	std::string logFilename = TestUtil::WorkingDir() + "/nzbget.log";
+	CString logFileOption = CString::FormatStr("LogFile=%s", logFilename.c_str());
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=append");
+	cmdOpts.push_back(logFileOption);
+	cmdOpts.push_back("InfoTarget=log");
+	cmdOpts.push_back("ErrorTarget=log");
+	Options options(&cmdOpts, nullptr);
+
+	Log* globalLog = g_Log;
+	{
+		Log log;
+		log.InitOptions();
+		log.StartWriter();
+
+		info("queued message");
+		error("failure message");
+
+		// the error and the lines logged before it are on disk without flushing the writer
+		std::string content = ReadLogFile(logFilename.c_str());
+		size_t infoPos = content.find("INFO\tqueued message");
+		size_t errorPos = content.find("ERROR\tfailure message");
+		REQUIRE(infoPos != std::string::npos);
+		REQUIRE(errorPos != std::string::npos);
+		REQUIRE(infoPos < errorPos);
+	}
+	g_Log = globalLog;
+
+	TestUtil::CleanupWorkingDir();
+}
@@ -0,0 +1,87 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "PerfStats.h"
+
+static PerfStats::Summary FindSummary(PerfStats::EMetric metric)
+{
+	for (PerfStats::Summary& summary : PerfStats::Collect())
+	{
+		if (!strcmp(summary.name, PerfStats::GetName(metric)))
+		{
+			return summary;
+		}
+	}
+	return {};
+}
+
+TEST_CASE("Perf stats", "[PerfStats][Quick]")
+{
+	// other tests may have executed rpc commands already, all of them
+	// much faster than the durations recorded here (1..1000 seconds)
+	PerfStats::Summary before = FindSummary(PerfStats::pmRpcCommand);
+	int64 second = 1000000000;
+	REQUIRE(before.max < second);
+
+	// recorded partly in a thread which finishes before collecting
+	for (int i = 1; i <= 500; i++)
+	{
+		PerfStats::Add(PerfStats::pmRpcCommand, i * second);
+	}
+	std::thread worker([second]()
+		{
+			for (int i = 501; i <= 1000; i++)
+			{
+				PerfStats::Add(PerfStats::pmRpcCommand, i * second);
+			}
+		});
+	worker.join();
+
+	PerfStats::Summary summary = FindSummary(PerfStats::pmRpcCommand);
+	REQUIRE(summary.count == before.count + 1000);
+	REQUIRE(summary.total == before.total + 500500 * second);
+	REQUIRE(summary.max == 1000 * second);
+
+	// percentile ranks counted among the values recorded above
+	int64 p50 = (summary.count * 500 + 999) / 1000 - before.count;
+	int64 p99 = (summary.count * 990 + 999) / 1000 - before.count;
+	REQUIRE(summary.p50 >= p50 * second);
+	REQUIRE(summary.p50 <= p50 * second * 5 / 4);
+	REQUIRE(summary.p99 >= p99 * second);
+	REQUIRE(summary.p99 <= 1000 * second);
+
+	// values beyond the bucket range are kept in the last bucket
+	PerfStats::Add(PerfStats::pmRpcCommand, (int64)1 << 50);
+	summary = FindSummary(PerfStats::pmRpcCommand);
+	REQUIRE(summary.count == before.count + 1001);
+	REQUIRE(summary.max == (int64)1 << 50);
+
+	int64 start = PerfStats::Now();
+	{
+		PerfTimer timer(PerfStats::pmRpcCommand);
+	}
+	summary = FindSummary(PerfStats::pmRpcCommand);
+	REQUIRE(summary.count == before.count + 1002);
+	REQUIRE(PerfStats::Now() >= start);
+}
@@ -0,0 +1,144 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Options.h"
+#include "Script.h"
+#include "FileSystem.h"
+#include "TestUtil.h"
+
+#ifndef WIN32
+
+class ScriptControllerMock : public ScriptController
+{
+public:
+	std::vector<std::string> messages;
+
+#ifdef USE_POSIX_SPAWN
+	using ScriptController::FindProgram;
+#endif
+
+protected:
+	virtual void AddMessage(Message::EKind kind, const char* text) { messages.push_back(text); }
+};
+
+static void CreateScript(const char* filename, const char* content, bool executable)
+{
+	REQUIRE(FileSystem::SaveBufferIntoFile(filename, content, strlen(content)));
+	REQUIRE(chmod(filename, executable ? 0755 : 0644) == 0);
+}
+
+#ifdef USE_POSIX_SPAWN
+TEST_CASE("Script: find program", "[Script][Quick]")
+{
+	TestUtil::PrepareWorkingDir("empty");
+	std::string workingDir = TestUtil::WorkingDir();
+
+	CString errmsg;
+	REQUIRE(FileSystem::ForceDirectories((workingDir + "/bin1").c_str(), errmsg));
+	REQUIRE(FileSystem::ForceDirectories((workingDir + "/bin2").c_str(), errmsg));
+	CreateScript((workingDir + "/bin1/prog").c_str(), "exit 0\n", false);
+	CreateScript((workingDir + "/bin2/prog").c_str(), "exit 0\n", true);
+	CreateScript((workingDir + "/bin1/noexec").c_str(), "exit 0\n", false);
+	CreateScript((workingDir + "/local").c_str(), "exit 0\n", true);
+
+	CString pathVar = CString::FormatStr("PATH=%s/bin1:%s/bin2", workingDir.c_str(), workingDir.c_str());
+	char* envdata[] = {(char*)"HOME=/nonexistent", pathVar, nullptr};
+	CString filename;
+
+	// PATH is taken from the child environment, files without execute permission are skipped
+	REQUIRE(ScriptControllerMock::FindProgram("prog", "/", envdata, filename));
+	REQUIRE(!strcmp(filename, (workingDir + "/bin2/prog").c_str()));
+
+	// if only files without execute permission exist the first of them is used (to report EACCES)
+	REQUIRE(ScriptControllerMock::FindProgram("noexec", "/", envdata, filename));
+	REQUIRE(!strcmp(filename, (workingDir + "/bin1/noexec").c_str()));
+
+	REQUIRE(!ScriptControllerMock::FindProgram("nonexistent-program", "/", envdata, filename));
+
+	// programs with path are not searched
+	REQUIRE(ScriptControllerMock::FindProgram("./prog", "/", envdata, filename));
+	REQUIRE(!strcmp(filename, "./prog"));
+
+	// relative and empty PATH entries refer to the working directory of the child
+	char* relativeEnv[] = {(char*)"PATH=bin2", nullptr};
+	REQUIRE(ScriptControllerMock::FindProgram("prog", workingDir.c_str(), relativeEnv, filename));
+	REQUIRE(!strcmp(filename, (workingDir + "/bin2/prog").c_str()));
+
+	char* emptyEntryEnv[] = {(char*)"PATH=/nonexistent::/bin", nullptr};
+	REQUIRE(ScriptControllerMock::FindProgram("local", workingDir.c_str(), emptyEntryEnv, filename));
+	REQUIRE(!strcmp(filename, (workingDir + "/./local").c_str()));
+
+	// without PATH the default search path is used
+	char* noPathEnv[] = {nullptr};
+	REQUIRE(ScriptControllerMock::FindProgram("sh", workingDir.c_str(), noPathEnv, filename));
+	REQUIRE(!strcmp(filename, "/bin/sh"));
+
+	TestUtil::CleanupWorkingDir();
+}
+#endif
+
+TEST_CASE("Script: execute", "[Script][Quick]")
+{
+	Options::CmdOptList cmdOpts;
+	cmdOpts.push_back("WriteLog=none");
+	Options options(&cmdOpts, nullptr);
+
+	TestUtil::PrepareWorkingDir("empty");
+	std::string workingDir = TestUtil::WorkingDir();
+	std::string withShebang = workingDir + "/shebang.sh";
+	std::string withoutShebang = workingDir + "/plain.sh";
+
+	CreateScript(withShebang.c_str(), "#!/bin/sh\necho \"shebang $1\"\nexit 3\n", true);
+	// executed by the shell like with execvp
+	CreateScript(withoutShebang.c_str(), "echo \"plain $1 $2\"\nexit 5\n", true);
+
+	{
+		ScriptControllerMock script;
+		ScriptController::ArgList args;
+		args.emplace_back(withShebang.c_str());
+		args.emplace_back("arg");
+		script.SetArgs(std::move(args));
+		script.SetWorkingDir(workingDir.c_str());
+		REQUIRE(script.Execute() == 3);
+		REQUIRE(script.messages.size() == 1);
+		REQUIRE(script.messages[0] == "shebang arg");
+	}
+
+	{
+		ScriptControllerMock script;
+		ScriptController::ArgList args;
+		args.emplace_back(withoutShebang.c_str());
+		args.emplace_back("arg1");
+		args.emplace_back("arg2");
+		script.SetArgs(std::move(args));
+		script.SetWorkingDir(workingDir.c_str());
+		REQUIRE(script.Execute() == 5);
+		REQUIRE(script.messages.size() == 1);
+		REQUIRE(script.messages[0] == "plain arg1 arg2");
+	}
+
+	TestUtil::CleanupWorkingDir();
+}
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ *  This file is part of nzbget. See <http://nzbget.net>.
+ *
+ *  Copyright (C) 2026 Andrey Prygunkov <hugbug@users.sourceforge.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "nzbget.h"
+
+#include "catch.h"
+
+#include "Thread.h"
+#include "Util.h"
+
+TEST_CASE("Lock profile", "[Thread][Quick]")
+{
+	Mutex mutex;
+	std::vector<int> values;
+
+	{
+		// not profiled yet
+		Guard guard(mutex);
+	}
+
+	mutex.EnableProfiling();
+
+	for (int i = 0; i < 3; i++)
+	{
+		Guard guard(mutex);
+		values.push_back(i);
+	}
+	int shortLine = __LINE__ - 3;
+
+	{
+		GuardedPtr<std::vector<int>> guardedValues(&values, &mutex);
+		Util::Sleep(20);
+		guardedValues->clear();
+	}
+	int longLine = __LINE__ - 4;
+
+	{
+		// locks without source location aren't recorded
+		mutex.Lock();
+		mutex.Unlock();
+	}
+
+	Guard guard(mutex);
+	LockProfile::SiteList sites = mutex.GetProfile()->GetSites();
+	REQUIRE(sites.size() == 3);
+
+	// ordered by hold time; the current lock isn't released yet
+	REQUIRE(sites[0].line == longLine);
+	REQUIRE(sites[0].count == 1);
+	REQUIRE(sites[0].holdTime >= 20000000);
+	REQUIRE(sites[0].maxHold == sites[0].holdTime);
+	REQUIRE(sites[1].line == shortLine);
+	REQUIRE(sites[1].count == 3);
+	REQUIRE(sites[1].holdTime < sites[0].holdTime);
+	REQUIRE(sites[2].count == 1);
+	REQUIRE(sites[2].holdTime == 0);
+	REQUIRE(!strcmp(sites[0].file, __FILE__));
+
+	mutex.GetProfile()->Reset();
+	REQUIRE(mutex.GetProfile()->GetSites().empty());
+}
+
+TEST_CASE("Worker pool", "[Thread][Quick]")
+{
+	const int jobCount = 20;
+	std::thread::id callerThread = std::this_thread::get_id();
+
+	// results are stored by index, the earlier jobs take longer and complete later
+	WorkerPool pool(4);
+	std::vector<int> results(jobCount);
+	std::vector<int> progress;
+	bool progressOnCaller = true;
+	pool.Execute(jobCount,
+		[&](int index)
+		{
+			Util::Sleep((jobCount - index) / 4);
+			results[index] = index * index;
+		},
+		[&](int completed, int lastIndex)
+		{
+			progress.push_back(completed);
+			// the last completed job is reported, not the job at position "completed"
+			REQUIRE(lastIndex >= 0);
+			REQUIRE(lastIndex < jobCount);
+			REQUIRE(results[lastIndex] == lastIndex * lastIndex);
+			progressOnCaller = progressOnCaller && std::this_thread::get_id() == callerThread;
+		});
+
+	for (int i = 0; i < jobCount; i++)
+	{
+		REQUIRE(results[i] == i * i);
+	}
+	REQUIRE(progressOnCaller);
+	REQUIRE(!progress.empty());
+	REQUIRE(std::is_sorted(progress.begin(), progress.end()));
+	REQUIRE(std::adjacent_find(progress.begin(), progress.end()) == progress.end());
+	REQUIRE(progress.back() == jobCount);
+
+	// stopping mid-run: jobs already running are completed, the others are not started
+	for (int threads : {1, 4})
+	{
+		WorkerPool stoppedPool(threads);
+		std::atomic<int> executed{0};
+		int lastProgress = 0;
+		stoppedPool.Execute(jobCount,
+			[&](int index)
+			{
+				executed++;
+				if (index == 5)
+				{
+					stoppedPool.Stop();
+				}
+				Util::Sleep(5);
+			},
+			[&](int completed, int lastIndex)
+			{
+				lastProgress = completed;
+			});
+
+		INFO("threads: " << threads);
+		REQUIRE(executed >= 6);
+		REQUIRE(executed < jobCount);
+		REQUIRE(lastProgress == executed);
+	}
+}